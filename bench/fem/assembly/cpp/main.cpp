@@ -42,6 +42,8 @@ double reassemble_form(Form& form)
   Matrix A;
   Assembler assembler;
   assembler.assemble(A, form);
+  const std::string prefix = parameters["timer_prefix"];
+  timing(prefix + "Assemble cells", TimingClear::clear);
 
   // Reassemble
   const double t0 = time();
@@ -49,6 +51,36 @@ double reassemble_form(Form& form)
   return time() - t0;
 }
 
+double reassemble_form_plan(Form& form)
+{
+  // Assemble once, building assembly plan
+  Matrix A;
+  Assembler assembler;
+  AssemblyPlan plan(form);
+  assembler.assemble(A, plan);
+  const std::string prefix = parameters["timer_prefix"];
+  timing(prefix + "Assemble cells", TimingClear::clear);
+
+  // Reassemble using plan, adding cell tensors directly into the
+  // matrix storage for backends that support it
+  const double t0 = time();
+  assembler.assemble(A, plan);
+  return time() - t0;
+}
+
+double assemble_form_blocked(Form& form)
+{
+  // Assemble once, gathering and tabulating cells in blocks
+  parameters["assembly_cell_block_size"] = 32;
+  const double t0 = time();
+  Matrix A;
+  Assembler assembler;
+  assembler.assemble(A, form);
+  const double t = time() - t0;
+  parameters["assembly_cell_block_size"] = 0;
+  return t;
+}
+
 int main(int argc, char* argv[])
 {
   info("Assembly for various forms and backends");
@@ -93,6 +125,11 @@ int main(int argc, char* argv[])
   Table t5("Assemble cells");
   Table t6("Overhead");
   Table t7("Reassemble total");
+  Table t8("Assemble total (blocked)");
+  Table t10("Reassemble total (plan)");
+  Table t9("Assemble cells (blocked)");
+  Table t11("Reassemble cells");
+  Table t12("Reassemble cells (plan)");
 
   // Benchmark assembly
   for (unsigned int i = 0; i < forms.size(); i++)
@@ -143,6 +180,40 @@ int main(int argc, char* argv[])
         parameters["timer_prefix"] = backends[j];
         std::cout << "  Backend: " << backends[j] << std::endl;
         t7(forms[i], backends[j]) = bench_form(forms[i], reassemble_form);
+        const auto timing11 = timing(backends[j] + t5.name(),
+                                     TimingClear::clear);
+        t10(forms[i], backends[j]) = bench_form(forms[i],
+                                                reassemble_form_plan);
+        const auto timing12 = timing(backends[j] + t5.name(),
+                                     TimingClear::clear);
+        t11(forms[i], backends[j]) = std::get<1>(timing11);
+        t12(forms[i], backends[j]) = std::get<1>(timing12);
+        std::cout << "  BENCH " << forms[i] << "-" << backends[j]
+                  << "-cells " << std::get<1>(timing11) << std::endl;
+        std::cout << "  BENCH " << forms[i] << "-" << backends[j]
+                  << "-cells-plan " << std::get<1>(timing12) << std::endl;
+      }
+    }
+  }
+
+  // Benchmark blocked cell assembly
+  if (argc == 1)
+  {
+    for (unsigned int i = 0; i < forms.size(); i++)
+    {
+      std::cout << "Form: " << forms[i] << std::endl;
+      for (unsigned int j = 0; j < backends.size(); j++)
+      {
+        parameters["linear_algebra_backend"] = backends[j];
+        parameters["timer_prefix"] = backends[j];
+        std::cout << "  Backend: " << backends[j] << std::endl;
+        timing(backends[j] + t5.name(), TimingClear::clear);
+        t8(forms[i], backends[j]) = bench_form(forms[i],
+                                               assemble_form_blocked);
+        const auto timing9 = timing(backends[j] + t5.name(),
+                                    TimingClear::clear);
+        t9(forms[i], backends[j])
+          = std::get<1>(timing9)/static_cast<double>(std::get<0>(timing9));
       }
     }
   }
@@ -157,7 +228,14 @@ int main(int argc, char* argv[])
   std::cout << std::endl; info(t5, true);
   std::cout << std::endl; info(t6, true);
   if (argc == 1)
+  {
     std::cout << std::endl; info(t7, true);
+    std::cout << std::endl; info(t10, true);
+    std::cout << std::endl; info(t11, true);
+    std::cout << std::endl; info(t12, true);
+    std::cout << std::endl; info(t8, true);
+    std::cout << std::endl; info(t9, true);
+  }
 
   return 0;
 }
@@ -0,0 +1,112 @@
+// Copyright (C) 2016 The FEniCS Project
+//
+// This file is part of DOLFIN.
+//
+// DOLFIN is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// DOLFIN is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with DOLFIN. If not, see <http://www.gnu.org/licenses/>.
+//
+// First added:  2016-10-18
+// Last changed: 2016-10-18
+//
+// This benchmark compares the memory footprint and the time of
+// NUM_REPS matrix-vector products for an assembled PETSc matrix and
+// for a MatrixFreeOperator (with and without cached cell tensors)
+// for a P3 Poisson problem in 3D. Each variant runs in a separate
+// process such that peak memory is measured independently.
+
+#include <cstdio>
+#include <iostream>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <dolfin.h>
+#include "Poisson.h"
+
+#define SIZE 16
+#define NUM_REPS 10
+
+using namespace dolfin;
+
+// Return peak resident memory of process in MB
+double peak_memory()
+{
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_maxrss/1024.0;
+}
+
+void bench_operator(std::string variant)
+{
+  parameters["linear_algebra_backend"] = "PETSc";
+
+  UnitCubeMesh mesh(SIZE, SIZE, SIZE);
+  std::shared_ptr<FunctionSpace> V(new Poisson::FunctionSpace(mesh));
+  std::shared_ptr<Form> a(new Poisson::BilinearForm(V, V));
+  Function u(V);
+  *u.vector() = 1.0;
+  Vector y(*u.vector());
+
+  const double memory0 = peak_memory();
+  std::size_t bytes = 0;
+  double t = 0.0;
+  if (variant == "assembled")
+  {
+    Matrix A;
+    assemble(A, *a);
+    tic();
+    for (int i = 0; i < NUM_REPS; ++i)
+      A.mult(*u.vector(), y);
+    t = toc();
+
+    // Values and column indices of the compressed row storage
+    bytes = A.nnz()*(sizeof(double) + sizeof(dolfin::la_index));
+  }
+  else
+  {
+    MatrixFreeOperator A(a);
+    A.parameters["cache_cell_tensors"] = (variant == "matrix-free cached");
+    tic();
+    for (int i = 0; i < NUM_REPS; ++i)
+      A.mult(*u.vector(), y);
+    t = toc();
+    bytes = A.memory_usage();
+  }
+  const double memory = peak_memory() - memory0;
+
+  info("BENCH %s %g", variant.c_str(), t);
+  info("%s: operator data %.1f MB, peak memory increase %.1f MB",
+       variant.c_str(), bytes/(1024.0*1024.0), memory);
+}
+
+int main(int argc, char* argv[])
+{
+  info("Matrix-vector products for assembled and matrix-free operators");
+  std::cout.flush();
+  std::fflush(stdout);
+
+  const std::string variants[] = {"assembled", "matrix-free",
+                                  "matrix-free cached"};
+  for (std::size_t i = 0; i < 3; ++i)
+  {
+    const pid_t pid = fork();
+    if (pid == 0)
+    {
+      bench_operator(variants[i]);
+      return 0;
+    }
+    waitpid(pid, NULL, 0);
+  }
+
+  return 0;
+}
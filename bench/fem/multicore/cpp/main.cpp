@@ -21,6 +21,10 @@
 // If run without command-line arguments, this benchmark iterates from
 // zero to MAX_NUM_THREADS. If a command-line argument --num_threads n
 // is given, the benchmark is run with the specified number of threads.
+//
+// The benchmark times both the Assembler (for the bilinear forms) and
+// the SystemAssembler with a Dirichlet boundary condition applied
+// symmetrically (for the Poisson system).
 
 #include <cstdlib>
 
@@ -47,6 +51,14 @@ class PoissonFactory
     return _a;
   }
 
+  static std::shared_ptr<Form> L(std::shared_ptr<const FunctionSpace> V)
+  {
+    std::shared_ptr<Constant> f(new Constant(1.0));
+    std::shared_ptr<Form> _L(new Poisson::LinearForm(V));
+    _L->set_coefficient(0, f);
+    return _L;
+  }
+
 };
 
 class NavierStokesFactory
@@ -114,6 +126,39 @@ double bench(std::string form, std::shared_ptr<const Form> a)
   return t;
 }
 
+double bench_system(std::shared_ptr<const Form> a,
+                    std::shared_ptr<const Form> L)
+{
+  std::size_t num_threads = parameters["num_threads"];
+  info_underline("Benchmarking system assembly, num_threads = %d",
+                 num_threads);
+
+  // Create boundary condition
+  Constant zero(0.0);
+  DomainBoundary boundary;
+  DirichletBC bc(*a->function_space(0), zero, boundary);
+
+  // Assemble once to initialize matrix and vector
+  Matrix A;
+  Vector b;
+  SystemAssembler assembler(a, L, bc);
+  assembler.assemble(A, b);
+
+  // Run timing
+  Timer timer("Total time");
+  for (std::size_t i = 0; i < NUM_REPS; ++i)
+    assembler.assemble(A, b);
+  const double t = timer.stop();
+
+  // Report timings
+  list_timings(TimingClear::clear,
+               { TimingType::wall, TimingType::user, TimingType::system });
+
+  info("");
+
+  return t;
+}
+
 int main(int argc, char* argv[])
 {
   // Parse command-line arguments
@@ -129,11 +174,17 @@ int main(int argc, char* argv[])
   //forms.push_back(std::make_pair("Poisson", PoissonFactory::a(mesh)));
   forms.push_back(std::make_pair("NavierStokes", NavierStokesFactory::a(mesh)));
 
+  // Poisson system for SystemAssembler
+  std::shared_ptr<const Form> a_system = PoissonFactory::a(mesh);
+  std::shared_ptr<const Form> L_system
+    = PoissonFactory::L(a_system->function_space(0));
+
   // If parameter num_threads has been set, just run once
   if (parameters["num_threads"].change_count() > 0)
   {
     for (std::size_t i = 0; i < forms.size(); i++)
       bench(forms[i].first, forms[i].second);
+    bench_system(a_system, L_system);
   }
 
   // Otherwise, iterate from 1 to MAX_NUM_THREADS
@@ -143,7 +194,7 @@ int main(int argc, char* argv[])
     Table speedups("Speedups");
 
     // Iterate over number of threads
-    for (int num_threads = 2; num_threads <= MAX_NUM_THREADS; num_threads++)
+    for (int num_threads = 0; num_threads <= MAX_NUM_THREADS; num_threads++)
     {
       // Set the number of threads
       parameters["num_threads"] = num_threads;
@@ -168,6 +219,14 @@ int main(int argc, char* argv[])
             = run_timings.get_value("1 threads", forms[i].first)/t;
         }
       }
+
+      // Run SystemAssembler test case (0 threads = serial version)
+      const std::string name = "Poisson system";
+      const double t = bench_system(a_system, L_system);
+      std::stringstream s;
+      s << num_threads << " threads";
+      run_timings(s.str(), name) = t;
+      speedups(s.str(), name) = run_timings.get_value("0 threads", name)/t;
     }
 
     // Display results
@@ -0,0 +1,161 @@
+// Copyright (C) 2016 The FEniCS Project
+//
+// This file is part of DOLFIN.
+//
+// DOLFIN is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// DOLFIN is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with DOLFIN. If not, see <http://www.gnu.org/licenses/>.
+//
+// First added:  2016-10-18
+// Last changed: 2016-10-18
+//
+// This benchmark measures the time and peak memory used to build the
+// sparsity pattern for a vector-valued P2 problem in 3D, comparing
+// the two-pass builder used by SparsityPatternBuilder with insertion
+// of entries cell by cell, and with the storage used before
+// compressed rows were added (a dolfin::Set of global column indices
+// for each row of the diagonal and off-diagonal blocks, filled cell
+// by cell). Each builder runs in a separate process such that peak
+// memory is measured independently.
+
+#include <cstdio>
+#include <iostream>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <dolfin.h>
+#include "Elasticity.h"
+
+#define SIZE 16
+
+using namespace dolfin;
+
+// Builders to compare
+enum Builder {two_pass, cell_wise, set_rows};
+
+// Sparsity pattern stored as a set of columns for each row
+struct SetSparsityPattern
+{
+  typedef dolfin::Set<std::size_t> set_type;
+
+  SetSparsityPattern(std::size_t num_rows)
+    : diagonal(num_rows), off_diagonal(num_rows) {}
+
+  // Insert entries as SparsityPattern::insert_local did (sequential
+  // mode, where all entries belong to the diagonal block)
+  void insert_local(const std::vector<ArrayView<const dolfin::la_index>>& dofs)
+  {
+    for (std::size_t i = 0; i < dofs[0].size(); i++)
+      diagonal[dofs[0][i]].insert(dofs[1].begin(), dofs[1].end());
+  }
+
+  std::size_t num_nonzeros() const
+  {
+    std::size_t nz = 0;
+    for (std::size_t i = 0; i < diagonal.size(); i++)
+      nz += diagonal[i].size() + off_diagonal[i].size();
+    return nz;
+  }
+
+  std::vector<set_type> diagonal;
+  std::vector<set_type> off_diagonal;
+};
+
+// Return peak resident memory of process in MB
+double peak_memory()
+{
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_maxrss/1024.0;
+}
+
+void bench_sparsity_pattern(Builder builder)
+{
+  UnitCubeMesh mesh(SIZE, SIZE, SIZE);
+  Elasticity::FunctionSpace V(mesh);
+
+  std::shared_ptr<const GenericDofMap> dofmap = V.dofmap();
+  const std::vector<const GenericDofMap*> dofmaps(2, dofmap.get());
+  const std::vector<std::shared_ptr<const IndexMap>>
+    index_maps(2, dofmap->index_map());
+  const std::vector<std::size_t> dims(2, dofmap->global_dimension());
+
+  const double memory0 = peak_memory();
+  std::vector<ArrayView<const dolfin::la_index>> dofs(2);
+  std::size_t num_nonzeros = 0;
+  std::string name;
+  tic();
+  if (builder == two_pass)
+  {
+    name = "two-pass";
+    SparsityPattern pattern(0);
+    SparsityPatternBuilder::build(pattern, mesh, dofmaps,
+                                  true, false, false, false, false);
+    num_nonzeros = pattern.num_nonzeros();
+  }
+  else if (builder == cell_wise)
+  {
+    // Insert entries cell by cell
+    name = "cell-wise";
+    SparsityPattern pattern(0);
+    pattern.init(mesh.mpi_comm(), dims, index_maps);
+    for (CellIterator cell(mesh); !cell.end(); ++cell)
+    {
+      dofs[0] = dofmap->cell_dofs(cell->index());
+      dofs[1] = dofs[0];
+      pattern.insert_local(dofs);
+    }
+    pattern.apply();
+    num_nonzeros = pattern.num_nonzeros();
+  }
+  else
+  {
+    // Insert entries cell by cell into a set for each row
+    name = "set-rows";
+    SetSparsityPattern pattern(dofmap->index_map()->size());
+    for (CellIterator cell(mesh); !cell.end(); ++cell)
+    {
+      dofs[0] = dofmap->cell_dofs(cell->index());
+      dofs[1] = dofs[0];
+      pattern.insert_local(dofs);
+    }
+    num_nonzeros = pattern.num_nonzeros();
+  }
+  const double t = toc();
+  const double memory = peak_memory() - memory0;
+
+  info("BENCH %s %g", name.c_str(), t);
+  info("%s: %d nonzeros, peak memory increase %.1f MB", name.c_str(),
+       (int) num_nonzeros, memory);
+}
+
+int main(int argc, char* argv[])
+{
+  info("Building sparsity pattern for vector-valued P2 elements");
+  std::cout.flush();
+  std::fflush(stdout);
+
+  const Builder builders[] = {two_pass, cell_wise, set_rows};
+  for (std::size_t i = 0; i < 3; ++i)
+  {
+    const pid_t pid = fork();
+    if (pid == 0)
+    {
+      bench_sparsity_pattern(builders[i]);
+      return 0;
+    }
+    waitpid(pid, NULL, 0);
+  }
+
+  return 0;
+}
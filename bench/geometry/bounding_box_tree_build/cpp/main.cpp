@@ -16,17 +16,43 @@
 // along with DOLFIN. If not, see <http://www.gnu.org/licenses/>.
 //
 // This benchmark measures the performance of building a BoundingBoxTree (and
-// one call to compute_entities, which is dominated by building).
+// one call to compute_entities, which is dominated by building), the
+// scaling of the build with the number of threads, and the time of
+// refitting the tree after moving the mesh compared to rebuilding it,
+// together with the query time of the refitted and rebuilt trees.
 //
 // First added:  2013-04-18
-// Last changed: 2013-06-25
+// Last changed: 2016-10-18
 
+#include <cmath>
+#include <cstdio>
 #include <vector>
 #include <dolfin.h>
 
 using namespace dolfin;
 
 #define SIZE 128
+#define NUM_QUERIES 100000
+
+// Use for quick testing
+//#define SIZE 32
+//#define NUM_QUERIES 1000
+
+// Time point queries on the unit cube
+double time_queries(const BoundingBoxTree& tree)
+{
+  tic();
+  std::size_t num_collisions = 0;
+  for (int i = 0; i < NUM_QUERIES; i++)
+  {
+    const double s = (double) i / NUM_QUERIES;
+    const Point p(s, 0.5 + 0.4*std::sin(100.0*s), 0.5 + 0.4*std::cos(37.0*s));
+    num_collisions += tree.compute_entity_collisions(p).size();
+  }
+  const double t = toc();
+  info("%d collisions for %d points", (int) num_collisions, NUM_QUERIES);
+  return t;
+}
 
 int main(int argc, char* argv[])
 {
@@ -39,5 +65,41 @@ int main(int argc, char* argv[])
   tree.build(mesh);
   info("BENCH %g", toc());
 
+  // Build with increasing number of threads
+  const int num_threads = parameters["num_threads"];
+  for (int n = 1; n <= 8; n *= 2)
+  {
+    parameters["num_threads"] = n;
+    tic();
+    BoundingBoxTree tree_n;
+    tree_n.build(mesh);
+    char name[32];
+    std::snprintf(name, sizeof(name), "build-threads-%d", n);
+    info("BENCH %s %g", name, toc());
+  }
+  parameters["num_threads"] = num_threads;
+
+  // Move mesh (non-uniformly)
+  std::vector<double>& x = mesh.coordinates();
+  for (std::size_t i = 0; i < x.size(); i += 3)
+  {
+    x[i] += 0.1*std::sin(3.0*x[i + 1]);
+    x[i + 1] += 0.1*x[i]*x[i + 2];
+  }
+
+  // Refit and rebuild tree
+  tic();
+  tree.refit();
+  info("BENCH refit %g", toc());
+
+  tic();
+  BoundingBoxTree rebuilt_tree;
+  rebuilt_tree.build(mesh);
+  info("BENCH rebuild %g", toc());
+
+  // Compare query times
+  info("BENCH query-refit %g", time_queries(tree));
+  info("BENCH query-rebuild %g", time_queries(rebuilt_tree));
+
   return 0;
 }
@@ -0,0 +1,123 @@
+// Copyright (C) 2016 The FEniCS Project
+//
+// This file is part of DOLFIN.
+//
+// DOLFIN is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// DOLFIN is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with DOLFIN. If not, see <http://www.gnu.org/licenses/>.
+//
+// This benchmark measures the time of computing the collisions of
+// the cells of two overlapping meshes of triangles (in the plane and
+// on the boundary surfaces of two cubes) and of tetrahedra,
+// checking the bounding box candidates pair by pair and with the
+// batched collision tests of compute_entity_collisions.
+//
+// First added:  2016-10-18
+// Last changed: 2016-10-18
+
+#include <string>
+#include <vector>
+#include <dolfin.h>
+
+using namespace dolfin;
+
+#define NUM_REPS 5
+#define SIZE_2D 256
+#define SIZE_3D 24
+
+// Use for quick testing
+//#define NUM_REPS 1
+//#define SIZE_2D 32
+//#define SIZE_3D 8
+
+void bench_collisions(const std::string name, const Mesh& mesh_A,
+                      const Mesh& mesh_B)
+{
+  BoundingBoxTree tree_A;
+  BoundingBoxTree tree_B;
+  tree_A.build(mesh_A);
+  tree_B.build(mesh_B);
+
+  // Check candidates pair by pair
+  std::size_t num_pairwise = 0;
+  tic();
+  for (int i = 0; i < NUM_REPS; i++)
+  {
+    std::pair<std::vector<unsigned int>, std::vector<unsigned int>>
+      candidates = tree_A.compute_collisions(tree_B);
+    num_pairwise = 0;
+    for (std::size_t j = 0; j < candidates.first.size(); j++)
+    {
+      const Cell cell_A(mesh_A, candidates.first[j]);
+      const Cell cell_B(mesh_B, candidates.second[j]);
+      if (cell_A.collides(cell_B))
+        num_pairwise++;
+    }
+  }
+  const double t_pairwise = toc()/NUM_REPS;
+
+  // Check candidates in batches
+  std::size_t num_batched = 0;
+  tic();
+  for (int i = 0; i < NUM_REPS; i++)
+  {
+    num_batched
+      = tree_A.compute_entity_collisions(tree_B).first.size();
+  }
+  const double t_batched = toc()/NUM_REPS;
+
+  if (num_pairwise != num_batched)
+  {
+    error("Number of collisions differs (%d pairwise, %d batched)",
+          num_pairwise, num_batched);
+  }
+
+  info("BENCH %s-pairwise %g", name.c_str(), t_pairwise);
+  info("BENCH %s-batched %g", name.c_str(), t_batched);
+  info("%s: %d collisions, pairwise %.3g s, batched %.3g s (speedup %.2f)",
+       name.c_str(), num_batched, t_pairwise, t_batched,
+       t_pairwise/t_batched);
+}
+
+int main(int argc, char* argv[])
+{
+  // Triangle-triangle
+  {
+    UnitSquareMesh mesh_A(SIZE_2D, SIZE_2D);
+    UnitSquareMesh mesh_B(SIZE_2D + 3, SIZE_2D - 5);
+    mesh_B.translate(Point(0.31, 0.17));
+    bench_collisions("triangle-triangle", mesh_A, mesh_B);
+  }
+
+  // Triangle-triangle on surfaces in 3D (the triangles are not in
+  // the same plane, so the plane tests of the batched tests apply)
+  {
+    UnitCubeMesh cube_A(2*SIZE_3D, 2*SIZE_3D, 2*SIZE_3D);
+    UnitCubeMesh cube_B(2*SIZE_3D + 1, 2*SIZE_3D - 2, 2*SIZE_3D + 3);
+    cube_B.rotate(17.0, 0);
+    cube_B.rotate(23.0, 1);
+    cube_B.translate(Point(0.31, 0.17, 0.23));
+    BoundaryMesh mesh_A(cube_A, "exterior");
+    BoundaryMesh mesh_B(cube_B, "exterior");
+    bench_collisions("surface-triangle-triangle", mesh_A, mesh_B);
+  }
+
+  // Tetrahedron-tetrahedron
+  {
+    UnitCubeMesh mesh_A(SIZE_3D, SIZE_3D, SIZE_3D);
+    UnitCubeMesh mesh_B(SIZE_3D + 1, SIZE_3D - 2, SIZE_3D + 3);
+    mesh_B.translate(Point(0.31, 0.17, 0.23));
+    bench_collisions("tetrahedron-tetrahedron", mesh_A, mesh_B);
+  }
+
+  return 0;
+}
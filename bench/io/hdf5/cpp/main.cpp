@@ -0,0 +1,155 @@
+// Copyright (C) 2016 The FEniCS Project
+//
+// This file is part of DOLFIN.
+//
+// DOLFIN is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// DOLFIN is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with DOLFIN. If not, see <http://www.gnu.org/licenses/>.
+//
+// First added:  2016-10-18
+// Last changed: 2016-10-18
+//
+// This benchmark measures the write and read throughput of HDF5File
+// for a vector and a mesh with different HDF5 parameters. Run in
+// parallel with mpirun; the file is written to the current directory
+// unless --dir is given. MPI-IO hints can be passed with
+// --hints "cb_nodes=4,striping_factor=8".
+
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <dolfin.h>
+
+using namespace dolfin;
+
+#define NUM_REPS 3
+#define SIZE 32
+#define VECTOR_SIZE 16777216
+
+// Use for quick testing
+//#define NUM_REPS 1
+//#define SIZE 8
+//#define VECTOR_SIZE 1048576
+
+// Return maximum over processes of wall time since t0
+double elapsed(MPI_Comm comm, double t0)
+{
+  return dolfin::MPI::max(comm, time() - t0);
+}
+
+void bench_hdf5(const std::string name, const Parameters& p,
+                const std::string filename, const GenericVector& x,
+                const Mesh& mesh)
+{
+  const MPI_Comm comm = mesh.mpi_comm();
+  const double mbytes = 8.0*x.size()/1048576.0;
+
+  double t_write = 0.0;
+  double t_read = 0.0;
+  double t_mesh_write = 0.0;
+  double t_mesh_read = 0.0;
+  for (int i = 0; i < NUM_REPS; i++)
+  {
+    // Write
+    dolfin::MPI::barrier(comm);
+    double t0 = time();
+    {
+      HDF5File file(comm, filename, "w", p);
+      file.write(x, "/vector");
+      file.flush();
+      t_write += elapsed(comm, t0);
+
+      t0 = time();
+      file.write(mesh, "/mesh");
+      file.flush();
+      t_mesh_write += elapsed(comm, t0);
+    }
+
+    // Read
+    dolfin::MPI::barrier(comm);
+    t0 = time();
+    {
+      HDF5File file(comm, filename, "r", p);
+      Vector y(comm, x.size());
+      file.read(y, "/vector", false);
+      t_read += elapsed(comm, t0);
+
+      t0 = time();
+      Mesh mesh_in(comm);
+      file.read(mesh_in, "/mesh", false);
+      t_mesh_read += elapsed(comm, t0);
+    }
+  }
+
+  info("BENCH %s-write %g", name.c_str(), t_write/NUM_REPS);
+  info("BENCH %s-read %g", name.c_str(), t_read/NUM_REPS);
+  info("BENCH %s-mesh-write %g", name.c_str(), t_mesh_write/NUM_REPS);
+  info("BENCH %s-mesh-read %g", name.c_str(), t_mesh_read/NUM_REPS);
+  info("%s: vector write %.1f MB/s, read %.1f MB/s",
+       name.c_str(), mbytes*NUM_REPS/t_write, mbytes*NUM_REPS/t_read);
+}
+
+int main(int argc, char* argv[])
+{
+  info("Writing and reading vector of size %d and unit cube of size %d x %d x %d with HDF5 (%d repetitions)",
+       VECTOR_SIZE, SIZE, SIZE, SIZE, NUM_REPS);
+
+  // Parse directory and MPI-IO hints
+  std::string dir = ".";
+  std::string hints = "";
+  for (int i = 1; i + 1 < argc; i++)
+  {
+    const std::string arg = argv[i];
+    if (arg == "--dir")
+      dir = argv[++i];
+    else if (arg == "--hints")
+      hints = argv[++i];
+  }
+  const std::string filename = dir + "/bench_io_hdf5.h5";
+
+  UnitCubeMesh mesh(SIZE, SIZE, SIZE);
+  Vector x(mesh.mpi_comm(), VECTOR_SIZE);
+  std::vector<double> values(x.local_size());
+  for (std::size_t i = 0; i < values.size(); ++i)
+    values[i] = (double) ((x.local_range().first + i) % 1000);
+  x.set_local(values);
+  x.apply("insert");
+
+  Parameters p = HDF5File::default_parameters();
+  p["mpi_io_hints"] = hints;
+  bench_hdf5("collective", p, filename, x, mesh);
+
+  p["mpi_io_transfer"] = "independent";
+  bench_hdf5("independent", p, filename, x, mesh);
+
+  p["mpi_io_transfer"] = "collective";
+  p["chunking"] = true;
+  bench_hdf5("chunked", p, filename, x, mesh);
+
+  // Parallel compression requires HDF5 1.10.2 or later
+  p["compression_level"] = 1;
+  p["shuffle"] = true;
+  try
+  {
+    bench_hdf5("compressed", p, filename, x, mesh);
+  }
+  catch (std::runtime_error& e)
+  {
+    info("Compressed output not available: %s", e.what());
+  }
+
+  if (dolfin::MPI::rank(mesh.mpi_comm()) == 0)
+    std::remove(filename.c_str());
+
+  return 0;
+}
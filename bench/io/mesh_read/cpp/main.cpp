@@ -0,0 +1,136 @@
+// Copyright (C) 2016 The FEniCS Project
+//
+// This file is part of DOLFIN.
+//
+// DOLFIN is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// DOLFIN is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with DOLFIN. If not, see <http://www.gnu.org/licenses/>.
+//
+// First added:  2016-10-18
+// Last changed: 2016-10-18
+//
+// This benchmark measures the time and the peak memory per process
+// of reading a mesh in parallel from XML, from the HDF5 cache of the
+// XML file, from HDF5 and from XDMF. Create the files first with
+//
+//   mpirun -n 1 ./bench_io_mesh_read --prepare
+//
+// and then run each format in a separate process (the peak memory is
+// that of the whole process) for increasing numbers of processes,
+// e.g.
+//
+//   mpirun -n 16 ./bench_io_mesh_read xml
+//   mpirun -n 16 ./bench_io_mesh_read xml-cache
+//   mpirun -n 16 ./bench_io_mesh_read hdf5
+//   mpirun -n 16 ./bench_io_mesh_read xdmf
+
+#include <string>
+#include <sys/resource.h>
+#include <dolfin.h>
+
+using namespace dolfin;
+
+#define SIZE 64
+
+// Use for quick testing
+//#define SIZE 16
+
+// Return peak resident memory of process in MB
+double peak_memory()
+{
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_maxrss/1024.0;
+}
+
+void prepare(MPI_Comm comm)
+{
+  info("Writing unit cube of size %d x %d x %d to XML, HDF5 and XDMF",
+       SIZE, SIZE, SIZE);
+
+  // XML output is serial
+  if (dolfin::MPI::rank(comm) == 0)
+  {
+    UnitCubeMesh mesh(MPI_COMM_SELF, SIZE, SIZE, SIZE);
+    File file(MPI_COMM_SELF, "bench_io_mesh_read.xml");
+    file << mesh;
+  }
+  dolfin::MPI::barrier(comm);
+
+  // Create HDF5 cache of XML file
+  parameters["xml_mesh_cache"] = true;
+  Mesh mesh(comm, "bench_io_mesh_read.xml");
+  parameters["xml_mesh_cache"] = false;
+
+  HDF5File hdf5_file(comm, "bench_io_mesh_read.h5", "w");
+  hdf5_file.write(mesh, "/mesh");
+
+  XDMFFile xdmf_file(comm, "bench_io_mesh_read.xdmf");
+  xdmf_file << mesh;
+}
+
+int main(int argc, char* argv[])
+{
+  const MPI_Comm comm = MPI_COMM_WORLD;
+  const std::string format = argc > 1 ? argv[1] : "xml";
+  if (format == "--prepare")
+  {
+    prepare(comm);
+    return 0;
+  }
+
+  const std::size_t num_processes = dolfin::MPI::size(comm);
+  info("Reading mesh from %s on %d processes", format.c_str(),
+       num_processes);
+
+  dolfin::MPI::barrier(comm);
+  const double memory_before = peak_memory();
+  const double t0 = time();
+
+  Mesh mesh(comm);
+  if (format == "xml" || format == "xml-cache")
+  {
+    parameters["xml_mesh_cache"] = (format == "xml-cache");
+    File file(comm, "bench_io_mesh_read.xml");
+    file >> mesh;
+  }
+  else if (format == "hdf5")
+  {
+    HDF5File file(comm, "bench_io_mesh_read.h5", "r");
+    file.read(mesh, "/mesh", false);
+  }
+  else if (format == "xdmf")
+  {
+    XDMFFile file(comm, "bench_io_mesh_read.xdmf");
+    file >> mesh;
+  }
+  else
+  {
+    error("Unknown format \"%s\"", format.c_str());
+  }
+
+  const double t = dolfin::MPI::max(comm, time() - t0);
+  const double memory = peak_memory();
+  const double memory_max = dolfin::MPI::max(comm, memory);
+  const double memory_sum = dolfin::MPI::sum(comm, memory);
+  const double memory_increase_max
+    = dolfin::MPI::max(comm, memory - memory_before);
+
+  info("BENCH mesh-read-%s-np%d %g", format.c_str(), num_processes, t);
+  info("BENCH mesh-read-%s-np%d-peak-memory-MB %g", format.c_str(),
+       num_processes, memory_max);
+  info("%s on %d processes: %.3g s, %d cells, peak memory per process %.1f MB (max), %.1f MB (mean), increase by read %.1f MB (max)",
+       format.c_str(), num_processes, t, mesh.size_global(3), memory_max,
+       memory_sum/num_processes, memory_increase_max);
+
+  return 0;
+}
@@ -0,0 +1,83 @@
+// Copyright (C) 2016 The FEniCS Project
+//
+// This file is part of DOLFIN.
+//
+// DOLFIN is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// DOLFIN is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with DOLFIN. If not, see <http://www.gnu.org/licenses/>.
+//
+// First added:  2016-10-18
+// Last changed: 2016-10-18
+//
+// This benchmark measures the time of encoding a data array for VTK
+// output with base64 and zlib compression, using the streaming
+// encoder of VTKWriter with compression of blocks in parallel for
+// increasing numbers of threads.
+
+#include <cmath>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <dolfin.h>
+#include <dolfin/io/VTKWriter.h>
+
+using namespace dolfin;
+
+#define NUM_REPS 3
+#define SIZE 16777216
+
+// Use for quick testing
+//#define NUM_REPS 1
+//#define SIZE 1048576
+
+void bench_encoded_array_writer(const std::vector<double>& data,
+                                bool compress, int num_threads)
+{
+  const std::string name = compress ? "compressed" : "base64";
+  parameters["num_threads"] = num_threads;
+  std::size_t length = 0;
+  const double t0 = time();
+  for (int i = 0; i < NUM_REPS; i++)
+  {
+    std::stringstream stream;
+    VTKWriter::EncodedArrayWriter<double> writer(stream, data.size(),
+                                                 compress);
+    for (std::size_t j = 0; j < data.size(); j++)
+      writer.add(data[j]);
+    writer.finish();
+    length = stream.str().size();
+  }
+  const double t = (time() - t0)/NUM_REPS;
+  parameters["num_threads"] = 0;
+
+  info("BENCH encoded-array-writer-%s-%d %g", name.c_str(), num_threads, t);
+  info("EncodedArrayWriter (%s, %d threads): %.1f MB/s, %d characters",
+       name.c_str(), num_threads, 8.0*data.size()/1048576.0/t, length);
+}
+
+int main(int argc, char* argv[])
+{
+  info("Encoding array of %d doubles for VTK (%d repetitions)",
+       SIZE, NUM_REPS);
+
+  // Smooth data, as for function values
+  std::vector<double> data(SIZE);
+  for (std::size_t i = 0; i < data.size(); i++)
+    data[i] = std::sin(1.0e-4*i) + 1.0e-3*(i % 17);
+
+  bench_encoded_array_writer(data, false, 1);
+
+  for (int num_threads = 1; num_threads <= 8; num_threads *= 2)
+    bench_encoded_array_writer(data, true, num_threads);
+
+  return 0;
+}
@@ -0,0 +1,94 @@
+// Copyright (C) 2016 The FEniCS Project
+//
+// This file is part of DOLFIN.
+//
+// DOLFIN is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// DOLFIN is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with DOLFIN. If not, see <http://www.gnu.org/licenses/>.
+//
+// First added:  2016-10-18
+// Last changed: 2016-10-18
+//
+// This benchmark measures the cost of writing a long time series of
+// a Function to XDMF, rewriting the mesh at each step, writing the
+// mesh once, and writing the mesh once with incremental output of
+// values and XML. The time for the last block of steps shows whether
+// the cost of a step grows with the number of steps written.
+
+#include <cstdio>
+#include <string>
+#include <dolfin.h>
+#include "P1.h"
+
+using namespace dolfin;
+
+#define NUM_STEPS 10000
+#define BLOCK_SIZE 1000
+#define SIZE 32
+
+// Use for quick testing
+//#define NUM_STEPS 100
+//#define BLOCK_SIZE 10
+//#define SIZE 8
+
+void bench_xdmf(const std::string name, const Function& u,
+                bool rewrite_mesh, bool incremental)
+{
+  const MPI_Comm comm = u.function_space()->mesh()->mpi_comm();
+  const std::string filename = "bench_io_xdmf_series_" + name + ".xdmf";
+
+  XDMFFile file(comm, filename);
+  file.parameters["rewrite_function_mesh"] = rewrite_mesh;
+  file.parameters["incremental_time_series"] = incremental;
+
+  dolfin::MPI::barrier(comm);
+  const double t0 = time();
+  double t_block = t0;
+  for (int step = 0; step < NUM_STEPS; step++)
+  {
+    if (step == NUM_STEPS - BLOCK_SIZE)
+      t_block = time();
+    file << std::make_pair(&u, (double) step);
+  }
+  const double t1 = time();
+  const double t_total = dolfin::MPI::max(comm, t1 - t0);
+  const double t_last = dolfin::MPI::max(comm, t1 - t_block);
+
+  info("BENCH %s %g", name.c_str(), t_total);
+  info("BENCH %s-last-%d %g", name.c_str(), BLOCK_SIZE, t_last);
+  info("%s: %.3g ms per step on average, %.3g ms per step for last %d steps",
+       name.c_str(), 1000.0*t_total/NUM_STEPS, 1000.0*t_last/BLOCK_SIZE,
+       BLOCK_SIZE);
+
+  if (dolfin::MPI::rank(comm) == 0)
+  {
+    std::remove(filename.c_str());
+    std::remove(("bench_io_xdmf_series_" + name + ".h5").c_str());
+  }
+}
+
+int main(int argc, char* argv[])
+{
+  info("Writing %d time steps of P1 function on unit square of size %d x %d to XDMF",
+       NUM_STEPS, SIZE, SIZE);
+
+  UnitSquareMesh mesh(SIZE, SIZE);
+  std::shared_ptr<FunctionSpace> V(new P1::FunctionSpace(mesh));
+  Function u(V);
+  *u.vector() = 1.0;
+
+  bench_xdmf("rewrite-mesh", u, true, false);
+  bench_xdmf("constant-mesh", u, false, false);
+  bench_xdmf("incremental", u, false, true);
+
+  return 0;
+}
@@ -0,0 +1,144 @@
+// Copyright (C) 2016 The FEniCS Project
+//
+// This file is part of DOLFIN.
+//
+// DOLFIN is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// DOLFIN is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with DOLFIN. If not, see <http://www.gnu.org/licenses/>.
+//
+// First added:  2016-10-18
+// Last changed: 2016-10-18
+//
+// This benchmark measures iteration over cell-vertex connectivity
+// (stored with fixed stride) and vertex-cell connectivity (stored
+// with offsets) of MeshConnectivity, compared to a copy of the same
+// connections stored with an offset for each entity (the storage
+// used before fixed stride connectivity was added). It also reports
+// the memory used and the time to compress and decompress.
+
+#include <vector>
+#include <dolfin.h>
+
+using namespace dolfin;
+
+#define NUM_REPS 100
+#define SIZE 64
+
+// Use for quick testing
+//#define NUM_REPS 2
+//#define SIZE 8
+
+// Connections stored with an offset for each entity
+struct OffsetConnectivity
+{
+  OffsetConnectivity(const MeshConnectivity& c, std::size_t num_entities)
+    : offsets(1, 0)
+  {
+    offsets.reserve(num_entities + 1);
+    for (std::size_t e = 0; e < num_entities; e++)
+    {
+      connections.insert(connections.end(), c(e), c(e) + c.size(e));
+      offsets.push_back(connections.size());
+    }
+  }
+
+  std::vector<unsigned int> connections;
+  std::vector<unsigned int> offsets;
+};
+
+// Sum connections using MeshConnectivity
+std::size_t sum_connections(const MeshConnectivity& c,
+                            std::size_t num_entities)
+{
+  std::size_t sum = 0;
+  for (std::size_t e = 0; e < num_entities; e++)
+  {
+    const unsigned int* entities = c(e);
+    const std::size_t n = c.size(e);
+    for (std::size_t i = 0; i < n; i++)
+      sum += entities[i];
+  }
+  return sum;
+}
+
+// Sum connections using offset for each entity
+std::size_t sum_connections(const OffsetConnectivity& c,
+                            std::size_t num_entities)
+{
+  std::size_t sum = 0;
+  for (std::size_t e = 0; e < num_entities; e++)
+  {
+    const unsigned int* entities = &c.connections[c.offsets[e]];
+    const std::size_t n = c.offsets[e + 1] - c.offsets[e];
+    for (std::size_t i = 0; i < n; i++)
+      sum += entities[i];
+  }
+  return sum;
+}
+
+// Benchmark iteration over connectivity d0 - d1
+void bench_connectivity(const Mesh& mesh, std::size_t d0, std::size_t d1)
+{
+  const MeshConnectivity& c = mesh.topology()(d0, d1);
+  const std::size_t num_entities = mesh.num_entities(d0);
+  const OffsetConnectivity baseline(c, num_entities);
+
+  std::size_t sum = 0;
+  tic();
+  for (int i = 0; i < NUM_REPS; i++)
+    sum += sum_connections(baseline, num_entities);
+  info("BENCH iterate-%d-%d-offsets %g", d0, d1, toc());
+
+  tic();
+  for (int i = 0; i < NUM_REPS; i++)
+    sum += sum_connections(c, num_entities);
+  info("BENCH iterate-%d-%d %g", d0, d1, toc());
+
+  // To prevent optimizing the loops away
+  info("Sum is %d", sum);
+
+  const std::size_t baseline_memory
+    = sizeof(unsigned int)*(baseline.connections.capacity()
+                            + baseline.offsets.capacity());
+  info("Memory used by connectivity %d - %d: %d bytes (%d bytes with offsets)",
+       d0, d1, c.memory_usage(), baseline_memory);
+}
+
+int main(int argc, char* argv[])
+{
+  info("Iteration over connectivity of unit cube of size %d x %d x %d (%d repetitions)",
+       SIZE, SIZE, SIZE, NUM_REPS);
+
+  parameters.parse(argc, argv);
+
+  UnitCubeMesh mesh(SIZE, SIZE, SIZE);
+  mesh.init(0, 3);
+
+  // Cell-vertex connectivity is stored with fixed stride
+  bench_connectivity(mesh, 3, 0);
+
+  // Vertex-cell connectivity is stored with offsets
+  bench_connectivity(mesh, 0, 3);
+
+  // Compress and decompress vertex-cell connectivity
+  MeshConnectivity& c = mesh.topology()(0, 3);
+  tic();
+  c.compress();
+  info("BENCH compress-0-3 %g", toc());
+  info("Memory used by compressed connectivity 0 - 3: %d bytes",
+       c.memory_usage());
+  tic();
+  c.decompress();
+  info("BENCH decompress-0-3 %g", toc());
+
+  return 0;
+}
@@ -0,0 +1,136 @@
+// Copyright (C) 2016 The FEniCS Project
+//
+// This file is part of DOLFIN.
+//
+// DOLFIN is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// DOLFIN is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with DOLFIN. If not, see <http://www.gnu.org/licenses/>.
+//
+// First added:  2016-10-18
+// Last changed: 2016-10-18
+//
+// This benchmark measures the time of building a multimesh (a
+// background mesh with a number of fixed overlapping meshes and one
+// moving mesh) for increasing numbers of threads, and the time per
+// step of a moving-overlap simulation when the multimesh is rebuilt
+// with build() and when it is updated with update(), which recomputes
+// only the quadrature rules of the cut cells affected by the moving
+// mesh.
+
+#include <cstdio>
+#include <vector>
+#include <dolfin.h>
+
+using namespace dolfin;
+
+#define SIZE 256
+#define NUM_FIXED 8
+#define NUM_STEPS 20
+
+// Use for quick testing
+//#define SIZE 32
+//#define NUM_FIXED 2
+//#define NUM_STEPS 4
+
+// Sum of weights of all cut cell quadrature rules
+double cut_cell_volume(const MultiMesh& multimesh)
+{
+  double volume = 0.0;
+  for (std::size_t part = 0; part < multimesh.num_parts(); part++)
+  {
+    const QuadratureRules& qr = multimesh.cut_cell_quadrature(part);
+    for (std::size_t i = 0; i < qr.size(); i++)
+      for (std::size_t j = 0; j < qr.num_points(i); j++)
+        volume += qr.weights(i)[j];
+  }
+  return volume;
+}
+
+int main(int argc, char* argv[])
+{
+  info("Building multimesh of unit square of size %d x %d with %d fixed and 1 moving mesh",
+       SIZE, SIZE, NUM_FIXED);
+
+  // Create background mesh and fixed overlapping meshes along the
+  // bottom of the domain
+  std::vector<std::shared_ptr<Mesh>> meshes;
+  meshes.push_back(std::shared_ptr<Mesh>(new UnitSquareMesh(SIZE, SIZE)));
+  const double width = 0.8/NUM_FIXED;
+  const std::size_t n = SIZE/(2*NUM_FIXED) + 1;
+  for (int i = 0; i < NUM_FIXED; i++)
+  {
+    const double x0 = 0.1 + i*width + 0.013;
+    std::shared_ptr<Mesh> mesh(new RectangleMesh(Point(x0, 0.107),
+                                                 Point(x0 + 0.8*width, 0.397),
+                                                 n, 3*n));
+    meshes.push_back(mesh);
+  }
+
+  // Create moving mesh in the upper half of the domain
+  std::shared_ptr<Mesh> moving_mesh(new RectangleMesh(Point(0.103, 0.553),
+                                                      Point(0.403, 0.853),
+                                                      SIZE/4, SIZE/4));
+  meshes.push_back(moving_mesh);
+
+  MultiMesh multimesh;
+  for (std::size_t i = 0; i < meshes.size(); i++)
+    multimesh.add(meshes[i]);
+
+  // Build with increasing number of threads
+  const int num_threads = parameters["num_threads"];
+  for (int k = 1; k <= 8; k *= 2)
+  {
+    parameters["num_threads"] = k;
+    tic();
+    multimesh.build();
+    char name[32];
+    std::snprintf(name, sizeof(name), "build-threads-%d", k);
+    info("BENCH %s %g", name, toc());
+  }
+  parameters["num_threads"] = num_threads;
+
+  std::size_t num_cut_cells = 0;
+  for (std::size_t part = 0; part < multimesh.num_parts(); part++)
+    num_cut_cells += multimesh.cut_cells(part).size();
+  info("%d cut cells", num_cut_cells);
+
+  // Move mesh and rebuild multimesh
+  const Point step(0.01, -0.003);
+  tic();
+  for (int i = 0; i < NUM_STEPS; i++)
+  {
+    moving_mesh->translate(step);
+    multimesh.build();
+  }
+  const double t_build = toc()/NUM_STEPS;
+  const double volume_build = cut_cell_volume(multimesh);
+
+  // Move mesh back and update multimesh
+  const std::vector<std::size_t> moved_parts(1, meshes.size() - 1);
+  moving_mesh->translate(Point(-NUM_STEPS*step[0], -NUM_STEPS*step[1]));
+  multimesh.build();
+  tic();
+  for (int i = 0; i < NUM_STEPS; i++)
+  {
+    moving_mesh->translate(step);
+    multimesh.update(moved_parts);
+  }
+  const double t_update = toc()/NUM_STEPS;
+  const double volume_update = cut_cell_volume(multimesh);
+
+  info("BENCH step-build %g", t_build);
+  info("BENCH step-update %g", t_update);
+  info("Cut cell volume %.12g (build), %.12g (update)", volume_build,
+       volume_update);
+
+  return 0;
+}
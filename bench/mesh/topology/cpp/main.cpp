@@ -16,7 +16,19 @@
 // along with DOLFIN. If not, see <http://www.gnu.org/licenses/>.
 //
 // First added:  2010-11-25
-// Last changed: 2012-12-12
+// Last changed: 2016-10-18
+//
+// This benchmark measures the time and peak memory used to compute
+// edges, facets and cell-cell connectivity of a unit cube, comparing
+// the algorithms for numbering entities selected by the parameter
+// "entity_numbering". Each algorithm runs in a separate process such
+// that peak memory is measured independently.
+
+#include <cstdio>
+#include <iostream>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
 
 #include <dolfin.h>
 #include <dolfin/log/LogLevel.h>
@@ -30,28 +42,74 @@ using namespace dolfin;
 //#define NUM_REPS 2
 //#define SIZE 32
 
-int main(int argc, char* argv[])
+// Return peak resident memory of process in MB
+double peak_memory()
 {
-  info("Creating cell-cell connectivity for unit cube of size %d x %d x %d (%d repetitions)",
-       SIZE, SIZE, SIZE, NUM_REPS);
-
-  set_log_level(DBG);
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_maxrss/1024.0;
+}
 
-  parameters.parse(argc, argv);
+void bench_topology(std::string algorithm)
+{
+  parameters["entity_numbering"] = algorithm;
 
   UnitCubeMesh mesh(SIZE, SIZE, SIZE);
   const int D = mesh.topology().dim();
 
+  const double memory0 = peak_memory();
+  double t_edges = 0.0;
+  double t_facets = 0.0;
+  double t_cells = 0.0;
   for (int i = 0; i < NUM_REPS; i++)
   {
     mesh.clean();
+    tic();
+    mesh.init(1);
+    t_edges += toc();
+    tic();
+    mesh.init(D - 1);
+    t_facets += toc();
+    tic();
     mesh.init(D, D);
-    dolfin::cout << "Created unit cube: " << mesh << dolfin::endl;
+    t_cells += toc();
   }
+  const double memory = peak_memory() - memory0;
+
+  info("BENCH %s-edges %g", algorithm.c_str(), t_edges/NUM_REPS);
+  info("BENCH %s-facets %g", algorithm.c_str(), t_facets/NUM_REPS);
+  info("BENCH %s-cell-cell %g", algorithm.c_str(), t_cells/NUM_REPS);
+  info("%s: %d edges, %d facets, peak memory increase %.1f MB",
+       algorithm.c_str(), (int) mesh.num_edges(), (int) mesh.num_facets(),
+       memory);
 
   // Report timings
   list_timings(TimingClear::keep,
                { TimingType::wall, TimingType::user, TimingType::system });
+}
+
+int main(int argc, char* argv[])
+{
+  info("Creating edges, facets and cell-cell connectivity for unit cube of size %d x %d x %d (%d repetitions)",
+       SIZE, SIZE, SIZE, NUM_REPS);
+
+  set_log_level(DBG);
+
+  parameters.parse(argc, argv);
+  std::cout.flush();
+  std::fflush(stdout);
+
+  const std::string algorithms[] = {"sort", "map"};
+  for (std::size_t i = 0; i < 2; ++i)
+  {
+    const pid_t pid = fork();
+    if (pid == 0)
+    {
+      bench_topology(algorithms[i]);
+      return 0;
+    }
+    waitpid(pid, NULL, 0);
+  }
 
   return 0;
 }
@@ -22,6 +22,7 @@
 // Modified by Martin Alnaes 2013-2015
 
 #include <algorithm>
+#include <memory>
 #include <dolfin/log/log.h>
 #include <dolfin/log/Progress.h>
 #include <dolfin/common/Array.h>
@@ -43,12 +44,37 @@
 #include "FiniteElement.h"
 #include "OpenMpAssembler.h"
 #include "AssemblerBase.h"
+#include "AssemblyPlan.h"
+#include "CellTensorCache.h"
 #include "Assembler.h"
 
 #include <dolfin/la/GenericMatrix.h>
 
 using namespace dolfin;
 
+// Copy cell data (coordinate dofs and values of enabled coefficients)
+// to the cell data kept by an assembly plan. Returns true if the data
+// differs from the kept data.
+static bool store_cell_data(double* data, const AssemblyPlan& plan,
+                            const std::vector<double>& coordinate_dofs,
+                            const UFC& ufc,
+                            const std::vector<bool>& enabled_coefficients)
+{
+  bool changed = !std::equal(coordinate_dofs.begin(), coordinate_dofs.end(),
+                             data);
+  std::copy(coordinate_dofs.begin(), coordinate_dofs.end(), data);
+  for (std::size_t i = 0; i < enabled_coefficients.size(); ++i)
+  {
+    if (!enabled_coefficients[i])
+      continue;
+    const std::size_t offset = plan.coefficient_offset(i);
+    const std::size_t dim = plan.coefficient_offset(i + 1) - offset;
+    const double* w = ufc.w()[i];
+    changed = changed || !std::equal(w, w + dim, data + offset);
+    std::copy(w, w + dim, data + offset);
+  }
+  return changed;
+}
 //----------------------------------------------------------------------------
 void Assembler::assemble(GenericTensor& A, const Form& a)
 {
@@ -117,6 +143,106 @@ void Assembler::assemble(GenericTensor& A, const Form& a)
     A.apply("add");
 }
 //-----------------------------------------------------------------------------
+void Assembler::assemble(GenericTensor& A, AssemblyPlan& plan)
+{
+  // Rebuild plan if the form has changed since the plan was built
+  plan.update();
+  const Form& a = plan.form();
+
+  // Check form
+  AssemblerBase::check(a);
+
+  // Initialize global tensor and bind plan to it
+  init_global_tensor(A, a);
+  plan.bind(A);
+
+  // Assemble over cells and release direct access to tensor storage
+  assemble_cells(A, plan);
+  plan.release();
+
+  // Assemble over facets and vertices, reusing UFC data of plan
+  UFC& ufc = plan.ufc();
+  assemble_exterior_facets(A, a, ufc, a.exterior_facet_domains(), NULL);
+  assemble_interior_facets(A, a, ufc, a.interior_facet_domains(),
+                           a.cell_domains(), NULL);
+  assemble_vertices(A, a, ufc, a.vertex_domains());
+
+  // Finalize assembly of global tensor
+  if (finalize_tensor)
+    A.apply("add");
+}
+//-----------------------------------------------------------------------------
+void Assembler::reassemble(GenericTensor& A, AssemblyPlan& plan,
+                           const std::vector<std::size_t>& cells)
+{
+  if (!init_reassembly(A, plan))
+    return;
+
+  // Get planned positions of cells
+  const std::size_t num_cells = plan.form().mesh().num_cells();
+  std::vector<std::size_t> planned_cells;
+  planned_cells.reserve(cells.size());
+  for (std::size_t i = 0; i < cells.size(); ++i)
+  {
+    if (cells[i] >= num_cells)
+    {
+      dolfin_error("Assembler.cpp",
+                   "reassemble tensor",
+                   "Cell index %d is out of range", cells[i]);
+    }
+    const int k = plan.plan_index(cells[i]);
+    if (k >= 0)
+      planned_cells.push_back(k);
+  }
+  std::sort(planned_cells.begin(), planned_cells.end());
+  planned_cells.erase(std::unique(planned_cells.begin(), planned_cells.end()),
+                      planned_cells.end());
+
+  // Reassemble over cells
+  reassemble_cells(A, plan, &planned_cells);
+
+  // Finalize assembly of global tensor
+  if (finalize_tensor)
+    A.apply("add");
+}
+//-----------------------------------------------------------------------------
+void Assembler::reassemble(GenericTensor& A, AssemblyPlan& plan,
+                           const MeshFunction<std::size_t>& markers,
+                           std::size_t marker)
+{
+  const Mesh& mesh = plan.form().mesh();
+  if (markers.dim() != mesh.topology().dim()
+      || markers.size() != mesh.num_cells())
+  {
+    dolfin_error("Assembler.cpp",
+                 "reassemble tensor",
+                 "Markers are not a cell function on the mesh of the form");
+  }
+
+  // Collect marked cells
+  std::vector<std::size_t> cells;
+  for (std::size_t c = 0; c < markers.size(); ++c)
+  {
+    if (markers[c] == marker)
+      cells.push_back(c);
+  }
+
+  reassemble(A, plan, cells);
+}
+//-----------------------------------------------------------------------------
+void Assembler::reassemble(GenericTensor& A, AssemblyPlan& plan)
+{
+  if (!init_reassembly(A, plan))
+    return;
+
+  // Reassemble over cells with changed cell data
+  reassemble_cells(A, plan, NULL);
+
+  // Finalize assembly of global tensor
+  if (finalize_tensor)
+    A.apply("add");
+}
+//-----------------------------------------------------------------------------
 void Assembler::assemble_cells(
   GenericTensor& A,
   const Form& a,
@@ -131,6 +257,22 @@ void Assembler::assemble_cells(
   // Set timer
   Timer timer("Assemble cells");
 
+  // Use blocked assembly if requested
+  const int block_size = parameters["assembly_cell_block_size"];
+  if (block_size < 0)
+  {
+    dolfin_error("Assembler.cpp",
+                 "assemble cells",
+                 "Parameter \"assembly_cell_block_size\" must be non-negative (got %d)",
+                 block_size);
+  }
+  if (block_size > 1)
+  {
+    assemble_cells_blocked(A, a, ufc, domains, values,
+                           (std::size_t) block_size);
+    return;
+  }
+
   // Extract mesh
   const Mesh& mesh = a.mesh();
 
@@ -154,6 +296,14 @@ void Assembler::assemble_cells(
   // Check whether integral is domain-dependent
   bool use_domains = domains && !domains->empty();
 
+  // Cache tensors of congruent cells if requested
+  std::unique_ptr<CellTensorCache> cache;
+  if (dolfin::parameters["assembly_cache_cell_tensors"]
+      && CellTensorCache::supported(mesh))
+  {
+    cache.reset(new CellTensorCache(a, ufc.A.size()));
+  }
+
   // Assemble over cells
   ufc::cell ufc_cell;
   std::vector<double> coordinate_dofs;
@@ -190,10 +340,17 @@ void Assembler::assemble_cells(
     if (empty_dofmap)
       continue;
 
-    // Tabulate cell tensor
-    integral->tabulate_tensor(ufc.A.data(), ufc.w(),
-                              coordinate_dofs.data(),
-                              ufc_cell.orientation);
+    // Tabulate cell tensor (unless cached)
+    if (!cache || !cache->find(*integral, coordinate_dofs.data(),
+                               ufc_cell.orientation, ufc, ufc.w(),
+                               ufc.A.data()))
+    {
+      integral->tabulate_tensor(ufc.A.data(), ufc.w(),
+                                coordinate_dofs.data(),
+                                ufc_cell.orientation);
+      if (cache)
+        cache->insert(ufc.A.data());
+    }
 
     // Add entries to global tensor. Either store values cell-by-cell
     // (currently only available for functionals)
@@ -204,6 +361,246 @@ void Assembler::assemble_cells(
 
     p++;
   }
+
+  // Report cache hits and misses
+  if (cache)
+    cache->register_timings();
+}
+//-----------------------------------------------------------------------------
+void Assembler::assemble_cells(GenericTensor& A, AssemblyPlan& plan)
+{
+  UFC& ufc = plan.ufc();
+
+  // Skip assembly if there are no cell integrals
+  if (!ufc.form.has_cell_integrals())
+    return;
+
+  // Set timer
+  Timer timer("Assemble cells");
+
+  // Extract mesh
+  const Mesh& mesh = plan.form().mesh();
+
+  // Form rank
+  const std::size_t form_rank = ufc.form.rank();
+
+  // Vector to hold dof map for a cell
+  std::vector<ArrayView<const dolfin::la_index>> dofs(form_rank);
+
+  // Values of tensor if plan supports direct insertion
+  double* values = plan.values();
+  const std::size_t tensor_size = plan.tensor_size();
+
+  // Keep cell tensors for incremental reassembly if requested
+  const bool keep_cell_tensors = plan.keeps_cell_tensors();
+  if (keep_cell_tensors)
+    plan.init_cell_tensors();
+
+  // Assemble over planned cells, one cell integral at a time
+  ufc::cell ufc_cell;
+  std::vector<double> coordinate_dofs;
+  Progress p(AssemblerBase::progress_message(A.rank(), "cells"),
+             plan.num_cells());
+  for (std::size_t i = 0; i < plan.num_cell_integrals(); ++i)
+  {
+    const ufc::cell_integral* integral = plan.cell_integral(i);
+    const std::pair<std::size_t, std::size_t> range = plan.cell_range(i);
+    for (std::size_t k = range.first; k < range.second; ++k)
+    {
+      // Update to current cell
+      const Cell cell(mesh, plan.cell(k));
+      cell.get_cell_data(ufc_cell);
+      cell.get_coordinate_dofs(coordinate_dofs);
+      ufc.update(cell, coordinate_dofs, ufc_cell,
+                 integral->enabled_coefficients());
+
+      // Tabulate cell tensor
+      integral->tabulate_tensor(ufc.A.data(), ufc.w(),
+                                coordinate_dofs.data(),
+                                ufc_cell.orientation);
+
+      // Keep cell tensor and cell data
+      if (keep_cell_tensors)
+      {
+        store_cell_data(plan.cell_data(k), plan, coordinate_dofs, ufc,
+                        integral->enabled_coefficients());
+        std::copy(ufc.A.begin(), ufc.A.end(), plan.cell_tensor(k));
+      }
+
+      // Add entries to global tensor, directly into the tensor
+      // storage if possible
+      if (values)
+      {
+        const dolfin::la_index* positions = plan.positions(k);
+        for (std::size_t j = 0; j < tensor_size; ++j)
+          values[positions[j]] += ufc.A[j];
+      }
+      else
+      {
+        for (std::size_t j = 0; j < form_rank; ++j)
+          dofs[j] = plan.cell_dofs(j, k);
+        A.add_local(ufc.A.data(), dofs);
+      }
+
+      p++;
+    }
+  }
+}
+//-----------------------------------------------------------------------------
+void Assembler::assemble_cells_blocked(
+  GenericTensor& A,
+  const Form& a,
+  UFC& ufc,
+  std::shared_ptr<const MeshFunction<std::size_t>> domains,
+  std::vector<double>* values,
+  std::size_t block_size)
+{
+  dolfin_assert(block_size > 0);
+
+  // Extract mesh
+  const Mesh& mesh = a.mesh();
+  const std::size_t num_cells = mesh.num_cells();
+
+  // Form rank and number of coefficients
+  const std::size_t form_rank = ufc.form.rank();
+  const std::size_t num_coefficients = ufc.form.num_coefficients();
+
+  // Check if form is a functional
+  const bool is_cell_functional = (values && form_rank == 0) ? true : false;
+
+  // Collect pointers to dof maps
+  std::vector<const GenericDofMap*> dofmaps;
+  for (std::size_t i = 0; i < form_rank; ++i)
+    dofmaps.push_back(a.function_space(i)->dofmap().get());
+
+  // Check whether integral is domain-dependent
+  bool use_domains = domains && !domains->empty();
+
+  // Number of coordinate dofs and tensor entries per cell
+  const MeshGeometry& geometry = mesh.geometry();
+  std::size_t num_coordinate_dofs = mesh.type().num_vertices();
+  if (geometry.degree() == 2)
+    num_coordinate_dofs += mesh.type().num_entities(1);
+  num_coordinate_dofs *= geometry.dim();
+  const std::size_t tensor_size = ufc.A.size();
+
+  // Staging buffers for a block of cells. Coordinate dofs and cell
+  // tensors are stored contiguously cell by cell, while each
+  // coefficient is stored in its own contiguous array over the block.
+  std::vector<double> coordinate_dofs_block(block_size*num_coordinate_dofs);
+  std::vector<double> A_block(block_size*tensor_size);
+  std::vector<std::vector<double>> w_block(num_coefficients);
+  std::vector<double*> w_pointers(block_size*num_coefficients);
+  for (std::size_t i = 0; i < num_coefficients; ++i)
+  {
+    const std::size_t dim = ufc.coefficient_dimension(i);
+    w_block[i].resize(block_size*dim);
+    for (std::size_t k = 0; k < block_size; ++k)
+      w_pointers[k*num_coefficients + i] = w_block[i].data() + k*dim;
+  }
+  std::vector<const ufc::cell_integral*> integrals(block_size);
+  std::vector<int> orientations(block_size);
+  std::vector<std::size_t> cell_indices(block_size);
+  std::vector<std::vector<ArrayView<const dolfin::la_index>>>
+    dofs(block_size, std::vector<ArrayView<const dolfin::la_index>>(form_rank));
+
+  // Cache tensors of congruent cells if requested
+  std::unique_ptr<CellTensorCache> cache;
+  if (dolfin::parameters["assembly_cache_cell_tensors"]
+      && CellTensorCache::supported(mesh))
+  {
+    cache.reset(new CellTensorCache(a, tensor_size));
+  }
+
+  // Assemble over blocks of cells
+  ufc::cell ufc_cell;
+  std::vector<double> coordinate_dofs;
+  Progress p(AssemblerBase::progress_message(A.rank(), "cells"), num_cells);
+  for (std::size_t first = 0; first < num_cells; first += block_size)
+  {
+    const std::size_t last = std::min(first + block_size, num_cells);
+
+    // Gather cell data for block
+    std::size_t n = 0;
+    for (std::size_t c = first; c < last; ++c)
+    {
+      const Cell cell(mesh, c);
+
+      // Get integral for sub domain (if any)
+      ufc::cell_integral* integral = ufc.default_cell_integral.get();
+      if (use_domains)
+        integral = ufc.get_cell_integral((*domains)[cell]);
+
+      // Skip if no integral on current domain
+      if (!integral)
+        continue;
+
+      // Check that cell is not a ghost
+      dolfin_assert(!cell.is_ghost());
+
+      // Get local-to-global dof maps for cell
+      bool empty_dofmap = false;
+      for (std::size_t i = 0; i < form_rank; ++i)
+      {
+        dofs[n][i] = dofmaps[i]->cell_dofs(c);
+        empty_dofmap = empty_dofmap || dofs[n][i].size() == 0;
+      }
+
+      // Skip if at least one dofmap is empty
+      if (empty_dofmap)
+        continue;
+
+      // Copy coordinate dofs into block
+      cell.get_cell_data(ufc_cell);
+      cell.get_coordinate_dofs(coordinate_dofs);
+      dolfin_assert(coordinate_dofs.size() == num_coordinate_dofs);
+      std::copy(coordinate_dofs.begin(), coordinate_dofs.end(),
+                coordinate_dofs_block.begin() + n*num_coordinate_dofs);
+
+      // Restrict coefficients into block
+      ufc.restrict_coefficients(cell, coordinate_dofs.data(), ufc_cell,
+                                integral->enabled_coefficients(),
+                                w_pointers.data() + n*num_coefficients);
+
+      integrals[n] = integral;
+      orientations[n] = ufc_cell.orientation;
+      cell_indices[n] = c;
+      ++n;
+
+      p++;
+    }
+
+    // Tabulate cell tensors for block (unless cached)
+    for (std::size_t k = 0; k < n; ++k)
+    {
+      double* A_cell = A_block.data() + k*tensor_size;
+      double** w_cell = w_pointers.data() + k*num_coefficients;
+      const double* coordinate_dofs_cell
+        = coordinate_dofs_block.data() + k*num_coordinate_dofs;
+      if (!cache || !cache->find(*integrals[k], coordinate_dofs_cell,
+                                 orientations[k], ufc, w_cell, A_cell))
+      {
+        integrals[k]->tabulate_tensor(A_cell, w_cell, coordinate_dofs_cell,
+                                      orientations[k]);
+        if (cache)
+          cache->insert(A_cell);
+      }
+    }
+
+    // Add entries to global tensor. Either store values cell-by-cell
+    // (currently only available for functionals)
+    if (is_cell_functional)
+    {
+      for (std::size_t k = 0; k < n; ++k)
+        (*values)[cell_indices[k]] = A_block[k*tensor_size];
+    }
+    else if (n > 0)
+      A.add_local_batch(A_block.data(), tensor_size, n, dofs);
+  }
+
+  // Report cache hits and misses
+  if (cache)
+    cache->register_timings();
 }
 //-----------------------------------------------------------------------------
 void Assembler::assemble_exterior_facets(
@@ -691,3 +1088,129 @@ void Assembler::assemble_vertices(
   }
 }
 //-----------------------------------------------------------------------------
+bool Assembler::init_reassembly(GenericTensor& A, AssemblyPlan& plan)
+{
+  if (!plan.keeps_cell_tensors())
+  {
+    dolfin_error("Assembler.cpp",
+                 "reassemble tensor",
+                 "Assembly plan does not keep cell tensors (see AssemblyPlan::keep_cell_tensors)");
+  }
+
+  // Check that form has no other integrals than cell integrals
+  const ufc::form& form = plan.ufc().form;
+  if (form.has_exterior_facet_integrals()
+      || form.has_interior_facet_integrals()
+      || form.has_vertex_integrals() || form.has_custom_integrals())
+  {
+    dolfin_error("Assembler.cpp",
+                 "reassemble tensor",
+                 "Incremental reassembly is only supported for forms with cell integrals only");
+  }
+
+  // Assemble in full if no cell tensors are available
+  if (plan.update() || !plan.has_cell_tensors() || A.empty())
+  {
+    assemble(A, plan);
+    return false;
+  }
+
+  return true;
+}
+//-----------------------------------------------------------------------------
+void Assembler::reassemble_cells(GenericTensor& A, AssemblyPlan& plan,
+                                 const std::vector<std::size_t>* cells)
+{
+  // Set timer
+  Timer timer("Reassemble cells");
+
+  UFC& ufc = plan.ufc();
+  const Mesh& mesh = plan.form().mesh();
+  const std::size_t form_rank = ufc.form.rank();
+
+  // Vector to hold dof map for a cell
+  std::vector<ArrayView<const dolfin::la_index>> dofs(form_rank);
+
+  // Bind plan to tensor for direct insertion
+  plan.bind(A);
+  double* values = plan.values();
+  const std::size_t tensor_size = plan.tensor_size();
+
+  // Difference between new and kept cell tensor
+  std::vector<double> A_diff(tensor_size);
+
+  // Reassemble over planned cells, one cell integral at a time
+  std::size_t num_reassembled = 0;
+  ufc::cell ufc_cell;
+  std::vector<double> coordinate_dofs;
+  for (std::size_t i = 0; i < plan.num_cell_integrals(); ++i)
+  {
+    const ufc::cell_integral* integral = plan.cell_integral(i);
+    const std::vector<bool>& enabled_coefficients
+      = integral->enabled_coefficients();
+
+    // Range of cells to visit, as positions in the plan or in the
+    // list of given cells
+    std::pair<std::size_t, std::size_t> range = plan.cell_range(i);
+    if (cells)
+    {
+      range.first = std::lower_bound(cells->begin(), cells->end(),
+                                     range.first) - cells->begin();
+      range.second = std::lower_bound(cells->begin(), cells->end(),
+                                      range.second) - cells->begin();
+    }
+
+    for (std::size_t n = range.first; n < range.second; ++n)
+    {
+      const std::size_t k = cells ? (*cells)[n] : n;
+
+      // Update to current cell
+      const Cell cell(mesh, plan.cell(k));
+      cell.get_cell_data(ufc_cell);
+      cell.get_coordinate_dofs(coordinate_dofs);
+      ufc.update(cell, coordinate_dofs, ufc_cell, enabled_coefficients);
+
+      // Store new cell data, skipping unchanged cells unless the
+      // cells are given
+      const bool changed = store_cell_data(plan.cell_data(k), plan,
+                                           coordinate_dofs, ufc,
+                                           enabled_coefficients);
+      if (!cells && !changed)
+        continue;
+
+      // Tabulate cell tensor
+      integral->tabulate_tensor(ufc.A.data(), ufc.w(),
+                                coordinate_dofs.data(),
+                                ufc_cell.orientation);
+
+      // Compute difference to kept cell tensor and keep new tensor
+      double* A_kept = plan.cell_tensor(k);
+      for (std::size_t j = 0; j < tensor_size; ++j)
+      {
+        A_diff[j] = ufc.A[j] - A_kept[j];
+        A_kept[j] = ufc.A[j];
+      }
+
+      // Add difference to global tensor
+      if (values)
+      {
+        const dolfin::la_index* positions = plan.positions(k);
+        for (std::size_t j = 0; j < tensor_size; ++j)
+          values[positions[j]] += A_diff[j];
+      }
+      else
+      {
+        for (std::size_t j = 0; j < form_rank; ++j)
+          dofs[j] = plan.cell_dofs(j, k);
+        A.add_local(A_diff.data(), dofs);
+      }
+
+      ++num_reassembled;
+    }
+  }
+  plan.release();
+
+  log(TRACE, "Reassembled %d of %d planned cells.", num_reassembled,
+      plan.num_cells());
+}
+//-----------------------------------------------------------------------------
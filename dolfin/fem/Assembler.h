@@ -30,6 +30,7 @@ namespace dolfin
 {
 
   // Forward declarations
+  class AssemblyPlan;
   class GenericTensor;
   class Form;
   class UFC;
@@ -48,6 +49,15 @@ namespace dolfin
   ///        form.dx = cell_domains
   ///        form.ds = exterior_facet_domains
   ///        form.dS = interior_facet_domains
+  ///
+  /// If the global parameter "assembly_cell_block_size" is larger
+  /// than one, cells are assembled in blocks of that many cells.
+  ///
+  /// If the global parameter "assembly_cache_cell_tensors" is set,
+  /// tensors of translation invariant cell integrals are cached and
+  /// reused for congruent cells of affine simplex meshes (see
+  /// _CellTensorCache_), both cell by cell and in blocks. The numbers
+  /// of cache hits and misses are reported in the timing table.
 
   class Assembler : public AssemblerBase
   {
@@ -65,6 +75,74 @@ namespace dolfin
     ///         The form to assemble the tensor from.
     void assemble(GenericTensor& A, const Form& a);
 
+    /// Assemble tensor from the form of an assembly plan, reusing
+    /// the data stored in the plan. This is intended for repeated
+    /// assembly of the same form.
+    ///
+    /// *Arguments*
+    ///     A (_GenericTensor_)
+    ///         The tensor to assemble.
+    ///     plan (_AssemblyPlan_)
+    ///         The assembly plan of the form to assemble.
+    void assemble(GenericTensor& A, AssemblyPlan& plan);
+
+    /// Reassemble tensor incrementally on given cells. The cell
+    /// tensors kept by the plan from the last assembly with the plan
+    /// are subtracted from the tensor and the new cell tensors are
+    /// added, reusing the sparsity of the tensor. This is intended
+    /// for forms whose coefficients change only on part of the mesh.
+    ///
+    /// The plan must keep cell tensors (see
+    /// AssemblyPlan::keep_cell_tensors) and the form may only have
+    /// cell integrals. If the plan holds no cell tensors (or has been
+    /// rebuilt), the tensor is assembled in full.
+    ///
+    /// Changes made to the tensor after assembly, such as by
+    /// DirichletBC::apply, are not undone: rows modified by boundary
+    /// conditions also receive the change of the cell tensors, so
+    /// boundary conditions must be applied again after reassembly.
+    /// This restores the rows set by DirichletBC::apply, while the
+    /// other rows hold the reassembled values. Tensors whose columns
+    /// were modified (e.g. by SystemAssembler) cannot be reassembled
+    /// incrementally.
+    ///
+    /// *Arguments*
+    ///     A (_GenericTensor_)
+    ///         The tensor to reassemble.
+    ///     plan (_AssemblyPlan_)
+    ///         The assembly plan of the form.
+    ///     cells (std::vector<std::size_t>)
+    ///         The (local) indices of the cells to reassemble.
+    void reassemble(GenericTensor& A, AssemblyPlan& plan,
+                    const std::vector<std::size_t>& cells);
+
+    /// Reassemble tensor incrementally on cells with given marker
+    ///
+    /// *Arguments*
+    ///     A (_GenericTensor_)
+    ///         The tensor to reassemble.
+    ///     plan (_AssemblyPlan_)
+    ///         The assembly plan of the form.
+    ///     markers (_MeshFunction_ <std::size_t>)
+    ///         Cell markers.
+    ///     marker (std::size_t)
+    ///         The marker of the cells to reassemble.
+    void reassemble(GenericTensor& A, AssemblyPlan& plan,
+                    const MeshFunction<std::size_t>& markers,
+                    std::size_t marker);
+
+    /// Reassemble tensor incrementally on all cells whose coordinate
+    /// dofs or coefficient values have changed since the last
+    /// assembly with the plan. Changed cells are detected by
+    /// comparing to the cell data kept by the plan.
+    ///
+    /// *Arguments*
+    ///     A (_GenericTensor_)
+    ///         The tensor to reassemble.
+    ///     plan (_AssemblyPlan_)
+    ///         The assembly plan of the form.
+    void reassemble(GenericTensor& A, AssemblyPlan& plan);
+
     /// Assemble tensor from given form over cells. This function is
     /// provided for users who wish to build a customized assembler.
     void assemble_cells(GenericTensor& A, const Form& a, UFC& ufc,
@@ -93,6 +171,28 @@ namespace dolfin
     void assemble_vertices(GenericTensor& A, const Form& a, UFC& ufc,
                            std::shared_ptr<const MeshFunction<std::size_t> > domains);
 
+  private:
+
+    // Assemble over cells using precomputed data in assembly plan
+    void assemble_cells(GenericTensor& A, AssemblyPlan& plan);
+
+    // Prepare incremental reassembly with plan. Returns false if the
+    // tensor has been assembled in full instead.
+    bool init_reassembly(GenericTensor& A, AssemblyPlan& plan);
+
+    // Reassemble given planned cells (sorted), or all planned cells
+    // with changed cell data if cells is null
+    void reassemble_cells(GenericTensor& A, AssemblyPlan& plan,
+                          const std::vector<std::size_t>* cells);
+
+    // Assemble over cells in blocks of block_size cells. Coordinate
+    // dofs and coefficients are gathered for the whole block before
+    // tabulation, and the block is added to the tensor in one call.
+    void assemble_cells_blocked(GenericTensor& A, const Form& a, UFC& ufc,
+                                std::shared_ptr<const MeshFunction<std::size_t> > domains,
+                                std::vector<double>* values,
+                                std::size_t block_size);
+
   };
 
 }
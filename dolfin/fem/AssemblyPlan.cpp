@@ -0,0 +1,384 @@
+// Copyright (C) 2016 The FEniCS Project
+//
+// This file is part of DOLFIN.
+//
+// DOLFIN is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// DOLFIN is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with DOLFIN. If not, see <http://www.gnu.org/licenses/>.
+//
+// First added:  2016-10-18
+// Last changed: 2016-10-18
+
+#include <algorithm>
+#include <dolfin/common/MPI.h>
+#include <dolfin/common/NoDeleter.h>
+#include <dolfin/common/Timer.h>
+#include <dolfin/function/FunctionSpace.h>
+#include <dolfin/function/GenericFunction.h>
+#include <dolfin/la/EigenMatrix.h>
+#include <dolfin/la/GenericTensor.h>
+#include <dolfin/la/PETScMatrix.h>
+#include <dolfin/log/log.h>
+#include <dolfin/mesh/Cell.h>
+#include <dolfin/mesh/Mesh.h>
+#include <dolfin/mesh/MeshFunction.h>
+#include "Form.h"
+#include "GenericDofMap.h"
+#include "UFC.h"
+#include "AssemblyPlan.h"
+
+using namespace dolfin;
+
+//-----------------------------------------------------------------------------
+AssemblyPlan::AssemblyPlan(std::shared_ptr<const Form> a)
+  : _form(a), _mesh_id(0), _num_mesh_cells(0), _tensor_size(0),
+    _tensor_id(0), _tensor_nnz(0), _tensor_columns(NULL), _values(NULL),
+    _petsc_matrix(NULL), _keep_cell_tensors(false), _has_cell_tensors(false)
+{
+  dolfin_assert(_form);
+  build();
+}
+//-----------------------------------------------------------------------------
+AssemblyPlan::AssemblyPlan(const Form& a)
+  : _form(reference_to_no_delete_pointer(a)), _mesh_id(0),
+    _num_mesh_cells(0), _tensor_size(0), _tensor_id(0), _tensor_nnz(0),
+    _tensor_columns(NULL), _values(NULL), _petsc_matrix(NULL),
+    _keep_cell_tensors(false), _has_cell_tensors(false)
+{
+  build();
+}
+//-----------------------------------------------------------------------------
+AssemblyPlan::~AssemblyPlan()
+{
+  release();
+}
+//-----------------------------------------------------------------------------
+bool AssemblyPlan::update()
+{
+  const Mesh& mesh = _form->mesh();
+  bool changed = mesh.id() != _mesh_id
+    || mesh.num_cells() != _num_mesh_cells
+    || _form->cell_domains() != _cell_domains
+    || _form->coefficients() != _coefficients;
+  for (std::size_t i = 0; i < _dofmaps.size(); ++i)
+    changed = changed || _form->function_space(i)->dofmap().get() != _dofmaps[i];
+
+  if (changed)
+    build();
+
+  return changed;
+}
+//-----------------------------------------------------------------------------
+bool AssemblyPlan::bind(GenericTensor& A)
+{
+  release();
+
+  // Direct insertion is only supported for matrices
+  if (A.rank() != 2)
+  {
+    _values = NULL;
+    return false;
+  }
+
+  // Direct insertion into EigenMatrix compressed row storage
+  EigenMatrix* eigen_matrix = dynamic_cast<EigenMatrix*>(A.instance());
+  if (eigen_matrix)
+  {
+    eigen_matrix->compress();
+    EigenMatrix::eigen_matrix_type& mat = eigen_matrix->mat();
+
+    // Reuse positions if matrix is unchanged since last call
+    const std::size_t nnz = mat.nonZeros();
+    _values = mat.valuePtr();
+    if (eigen_matrix->id() == _tensor_id && nnz == _tensor_nnz
+        && mat.innerIndexPtr() == _tensor_columns)
+    {
+      return true;
+    }
+
+    Timer timer("Compute assembly plan positions");
+    if (compute_positions(mat.outerIndexPtr(), mat.innerIndexPtr()))
+    {
+      _tensor_id = eigen_matrix->id();
+      _tensor_nnz = nnz;
+      _tensor_columns = mat.innerIndexPtr();
+      return true;
+    }
+  }
+
+  #ifdef HAS_PETSC
+  // Direct insertion into the value array of a sequential PETSc AIJ
+  // matrix whose nonzero structure has been set up
+  PETScMatrix* petsc_matrix = dynamic_cast<PETScMatrix*>(A.instance());
+  if (petsc_matrix && petsc_matrix->mat()
+      && MPI::size(petsc_matrix->mpi_comm()) == 1)
+  {
+    Mat mat = petsc_matrix->mat();
+    PetscBool is_seqaij = PETSC_FALSE, assembled = PETSC_FALSE;
+    PetscObjectTypeCompare((PetscObject) mat, MATSEQAIJ, &is_seqaij);
+    MatAssembled(mat, &assembled);
+
+    PetscInt n = 0;
+    const PetscInt* row_ptr = NULL;
+    const PetscInt* cols = NULL;
+    PetscBool done = PETSC_FALSE;
+    if (is_seqaij && assembled)
+      MatGetRowIJ(mat, 0, PETSC_FALSE, PETSC_FALSE, &n, &row_ptr, &cols, &done);
+
+    if (done)
+    {
+      // Reuse positions if matrix is unchanged since last call
+      const std::size_t nnz = row_ptr[n];
+      bool found = petsc_matrix->id() == _tensor_id && nnz == _tensor_nnz
+        && cols == _tensor_columns;
+      if (!found)
+      {
+        Timer timer("Compute assembly plan positions");
+        found = compute_positions(row_ptr, cols);
+      }
+      MatRestoreRowIJ(mat, 0, PETSC_FALSE, PETSC_FALSE, &n, &row_ptr, &cols,
+                      &done);
+
+      if (found)
+      {
+        _tensor_id = petsc_matrix->id();
+        _tensor_nnz = nnz;
+        _tensor_columns = cols;
+
+        PetscScalar* values = NULL;
+        PetscErrorCode ierr = MatSeqAIJGetArray(mat, &values);
+        if (ierr != 0)
+          PETScObject::petsc_error(ierr, __FILE__, "MatSeqAIJGetArray");
+        _values = values;
+        _petsc_matrix = petsc_matrix;
+        return true;
+      }
+    }
+  }
+  #endif
+
+  // Fall back to insertion through the GenericTensor interface
+  _tensor_id = 0;
+  _tensor_nnz = 0;
+  _tensor_columns = NULL;
+  _values = NULL;
+  _positions.clear();
+
+  return false;
+}
+//-----------------------------------------------------------------------------
+void AssemblyPlan::release()
+{
+  #ifdef HAS_PETSC
+  if (_petsc_matrix)
+  {
+    PetscScalar* values = _values;
+    PetscErrorCode ierr = MatSeqAIJRestoreArray(_petsc_matrix->mat(), &values);
+    if (ierr != 0)
+      PETScObject::petsc_error(ierr, __FILE__, "MatSeqAIJRestoreArray");
+    _petsc_matrix = NULL;
+  }
+  #endif
+
+  _values = NULL;
+}
+//-----------------------------------------------------------------------------
+void AssemblyPlan::keep_cell_tensors(bool keep)
+{
+  _keep_cell_tensors = keep;
+  if (!keep)
+  {
+    _has_cell_tensors = false;
+    std::vector<double>().swap(_cell_tensors);
+    std::vector<double>().swap(_cell_data);
+  }
+}
+//-----------------------------------------------------------------------------
+void AssemblyPlan::init_cell_tensors()
+{
+  dolfin_assert(_keep_cell_tensors);
+  _cell_tensors.resize(_cells.size()*_tensor_size);
+  _cell_data.resize(_cells.size()*_coefficient_offsets.back());
+  _has_cell_tensors = true;
+}
+//-----------------------------------------------------------------------------
+void AssemblyPlan::build()
+{
+  Timer timer("Build assembly plan");
+
+  const Form& a = *_form;
+  const Mesh& mesh = a.mesh();
+  const std::size_t form_rank = a.rank();
+
+  // Create UFC data for form
+  _ufc.reset(new UFC(a));
+
+  // Store data used to detect changes
+  _mesh_id = mesh.id();
+  _num_mesh_cells = mesh.num_cells();
+  _cell_domains = a.cell_domains();
+  _coefficients = a.coefficients();
+  _dofmaps.resize(form_rank);
+  for (std::size_t i = 0; i < form_rank; ++i)
+    _dofmaps[i] = a.function_space(i)->dofmap().get();
+
+  // Number of dofs per cell along each dimension
+  _num_element_dofs.resize(form_rank);
+  _tensor_size = 1;
+  for (std::size_t i = 0; i < form_rank; ++i)
+  {
+    _num_element_dofs[i] = _dofmaps[i]->max_element_dofs();
+    _tensor_size *= _num_element_dofs[i];
+  }
+
+  // Reset bound tensor
+  release();
+  _tensor_id = 0;
+  _tensor_nnz = 0;
+  _tensor_columns = NULL;
+  _positions.clear();
+
+  // Look up cell integral for each cell, numbering the integrals in
+  // the order they are first encountered
+  const bool use_domains = _cell_domains && !_cell_domains->empty();
+  _cell_integrals.clear();
+  std::vector<int> cell_to_integral(mesh.num_cells(), -1);
+  std::vector<std::size_t> num_cells_per_integral;
+  if (_ufc->form.has_cell_integrals())
+  {
+    for (CellIterator cell(mesh); !cell.end(); ++cell)
+    {
+      // Get integral for sub domain (if any)
+      const ufc::cell_integral* integral
+        = _ufc->default_cell_integral.get();
+      if (use_domains)
+        integral = _ufc->get_cell_integral((*_cell_domains)[*cell]);
+
+      // Skip if no integral on current domain
+      if (!integral)
+        continue;
+
+      // Skip cells with empty dofmap
+      bool empty_dofmap = false;
+      for (std::size_t i = 0; i < form_rank; ++i)
+      {
+        const std::size_t num_dofs = _dofmaps[i]->num_element_dofs(cell->index());
+        empty_dofmap = empty_dofmap || num_dofs == 0;
+        if (num_dofs != 0 && num_dofs != _num_element_dofs[i])
+        {
+          dolfin_error("AssemblyPlan.cpp",
+                       "build assembly plan",
+                       "Number of cell dofs varies between cells");
+        }
+      }
+      if (empty_dofmap)
+        continue;
+
+      // Find integral in dispatch table
+      std::size_t pos
+        = std::find(_cell_integrals.begin(), _cell_integrals.end(), integral)
+        - _cell_integrals.begin();
+      if (pos == _cell_integrals.size())
+      {
+        _cell_integrals.push_back(integral);
+        num_cells_per_integral.push_back(0);
+      }
+      cell_to_integral[cell->index()] = pos;
+      ++num_cells_per_integral[pos];
+    }
+  }
+
+  // Compute offsets into cell list for each integral
+  _cell_offsets.assign(_cell_integrals.size() + 1, 0);
+  for (std::size_t i = 0; i < _cell_integrals.size(); ++i)
+    _cell_offsets[i + 1] = _cell_offsets[i] + num_cells_per_integral[i];
+
+  // Bucket cells by integral, preserving mesh order within each
+  // bucket
+  _cells.resize(_cell_offsets.back());
+  _plan_index.assign(mesh.num_cells(), -1);
+  std::vector<std::size_t> insert_pos(_cell_offsets.begin(),
+                                      _cell_offsets.end() - 1);
+  for (std::size_t c = 0; c < cell_to_integral.size(); ++c)
+  {
+    if (cell_to_integral[c] < 0)
+      continue;
+    const std::size_t k = insert_pos[cell_to_integral[c]]++;
+    _cells[k] = c;
+    _plan_index[c] = k;
+  }
+
+  // Compute layout of cell data (coordinate dofs followed by
+  // coefficient values) and discard kept cell tensors
+  std::vector<double> coordinate_dofs;
+  if (!_cells.empty())
+    Cell(mesh, _cells[0]).get_coordinate_dofs(coordinate_dofs);
+  const std::size_t num_coefficients = _ufc->form.num_coefficients();
+  _coefficient_offsets.assign(1, coordinate_dofs.size());
+  for (std::size_t i = 0; i < num_coefficients; ++i)
+  {
+    _coefficient_offsets.push_back(_coefficient_offsets.back()
+                                   + _ufc->coefficient_dimension(i));
+  }
+  _has_cell_tensors = false;
+  _cell_tensors.clear();
+  _cell_data.clear();
+
+  // Copy dofs of planned cells into contiguous arrays
+  _dofs.resize(form_rank);
+  for (std::size_t i = 0; i < form_rank; ++i)
+  {
+    const std::size_t n = _num_element_dofs[i];
+    _dofs[i].resize(_cells.size()*n);
+    for (std::size_t k = 0; k < _cells.size(); ++k)
+    {
+      const ArrayView<const dolfin::la_index> dofs
+        = _dofmaps[i]->cell_dofs(_cells[k]);
+      std::copy(dofs.data(), dofs.data() + n, _dofs[i].begin() + k*n);
+    }
+  }
+}
+//-----------------------------------------------------------------------------
+template<typename T>
+bool AssemblyPlan::compute_positions(const T* row_ptr, const T* cols)
+{
+  dolfin_assert(_dofs.size() == 2);
+  const std::size_t m = _num_element_dofs[0];
+  const std::size_t n = _num_element_dofs[1];
+
+  _positions.resize(_cells.size()*_tensor_size);
+  for (std::size_t k = 0; k < _cells.size(); ++k)
+  {
+    const dolfin::la_index* rows = _dofs[0].data() + k*m;
+    const dolfin::la_index* columns = _dofs[1].data() + k*n;
+    dolfin::la_index* pos = _positions.data() + k*_tensor_size;
+    for (std::size_t i = 0; i < m; ++i)
+    {
+      const T* row_begin = cols + row_ptr[rows[i]];
+      const T* row_end = cols + row_ptr[rows[i] + 1];
+      for (std::size_t j = 0; j < n; ++j)
+      {
+        // Find column in (sorted) row
+        const T* entry = std::lower_bound(row_begin, row_end, columns[j]);
+        if (entry == row_end || *entry != columns[j])
+        {
+          _positions.clear();
+          return false;
+        }
+        pos[i*n + j] = entry - cols;
+      }
+    }
+  }
+
+  return true;
+}
+//-----------------------------------------------------------------------------
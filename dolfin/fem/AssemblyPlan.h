@@ -0,0 +1,244 @@
+// Copyright (C) 2016 The FEniCS Project
+//
+// This file is part of DOLFIN.
+//
+// DOLFIN is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// DOLFIN is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with DOLFIN. If not, see <http://www.gnu.org/licenses/>.
+//
+// First added:  2016-10-18
+// Last changed: 2016-10-18
+
+#ifndef __ASSEMBLY_PLAN_H
+#define __ASSEMBLY_PLAN_H
+
+#include <memory>
+#include <utility>
+#include <vector>
+#include <dolfin/common/ArrayView.h>
+#include <dolfin/common/types.h>
+
+namespace ufc
+{
+  class cell_integral;
+}
+
+namespace dolfin
+{
+
+  // Forward declarations
+  class Form;
+  class GenericDofMap;
+  class GenericFunction;
+  class GenericTensor;
+  class PETScMatrix;
+  class UFC;
+  template<typename T> class MeshFunction;
+
+  /// This class holds data that can be reused when the same form is
+  /// assembled many times, for example inside a time-stepping loop.
+  /// The plan keeps the UFC data for the form, the list of cells to
+  /// assemble grouped by cell integral (the dispatch table from
+  /// subdomains to integrals), and the dofs of each of these
+  /// cells. When bound to a matrix whose compressed row storage can
+  /// be accessed directly, the plan also computes the position of
+  /// each entry of each cell tensor in the matrix value array, so
+  /// that reassembly only needs to tabulate and add values.
+  ///
+  /// The plan is rebuilt automatically by update() if the mesh, the
+  /// dofmaps, the cell domains or the coefficient objects of the
+  /// form change.
+  ///
+  /// The plan can optionally keep the cell tensors of the last
+  /// assembly together with the cell data they were computed from,
+  /// which allows incremental reassembly of a subset of cells (see
+  /// Assembler::reassemble). Boundary conditions applied to the
+  /// tensor must be applied again after incremental reassembly.
+
+  class AssemblyPlan
+  {
+  public:
+
+    /// Create assembly plan for form
+    explicit AssemblyPlan(std::shared_ptr<const Form> a);
+
+    /// Create assembly plan for form
+    explicit AssemblyPlan(const Form& a);
+
+    /// Destructor
+    ~AssemblyPlan();
+
+    /// Rebuild plan if the form data it was built from has changed.
+    /// Returns true if the plan was rebuilt.
+    bool update();
+
+    /// Return form
+    const Form& form() const
+    { return *_form; }
+
+    /// Return UFC data for form
+    UFC& ufc()
+    { return *_ufc; }
+
+    /// Return number of cells in plan
+    std::size_t num_cells() const
+    { return _cells.size(); }
+
+    /// Return number of cell integrals in dispatch table
+    std::size_t num_cell_integrals() const
+    { return _cell_integrals.size(); }
+
+    /// Return cell integral i of dispatch table
+    const ufc::cell_integral* cell_integral(std::size_t i) const
+    { return _cell_integrals[i]; }
+
+    /// Return range [first, last) of planned cells that are
+    /// assembled with cell integral i
+    std::pair<std::size_t, std::size_t> cell_range(std::size_t i) const
+    { return std::make_pair(_cell_offsets[i], _cell_offsets[i + 1]); }
+
+    /// Return mesh index of planned cell k
+    std::size_t cell(std::size_t k) const
+    { return _cells[k]; }
+
+    /// Return dofs for planned cell k along dimension dim of the
+    /// tensor
+    ArrayView<const dolfin::la_index> cell_dofs(std::size_t dim,
+                                                std::size_t k) const
+    {
+      const std::size_t n = _num_element_dofs[dim];
+      return ArrayView<const dolfin::la_index>(n, _dofs[dim].data() + k*n);
+    }
+
+    /// Return number of entries in the tensor of a planned cell
+    std::size_t tensor_size() const
+    { return _tensor_size; }
+
+    /// Bind plan to tensor. If direct insertion into the storage of
+    /// the tensor is supported (serial EigenMatrix and PETScMatrix),
+    /// positions of all cell tensor entries are computed (or reused
+    /// if the tensor is unchanged since the last call). Returns true
+    /// if direct insertion is available.
+    bool bind(GenericTensor& A);
+
+    /// Release direct access to the storage of the bound tensor.
+    /// This must be called after insertion and before the tensor is
+    /// finalized.
+    void release();
+
+    /// Return pointer to values of the bound tensor if direct
+    /// insertion is available, otherwise a null pointer
+    double* values()
+    { return _values; }
+
+    /// Return pointer to positions in the value array of the bound
+    /// tensor for entries of the tensor of planned cell k
+    const dolfin::la_index* positions(std::size_t k) const
+    { return _positions.data() + k*_tensor_size; }
+
+    /// Return planned position of given cell, or -1 if the cell is
+    /// not in the plan
+    int plan_index(std::size_t cell_index) const
+    { return _plan_index[cell_index]; }
+
+    /// Keep cell tensors and the cell data (coordinate dofs and
+    /// values of coefficients) they were computed from during
+    /// assembly with the plan
+    void keep_cell_tensors(bool keep);
+
+    /// Return true if cell tensors are kept during assembly
+    bool keeps_cell_tensors() const
+    { return _keep_cell_tensors; }
+
+    /// Allocate storage for kept cell tensors and cell data. This is
+    /// called by the assembler before full assembly with the plan.
+    void init_cell_tensors();
+
+    /// Return true if kept cell tensors are available, i.e. the plan
+    /// has been used for full assembly since it was (re)built
+    bool has_cell_tensors() const
+    { return _has_cell_tensors; }
+
+    /// Return kept tensor of planned cell k
+    double* cell_tensor(std::size_t k)
+    { return _cell_tensors.data() + k*_tensor_size; }
+
+    /// Return kept cell data of planned cell k. The coordinate dofs
+    /// are followed by the values of each coefficient, starting at
+    /// coefficient_offset(i) for coefficient i.
+    double* cell_data(std::size_t k)
+    { return _cell_data.data() + k*_coefficient_offsets.back(); }
+
+    /// Return offset of coefficient i in kept cell data
+    std::size_t coefficient_offset(std::size_t i) const
+    { return _coefficient_offsets[i]; }
+
+  private:
+
+    // Build plan
+    void build();
+
+    // Compute positions in compressed row storage
+    template<typename T>
+    bool compute_positions(const T* row_ptr, const T* cols);
+
+    // The form
+    std::shared_ptr<const Form> _form;
+
+    // UFC data for form
+    std::unique_ptr<UFC> _ufc;
+
+    // Data the plan was built from, used to detect changes
+    std::size_t _mesh_id, _num_mesh_cells;
+    std::shared_ptr<const MeshFunction<std::size_t>> _cell_domains;
+    std::vector<const GenericDofMap*> _dofmaps;
+    std::vector<std::shared_ptr<const GenericFunction>> _coefficients;
+
+    // Cell integrals and offsets into _cells (dispatch table)
+    std::vector<const ufc::cell_integral*> _cell_integrals;
+    std::vector<std::size_t> _cell_offsets;
+
+    // Cells to assemble, grouped by integral
+    std::vector<std::size_t> _cells;
+
+    // Map from mesh cell index to position in _cells (-1 if absent)
+    std::vector<int> _plan_index;
+
+    // Dofs of planned cells for each tensor dimension
+    std::vector<std::size_t> _num_element_dofs;
+    std::vector<std::vector<dolfin::la_index>> _dofs;
+
+    // Number of entries in cell tensor
+    std::size_t _tensor_size;
+
+    // Bound tensor data. The column array identifies the storage
+    // the positions were computed for.
+    std::size_t _tensor_id, _tensor_nnz;
+    const void* _tensor_columns;
+    double* _values;
+    std::vector<dolfin::la_index> _positions;
+
+    // PETSc matrix whose value array is held between bind() and
+    // release()
+    PETScMatrix* _petsc_matrix;
+
+    // Kept cell tensors and cell data of planned cells
+    bool _keep_cell_tensors, _has_cell_tensors;
+    std::vector<std::size_t> _coefficient_offsets;
+    std::vector<double> _cell_tensors;
+    std::vector<double> _cell_data;
+
+  };
+
+}
+
+#endif
@@ -0,0 +1,230 @@
+// Copyright (C) 2016 The FEniCS Project
+//
+// This file is part of DOLFIN.
+//
+// DOLFIN is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// DOLFIN is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with DOLFIN. If not, see <http://www.gnu.org/licenses/>.
+//
+// First added:  2016-10-18
+// Last changed: 2016-10-18
+
+#ifdef HAS_OPENMP
+
+#include <algorithm>
+#include <dolfin/common/ArrayView.h>
+#include <dolfin/common/Timer.h>
+#include <dolfin/log/log.h>
+#include "GenericDofMap.h"
+#include "AssemblySchedule.h"
+
+using namespace dolfin;
+
+// Number of rows protected by one lock
+static const std::size_t rows_per_lock = 16;
+
+// Target size in bytes of the staging data for one block
+static const std::size_t block_cache_size = 256*1024;
+
+// Minimum number of blocks per thread, for load balancing
+static const std::size_t blocks_per_thread = 8;
+
+// Minimum number of coloured blocks (independent of the number of
+// threads, such that coloured assembly is reproducible)
+static const std::size_t min_num_colored_blocks = 64;
+
+//-----------------------------------------------------------------------------
+AssemblySchedule::AssemblySchedule(const std::vector<std::size_t>& entities,
+                                   const std::vector<std::size_t>& cells,
+                                   std::size_t cells_per_entity,
+                                   const GenericDofMap* row_dofmap,
+                                   std::size_t block_size,
+                                   std::size_t bytes_per_entity,
+                                   std::size_t num_threads,
+                                   bool colored)
+  : _block_size(block_size), _colored(colored)
+{
+  Timer timer("Build threaded assembly schedule");
+
+  dolfin_assert(cells.size() == entities.size()*cells_per_entity);
+  const std::size_t num_entities = entities.size();
+
+  // Choose block size such that the staging data of a block fits in
+  // cache, while keeping enough blocks to balance load between
+  // threads
+  if (_block_size == 0)
+  {
+    _block_size = std::max(block_cache_size/std::max(bytes_per_entity,
+                                                     (std::size_t) 1),
+                           (std::size_t) 1);
+    const std::size_t min_num_blocks
+      = colored ? min_num_colored_blocks : blocks_per_thread*num_threads;
+    if (num_entities < _block_size*min_num_blocks)
+      _block_size = std::max(num_entities/min_num_blocks, (std::size_t) 1);
+  }
+
+  // Partition entities into contiguous blocks
+  const std::size_t num_blocks = (num_entities + _block_size - 1)/_block_size;
+  _block_offsets.resize(num_blocks + 1);
+  for (std::size_t b = 0; b < num_blocks; ++b)
+    _block_offsets[b] = b*_block_size;
+  _block_offsets[num_blocks] = num_entities;
+
+  // Compute row chunks touched by each block
+  _lock_offsets.assign(num_blocks + 1, 0);
+  _block_locks.clear();
+  if (row_dofmap)
+    compute_block_locks(cells, cells_per_entity, *row_dofmap);
+
+  if (_colored)
+    color_blocks();
+  else
+  {
+    // Single colour holding all blocks
+    _color_offsets.assign(1, 0);
+    _color_offsets.push_back(num_blocks);
+    _colored_blocks.resize(num_blocks);
+    for (std::size_t b = 0; b < num_blocks; ++b)
+      _colored_blocks[b] = b;
+  }
+
+  // Create locks
+  if (!_colored)
+  {
+    std::size_t num_locks = 0;
+    if (!_block_locks.empty())
+    {
+      num_locks = *std::max_element(_block_locks.begin(),
+                                    _block_locks.end()) + 1;
+    }
+    _locks.resize(num_locks);
+    for (std::size_t i = 0; i < num_locks; ++i)
+      omp_init_lock(&_locks[i]);
+  }
+}
+//-----------------------------------------------------------------------------
+AssemblySchedule::~AssemblySchedule()
+{
+  for (std::size_t i = 0; i < _locks.size(); ++i)
+    omp_destroy_lock(&_locks[i]);
+}
+//-----------------------------------------------------------------------------
+void AssemblySchedule::lock(std::size_t b)
+{
+  if (_colored)
+    return;
+
+  // Locks are acquired in increasing order to avoid deadlock
+  for (std::size_t i = _lock_offsets[b]; i < _lock_offsets[b + 1]; ++i)
+    omp_set_lock(&_locks[_block_locks[i]]);
+}
+//-----------------------------------------------------------------------------
+void AssemblySchedule::unlock(std::size_t b)
+{
+  if (_colored)
+    return;
+
+  for (std::size_t i = _lock_offsets[b + 1]; i > _lock_offsets[b]; --i)
+    omp_unset_lock(&_locks[_block_locks[i - 1]]);
+}
+//-----------------------------------------------------------------------------
+void AssemblySchedule::compute_block_locks(
+  const std::vector<std::size_t>& cells,
+  std::size_t cells_per_entity,
+  const GenericDofMap& row_dofmap)
+{
+  const int num_blocks = this->num_blocks();
+  std::vector<std::vector<std::size_t>> locks(num_blocks);
+
+  // Collect sorted row chunks for each block
+  #pragma omp parallel for schedule(dynamic, 16)
+  for (int b = 0; b < num_blocks; ++b)
+  {
+    std::vector<std::size_t>& block_locks = locks[b];
+    const std::size_t first = _block_offsets[b]*cells_per_entity;
+    const std::size_t last = _block_offsets[b + 1]*cells_per_entity;
+    for (std::size_t i = first; i < last; ++i)
+    {
+      const ArrayView<const dolfin::la_index> dofs
+        = row_dofmap.cell_dofs(cells[i]);
+      for (std::size_t j = 0; j < dofs.size(); ++j)
+        block_locks.push_back(dofs[j]/rows_per_lock);
+    }
+    std::sort(block_locks.begin(), block_locks.end());
+    block_locks.erase(std::unique(block_locks.begin(), block_locks.end()),
+                      block_locks.end());
+  }
+
+  // Store in compressed form
+  for (int b = 0; b < num_blocks; ++b)
+    _lock_offsets[b + 1] = _lock_offsets[b] + locks[b].size();
+  _block_locks.resize(_lock_offsets.back());
+  for (int b = 0; b < num_blocks; ++b)
+  {
+    std::copy(locks[b].begin(), locks[b].end(),
+              _block_locks.begin() + _lock_offsets[b]);
+  }
+}
+//-----------------------------------------------------------------------------
+void AssemblySchedule::color_blocks()
+{
+  const std::size_t num_blocks = this->num_blocks();
+
+  // Number of row chunks
+  std::size_t num_chunks = 0;
+  if (!_block_locks.empty())
+  {
+    num_chunks = *std::max_element(_block_locks.begin(),
+                                   _block_locks.end()) + 1;
+  }
+
+  // Greedy colouring of blocks in order, which makes the colouring
+  // independent of the number of threads
+  std::vector<std::vector<std::size_t>> chunk_colors(num_chunks);
+  std::vector<std::size_t> block_color(num_blocks, 0);
+  std::vector<bool> used_colors;
+  std::size_t num_colors = num_blocks > 0 ? 1 : 0;
+  for (std::size_t b = 0; b < num_blocks; ++b)
+  {
+    // Mark colours of blocks sharing a row chunk with this block
+    used_colors.assign(num_colors + 1, false);
+    for (std::size_t i = _lock_offsets[b]; i < _lock_offsets[b + 1]; ++i)
+    {
+      const std::vector<std::size_t>& colors = chunk_colors[_block_locks[i]];
+      for (std::size_t j = 0; j < colors.size(); ++j)
+        used_colors[colors[j]] = true;
+    }
+
+    // Pick first free colour
+    const std::size_t c
+      = std::find(used_colors.begin(), used_colors.end(), false)
+      - used_colors.begin();
+    block_color[b] = c;
+    num_colors = std::max(num_colors, c + 1);
+    for (std::size_t i = _lock_offsets[b]; i < _lock_offsets[b + 1]; ++i)
+      chunk_colors[_block_locks[i]].push_back(c);
+  }
+
+  // Group blocks by colour, preserving block order within a colour
+  _color_offsets.assign(num_colors + 1, 0);
+  for (std::size_t b = 0; b < num_blocks; ++b)
+    ++_color_offsets[block_color[b] + 1];
+  for (std::size_t c = 0; c < num_colors; ++c)
+    _color_offsets[c + 1] += _color_offsets[c];
+  _colored_blocks.resize(num_blocks);
+  std::vector<std::size_t> insert_pos(_color_offsets.begin(),
+                                      _color_offsets.end() - 1);
+  for (std::size_t b = 0; b < num_blocks; ++b)
+    _colored_blocks[insert_pos[block_color[b]]++] = b;
+}
+//-----------------------------------------------------------------------------
+#endif
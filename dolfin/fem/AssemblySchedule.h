@@ -0,0 +1,146 @@
+// Copyright (C) 2016 The FEniCS Project
+//
+// This file is part of DOLFIN.
+//
+// DOLFIN is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// DOLFIN is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with DOLFIN. If not, see <http://www.gnu.org/licenses/>.
+//
+// First added:  2016-10-18
+// Last changed: 2016-10-18
+
+#ifndef __ASSEMBLY_SCHEDULE_H
+#define __ASSEMBLY_SCHEDULE_H
+
+#ifdef HAS_OPENMP
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+#include <omp.h>
+
+namespace dolfin
+{
+
+  // Forward declarations
+  class GenericDofMap;
+
+  /// This class partitions a list of mesh entities (cells or facets)
+  /// into blocks for multithreaded assembly. Each block is a
+  /// contiguous range of entities small enough for the cell tensors
+  /// and dofs of the block to stay in cache, and blocks are handed
+  /// out to threads dynamically, so that threads which finish early
+  /// take over remaining work.
+  ///
+  /// Two blocks conflict if they add to a common row of the global
+  /// tensor. Rows are grouped into small chunks, each protected by a
+  /// lock, and a thread holds the locks of all row chunks touched by
+  /// a block while inserting the tensors of the block. Alternatively,
+  /// the blocks can be coloured such that blocks of the same colour
+  /// do not conflict. Colours are then processed one after the other
+  /// in a fixed order, which makes the order of additions to each
+  /// entry of the global tensor, and hence the result, independent
+  /// of the number of threads and of thread scheduling.
+
+  class AssemblySchedule
+  {
+  public:
+
+    /// Create schedule for entities. Each entity is attached to
+    /// cells_per_entity cells in the list cells (one for cells, two
+    /// for interior facets), and the rows touched by an entity are
+    /// the dofs of row_dofmap on these cells. If row_dofmap is null
+    /// (functionals) blocks never conflict. If block_size is zero,
+    /// it is chosen from the number of bytes per entity of the
+    /// staging data.
+    AssemblySchedule(const std::vector<std::size_t>& entities,
+                     const std::vector<std::size_t>& cells,
+                     std::size_t cells_per_entity,
+                     const GenericDofMap* row_dofmap,
+                     std::size_t block_size,
+                     std::size_t bytes_per_entity,
+                     std::size_t num_threads,
+                     bool colored);
+
+    /// Destructor
+    ~AssemblySchedule();
+
+    /// Return number of blocks
+    std::size_t num_blocks() const
+    { return _block_offsets.size() - 1; }
+
+    /// Return maximum number of entities in a block
+    std::size_t block_size() const
+    { return _block_size; }
+
+    /// Return range [first, last) of positions in entity list for
+    /// block b
+    std::pair<std::size_t, std::size_t> block(std::size_t b) const
+    { return std::make_pair(_block_offsets[b], _block_offsets[b + 1]); }
+
+    /// Return number of colours (one if blocks are not coloured)
+    std::size_t num_colors() const
+    { return _color_offsets.size() - 1; }
+
+    /// Return range [first, last) of positions in colored_blocks()
+    /// for colour c
+    std::pair<std::size_t, std::size_t> color(std::size_t c) const
+    { return std::make_pair(_color_offsets[c], _color_offsets[c + 1]); }
+
+    /// Return blocks ordered by colour
+    const std::vector<std::size_t>& colored_blocks() const
+    { return _colored_blocks; }
+
+    /// Acquire locks for rows touched by block b (does nothing if
+    /// blocks are coloured)
+    void lock(std::size_t b);
+
+    /// Release locks for rows touched by block b
+    void unlock(std::size_t b);
+
+  private:
+
+    // Compute row chunks touched by each block
+    void compute_block_locks(const std::vector<std::size_t>& cells,
+                             std::size_t cells_per_entity,
+                             const GenericDofMap& row_dofmap);
+
+    // Colour blocks such that no two blocks of the same colour touch
+    // the same row chunk
+    void color_blocks();
+
+    // Maximum number of entities per block
+    std::size_t _block_size;
+
+    // Offsets into entity list for each block
+    std::vector<std::size_t> _block_offsets;
+
+    // Row chunks touched by each block (sorted, in compressed form)
+    std::vector<std::size_t> _lock_offsets;
+    std::vector<std::size_t> _block_locks;
+
+    // Blocks grouped by colour
+    std::vector<std::size_t> _color_offsets;
+    std::vector<std::size_t> _colored_blocks;
+
+    // True if blocks are coloured rather than locked
+    bool _colored;
+
+    // Locks for row chunks
+    std::vector<omp_lock_t> _locks;
+
+  };
+
+}
+
+#endif
+#endif
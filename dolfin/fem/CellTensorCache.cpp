@@ -0,0 +1,164 @@
+// Copyright (C) 2016 The FEniCS Project
+//
+// This file is part of DOLFIN.
+//
+// DOLFIN is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// DOLFIN is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with DOLFIN. If not, see <http://www.gnu.org/licenses/>.
+//
+// First added:  2016-10-18
+// Last changed: 2016-10-18
+
+#include <algorithm>
+#include <cmath>
+#include <tuple>
+#include <ufc.h>
+#include <dolfin/log/LogManager.h>
+#include <dolfin/log/log.h>
+#include <dolfin/mesh/CellType.h>
+#include <dolfin/mesh/Mesh.h>
+#include "Form.h"
+#include "UFC.h"
+#include "CellTensorCache.h"
+
+using namespace dolfin;
+
+// Number of lookups after which caching is switched off for an
+// integral if less than min_hit_rate of the lookups were hits
+static const std::size_t min_num_lookups = 1024;
+static const double min_hit_rate = 0.1;
+
+// Maximum size in bytes of cached tensors
+static const std::size_t max_cache_size = 64*1024*1024;
+
+//-----------------------------------------------------------------------------
+CellTensorCache::CellTensorCache(const Form& a, std::size_t tensor_size)
+  : _form(a), _tensor_size(tensor_size), _gdim(a.mesh().geometry().dim()),
+    _num_coordinate_dofs(a.mesh().type().num_vertices()*_gdim),
+    _current(NULL), _num_hits(0), _num_misses(0)
+{
+  // Relative vertex coordinates are compared up to a small fraction
+  // of the extent of the mesh
+  const std::vector<double>& x = a.mesh().coordinates();
+  double extent = 0.0;
+  for (std::size_t i = 0; i < x.size(); ++i)
+    extent = std::max(extent, std::abs(x[i]));
+  _resolution = 1.0e-12*(extent > 0.0 ? extent : 1.0);
+}
+//-----------------------------------------------------------------------------
+bool CellTensorCache::supported(const Mesh& mesh)
+{
+  const CellType::Type cell_type = mesh.type().cell_type();
+  return mesh.geometry().degree() == 1
+    && (cell_type == CellType::interval || cell_type == CellType::triangle
+        || cell_type == CellType::tetrahedron);
+}
+//-----------------------------------------------------------------------------
+bool CellTensorCache::find(const ufc::cell_integral& integral,
+                           const double* coordinate_dofs, int orientation,
+                           const UFC& ufc, const double * const * w,
+                           double* A)
+{
+  _current = NULL;
+
+  // Cache only integrals that are translation invariant by
+  // construction
+  std::map<const ufc::cell_integral*, IntegralCache>::iterator it
+    = _integrals.find(&integral);
+  if (it == _integrals.end())
+  {
+    it = _integrals.insert(std::make_pair(&integral, IntegralCache())).first;
+    it->second.enabled = _form.translation_invariant(integral);
+  }
+  IntegralCache& data = it->second;
+
+  // Switch caching off for integrals with low hit rate
+  if (data.enabled && data.num_lookups == min_num_lookups
+      && data.num_hits < min_hit_rate*min_num_lookups)
+  {
+    log(DBG, "Low hit rate, switching off cell tensor cache for integral.");
+    data.enabled = false;
+    map_type().swap(data.index);
+  }
+
+  if (!data.enabled)
+  {
+    ++_num_misses;
+    return false;
+  }
+  ++data.num_lookups;
+
+  // Compute key from orientation, vertex coordinates relative to the
+  // first vertex and values of enabled coefficients
+  _key.clear();
+  _key.push_back(orientation);
+  for (std::size_t i = _gdim; i < _num_coordinate_dofs; ++i)
+  {
+    _key.push_back(std::round((coordinate_dofs[i] - coordinate_dofs[i % _gdim])
+                              /_resolution));
+  }
+  const std::vector<bool>& enabled_coefficients
+    = integral.enabled_coefficients();
+  for (std::size_t i = 0; i < enabled_coefficients.size(); ++i)
+  {
+    if (enabled_coefficients[i])
+      _key.insert(_key.end(), w[i], w[i] + ufc.coefficient_dimension(i));
+  }
+
+  map_type::const_iterator entry = data.index.find(_key);
+  if (entry == data.index.end())
+  {
+    // Tensor must be tabulated and inserted
+    _current = &data;
+    ++_num_misses;
+    return false;
+  }
+
+  // Copy cached tensor
+  ++data.num_hits;
+  std::copy(_tensors.begin() + entry->second,
+            _tensors.begin() + entry->second + _tensor_size, A);
+  ++_num_hits;
+  return true;
+}
+//-----------------------------------------------------------------------------
+void CellTensorCache::insert(const double* A)
+{
+  if (!_current)
+    return;
+
+  IntegralCache& data = *_current;
+  _current = NULL;
+
+  // Store tensor
+  if (sizeof(double)*(_tensors.size() + _tensor_size) <= max_cache_size)
+  {
+    data.index[_key] = _tensors.size();
+    _tensors.insert(_tensors.end(), A, A + _tensor_size);
+  }
+}
+//-----------------------------------------------------------------------------
+void CellTensorCache::register_timings() const
+{
+  const std::tuple<double, double, double> no_time(0.0, 0.0, 0.0);
+  if (_num_hits > 0)
+  {
+    LogManager::logger().register_timing("Cell tensor cache hit", no_time,
+                                         _num_hits);
+  }
+  if (_num_misses > 0)
+  {
+    LogManager::logger().register_timing("Cell tensor cache miss", no_time,
+                                         _num_misses);
+  }
+}
+//-----------------------------------------------------------------------------
@@ -0,0 +1,140 @@
+// Copyright (C) 2016 The FEniCS Project
+//
+// This file is part of DOLFIN.
+//
+// DOLFIN is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// DOLFIN is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with DOLFIN. If not, see <http://www.gnu.org/licenses/>.
+//
+// First added:  2016-10-18
+// Last changed: 2016-10-18
+
+#ifndef __CELL_TENSOR_CACHE_H
+#define __CELL_TENSOR_CACHE_H
+
+#include <map>
+#include <unordered_map>
+#include <vector>
+#include <boost/functional/hash.hpp>
+
+namespace ufc
+{
+  class cell_integral;
+}
+
+namespace dolfin
+{
+
+  // Forward declarations
+  class Form;
+  class Mesh;
+  class UFC;
+
+  /// This class caches cell tensors on affine simplex meshes. The
+  /// tensor of an affine cell depends only on the cell integral, the
+  /// vertex coordinates relative to the first vertex, the cell
+  /// orientation and the values of the enabled coefficients on the
+  /// cell. Cells that agree in all of these (congruent cells with the
+  /// same piecewise constant coefficients, as in structured meshes)
+  /// share a cached tensor, so that tabulation is needed only once
+  /// for each such shape.
+  ///
+  /// Only integrals for which this holds by construction are cached,
+  /// that is integrals that do not use the spatial coordinate and
+  /// whose enabled coefficients are all constant on each cell (see
+  /// Form::translation_invariant). Caching is also switched off for
+  /// integrals with a low hit rate.
+
+  class CellTensorCache
+  {
+  public:
+
+    /// Create cache for cell tensors of form with tensor_size entries
+    CellTensorCache(const Form& a, std::size_t tensor_size);
+
+    /// Return true if the mesh supports caching (affine simplex
+    /// cells)
+    static bool supported(const Mesh& mesh);
+
+    /// Look up tensor of a cell given its coordinate dofs,
+    /// orientation and restricted coefficients w (with dimensions
+    /// given by the UFC object). Returns true and copies the tensor
+    /// to A if the tensor is cached. Otherwise the tensor must be
+    /// tabulated and passed to insert().
+    bool find(const ufc::cell_integral& integral,
+              const double* coordinate_dofs, int orientation,
+              const UFC& ufc, const double * const * w, double* A);
+
+    /// Store tabulated tensor of the cell last passed to find()
+    void insert(const double* A);
+
+    /// Register numbers of hits and misses as repetitions in the
+    /// timing table
+    void register_timings() const;
+
+    /// Return number of cells for which the tensor was taken from the
+    /// cache
+    std::size_t num_hits() const
+    { return _num_hits; }
+
+    /// Return number of cells for which the tensor was tabulated
+    std::size_t num_misses() const
+    { return _num_misses; }
+
+  private:
+
+    typedef std::unordered_map<std::vector<double>, std::size_t,
+                               boost::hash<std::vector<double>>> map_type;
+
+    // Cache data for one cell integral
+    struct IntegralCache
+    {
+      IntegralCache() : num_lookups(0), num_hits(0), enabled(true) {}
+
+      // Map from cell key to position of tensor in _tensors
+      map_type index;
+
+      // Statistics used to switch caching off
+      std::size_t num_lookups, num_hits;
+      bool enabled;
+    };
+
+    // The form
+    const Form& _form;
+
+    // Number of entries in cell tensor
+    std::size_t _tensor_size;
+
+    // Geometric dimension and number of coordinate dofs of a cell
+    std::size_t _gdim, _num_coordinate_dofs;
+
+    // Resolution used when comparing relative vertex coordinates
+    double _resolution;
+
+    // Cache data for each integral
+    std::map<const ufc::cell_integral*, IntegralCache> _integrals;
+
+    // Cached tensors
+    std::vector<double> _tensors;
+
+    // Key and integral of the cell last passed to find()
+    std::vector<double> _key;
+    IntegralCache* _current;
+
+    // Total number of hits and misses
+    std::size_t _num_hits, _num_misses;
+
+  };
+
+}
+
+#endif
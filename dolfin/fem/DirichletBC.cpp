@@ -789,7 +789,7 @@ void DirichletBC::init_from_mesh(std::size_t sub_domain) const
 
   // Assign domain numbers for each facet
   const std::size_t D = mesh.topology().dim();
-  const std::map<std::size_t, std::size_t>& markers
+  const boost::container::flat_map<std::size_t, std::size_t>& markers
     = mesh.domains().markers(D - 1);
 
   dolfin_assert(_facets.empty());
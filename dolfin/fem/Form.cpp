@@ -42,7 +42,8 @@ using namespace dolfin;
 Form::Form(std::size_t rank, std::size_t num_coefficients)
   : Hierarchical<Form>(*this),
     dx(*this), ds(*this), dS(*this), dP(*this),
-    _function_spaces(rank), _coefficients(num_coefficients), _rank(rank)
+    _function_spaces(rank), _coefficients(num_coefficients),
+    _uses_spatial_coordinate(true), _rank(rank)
 {
   // Do nothing
 }
@@ -53,7 +54,7 @@ Form::Form(std::shared_ptr<const ufc::form> ufc_form,
   : Hierarchical<Form>(*this),
     dx(*this), ds(*this), dS(*this), dP(*this), _ufc_form(ufc_form),
     _function_spaces(function_spaces), _coefficients(coefficients),
-    _rank(ufc_form->rank())
+    _uses_spatial_coordinate(true), _rank(ufc_form->rank())
 {
   // Do nothing
 }
@@ -339,6 +340,42 @@ void Form::set_vertex_domains
   _vertex_domains = vertex_domains;
 }
 //-----------------------------------------------------------------------------
+void Form::set_position_dependence(
+  bool uses_spatial_coordinate,
+  const std::vector<std::size_t>& cellwise_constant_coefficients)
+{
+  _uses_spatial_coordinate = uses_spatial_coordinate;
+  _cellwise_constant_coefficients.assign(num_coefficients(), false);
+  for (std::size_t i = 0; i < cellwise_constant_coefficients.size(); ++i)
+  {
+    const std::size_t j = cellwise_constant_coefficients[i];
+    if (j >= _cellwise_constant_coefficients.size())
+    {
+      dolfin_error("Form.cpp",
+                   "set position dependence of form",
+                   "Illegal coefficient number %d", j);
+    }
+    _cellwise_constant_coefficients[j] = true;
+  }
+}
+//-----------------------------------------------------------------------------
+bool Form::translation_invariant(const ufc::cell_integral& integral) const
+{
+  if (_uses_spatial_coordinate)
+    return false;
+
+  const std::vector<bool>& enabled = integral.enabled_coefficients();
+  for (std::size_t i = 0; i < enabled.size(); ++i)
+  {
+    if (enabled[i] && (i >= _cellwise_constant_coefficients.size()
+                       || !_cellwise_constant_coefficients[i]))
+    {
+      return false;
+    }
+  }
+  return true;
+}
+//-----------------------------------------------------------------------------
 std::shared_ptr<const ufc::form> Form::ufc_form() const
 {
   return _ufc_form;
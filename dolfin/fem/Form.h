@@ -36,6 +36,7 @@
 // Forward declaration
 namespace ufc
 {
+  class cell_integral;
   class form;
 }
 
@@ -334,6 +335,35 @@ namespace dolfin
     ///         The vertex domains.
     void set_vertex_domains(std::shared_ptr<const MeshFunction<std::size_t> > vertex_domains);
 
+    /// Describe how the integrand depends on the position of a cell.
+    /// This decides whether tensors of congruent cells may be reused
+    /// during assembly (see _CellTensorCache_). It is set for forms
+    /// created from UFL in Python and is unknown otherwise.
+    ///
+    /// *Arguments*
+    ///     uses_spatial_coordinate (bool)
+    ///         True if the integrand uses the spatial coordinate.
+    ///     cellwise_constant_coefficients (std::vector<std::size_t>)
+    ///         The numbers of the coefficients that are constant on
+    ///         each cell.
+    void set_position_dependence(bool uses_spatial_coordinate,
+                                 const std::vector<std::size_t>& cellwise_constant_coefficients);
+
+    /// Return true if the tensor of a cell integral depends on the
+    /// cell only through its vertex coordinates relative to each
+    /// other, that is if the integrand does not use the spatial
+    /// coordinate and all coefficients enabled for the integral are
+    /// constant on each cell. Returns false if this is unknown.
+    ///
+    /// *Arguments*
+    ///     integral (ufc::cell_integral)
+    ///         A cell integral of the form.
+    ///
+    /// *Returns*
+    ///     bool
+    ///         True if the cell tensor is translation invariant.
+    bool translation_invariant(const ufc::cell_integral& integral) const;
+
     /// Return UFC form shared pointer
     ///
     /// *Returns*
@@ -382,6 +412,13 @@ namespace dolfin
     // Markers for vertex domains
     std::shared_ptr<const MeshFunction<std::size_t> > _vertex_domains;
 
+    // True if the integrand uses the spatial coordinate (or if this
+    // is unknown)
+    bool _uses_spatial_coordinate;
+
+    // True for each coefficient that is constant on each cell
+    std::vector<bool> _cellwise_constant_coefficients;
+
   private:
 
     const std::size_t _rank;
@@ -0,0 +1,364 @@
+// Copyright (C) 2016 The FEniCS Project
+//
+// This file is part of DOLFIN.
+//
+// DOLFIN is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// DOLFIN is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with DOLFIN. If not, see <http://www.gnu.org/licenses/>.
+//
+// First added:  2016-10-18
+// Last changed: 2016-10-18
+
+#include <algorithm>
+#include <sstream>
+#include <dolfin/common/MPI.h>
+#include <dolfin/common/Timer.h>
+#include <dolfin/function/FunctionSpace.h>
+#include <dolfin/la/GenericVector.h>
+#include <dolfin/la/IndexMap.h>
+#include <dolfin/la/Vector.h>
+#include <dolfin/log/log.h>
+#include <dolfin/mesh/Cell.h>
+#include <dolfin/mesh/Mesh.h>
+#include <dolfin/parameter/GlobalParameters.h>
+#include "AssemblyPlan.h"
+#include "AssemblySchedule.h"
+#include "DirichletBC.h"
+#include "Form.h"
+#include "GenericDofMap.h"
+#include "UFC.h"
+#include "MatrixFreeOperator.h"
+
+using namespace dolfin;
+
+// Number of cells per block in serial runs
+static const std::size_t serial_block_size = 256;
+
+//-----------------------------------------------------------------------------
+// Create vector with the parallel layout of dimension dim of form a
+static std::shared_ptr<GenericVector> create_vector(const Form& a,
+                                                    std::size_t dim)
+{
+  std::shared_ptr<GenericVector> x(new Vector);
+  x->init(a.mesh().mpi_comm(),
+          a.function_space(dim)->dofmap()->ownership_range());
+  return x;
+}
+//-----------------------------------------------------------------------------
+MatrixFreeOperator::MatrixFreeOperator(std::shared_ptr<const Form> a)
+  : LinearOperator(*create_vector(*a, 1), *create_vector(*a, 0)), _a(a),
+    _schedule_num_threads(0), _num_owned_rows(0)
+{
+  parameters = default_parameters();
+  init();
+}
+//-----------------------------------------------------------------------------
+MatrixFreeOperator::MatrixFreeOperator(
+  std::shared_ptr<const Form> a,
+  std::vector<std::shared_ptr<const DirichletBC>> bcs)
+  : LinearOperator(*create_vector(*a, 1), *create_vector(*a, 0)), _a(a),
+    _bcs(bcs), _schedule_num_threads(0), _num_owned_rows(0)
+{
+  parameters = default_parameters();
+  init();
+}
+//-----------------------------------------------------------------------------
+MatrixFreeOperator::~MatrixFreeOperator()
+{
+  // Do nothing
+}
+//-----------------------------------------------------------------------------
+std::size_t MatrixFreeOperator::size(std::size_t dim) const
+{
+  dolfin_assert(dim < 2);
+  return _a->function_space(dim)->dim();
+}
+//-----------------------------------------------------------------------------
+void MatrixFreeOperator::mult(const GenericVector& x, GenericVector& y) const
+{
+  Timer timer("Matrix-free operator action");
+
+  if (x.size() != size(1) || y.size() != size(0))
+  {
+    dolfin_error("MatrixFreeOperator.cpp",
+                 "compute matrix-free operator action",
+                 "Dimensions of vectors do not match the operator");
+  }
+
+  // Cell tensors are tabulated into the cache on the first call
+  const bool use_cache = parameters["cache_cell_tensors"];
+  const std::size_t num_cells = _plan->num_cells();
+  const bool fill_cache = use_cache && _cell_tensors.empty();
+  if (fill_cache)
+    _cell_tensors.resize(num_cells*_plan->tensor_size());
+
+  // Gather entries of x for local dofs (including ghosts)
+  std::vector<double> x_local;
+  x.gather(x_local, _local_to_global[1]);
+
+  // Compute action for local dofs (including ghosts)
+  std::vector<double> y_local(_local_to_global[0].size(), 0.0);
+
+#ifdef HAS_OPENMP
+  // Apply blocks of cells in parallel
+  const std::size_t num_threads = dolfin::parameters["num_threads"];
+  if (num_threads > 0 && MPI::size(_a->mesh().mpi_comm()) == 1)
+  {
+    // Build schedule over planned cells, locking rows of y_local
+    if (!_schedule || _schedule_num_threads != num_threads)
+    {
+      std::vector<std::size_t> positions(num_cells), cells(num_cells);
+      for (std::size_t k = 0; k < num_cells; ++k)
+      {
+        positions[k] = k;
+        cells[k] = _plan->cell(k);
+      }
+      const std::size_t bytes_per_cell
+        = sizeof(double)*_plan->tensor_size();
+      const std::size_t block_size
+        = dolfin::parameters["threaded_assembly_block_size"];
+      const bool reproducible
+        = dolfin::parameters["threaded_assembly_reproducible"];
+      _schedule.reset(new AssemblySchedule(positions, cells, 1,
+                                           _a->function_space(0)->dofmap().get(),
+                                           block_size, bytes_per_cell,
+                                           num_threads, reproducible));
+      _schedule_num_threads = num_threads;
+    }
+    AssemblySchedule& schedule = *_schedule;
+    const std::vector<std::size_t>& colored_blocks
+      = schedule.colored_blocks();
+
+    #pragma omp parallel num_threads(num_threads)
+    {
+      // Each thread needs its own UFC object and work arrays
+      UFC ufc(_plan->ufc());
+      std::vector<double> y_block, coordinate_dofs;
+
+      for (std::size_t color = 0; color < schedule.num_colors(); ++color)
+      {
+        const int first = schedule.color(color).first;
+        const int last = schedule.color(color).second;
+
+        // Threads take blocks of the current colour on demand
+        #pragma omp for schedule(dynamic, 1)
+        for (int k = first; k < last; ++k)
+        {
+          const std::size_t b = colored_blocks[k];
+          const std::pair<std::size_t, std::size_t> range = schedule.block(b);
+          mult_cells(range.first, range.second, ufc, x_local, y_block,
+                     coordinate_dofs, use_cache, fill_cache);
+
+          // Add block to local values of y
+          schedule.lock(b);
+          add_cells(range.first, range.second, y_block, y_local);
+          schedule.unlock(b);
+        }
+      }
+    }
+  }
+  else
+#endif
+  {
+    std::vector<double> y_block, coordinate_dofs;
+    for (std::size_t first = 0; first < num_cells; first += serial_block_size)
+    {
+      const std::size_t last = std::min(first + serial_block_size, num_cells);
+      mult_cells(first, last, _plan->ufc(), x_local, y_block,
+                 coordinate_dofs, use_cache, fill_cache);
+      add_cells(first, last, y_block, y_local);
+    }
+  }
+
+  // Replace rows of boundary dofs by rows of the identity. Rows of
+  // ghost boundary dofs are zeroed, the owner sets the diagonal.
+  for (std::size_t i = 0; i < _bc_dofs.size(); ++i)
+  {
+    const dolfin::la_index dof = _bc_dofs[i];
+    y_local[dof] = (std::size_t) dof < _num_owned_rows ? x_local[dof] : 0.0;
+  }
+
+  // Add contributions to y
+  y.zero();
+  y.add(y_local.data(), y_local.size(), _local_to_global[0].data());
+  y.apply("add");
+}
+//-----------------------------------------------------------------------------
+void MatrixFreeOperator::update()
+{
+  _plan->update();
+  init();
+}
+//-----------------------------------------------------------------------------
+std::size_t MatrixFreeOperator::memory_usage() const
+{
+  std::size_t num_element_dofs = 0;
+  for (std::size_t i = 0; i < 2; ++i)
+    num_element_dofs += _a->function_space(i)->dofmap()->max_element_dofs();
+
+  return sizeof(double)*_cell_tensors.size()
+    + sizeof(dolfin::la_index)*_plan->num_cells()*num_element_dofs
+    + sizeof(std::size_t)*_plan->num_cells()
+    + sizeof(dolfin::la_index)*(_local_to_global[0].size()
+                                + _local_to_global[1].size()
+                                + _bc_dofs.size());
+}
+//-----------------------------------------------------------------------------
+std::string MatrixFreeOperator::str(bool verbose) const
+{
+  std::stringstream s;
+  s << "<MatrixFreeOperator of size " << size(0) << " x " << size(1) << ">";
+  return s.str();
+}
+//-----------------------------------------------------------------------------
+void MatrixFreeOperator::init()
+{
+  dolfin_assert(_a);
+  const Form& a = *_a;
+
+  // Check form
+  if (a.rank() != 2)
+  {
+    dolfin_error("MatrixFreeOperator.cpp",
+                 "create matrix-free operator",
+                 "Form must be bilinear (rank 2), not rank %d", a.rank());
+  }
+
+  // Create or rebuild plan holding cells and dofs
+  if (!_plan)
+    _plan.reset(new AssemblyPlan(_a));
+  const ufc::form& form = _plan->ufc().form;
+  if (form.has_exterior_facet_integrals() || form.has_interior_facet_integrals()
+      || form.has_vertex_integrals() || form.has_custom_integrals())
+  {
+    dolfin_error("MatrixFreeOperator.cpp",
+                 "create matrix-free operator",
+                 "Only cell integrals are supported");
+  }
+
+  // Compute global indices of local dofs (including ghosts)
+  for (std::size_t i = 0; i < 2; ++i)
+  {
+    std::shared_ptr<const IndexMap> index_map
+      = a.function_space(i)->dofmap()->index_map();
+    const std::size_t num_local_dofs = index_map->size()
+      + index_map->block_size()*index_map->local_to_global_unowned().size();
+    _local_to_global[i].resize(num_local_dofs);
+    for (std::size_t j = 0; j < num_local_dofs; ++j)
+      _local_to_global[i][j] = index_map->local_to_global(j);
+  }
+  _num_owned_rows = a.function_space(0)->dofmap()->index_map()->size();
+
+  // Collect local boundary dofs (on all processes sharing a dof)
+  _bc_dofs.clear();
+  if (!_bcs.empty())
+  {
+    if (*a.function_space(0) != *a.function_space(1))
+    {
+      dolfin_error("MatrixFreeOperator.cpp",
+                   "apply boundary conditions to matrix-free operator",
+                   "Test and trial spaces must be equal");
+    }
+
+    DirichletBC::Map boundary_values;
+    for (std::size_t i = 0; i < _bcs.size(); ++i)
+    {
+      _bcs[i]->get_boundary_values(boundary_values);
+      if (MPI::size(a.mesh().mpi_comm()) > 1
+          && _bcs[i]->method() != "pointwise")
+      {
+        _bcs[i]->gather(boundary_values);
+      }
+    }
+    for (DirichletBC::Map::const_iterator bv = boundary_values.begin();
+         bv != boundary_values.end(); ++bv)
+    {
+      _bc_dofs.push_back(bv->first);
+    }
+  }
+
+  // Discard cached data
+  _cell_tensors.clear();
+  _schedule.reset();
+}
+//-----------------------------------------------------------------------------
+void MatrixFreeOperator::mult_cells(std::size_t first, std::size_t last,
+                                    UFC& ufc,
+                                    const std::vector<double>& x_local,
+                                    std::vector<double>& y_block,
+                                    std::vector<double>& coordinate_dofs,
+                                    bool use_cache, bool fill_cache) const
+{
+  const Mesh& mesh = _a->mesh();
+  const std::size_t tensor_size = _plan->tensor_size();
+  const std::size_t m = _a->function_space(0)->dofmap()->max_element_dofs();
+  y_block.resize((last - first)*m);
+  ufc::cell ufc_cell;
+
+  // Find cell integral of first cell
+  std::size_t i = 0;
+  while (i < _plan->num_cell_integrals() && _plan->cell_range(i).second <= first)
+    ++i;
+
+  for (std::size_t k = first; k < last; ++k)
+  {
+    // Move on to next cell integral
+    while (_plan->cell_range(i).second <= k)
+      ++i;
+    const ufc::cell_integral* integral = _plan->cell_integral(i);
+
+    // Get cell tensor, tabulating it if not cached
+    const double* A = _cell_tensors.data() + k*tensor_size;
+    if (!use_cache || fill_cache)
+    {
+      const Cell cell(mesh, _plan->cell(k));
+      cell.get_cell_data(ufc_cell);
+      cell.get_coordinate_dofs(coordinate_dofs);
+      ufc.update(cell, coordinate_dofs, ufc_cell,
+                 integral->enabled_coefficients());
+
+      double* A_cell = fill_cache ? _cell_tensors.data() + k*tensor_size
+        : ufc.A.data();
+      integral->tabulate_tensor(A_cell, ufc.w(), coordinate_dofs.data(),
+                                ufc_cell.orientation);
+      A = A_cell;
+    }
+
+    // Apply cell tensor to cell values of x
+    const ArrayView<const dolfin::la_index> dofs1 = _plan->cell_dofs(1, k);
+    const std::size_t n = dofs1.size();
+    double* y_cell = y_block.data() + (k - first)*m;
+    for (std::size_t r = 0; r < m; ++r)
+    {
+      const double* A_row = A + r*n;
+      double sum = 0.0;
+      for (std::size_t c = 0; c < n; ++c)
+        sum += A_row[c]*x_local[dofs1[c]];
+      y_cell[r] = sum;
+    }
+  }
+}
+//-----------------------------------------------------------------------------
+void MatrixFreeOperator::add_cells(std::size_t first, std::size_t last,
+                                   const std::vector<double>& y_block,
+                                   std::vector<double>& y_local) const
+{
+  const std::size_t m = _a->function_space(0)->dofmap()->max_element_dofs();
+  for (std::size_t k = first; k < last; ++k)
+  {
+    const ArrayView<const dolfin::la_index> dofs0 = _plan->cell_dofs(0, k);
+    const double* y_cell = y_block.data() + (k - first)*m;
+    for (std::size_t r = 0; r < m; ++r)
+      y_local[dofs0[r]] += y_cell[r];
+  }
+}
+//-----------------------------------------------------------------------------
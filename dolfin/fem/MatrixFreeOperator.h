@@ -0,0 +1,148 @@
+// Copyright (C) 2016 The FEniCS Project
+//
+// This file is part of DOLFIN.
+//
+// DOLFIN is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// DOLFIN is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with DOLFIN. If not, see <http://www.gnu.org/licenses/>.
+//
+// First added:  2016-10-18
+// Last changed: 2016-10-18
+
+#ifndef __MATRIX_FREE_OPERATOR_H
+#define __MATRIX_FREE_OPERATOR_H
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <dolfin/common/types.h>
+#include <dolfin/la/LinearOperator.h>
+#include <dolfin/parameter/Parameters.h>
+
+namespace dolfin
+{
+
+  // Forward declarations
+  class AssemblyPlan;
+  class AssemblySchedule;
+  class DirichletBC;
+  class Form;
+  class GenericVector;
+  class UFC;
+
+  /// This class implements the action of the matrix of a bilinear
+  /// form without assembling the matrix. Each call to mult()
+  /// tabulates the cell tensors and applies them to the input vector
+  /// cell by cell, or applies cached cell tensors if the parameter
+  /// "cache_cell_tensors" is set. The operator can be passed to
+  /// Krylov solvers of linear algebra backends that support
+  /// LinearOperator (PETSc).
+  ///
+  /// Dirichlet boundary conditions are applied as by
+  /// DirichletBC::apply(A), i.e. rows of boundary dofs are replaced
+  /// by rows of the identity.
+  ///
+  /// Only cell integrals are supported. The action is computed with
+  /// multiple threads if the global parameter "num_threads" is
+  /// positive (in serial runs).
+
+  class MatrixFreeOperator : public LinearOperator
+  {
+  public:
+
+    /// Create operator for bilinear form
+    explicit MatrixFreeOperator(std::shared_ptr<const Form> a);
+
+    /// Create operator for bilinear form with Dirichlet boundary
+    /// conditions
+    MatrixFreeOperator(std::shared_ptr<const Form> a,
+                       std::vector<std::shared_ptr<const DirichletBC>> bcs);
+
+    /// Destructor
+    ~MatrixFreeOperator();
+
+    /// Return size of given dimension
+    std::size_t size(std::size_t dim) const;
+
+    /// Compute matrix-vector product y = Ax
+    void mult(const GenericVector& x, GenericVector& y) const;
+
+    /// Recompute data held by the operator. This must be called if
+    /// the boundary conditions, or the coefficients of the form when
+    /// cell tensors are cached, have changed.
+    void update();
+
+    /// Return approximate number of bytes of data held by the
+    /// operator
+    std::size_t memory_usage() const;
+
+    /// Return informal string representation (pretty-print)
+    std::string str(bool verbose) const;
+
+    /// Default parameter values
+    static Parameters default_parameters()
+    {
+      Parameters p("matrix_free_operator");
+      p.add("cache_cell_tensors", false);
+      return p;
+    }
+
+  private:
+
+    // Check form and compute dof and boundary data
+    void init();
+
+    // Compute action of cell tensors of planned cells [first, last)
+    // on x, storing the values for each cell in y_block
+    void mult_cells(std::size_t first, std::size_t last, UFC& ufc,
+                    const std::vector<double>& x_local,
+                    std::vector<double>& y_block,
+                    std::vector<double>& coordinate_dofs,
+                    bool use_cache, bool fill_cache) const;
+
+    // Add values of planned cells [first, last) in y_block to y_local
+    void add_cells(std::size_t first, std::size_t last,
+                   const std::vector<double>& y_block,
+                   std::vector<double>& y_local) const;
+
+    // The bilinear form
+    std::shared_ptr<const Form> _a;
+
+    // Boundary conditions
+    std::vector<std::shared_ptr<const DirichletBC>> _bcs;
+
+    // Plan holding cell integrals, cells and dofs of the form
+    std::unique_ptr<AssemblyPlan> _plan;
+
+    // Schedule for multithreaded action (rebuilt when the number of
+    // threads changes)
+    mutable std::shared_ptr<AssemblySchedule> _schedule;
+    mutable std::size_t _schedule_num_threads;
+
+    // Global indices of local dofs (including ghosts) for each
+    // dimension
+    std::vector<dolfin::la_index> _local_to_global[2];
+
+    // Local indices of rows of boundary dofs
+    std::vector<dolfin::la_index> _bc_dofs;
+
+    // Number of owned rows
+    std::size_t _num_owned_rows;
+
+    // Cached cell tensors of planned cells
+    mutable std::vector<double> _cell_tensors;
+
+  };
+
+}
+
+#endif
@@ -208,7 +208,8 @@ void MultiMeshAssembler::_assemble_cut_cells(GenericTensor& A,
 
     // Get cut cells and quadrature rules
     const std::vector<unsigned int>& cut_cells = multimesh->cut_cells(part);
-    const auto& quadrature_rules = multimesh->quadrature_rule_cut_cells(part);
+    const QuadratureRules& quadrature_rules
+      = multimesh->cut_cell_quadrature(part);
 
     // Iterate over cut cells
     for (auto it = cut_cells.begin(); it != cut_cells.end(); ++it)
@@ -229,10 +230,13 @@ void MultiMeshAssembler::_assemble_cut_cells(GenericTensor& A,
       }
 
       // Get quadrature rule for cut cell
-      const auto& qr = quadrature_rules.at(*it);
+      const std::size_t cut_cell_number = it - cut_cells.begin();
+      const double* points = quadrature_rules.points(cut_cell_number);
+      const double* weights = quadrature_rules.weights(cut_cell_number);
 
       // Skip if there are no quadrature points
-      std::size_t num_quadrature_points = qr.second.size();
+      std::size_t num_quadrature_points
+        = quadrature_rules.num_points(cut_cell_number);
       if (num_quadrature_points == 0)
         continue;
 
@@ -248,18 +252,16 @@ void MultiMeshAssembler::_assemble_cut_cells(GenericTensor& A,
         const std::size_t gdim = mesh_part.geometry().dim();
         for (std::size_t i = 0; i < num_quadrature_points; i++)
         {
-          if (qr.second[i] > 0.0)
+          if (weights[i] > 0.0)
           {
-            pr.second.push_back(qr.second[i]);
+            pr.second.push_back(weights[i]);
             for (std::size_t j = i*gdim; j < (i + 1)*gdim; j++)
-              pr.first.push_back(qr.first[j]);
+              pr.first.push_back(points[j]);
           }
         }
         num_quadrature_points = pr.second.size();
-      }
-      else
-      {
-        pr = qr;
+        points = pr.first.data();
+        weights = pr.second.data();
       }
 
       // Tabulate cell tensor
@@ -267,8 +269,8 @@ void MultiMeshAssembler::_assemble_cut_cells(GenericTensor& A,
                                        ufc_part.w(),
                                        coordinate_dofs.data(),
                                        num_quadrature_points,
-                                       pr.first.data(),
-                                       pr.second.data(),
+                                       points,
+                                       weights,
                                        0,
                                        ufc_cell.orientation);
 
@@ -334,16 +336,21 @@ void MultiMeshAssembler::_assemble_interface(GenericTensor& A,
           part);
 
       // Get quadrature rules
-      const auto& quadrature_rules = multimesh->quadrature_rule_interface(part);
+      const QuadratureRules& quadrature_rules
+        = multimesh->interface_quadrature(part);
 
-      // Get collision map
+      // Get collision map and offsets into collision lists
       const auto& cmap = multimesh->collision_map_cut_cells(part);
+      const auto& collision_offsets = multimesh->collision_offsets(part);
 
       // Get facet normals
-      const auto& facet_normals = multimesh->facet_normals(part);
+      const std::vector<double>& facet_normals
+        = multimesh->interface_normals(part);
+      const std::size_t gdim = a_part.mesh().geometry().dim();
 
       // Iterate over all cut cells in collision map
-      for (auto it = cmap.begin(); it != cmap.end(); ++it)
+      std::size_t cut_cell_number = 0;
+      for (auto it = cmap.begin(); it != cmap.end(); ++it, ++cut_cell_number)
       {
         // Get cut cell
         const unsigned int cut_cell_index = it->first;
@@ -362,8 +369,8 @@ void MultiMeshAssembler::_assemble_interface(GenericTensor& A,
           // Get quadrature rule for interface part defined by
           // intersection of the cut and cutting cells
           const std::size_t k = jt - cutting_cells.begin();
-          dolfin_assert(k < quadrature_rules.at(cut_cell_index).size());
-          const auto& qr = quadrature_rules.at(cut_cell_index)[k];
+          const std::size_t c = collision_offsets[cut_cell_number] + k;
+          dolfin_assert(c < collision_offsets[cut_cell_number + 1]);
 
           // FIXME: There might be quite a few cases when we skip cutting
           // FIXME: cells because there are no quadrature points. Perhaps
@@ -371,7 +378,8 @@ void MultiMeshAssembler::_assemble_interface(GenericTensor& A,
           // FIXME: iterations.
 
           // Skip if there are no quadrature points
-          const std::size_t num_quadrature_points = qr.second.size();
+          const std::size_t num_quadrature_points
+            = quadrature_rules.num_points(c);
           if (num_quadrature_points == 0)
             continue;
 
@@ -426,13 +434,10 @@ void MultiMeshAssembler::_assemble_interface(GenericTensor& A,
           }
 
           // Get facet normals
-          const auto& n = facet_normals.at(cut_cell_index)[k];
-
-          // FIXME: We would like to use this assertion (but it fails for 2 meshes)
-          dolfin_assert(n.size() == a_part.mesh().geometry().dim()*num_quadrature_points);
-
-          // FIXME: For now, use this assertion (which fails for 3 meshes)
-          //dolfin_assert(n.size() > 0);
+          dolfin_assert(facet_normals.size()
+                        >= gdim*(quadrature_rules.offset(c) + num_quadrature_points));
+          const double* n = facet_normals.data()
+            + gdim*quadrature_rules.offset(c);
 
           // FIXME: Cell orientation not supported
           const int cell_orientation = ufc_cell[0].orientation;
@@ -442,9 +447,9 @@ void MultiMeshAssembler::_assemble_interface(GenericTensor& A,
                                            ufc_part.macro_w(),
                                            macro_coordinate_dofs.data(),
                                            num_quadrature_points,
-                                           qr.first.data(),
-                                           qr.second.data(),
-                                           n.data(),
+                                           quadrature_rules.points(c),
+                                           quadrature_rules.weights(c),
+                                           n,
                                            cell_orientation);
 
           // Add entries to global tensor
@@ -512,13 +517,16 @@ void MultiMeshAssembler::_assemble_overlap(GenericTensor& A,
       log(PROGRESS, "Assembling multimesh form over overlap on part %d.", part);
 
       // Get quadrature rules
-      const auto& quadrature_rules = multimesh->quadrature_rule_overlap(part);
+      const QuadratureRules& quadrature_rules
+        = multimesh->overlap_quadrature(part);
 
-      // Get collision map
+      // Get collision map and offsets into collision lists
       const auto& cmap = multimesh->collision_map_cut_cells(part);
+      const auto& collision_offsets = multimesh->collision_offsets(part);
 
       // Iterate over all cut cells in collision map
-      for (auto it = cmap.begin(); it != cmap.end(); ++it)
+      std::size_t cut_cell_number = 0;
+      for (auto it = cmap.begin(); it != cmap.end(); ++it, ++cut_cell_number)
       {
         // Get cut cell
         const unsigned int cut_cell_index = it->first;
@@ -536,8 +544,8 @@ void MultiMeshAssembler::_assemble_overlap(GenericTensor& A,
           // Get quadrature rule for interface part defined by
           // intersection of the cut and cutting cells
           const std::size_t k = jt - cutting_cells.begin();
-          dolfin_assert(k < quadrature_rules.at(cut_cell_index).size());
-          const auto& qr = quadrature_rules.at(cut_cell_index)[k];
+          const std::size_t c = collision_offsets[cut_cell_number] + k;
+          dolfin_assert(c < collision_offsets[cut_cell_number + 1]);
 
           // FIXME: There might be quite a few cases when we skip cutting
           // FIXME: cells because there are no quadrature points. Perhaps
@@ -545,7 +553,8 @@ void MultiMeshAssembler::_assemble_overlap(GenericTensor& A,
           // FIXME: iterations.
 
           // Skip if there are no quadrature points
-          const std::size_t num_quadrature_points = qr.second.size();
+          const std::size_t num_quadrature_points
+            = quadrature_rules.num_points(c);
           if (num_quadrature_points == 0)
             continue;
 
@@ -606,8 +615,8 @@ void MultiMeshAssembler::_assemble_overlap(GenericTensor& A,
                                            ufc_part.macro_w(),
                                            macro_coordinate_dofs.data(),
                                            num_quadrature_points,
-                                           qr.first.data(),
-                                           qr.second.data(),
+                                           quadrature_rules.points(c),
+                                           quadrature_rules.weights(c),
                                            0,
                                            cell_orientation);
 
@@ -38,10 +38,21 @@ namespace dolfin
   class UFC;
   template<typename T> class MeshFunction;
 
-  /// This class provides automated assembly of linear systems, or
-  /// more generally, assembly of a sparse tensor from a given
+  /// This class provides multithreaded assembly of linear systems,
+  /// or more generally, assembly of a sparse tensor from a given
   /// variational form.
   ///
+  /// Cells (and interior facets) are partitioned into cache-sized
+  /// blocks which are distributed dynamically between threads (see
+  /// AssemblySchedule). Each thread tabulates the tensors of a block
+  /// into its own staging buffer and then adds the whole block to the
+  /// global tensor while holding locks for the rows it touches. If
+  /// the parameter "threaded_assembly_reproducible" is set, blocks
+  /// are instead coloured and the colours are processed in a fixed
+  /// order, so that the result is bitwise independent of the number
+  /// of threads. Cell tensors are not cached (the parameter
+  /// "assembly_cache_cell_tensors" is ignored with a warning).
+  ///
   /// The MeshFunction arguments can be used to specify assembly over
   /// subdomains of the mesh cells, exterior facets or interior
   /// facets. Either a null pointer or an empty MeshFunction may be
@@ -60,23 +71,16 @@ namespace dolfin
 
   private:
 
-    // Assemble over cells
-    void assemble_cells(GenericTensor& A, const Form& a, UFC& ufc,
-                        std::shared_ptr<const MeshFunction<std::size_t> > domains,
-                        std::vector<double>* values);
-
-    // Assemble over exterior facets
+    // Assemble over cells and exterior facets
     void assemble_cells_and_exterior_facets(GenericTensor& A,
              const Form& a, UFC& ufc,
              std::shared_ptr<const MeshFunction<std::size_t> > cell_domains,
-             std::shared_ptr<const MeshFunction<std::size_t> > exterior_facet_domains,
-             std::vector<double>* values);
+             std::shared_ptr<const MeshFunction<std::size_t> > exterior_facet_domains);
 
     // Assemble over interior facets
     void assemble_interior_facets(GenericTensor& A, const Form& a, UFC& ufc,
              std::shared_ptr<const MeshFunction<std::size_t> > domains,
-             std::shared_ptr<const MeshFunction<std::size_t> > cell_domains,
-             std::vector<double>* values);
+             std::shared_ptr<const MeshFunction<std::size_t> > cell_domains);
 
   };
 
@@ -18,9 +18,12 @@
 // Modified by Ola Skavhaug 2007
 // Modified by Anders Logg 2008-2014
 
+#include <algorithm>
 #include <dolfin/common/ArrayView.h>
 #include <dolfin/common/MPI.h>
 #include <dolfin/la/GenericSparsityPattern.h>
+#include <dolfin/la/IndexMap.h>
+#include <dolfin/la/SparsityPattern.h>
 #include <dolfin/log/log.h>
 #include <dolfin/log/Progress.h>
 #include <dolfin/mesh/Cell.h>
@@ -30,12 +33,62 @@
 #include <dolfin/mesh/Vertex.h>
 #include <dolfin/function/FunctionSpace.h>
 #include <dolfin/function/MultiMeshFunctionSpace.h>
+#include <dolfin/parameter/GlobalParameters.h>
 #include "MultiMeshDofMap.h"
 #include "MultiMeshForm.h"
 #include "SparsityPatternBuilder.h"
 
 using namespace dolfin;
 
+//-----------------------------------------------------------------------------
+// Add the number of column dofs of each entity to the position of
+// each of its rows, and if columns is not null, copy the column dofs
+// to the old position. Each entity is attached to cells_per_entity
+// consecutive cells in the list cells.
+static void add_entity_dofs(const std::vector<std::size_t>& cells,
+                            std::size_t cells_per_entity,
+                            const GenericDofMap& row_dofmap,
+                            const GenericDofMap& col_dofmap,
+                            std::size_t* positions,
+                            dolfin::la_index* columns,
+                            int num_threads)
+{
+  const int num_entities = cells.size()/cells_per_entity;
+  #pragma omp parallel num_threads(num_threads)
+  {
+    std::vector<dolfin::la_index> rows, cols;
+
+    #pragma omp for schedule(static)
+    for (int e = 0; e < num_entities; ++e)
+    {
+      // Collect row and column dofs of entity
+      rows.clear();
+      cols.clear();
+      for (std::size_t k = 0; k < cells_per_entity; ++k)
+      {
+        const std::size_t c = cells[e*cells_per_entity + k];
+        const ArrayView<const dolfin::la_index> row_dofs
+          = row_dofmap.cell_dofs(c);
+        const ArrayView<const dolfin::la_index> col_dofs
+          = col_dofmap.cell_dofs(c);
+        rows.insert(rows.end(), row_dofs.begin(), row_dofs.end());
+        cols.insert(cols.end(), col_dofs.begin(), col_dofs.end());
+      }
+
+      // Reserve space in each row (and copy columns)
+      const std::size_t num_cols = cols.size();
+      for (std::size_t i = 0; i < rows.size(); ++i)
+      {
+        std::size_t pos;
+        #pragma omp atomic capture
+        { pos = positions[rows[i]]; positions[rows[i]] += num_cols; }
+
+        if (columns)
+          std::copy(cols.begin(), cols.end(), columns + pos);
+      }
+    }
+  }
+}
 //-----------------------------------------------------------------------------
 void
 SparsityPatternBuilder::build(GenericSparsityPattern& sparsity_pattern,
@@ -68,6 +121,18 @@ SparsityPatternBuilder::build(GenericSparsityPattern& sparsity_pattern,
   if (rank < 2)
     return;
 
+  // Build pattern for cells and facets in two passes if compressed
+  // rows can be inserted directly
+  SparsityPattern* pattern = dynamic_cast<SparsityPattern*>(&sparsity_pattern);
+  if (pattern && init && rank == 2)
+  {
+    build_compressed(*pattern, mesh, dofmaps, cells, interior_facets,
+                     exterior_facets);
+    cells = false;
+    interior_facets = false;
+    exterior_facets = false;
+  }
+
   // Vector to store macro-dofs, if required (for interior facets)
   std::vector<std::vector<dolfin::la_index>> macro_dofs(rank);
 
@@ -250,6 +315,127 @@ SparsityPatternBuilder::build(GenericSparsityPattern& sparsity_pattern,
     sparsity_pattern.apply();
 }
 //-----------------------------------------------------------------------------
+void SparsityPatternBuilder::build_compressed(
+  SparsityPattern& sparsity_pattern,
+  const Mesh& mesh,
+  const std::vector<const GenericDofMap*> dofmaps,
+  bool cells,
+  bool interior_facets,
+  bool exterior_facets)
+{
+  dolfin_assert(dofmaps.size() == 2);
+  const std::size_t D = mesh.topology().dim();
+
+  // Collect cells of entities attached to one cell (cells, exterior
+  // facets) and to two cells (interior facets)
+  std::vector<std::size_t> single_cells, cell_pairs;
+  if (cells)
+  {
+    single_cells.reserve(mesh.num_cells());
+    for (CellIterator cell(mesh); !cell.end(); ++cell)
+      single_cells.push_back(cell->index());
+  }
+
+  // Note: no need to iterate over exterior facets if cells are
+  //       included, since those dofs are included when tabulating
+  //       dofs on all cells
+  if (interior_facets || (exterior_facets && !cells))
+  {
+    // Compute facets and facet - cell connectivity if not already
+    // computed
+    mesh.init(D - 1);
+    mesh.init(D - 1, D);
+    if (!mesh.ordered())
+    {
+      dolfin_error("SparsityPatternBuilder.cpp",
+                   "compute sparsity pattern",
+                   "Mesh is not ordered according to the UFC numbering convention. "
+                   "Consider calling mesh.order()");
+    }
+
+    for (FacetIterator facet(mesh); !facet.end(); ++facet)
+    {
+      if (facet->num_global_entities(D) == 1)
+      {
+        if (exterior_facets && !cells)
+        {
+          dolfin_assert(facet->num_entities(D) == 1);
+          single_cells.push_back(facet->entities(D)[0]);
+        }
+      }
+      else if (interior_facets)
+      {
+        if (facet->num_entities(D) == 1)
+        {
+          dolfin_assert(facet->is_ghost());
+          continue;
+        }
+
+        dolfin_assert(facet->num_entities(D) == 2);
+        cell_pairs.push_back(facet->entities(D)[0]);
+        cell_pairs.push_back(facet->entities(D)[1]);
+      }
+    }
+  }
+
+  // Rows are along the primary dimension and include unowned rows
+  const std::size_t primary_dim = sparsity_pattern.primary_dim();
+  const GenericDofMap& row_dofmap = *dofmaps[primary_dim];
+  const GenericDofMap& col_dofmap = *dofmaps[1 - primary_dim];
+  std::shared_ptr<const IndexMap> row_index_map = row_dofmap.index_map();
+  const std::size_t num_rows = row_index_map->size()
+    + row_index_map->block_size()*row_index_map->local_to_global_unowned().size();
+
+  const int num_threads = std::max((int) parameters["num_threads"], 1);
+
+  // First pass: count entries (including duplicates) of each row
+  std::vector<std::size_t> offsets(num_rows + 1, 0);
+  add_entity_dofs(single_cells, 1, row_dofmap, col_dofmap,
+                  offsets.data() + 1, NULL, num_threads);
+  add_entity_dofs(cell_pairs, 2, row_dofmap, col_dofmap,
+                  offsets.data() + 1, NULL, num_threads);
+  for (std::size_t i = 0; i < num_rows; ++i)
+    offsets[i + 1] += offsets[i];
+
+  // Second pass: fill preallocated rows
+  std::vector<dolfin::la_index> columns(offsets.back());
+  std::vector<std::size_t> positions(offsets.begin(), offsets.end() - 1);
+  add_entity_dofs(single_cells, 1, row_dofmap, col_dofmap,
+                  positions.data(), columns.data(), num_threads);
+  add_entity_dofs(cell_pairs, 2, row_dofmap, col_dofmap,
+                  positions.data(), columns.data(), num_threads);
+  std::vector<std::size_t>().swap(positions);
+
+  // Sort rows and remove duplicates
+  std::vector<std::size_t> row_sizes(num_rows);
+  #pragma omp parallel for schedule(dynamic, 256) num_threads(num_threads)
+  for (int i = 0; i < (int) num_rows; ++i)
+  {
+    std::vector<dolfin::la_index>::iterator row_begin
+      = columns.begin() + offsets[i];
+    std::vector<dolfin::la_index>::iterator row_end
+      = columns.begin() + offsets[i + 1];
+    std::sort(row_begin, row_end);
+    row_sizes[i] = std::unique(row_begin, row_end) - row_begin;
+  }
+
+  // Compact rows (entries only move towards the front)
+  std::size_t pos = 0;
+  for (std::size_t i = 0; i < num_rows; ++i)
+  {
+    const std::size_t first = offsets[i];
+    offsets[i] = pos;
+    std::copy(columns.begin() + first, columns.begin() + first + row_sizes[i],
+              columns.begin() + pos);
+    pos += row_sizes[i];
+  }
+  offsets[num_rows] = pos;
+  columns.resize(pos);
+
+  // Insert rows into sparsity pattern
+  sparsity_pattern.insert_local_rows(offsets, columns);
+}
+//-----------------------------------------------------------------------------
 void SparsityPatternBuilder::build_multimesh_sparsity_pattern(
   GenericSparsityPattern& sparsity_pattern,
   const MultiMeshForm& form)
@@ -35,6 +35,7 @@ namespace dolfin
   class GenericSparsityPattern;
   class Mesh;
   class MultiMeshForm;
+  class SparsityPattern;
 
   /// This class provides functions to compute the sparsity pattern
   /// based on DOF maps
@@ -62,6 +63,16 @@ namespace dolfin
 
   private:
 
+    // Build sparsity pattern for cells and facets in two passes,
+    // first counting the entries of each row and then filling
+    // preallocated compressed rows
+    static void build_compressed(SparsityPattern& sparsity_pattern,
+                                 const Mesh& mesh,
+                                 const std::vector<const GenericDofMap*> dofmaps,
+                                 bool cells,
+                                 bool interior_facets,
+                                 bool exterior_facets);
+
     // Build sparsity pattern for interface part of multimesh form
     static void _build_multimesh_sparsity_pattern_interface
       (GenericSparsityPattern& sparsity_pattern,
@@ -38,7 +38,10 @@
 #include <dolfin/mesh/Facet.h>
 #include <dolfin/mesh/MeshFunction.h>
 #include <dolfin/mesh/SubDomain.h>
+#include <dolfin/parameter/GlobalParameters.h>
 #include "AssemblerBase.h"
+#include "AssemblyPlan.h"
+#include "AssemblySchedule.h"
 #include "DirichletBC.h"
 #include "FiniteElement.h"
 #include "Form.h"
@@ -133,6 +136,22 @@ void SystemAssembler::assemble(GenericVector& b, const GenericVector& x0)
   assemble(NULL, &b, &x0);
 }
 //-----------------------------------------------------------------------------
+void SystemAssembler::set_assembly_plans(std::shared_ptr<AssemblyPlan> a_plan,
+                                         std::shared_ptr<AssemblyPlan> L_plan)
+{
+  // Check that plans match forms
+  if ((a_plan && &a_plan->form() != _a.get())
+      || (L_plan && &L_plan->form() != _l.get()))
+  {
+    dolfin_error("SystemAssembler.cpp",
+                 "set assembly plans",
+                 "Assembly plans must be created for the forms of the assembler");
+  }
+
+  _a_plan = a_plan;
+  _l_plan = L_plan;
+}
+//-----------------------------------------------------------------------------
 void SystemAssembler::check_arity(std::shared_ptr<const Form> a,
                                   std::shared_ptr<const Form> L)
 {
@@ -241,26 +260,51 @@ void SystemAssembler::assemble(GenericMatrix* A, GenericVector* b,
                  "expected forms (a, L) to share a FunctionSpace");
   }
 
-  // Create data structures for local assembly data
-  UFC A_ufc(*_a), b_ufc(*_l);
+  // Create data structures for local assembly data, reusing the data
+  // of the assembly plans (if any)
+  std::unique_ptr<UFC> A_ufc, b_ufc;
+  std::array<UFC*, 2> ufc;
+  if (_a_plan)
+  {
+    _a_plan->update();
+    ufc[0] = &_a_plan->ufc();
+  }
+  else
+  {
+    A_ufc.reset(new UFC(*_a));
+    ufc[0] = A_ufc.get();
+  }
+  if (_l_plan)
+  {
+    _l_plan->update();
+    ufc[1] = &_l_plan->ufc();
+  }
+  else
+  {
+    b_ufc.reset(new UFC(*_l));
+    ufc[1] = b_ufc.get();
+  }
 
   // Raise error for Point integrals
-  if (A_ufc.form.has_vertex_integrals() || b_ufc.form.has_vertex_integrals())
+  if (ufc[0]->form.has_vertex_integrals()
+      || ufc[1]->form.has_vertex_integrals())
   {
     dolfin_error("SystemAssembler.cpp",
                  "assemble system",
                  "Point integrals are not supported (yet)");
   }
 
-  // Gather UFC  objects
-  std::array<UFC*, 2> ufc = { { &A_ufc, &b_ufc} } ;
-
   // Initialize global tensors
   if (A)
     init_global_tensor(*A, *_a);
   if (b)
     init_global_tensor(*b, *_l);
 
+  // Bind plan for bilinear form to matrix
+  AssemblyPlan* a_plan = NULL;
+  if (A && _a_plan && _a_plan->bind(*A))
+    a_plan = _a_plan.get();
+
   // Gather tensors
   std::array<GenericTensor*, 2> tensors = { {A, b} };
 
@@ -328,7 +372,7 @@ void SystemAssembler::assemble(GenericMatrix* A, GenericVector* b,
       && !ufc[1]->form.has_interior_facet_integrals())
   {
     // Assemble cell-wise (no interior facet integrals)
-    cell_wise_assembly(tensors, ufc, data, boundary_values,
+    cell_wise_assembly(tensors, ufc, a_plan, data, boundary_values,
                        cell_domains, exterior_facet_domains);
   }
   else
@@ -339,6 +383,10 @@ void SystemAssembler::assemble(GenericMatrix* A, GenericVector* b,
                         interior_facet_domains);
   }
 
+  // Release direct access to matrix storage
+  if (a_plan)
+    a_plan->release();
+
   // Finalise assembly
   if (finalize_tensor)
   {
@@ -352,6 +400,7 @@ void SystemAssembler::assemble(GenericMatrix* A, GenericVector* b,
 void SystemAssembler::cell_wise_assembly(
   std::array<GenericTensor*, 2>& tensors,
   std::array<UFC*, 2>& ufc,
+  AssemblyPlan* a_plan,
   Scratch& data,
   const std::vector<DirichletBC::Map>& boundary_values,
   std::shared_ptr<const MeshFunction<std::size_t>> cell_domains,
@@ -372,32 +421,81 @@ void SystemAssembler::cell_wise_assembly(
     mesh.init(D - 1, D);
   }
 
-  // Collect pointers to dof maps
-  std::array<std::vector<const GenericDofMap*>, 2> dofmaps;
-  for (std::size_t i = 0; i < 2; ++i)
-    dofmaps[0].push_back(ufc[0]->dolfin_form.function_space(i)->dofmap().get());
-  dofmaps[1].push_back(ufc[1]->dolfin_form.function_space(0)->dofmap().get());
-
-  // Vector to hold dof map for a cell
-  std::array<std::vector<ArrayView<const dolfin::la_index>>, 2> cell_dofs
-    = { {std::vector<ArrayView<const dolfin::la_index>>(2),
-         std::vector<ArrayView<const dolfin::la_index>>(1)} };
+  // Check whether integrals are domain-dependent
+  const MeshFunction<std::size_t>* cell_markers
+    = (cell_domains && !cell_domains->empty()) ? cell_domains.get() : NULL;
+  const MeshFunction<std::size_t>* exterior_facet_markers
+    = (exterior_facet_domains && !exterior_facet_domains->empty())
+    ? exterior_facet_domains.get() : NULL;
+
+#ifdef HAS_OPENMP
+  // Assemble blocks of cells in parallel
+  const std::size_t num_threads = parameters["num_threads"];
+  if (num_threads > 0 && MPI::size(mesh.mpi_comm()) == 1)
+  {
+    Timer timer("Assemble system (cell-wise, threaded)");
+
+    std::vector<std::size_t> cells(mesh.num_cells());
+    for (std::size_t c = 0; c < cells.size(); ++c)
+      cells[c] = c;
+
+    const std::size_t bytes_per_cell
+      = sizeof(double)*(data.Ae[0].size() + data.Ae[1].size())
+      + sizeof(dolfin::la_index)*data.dofmaps[0][0]->max_element_dofs();
+    const std::size_t block_size = parameters["threaded_assembly_block_size"];
+    const bool reproducible = parameters["threaded_assembly_reproducible"];
+    AssemblySchedule schedule(cells, cells, 1, data.dofmaps[0][0],
+                              block_size, bytes_per_cell, num_threads,
+                              reproducible);
+    const std::vector<std::size_t>& colored_blocks
+      = schedule.colored_blocks();
+
+    #pragma omp parallel num_threads(num_threads)
+    {
+      // Each thread needs its own UFC objects, work arrays and
+      // staging buffer
+      UFC A_ufc(*ufc[0]);
+      UFC b_ufc(*ufc[1]);
+      std::array<UFC*, 2> thread_ufc = { {&A_ufc, &b_ufc} };
+      Scratch thread_data(ufc[0]->dolfin_form, ufc[1]->dolfin_form);
+      TensorBuffer buffer(tensors, true);
+      ufc::cell ufc_cell;
+      std::vector<double> coordinate_dofs;
+
+      for (std::size_t color = 0; color < schedule.num_colors(); ++color)
+      {
+        const int first = schedule.color(color).first;
+        const int last = schedule.color(color).second;
 
-  // Create pointers to hold integral objects
-  std::array<const ufc::cell_integral*, 2> cell_integrals
-    = { {ufc[0]->default_cell_integral.get(),
-         ufc[1]->default_cell_integral.get()} };
+        // Threads take blocks of the current colour on demand
+        #pragma omp for schedule(dynamic, 1)
+        for (int k = first; k < last; ++k)
+        {
+          const std::size_t b = colored_blocks[k];
+          const std::pair<std::size_t, std::size_t> range = schedule.block(b);
+          for (std::size_t pos = range.first; pos < range.second; ++pos)
+          {
+            const Cell cell(mesh, cells[pos]);
+            assemble_cell(buffer, thread_ufc, thread_data, ufc_cell,
+                          coordinate_dofs, cell, a_plan, boundary_values,
+                          cell_markers, exterior_facet_markers,
+                          has_exterior_facet_integrals);
+          }
 
-  std::array<const ufc::exterior_facet_integral*, 2> exterior_facet_integrals
-    = { { ufc[0]->default_exterior_facet_integral.get(),
-          ufc[1]->default_exterior_facet_integral.get()} };
+          // Add block to global tensors
+          schedule.lock(b);
+          buffer.flush();
+          schedule.unlock(b);
+        }
+      }
+    }
 
-  // Check whether integrals are domain-dependent
-  bool use_cell_domains = cell_domains && !cell_domains->empty();
-  bool use_exterior_facet_domains
-    = exterior_facet_domains && !exterior_facet_domains->empty();
+    return;
+  }
+#endif
 
   // Iterate over all cells
+  TensorBuffer buffer(tensors, false);
   ufc::cell ufc_cell;
   std::vector<double> coordinate_dofs;
   Progress p("Assembling system (cell-wise)", mesh.num_cells());
@@ -406,130 +504,161 @@ void SystemAssembler::cell_wise_assembly(
     // Check that cell is not a ghost
     dolfin_assert(!cell->is_ghost());
 
-    // Get cell vertex coordinates
-    cell->get_coordinate_dofs(coordinate_dofs);
+    assemble_cell(buffer, ufc, data, ufc_cell, coordinate_dofs, *cell,
+                  a_plan, boundary_values, cell_markers,
+                  exterior_facet_markers, has_exterior_facet_integrals);
+    p++;
+  }
+}
+//-----------------------------------------------------------------------------
+void SystemAssembler::assemble_cell(
+  TensorBuffer& buffer,
+  std::array<UFC*, 2>& ufc,
+  Scratch& data,
+  ufc::cell& ufc_cell,
+  std::vector<double>& coordinate_dofs,
+  const Cell& cell,
+  AssemblyPlan* a_plan,
+  const std::vector<DirichletBC::Map>& boundary_values,
+  const MeshFunction<std::size_t>* cell_domains,
+  const MeshFunction<std::size_t>* exterior_facet_domains,
+  bool has_exterior_facet_integrals)
+{
+  // Vector to hold dof map for a cell
+  std::array<std::vector<ArrayView<const dolfin::la_index>>*, 2> cell_dofs
+    = { {&data.cell_dofs[0][0], &data.cell_dofs[1][0]} };
 
-    // Get UFC cell data
-    cell->get_cell_data(ufc_cell);
+  // Get cell vertex coordinates
+  cell.get_coordinate_dofs(coordinate_dofs);
 
-    // Loop over lhs and then rhs contributions
-    for (std::size_t form = 0; form < 2; ++form)
-    {
-      // Get rank (lhs=2, rhs=1)
-      const std::size_t rank = (form == 0) ? 2 : 1;
+  // Get UFC cell data
+  cell.get_cell_data(ufc_cell);
 
-      // Zero data
-      std::fill(data.Ae[form].begin(), data.Ae[form].end(), 0.0);
+  // Loop over lhs and then rhs contributions
+  for (std::size_t form = 0; form < 2; ++form)
+  {
+    // Get rank (lhs=2, rhs=1)
+    const std::size_t rank = (form == 0) ? 2 : 1;
 
-      // Get cell integrals for sub domain (if any)
-      if (use_cell_domains)
-      {
-        const std::size_t domain = (*cell_domains)[*cell];
-        cell_integrals[form] = ufc[form]->get_cell_integral(domain);
-      }
+    // Zero data
+    std::fill(data.Ae[form].begin(), data.Ae[form].end(), 0.0);
 
-      // Get local-to-global dof maps for cell
-      for (std::size_t dim = 0; dim < rank; ++dim)
-        cell_dofs[form][dim] = dofmaps[form][dim]->cell_dofs(cell->index());
+    // Get cell integrals for sub domain (if any)
+    const ufc::cell_integral* cell_integral
+      = ufc[form]->default_cell_integral.get();
+    if (cell_domains)
+      cell_integral = ufc[form]->get_cell_integral((*cell_domains)[cell]);
 
-      // Compute cell tensor (if required)
-      bool tensor_required;
-      if (rank == 2) // form == 0
-      {
-        tensor_required = cell_matrix_required(tensors[form],
-                                               cell_integrals[form],
-                                               boundary_values,
-                                               cell_dofs[form][1]);
-      }
-      else
-        tensor_required = tensors[form] && cell_integrals[form];
+    // Get local-to-global dof maps for cell
+    for (std::size_t dim = 0; dim < rank; ++dim)
+    {
+      (*cell_dofs[form])[dim]
+        = data.dofmaps[form][dim]->cell_dofs(cell.index());
+    }
 
-      if (tensor_required)
-      {
-        // Update to current cell
-        ufc[form]->update(*cell, coordinate_dofs, ufc_cell,
-                          cell_integrals[form]->enabled_coefficients());
+    // Compute cell tensor (if required)
+    bool tensor_required;
+    if (rank == 2) // form == 0
+    {
+      tensor_required = cell_matrix_required(buffer.tensor(form),
+                                             cell_integral,
+                                             boundary_values,
+                                             (*cell_dofs[form])[1]);
+    }
+    else
+      tensor_required = buffer.tensor(form) && cell_integral;
 
-        // Tabulate cell tensor
-        cell_integrals[form]->tabulate_tensor(ufc[form]->A.data(),
-                                              ufc[form]->w(),
-                                              coordinate_dofs.data(),
-                                              ufc_cell.orientation);
-        for (std::size_t i = 0; i < data.Ae[form].size(); ++i)
-          data.Ae[form][i] += ufc[form]->A[i];
-      }
+    if (tensor_required)
+    {
+      // Update to current cell
+      ufc[form]->update(cell, coordinate_dofs, ufc_cell,
+                        cell_integral->enabled_coefficients());
+
+      // Tabulate cell tensor
+      cell_integral->tabulate_tensor(ufc[form]->A.data(),
+                                     ufc[form]->w(),
+                                     coordinate_dofs.data(),
+                                     ufc_cell.orientation);
+      for (std::size_t i = 0; i < data.Ae[form].size(); ++i)
+        data.Ae[form][i] += ufc[form]->A[i];
+    }
 
-      // Compute exterior facet integral if present
-      if (has_exterior_facet_integrals)
+    // Compute exterior facet integral if present
+    if (has_exterior_facet_integrals)
+    {
+      for (FacetIterator facet(cell); !facet.end(); ++facet)
       {
-        for (FacetIterator facet(*cell); !facet.end(); ++facet)
-        {
-          // Only consider exterior facets
-          if (!facet->exterior())
-            continue;
+        // Only consider exterior facets
+        if (!facet->exterior())
+          continue;
 
-          // Get exterior facet integrals for sub domain (if any)
-          if (use_exterior_facet_domains)
-          {
-            const std::size_t domain = (*exterior_facet_domains)[*facet];
-            exterior_facet_integrals[form]
-              = ufc[form]->get_exterior_facet_integral(domain);
-          }
+        // Get exterior facet integrals for sub domain (if any)
+        const ufc::exterior_facet_integral* exterior_facet_integral
+          = ufc[form]->default_exterior_facet_integral.get();
+        if (exterior_facet_domains)
+        {
+          const std::size_t domain = (*exterior_facet_domains)[*facet];
+          exterior_facet_integral
+            = ufc[form]->get_exterior_facet_integral(domain);
+        }
 
-          // Skip if there are no integrals
-          if (!exterior_facet_integrals[form])
-            continue;
+        // Skip if there are no integrals
+        if (!exterior_facet_integral)
+          continue;
 
-          // Extract local facet index
-          const std::size_t local_facet = cell->index(*facet);
+        // Extract local facet index
+        const std::size_t local_facet = cell.index(*facet);
 
-          // Determine if tensor needs to be computed
-          bool tensor_required;
-          if (rank == 2) // form == 0
-          {
-            tensor_required
-              = cell_matrix_required(tensors[form],
-                                     exterior_facet_integrals[form],
-                                     boundary_values,
-                                     cell_dofs[form][1]);
-          }
-          else
-            tensor_required = tensors[form];
+        // Determine if tensor needs to be computed
+        bool tensor_required;
+        if (rank == 2) // form == 0
+        {
+          tensor_required
+            = cell_matrix_required(buffer.tensor(form),
+                                   exterior_facet_integral,
+                                   boundary_values,
+                                   (*cell_dofs[form])[1]);
+        }
+        else
+          tensor_required = buffer.tensor(form);
 
-          // Add exterior facet tensor
-          if (tensor_required)
-          {
-            // Update to current cell
-            cell->get_cell_data(ufc_cell);
-            ufc[form]->update(*cell, coordinate_dofs, ufc_cell,
-                              exterior_facet_integrals[form]->enabled_coefficients());
-
-            // Tabulate exterior facet tensor
-            exterior_facet_integrals[form]->tabulate_tensor(ufc[form]->A.data(),
-                                                            ufc[form]->w(),
-                                                            coordinate_dofs.data(),
-                                                            local_facet,
-                                                            ufc_cell.orientation);
-            for (std::size_t i = 0; i < data.Ae[form].size(); i++)
-              data.Ae[form][i] += ufc[form]->A[i];
-          }
+        // Add exterior facet tensor
+        if (tensor_required)
+        {
+          // Update to current cell
+          cell.get_cell_data(ufc_cell);
+          ufc[form]->update(cell, coordinate_dofs, ufc_cell,
+                            exterior_facet_integral->enabled_coefficients());
+
+          // Tabulate exterior facet tensor
+          exterior_facet_integral->tabulate_tensor(ufc[form]->A.data(),
+                                                   ufc[form]->w(),
+                                                   coordinate_dofs.data(),
+                                                   local_facet,
+                                                   ufc_cell.orientation);
+          for (std::size_t i = 0; i < data.Ae[form].size(); i++)
+            data.Ae[form][i] += ufc[form]->A[i];
         }
       }
     }
+  }
 
-    // Modify local matrix/element for Dirichlet boundary conditions
-    apply_bc(data.Ae[0].data(), data.Ae[1].data(), boundary_values,
-             cell_dofs[0][0], cell_dofs[0][1]);
-
-    // Add entries to global tensor
-    for (std::size_t form = 0; form < 2; ++form)
-    {
-      if (tensors[form])
-        tensors[form]->add_local(data.Ae[form].data(), cell_dofs[form]);
-    }
+  // Modify local matrix/element for Dirichlet boundary conditions
+  apply_bc(data.Ae[0].data(), data.Ae[1].data(), boundary_values,
+           (*cell_dofs[0])[0], (*cell_dofs[0])[1]);
 
-    p++;
+  // Add entries to global tensor, adding the cell matrix directly
+  // into the matrix storage if the cell is in the assembly plan
+  const int k = a_plan ? a_plan->plan_index(cell.index()) : -1;
+  if (k >= 0)
+  {
+    buffer.add_direct(a_plan->values(), a_plan->positions(k),
+                      data.Ae[0].data(), data.Ae[0].size());
   }
+  else if (buffer.tensor(0))
+    buffer.add_local(0, data.Ae[0].data(), *cell_dofs[0]);
+  if (buffer.tensor(1))
+    buffer.add_local(1, data.Ae[1].data(), *cell_dofs[1]);
 }
 //-----------------------------------------------------------------------------
 void SystemAssembler::facet_wise_assembly(
@@ -550,34 +679,136 @@ void SystemAssembler::facet_wise_assembly(
   mesh.init(D - 1);
   mesh.init(D - 1, D);
 
-  // Get my MPI rank
-  const int my_mpi_rank = MPI::rank(mesh.mpi_comm());
+  // Check whether integrals are domain-dependent
+  const MeshFunction<std::size_t>* cell_markers
+    = (cell_domains && !cell_domains->empty()) ? cell_domains.get() : NULL;
+  const MeshFunction<std::size_t>* exterior_facet_markers
+    = (exterior_facet_domains && !exterior_facet_domains->empty())
+    ? exterior_facet_domains.get() : NULL;
+  const MeshFunction<std::size_t>* interior_facet_markers
+    = (interior_facet_domains && !interior_facet_domains->empty())
+    ? interior_facet_domains.get() : NULL;
+
+#ifdef HAS_OPENMP
+  // Assemble blocks of facets in parallel
+  const std::size_t num_threads = parameters["num_threads"];
+  if (num_threads > 0 && MPI::size(mesh.mpi_comm()) == 1)
+  {
+    Timer timer("Assemble system (facet-wise, threaded)");
+
+    // Collect facets and the cells incident with each facet (the
+    // cell of an exterior facet is repeated)
+    const MeshConnectivity& facet_cell_connectivity
+      = mesh.topology()(D - 1, D);
+    std::vector<std::size_t> facets(mesh.num_facets());
+    std::vector<std::size_t> facet_cells(2*facets.size());
+    for (std::size_t f = 0; f < facets.size(); ++f)
+    {
+      const unsigned int* cells = facet_cell_connectivity(f);
+      const std::size_t num_cells = facet_cell_connectivity.size(f);
+      facets[f] = f;
+      facet_cells[2*f] = cells[0];
+      facet_cells[2*f + 1] = cells[num_cells - 1];
+    }
 
-  // Collect pointers to dof maps
-  std::array<std::vector<const GenericDofMap*>, 2> dofmaps;
-  for (std::size_t i = 0; i < 2; ++i)
-    dofmaps[0].push_back(ufc[0]->dolfin_form.function_space(i)->dofmap().get());
-  dofmaps[1].push_back(ufc[1]->dolfin_form.function_space(0)->dofmap().get());
+    const std::size_t bytes_per_facet
+      = 4*sizeof(double)*(data.Ae[0].size() + data.Ae[1].size())
+      + 2*sizeof(dolfin::la_index)*data.dofmaps[0][0]->max_element_dofs();
+    const std::size_t block_size = parameters["threaded_assembly_block_size"];
+    const bool reproducible = parameters["threaded_assembly_reproducible"];
+    AssemblySchedule schedule(facets, facet_cells, 2, data.dofmaps[0][0],
+                              block_size, bytes_per_facet, num_threads,
+                              reproducible);
+    const std::vector<std::size_t>& colored_blocks
+      = schedule.colored_blocks();
+
+    #pragma omp parallel num_threads(num_threads)
+    {
+      // Each thread needs its own UFC objects, work arrays and
+      // staging buffer
+      UFC A_ufc(*ufc[0]);
+      UFC b_ufc(*ufc[1]);
+      std::array<UFC*, 2> thread_ufc = { {&A_ufc, &b_ufc} };
+      Scratch thread_data(ufc[0]->dolfin_form, ufc[1]->dolfin_form);
+      TensorBuffer buffer(tensors, true);
+      std::array<ufc::cell, 2> ufc_cell;
+      std::array<std::vector<double>, 2> coordinate_dofs;
+
+      for (std::size_t color = 0; color < schedule.num_colors(); ++color)
+      {
+        const int first = schedule.color(color).first;
+        const int last = schedule.color(color).second;
+
+        // Threads take blocks of the current colour on demand
+        #pragma omp for schedule(dynamic, 1)
+        for (int k = first; k < last; ++k)
+        {
+          const std::size_t b = colored_blocks[k];
+          const std::pair<std::size_t, std::size_t> range = schedule.block(b);
+          for (std::size_t pos = range.first; pos < range.second; ++pos)
+          {
+            const Facet facet(mesh, facets[pos]);
+            assemble_facet(buffer, thread_ufc, thread_data, ufc_cell,
+                           coordinate_dofs, facet, boundary_values,
+                           cell_markers, exterior_facet_markers,
+                           interior_facet_markers);
+          }
+
+          // Add block to global tensors
+          schedule.lock(b);
+          buffer.flush();
+          schedule.unlock(b);
+        }
+      }
+    }
+
+    return;
+  }
+#endif
+
+  // Iterate over facets
+  TensorBuffer buffer(tensors, false);
+  std::array<ufc::cell, 2> ufc_cell;
+  std::array<std::vector<double>, 2> coordinate_dofs;
+  Progress p("Assembling system (facet-wise)", mesh.num_facets());
+  for (FacetIterator facet(mesh); !facet.end(); ++facet)
+  {
+    // Check that facet is not a ghost
+    dolfin_assert(!facet->is_ghost());
+
+    assemble_facet(buffer, ufc, data, ufc_cell, coordinate_dofs, *facet,
+                   boundary_values, cell_markers, exterior_facet_markers,
+                   interior_facet_markers);
+    p++;
+  }
+}
+//-----------------------------------------------------------------------------
+void SystemAssembler::assemble_facet(
+  TensorBuffer& buffer,
+  std::array<UFC*, 2>& ufc,
+  Scratch& data,
+  std::array<ufc::cell, 2>& ufc_cell,
+  std::array<std::vector<double>, 2>& coordinate_dofs,
+  const Facet& facet,
+  const std::vector<DirichletBC::Map>& boundary_values,
+  const MeshFunction<std::size_t>* cell_domains,
+  const MeshFunction<std::size_t>* exterior_facet_domains,
+  const MeshFunction<std::size_t>* interior_facet_domains)
+{
+  // Extract mesh
+  const Mesh& mesh = facet.mesh();
+  const std::size_t D = mesh.topology().dim();
 
   // Cell dofmaps [form][cell][form dim]
   std::array<std::array<std::vector<ArrayView<const dolfin::la_index>>,
-                        2>, 2> cell_dofs;
-  cell_dofs[0][0].resize(2);
-  cell_dofs[0][1].resize(2);
-  cell_dofs[1][0].resize(1);
-  cell_dofs[1][1].resize(1);
-
-  std::array<Cell, 2> cell;
-  std::array<std::size_t, 2> cell_index;
-  std::array<std::size_t, 2> local_facet;
+                        2>, 2>& cell_dofs = data.cell_dofs;
 
   // Vectors to hold dofs for macro cells
-  std::array<std::vector<std::vector<dolfin::la_index>>, 2> macro_dofs;
-  macro_dofs[0].resize(2);
-  macro_dofs[1].resize(1);
+  std::array<std::vector<std::vector<dolfin::la_index>>, 2>& macro_dofs
+    = data.macro_dofs;
 
   // Holder for number of dofs in macro-dofmap
-  std::vector<std::size_t> num_dofs(2);
+  std::array<std::size_t, 2> num_dofs;
 
   // Holders for UFC integrals
   std::array<const ufc::cell_integral*, 2> cell_integrals
@@ -590,314 +821,301 @@ void SystemAssembler::facet_wise_assembly(
     = { { ufc[0]->default_interior_facet_integral.get(),
           ufc[1]->default_interior_facet_integral.get() } };
 
-  // Check whether integrals are domain-dependent
-  bool use_cell_domains = cell_domains && !cell_domains->empty();
-  bool use_interior_facet_domains
-    = interior_facet_domains && !interior_facet_domains->empty();
-  bool use_exterior_facet_domains
-    = exterior_facet_domains && !exterior_facet_domains->empty();
-
   // Indicator whether or not tensor is required
   std::array<bool, 2> tensor_required_cell, tensor_required_facet;
 
-  // Track whether or not cell contribution has been computed
+  // The cell contribution is computed together with the first facet
+  // (lowest facet index) of the cell, which makes facets independent
+  // of each other
   std::array<bool, 2> compute_cell_tensor = {{true, true}};
-  std::vector<bool> cell_tensor_computed(mesh.num_cells(), false);
 
-  // Iterate over facets
-  std::array<ufc::cell, 2> ufc_cell;
-  std::array<std::vector<double>, 2> coordinate_dofs;
-  Progress p("Assembling system (facet-wise)", mesh.num_facets());
-  for (FacetIterator facet(mesh); !facet.end(); ++facet)
+  // Number of cells sharing facet
+  const std::size_t num_cells = facet.num_entities(D);
+
+  // Interior facet
+  if (num_cells == 2)
   {
-    // Number of cells sharing facet
-    const std::size_t num_cells = facet->num_entities(D);
+    // Get cells incident with facet (which is 0 and 1 here is arbitrary)
+    std::array<std::size_t, 2> cell_indices = {{facet.entities(D)[0],
+                                                facet.entities(D)[1]}};
+
+    // Make sure cell marker for '+' side is larger than cell marker
+    // for '-' side.  Note: by ffc convention, 0 is + and 1 is -
+    if (cell_domains && (*cell_domains)[cell_indices[0]]
+        < (*cell_domains)[cell_indices[1]])
+    {
+      std::swap(cell_indices[0], cell_indices[1]);
+    }
 
-    // Check that facet is not a ghost
-    dolfin_assert(!facet->is_ghost());
+    // Get cells incident with facet and associated data
+    std::array<Cell, 2> cell;
+    std::array<std::size_t, 2> local_facet;
+    for (std::size_t c = 0; c < 2; ++c)
+    {
+      cell[c] = Cell(mesh, cell_indices[c]);
+      local_facet[c] = cell[c].index(facet);
+      cell[c].get_coordinate_dofs(coordinate_dofs[c]);
+      cell[c].get_cell_data(ufc_cell[c], local_facet[c]);
+
+      compute_cell_tensor[c] = is_first_facet(cell[c], facet);
+    }
 
-    // Interior facet
-    if (num_cells == 2)
+    const bool process_facet = (cell[0].is_ghost() != cell[1].is_ghost());
+    bool facet_owner = true;
+    if (process_facet)
     {
-      // Get cells incident with facet (which is 0 and 1 here is arbitrary)
-      dolfin_assert(facet->num_entities(D) == 2);
-      std::array<std::size_t, 2> cell_indices = {{facet->entities(D)[0],
-                                                  facet->entities(D)[1]}};
-
-      // Make sure cell marker for '+' side is larger than cell marker
-      // for '-' side.  Note: by ffc convention, 0 is + and 1 is -
-      if (use_cell_domains && (*cell_domains)[cell_indices[0]]
-          < (*cell_domains)[cell_indices[1]])
-      {
-        std::swap(cell_indices[0], cell_indices[1]);
-      }
+      int ghost_rank = -1;
+      if (cell[0].is_ghost())
+        ghost_rank = cell[0].owner();
+      else
+        ghost_rank = cell[1].owner();
+      dolfin_assert(MPI::rank(mesh.mpi_comm()) != ghost_rank);
+      dolfin_assert(ghost_rank != -1);
+      if (ghost_rank < (int) MPI::rank(mesh.mpi_comm()))
+        facet_owner = false;
+    }
 
-      // Get cells incident with facet and associated data
+    // Loop over lhs and then rhs contributions
+    for (std::size_t form = 0; form < 2; ++form)
+    {
+      // Get rank (lhs=2, rhs=1)
+      const std::size_t rank = (form == 0) ? 2 : 1;
+
+      // Compute number of dofs in macro dofmap
+      std::fill(num_dofs.begin(), num_dofs.begin() + rank, 0);
       for (std::size_t c = 0; c < 2; ++c)
       {
-        cell[c] = Cell(mesh, cell_indices[c]);
-        cell_index[c] = cell[c].index();
-        local_facet[c] = cell[c].index(*facet);
-        cell[c].get_coordinate_dofs(coordinate_dofs[c]);
-        cell[c].get_cell_data(ufc_cell[c], local_facet[c]);
+        for (std::size_t dim = 0; dim < rank; ++dim)
+        {
+          cell_dofs[form][c][dim]
+            = data.dofmaps[form][dim]->cell_dofs(cell_indices[c]);
+          num_dofs[dim] += cell_dofs[form][c][dim].size();
+        }
+
+        // Resize macro dof holder
+        for (std::size_t dim = 0; dim < rank; ++dim)
+          macro_dofs[form][dim].resize(num_dofs[dim]);
 
-        compute_cell_tensor[c] = !cell_tensor_computed[cell_index[c]];
+        // Tabulate dofs on macro element
+        for (std::size_t dim = 0; dim < rank; ++dim)
+        {
+          std::copy(cell_dofs[form][c][dim].begin(),
+                    cell_dofs[form][c][dim].end(),
+                    macro_dofs[form][dim].begin()
+                    + c*cell_dofs[form][0][dim].size());
+        }
       }
 
-      const bool process_facet = (cell[0].is_ghost() != cell[1].is_ghost());
-      bool facet_owner = true;
-      if (process_facet)
+      // Get facet integral for sub domain (if any)
+      if (interior_facet_domains)
       {
-        int ghost_rank = -1;
-        if (cell[0].is_ghost())
-          ghost_rank = cell[0].owner();
-        else
-          ghost_rank = cell[1].owner();
-        dolfin_assert(my_mpi_rank != ghost_rank);
-        dolfin_assert(ghost_rank != -1);
-        if (ghost_rank < my_mpi_rank)
-          facet_owner = false;
+        const std::size_t domain = (*interior_facet_domains)[facet];
+        interior_facet_integrals[form]
+          = ufc[form]->get_interior_facet_integral(domain);
       }
 
-      // Loop over lhs and then rhs contributions
-      for (std::size_t form = 0; form < 2; ++form)
+      // Check if facet tensor is required
+      if (rank == 2)
       {
-        // Get rank (lhs=2, rhs=1)
-        const std::size_t rank = (form == 0) ? 2 : 1;
-
-        // Compute number of dofs in macro dofmap
-        std::fill(num_dofs.begin(), num_dofs.begin() + rank, 0);
         for (std::size_t c = 0; c < 2; ++c)
         {
-          for (std::size_t dim = 0; dim < rank; ++dim)
-          {
-            cell_dofs[form][c][dim]
-              = dofmaps[form][dim]->cell_dofs(cell_index[c]);
-            num_dofs[dim] += cell_dofs[form][c][dim].size();
-          }
-
-          // Resize macro dof holder
-          for (std::size_t dim = 0; dim < rank; ++dim)
-            macro_dofs[form][dim].resize(num_dofs[dim]);
-
-          // Tabulate dofs on macro element
-          const std::size_t rank = (form == 0) ? 2 : 1;
-          for (std::size_t dim = 0; dim < rank; ++dim)
-          {
-            std::copy(cell_dofs[form][c][dim].begin(),
-                      cell_dofs[form][c][dim].end(),
-                      macro_dofs[form][dim].begin()
-                      + c*cell_dofs[form][0][dim].size());
-          }
+          tensor_required_facet[form]
+            = cell_matrix_required(buffer.tensor(form),
+                                   interior_facet_integrals[form],
+                                   boundary_values,
+                                   cell_dofs[form][c][1]);
+          if (tensor_required_facet[form])
+            break;
         }
+      }
+      else
+      {
+        tensor_required_facet[form]
+          = (buffer.tensor(form) && interior_facet_integrals[form]);
+      }
 
-        // Get facet integral for sub domain (if any)
-        if (use_interior_facet_domains)
+      // Get cell integrals (if required)
+      tensor_required_cell[form] = false;
+      for (std::size_t c = 0; c < 2; ++c)
+      {
+        if (compute_cell_tensor[c])
         {
-          const std::size_t domain = (*interior_facet_domains)[*facet];
-          interior_facet_integrals[form]
-            = ufc[form]->get_interior_facet_integral(domain);
-        }
+          // Get cell integrals for sub domain (if any)
+          if (cell_domains)
+          {
+            const std::size_t domain = (*cell_domains)[cell[c]];
+            cell_integrals[form] = ufc[form]->get_cell_integral(domain);
+          }
 
-        // Check if facet tensor is required
-        if (rank == 2)
-        {
-          for (std::size_t c = 0; c < 2; ++c)
+          // Check if facet tensor is required
+          if (form == 0)
           {
-            tensor_required_facet[form]
-              = cell_matrix_required(tensors[form],
-                                     interior_facet_integrals[form],
+            tensor_required_cell[form]
+              = cell_matrix_required(buffer.tensor(form),
+                                     cell_integrals[form],
                                      boundary_values,
                                      cell_dofs[form][c][1]);
-            if (tensor_required_facet[form])
-              break;
           }
-        }
-        else
-        {
-          tensor_required_facet[form]
-            = (tensors[form] && interior_facet_integrals[form]);
-        }
-
-        // Get cell integrals (if required)
-        for (std::size_t c = 0; c < 2; ++c)
-        {
-          if (compute_cell_tensor[c])
+          else
           {
-            // Get cell integrals for sub domain (if any)
-            if (use_cell_domains)
-            {
-              const std::size_t domain = (*cell_domains)[cell[c]];
-              cell_integrals[form] = ufc[form]->get_cell_integral(domain);
-            }
-
-            // Check if facet tensor is required
-            if (form == 0)
-            {
-              tensor_required_cell[form]
-                = cell_matrix_required(tensors[form],
-                                       cell_integrals[form],
-                                       boundary_values,
-                                       cell_dofs[form][c][1]);
-            }
-            else
-              tensor_required_cell[form] = tensors[form] && cell_integrals[form];
+            tensor_required_cell[form]
+              = buffer.tensor(form) && cell_integrals[form];
           }
         }
-
-        // Reset work array
-        std::fill(ufc[form]->macro_A.begin(), ufc[form]->macro_A.end(), 0.0);
-      }
-
-      // Compute cell/facet tensor for lhs and rhs
-      std::array<std::size_t, 2> matrix_size;
-      std::size_t vector_size = 0;
-      for (std::size_t c = 0; c < 2; ++c)
-      {
-        matrix_size[0] = cell_dofs[0][c][0].size();
-        matrix_size[1] = cell_dofs[0][c][1].size();
-        vector_size = cell_dofs[1][c][0].size();
-      }
-      compute_interior_facet_tensor(ufc, ufc_cell,
-                                    coordinate_dofs,
-                                    tensor_required_cell,
-                                    tensor_required_facet,
-                                    cell, local_facet,
-                                    facet_owner,
-                                    cell_integrals,
-                                    interior_facet_integrals,
-                                    matrix_size,
-                                    vector_size,
-                                    compute_cell_tensor);
-
-      // Modify local tensors for bcs
-      ArrayView<const la_index> mdofs0(macro_dofs[0][0]);
-      ArrayView<const la_index> mdofs1(macro_dofs[0][1]);
-      apply_bc(ufc[0]->macro_A.data(), ufc[1]->macro_A.data(), boundary_values,
-               mdofs0, mdofs1);
-
-      // Add entries to global tensor
-      if (tensors[1])
-      {
-        std::vector<ArrayView<const la_index>> mdofs(macro_dofs[1].size());
-        for (std::size_t i = 0; i < macro_dofs[1].size(); ++i)
-          mdofs[i].set(macro_dofs[1][i]);
-        tensors[1]->add_local(ufc[1]->macro_A.data(), mdofs);
       }
 
-      const bool add_macro_element
-        = ufc[0]->form.has_interior_facet_integrals();
-      if (tensors[0] && add_macro_element)
-      {
-        std::vector<ArrayView<const la_index>> mdofs(macro_dofs[0].size());
-        for (std::size_t i = 0; i < macro_dofs[0].size(); ++i)
-          mdofs[i].set(macro_dofs[0][i]);
-        tensors[0]->add_local(ufc[0]->macro_A.data(), mdofs);
-      }
-      else if (tensors[0] && !add_macro_element && tensor_required_cell[0])
-      {
-        // FIXME: This can be simplied by assembling into Ae instead
-        // of macro_A.
-
-        // The sparsity pattern may not support the macro element so
-        // instead extract back out the diagonal cell blocks and add
-        // them individually
-        matrix_block_add(*tensors[0], data.Ae[0], ufc[0]->macro_A,
-                         compute_cell_tensor, cell_dofs[0]);
-      }
+      // Reset work array
+      std::fill(ufc[form]->macro_A.begin(), ufc[form]->macro_A.end(), 0.0);
+    }
 
-      // Mark cells as processed
-      cell_tensor_computed[cell_index[0]] = true;
-      cell_tensor_computed[cell_index[1]] = true;
+    // Compute cell/facet tensor for lhs and rhs
+    std::array<std::size_t, 2> matrix_size;
+    std::size_t vector_size = 0;
+    for (std::size_t c = 0; c < 2; ++c)
+    {
+      matrix_size[0] = cell_dofs[0][c][0].size();
+      matrix_size[1] = cell_dofs[0][c][1].size();
+      vector_size = cell_dofs[1][c][0].size();
     }
-    else // Exterior facet
+    compute_interior_facet_tensor(ufc, ufc_cell,
+                                  coordinate_dofs,
+                                  tensor_required_cell,
+                                  tensor_required_facet,
+                                  cell, local_facet,
+                                  facet_owner,
+                                  cell_integrals,
+                                  interior_facet_integrals,
+                                  matrix_size,
+                                  vector_size,
+                                  compute_cell_tensor);
+
+    // Modify local tensors for bcs
+    ArrayView<const la_index> mdofs0(macro_dofs[0][0]);
+    ArrayView<const la_index> mdofs1(macro_dofs[0][1]);
+    apply_bc(ufc[0]->macro_A.data(), ufc[1]->macro_A.data(), boundary_values,
+             mdofs0, mdofs1);
+
+    // Add entries to global tensor
+    if (buffer.tensor(1))
     {
-      // Get mesh cell to which mesh facet belongs (pick first, there
-      // is only one)
-      Cell cell(mesh, facet->entities(mesh.topology().dim())[0]);
+      std::vector<ArrayView<const la_index>> mdofs(macro_dofs[1].size());
+      for (std::size_t i = 0; i < macro_dofs[1].size(); ++i)
+        mdofs[i].set(macro_dofs[1][i]);
+      buffer.add_local(1, ufc[1]->macro_A.data(), mdofs);
+    }
 
-      // Check of attached cell needs to be processed
-      compute_cell_tensor[0] = !cell_tensor_computed[cell.index()];
+    const bool add_macro_element
+      = ufc[0]->form.has_interior_facet_integrals();
+    if (buffer.tensor(0) && add_macro_element)
+    {
+      std::vector<ArrayView<const la_index>> mdofs(macro_dofs[0].size());
+      for (std::size_t i = 0; i < macro_dofs[0].size(); ++i)
+        mdofs[i].set(macro_dofs[0][i]);
+      buffer.add_local(0, ufc[0]->macro_A.data(), mdofs);
+    }
+    else if (buffer.tensor(0) && !add_macro_element && tensor_required_cell[0])
+    {
+      // FIXME: This can be simplied by assembling into Ae instead
+      // of macro_A.
+
+      // The sparsity pattern may not support the macro element so
+      // instead extract back out the diagonal cell blocks and add
+      // them individually
+      matrix_block_add(buffer, data.Ae[0], ufc[0]->macro_A,
+                       compute_cell_tensor, cell_dofs[0]);
+    }
+  }
+  else // Exterior facet
+  {
+    // Get mesh cell to which mesh facet belongs (pick first, there
+    // is only one)
+    Cell cell(mesh, facet.entities(D)[0]);
 
-       // Decide if tensor needs to be computed
-      for (std::size_t form = 0; form < 2; ++form)
-      {
-        // Get rank (lhs=2, rhs=1)
-        const std::size_t rank = (form == 0) ? 2 : 1;
+    // Check of attached cell needs to be processed
+    compute_cell_tensor[0] = is_first_facet(cell, facet);
 
-        // Get cell integrals for sub domain (if any)
-        if (use_cell_domains)
-        {
-          const std::size_t domain = (*cell_domains)[cell];
-          cell_integrals[form] = ufc[form]->get_cell_integral(domain);
-        }
+    // Decide if tensor needs to be computed
+    for (std::size_t form = 0; form < 2; ++form)
+    {
+      // Get rank (lhs=2, rhs=1)
+      const std::size_t rank = (form == 0) ? 2 : 1;
 
-        // Get exterior facet integrals for sub domain (if any)
-        if (use_exterior_facet_domains)
-        {
-          const std::size_t domain = (*exterior_facet_domains)[*facet];
-          exterior_facet_integrals[form]
-            = ufc[form]->get_exterior_facet_integral(domain);
-        }
+      // Get cell integrals for sub domain (if any)
+      if (cell_domains)
+      {
+        const std::size_t domain = (*cell_domains)[cell];
+        cell_integrals[form] = ufc[form]->get_cell_integral(domain);
+      }
 
-        // Get local-to-global dof maps for cell
-        for (std::size_t dim = 0; dim < rank; ++dim)
-        {
-          cell_dofs[form][0][dim]
-            = dofmaps[form][dim]->cell_dofs(cell.index());
-        }
+      // Get exterior facet integrals for sub domain (if any)
+      if (exterior_facet_domains)
+      {
+        const std::size_t domain = (*exterior_facet_domains)[facet];
+        exterior_facet_integrals[form]
+          = ufc[form]->get_exterior_facet_integral(domain);
+      }
 
-        // Store if tensor is required
-        if (rank == 2)
-        {
-          tensor_required_facet[form]
-            = cell_matrix_required(tensors[form],
-                                   exterior_facet_integrals[form],
-                                   boundary_values,
-                                   cell_dofs[form][0][1]);
-          tensor_required_cell[form]
-            = cell_matrix_required(tensors[form],
-                                   cell_integrals[form],
-                                   boundary_values,
-                                   cell_dofs[form][0][1]);
-        }
-        else
-        {
-          tensor_required_facet[form]
-            = (tensors[form] && exterior_facet_integrals[form]);
-          tensor_required_cell[form]
-            = tensors[form] && cell_integrals[form];
-        }
+      // Get local-to-global dof maps for cell
+      for (std::size_t dim = 0; dim < rank; ++dim)
+      {
+        cell_dofs[form][0][dim]
+          = data.dofmaps[form][dim]->cell_dofs(cell.index());
       }
 
-      // Compute cell/facet tensors
-      compute_exterior_facet_tensor(data.Ae, ufc, ufc_cell[0],
-                                    coordinate_dofs[0],
-                                    tensor_required_cell,
-                                    tensor_required_facet,
-                                    cell, *facet,
-                                    cell_integrals,
-                                    exterior_facet_integrals,
-                                    compute_cell_tensor[0]);
-
-      // Modify local matrix/element for Dirichlet boundary conditions
-      apply_bc(data.Ae[0].data(), data.Ae[1].data(), boundary_values,
-               cell_dofs[0][0][0], cell_dofs[0][0][1]);
-
-      // Add entries to global tensor
-      for (std::size_t form = 0; form < 2; ++form)
+      // Store if tensor is required
+      if (rank == 2)
+      {
+        tensor_required_facet[form]
+          = cell_matrix_required(buffer.tensor(form),
+                                 exterior_facet_integrals[form],
+                                 boundary_values,
+                                 cell_dofs[form][0][1]);
+        tensor_required_cell[form]
+          = cell_matrix_required(buffer.tensor(form),
+                                 cell_integrals[form],
+                                 boundary_values,
+                                 cell_dofs[form][0][1]);
+      }
+      else
       {
-        if (tensors[form])
-          tensors[form]->add_local(data.Ae[form].data(), cell_dofs[form][0]);
+        tensor_required_facet[form]
+          = (buffer.tensor(form) && exterior_facet_integrals[form]);
+        tensor_required_cell[form]
+          = buffer.tensor(form) && cell_integrals[form];
       }
+    }
+
+    // Compute cell/facet tensors
+    compute_exterior_facet_tensor(data.Ae, ufc, ufc_cell[0],
+                                  coordinate_dofs[0],
+                                  tensor_required_cell,
+                                  tensor_required_facet,
+                                  cell, facet,
+                                  cell_integrals,
+                                  exterior_facet_integrals,
+                                  compute_cell_tensor[0]);
+
+    // Modify local matrix/element for Dirichlet boundary conditions
+    apply_bc(data.Ae[0].data(), data.Ae[1].data(), boundary_values,
+             cell_dofs[0][0][0], cell_dofs[0][0][1]);
 
-      // Mark cell as processed
-      cell_tensor_computed[cell.index()] = true;
+    // Add entries to global tensor
+    for (std::size_t form = 0; form < 2; ++form)
+    {
+      if (buffer.tensor(form))
+        buffer.add_local(form, data.Ae[form].data(), cell_dofs[form][0]);
     }
-    p++;
   }
 }
 //-----------------------------------------------------------------------------
+bool SystemAssembler::is_first_facet(const Cell& cell, const Facet& facet)
+{
+  const std::size_t D = cell.mesh().topology().dim();
+  const unsigned int* facets = cell.entities(D - 1);
+  const std::size_t num_facets = cell.num_entities(D - 1);
+  return *std::min_element(facets, facets + num_facets) == facet.index();
+}
+//-----------------------------------------------------------------------------
 void SystemAssembler:: compute_exterior_facet_tensor(
   std::array<std::vector<double>, 2>& Ae,
   std::array<UFC*, 2>& ufc,
@@ -1039,7 +1257,7 @@ void SystemAssembler::compute_interior_facet_tensor(
 }
 //-----------------------------------------------------------------------------
 void SystemAssembler::matrix_block_add(
-  GenericTensor& tensor,
+  TensorBuffer& buffer,
   std::vector<double>& Ae,
   std::vector<double>& macro_A,
   const std::array<bool, 2>& add_local_tensor,
@@ -1058,7 +1276,7 @@ void SystemAssembler::matrix_block_add(
         for (std::size_t j = 0; j < nn; j++)
           Ae[i*nn + j] = macro_A[2*nn*mm*c + 2*i*nn + nn*c +j];
       }
-      tensor.add_local(Ae.data(), cell_dofs[c]);
+      buffer.add_local(0, Ae.data(), cell_dofs[c]);
     }
   }
 }
@@ -1165,6 +1383,20 @@ SystemAssembler::Scratch::Scratch(const Form& a, const Form& L)
   A_num_entries *= a.function_space(1)->dofmap()->max_element_dofs();
   Ae[0].resize(A_num_entries);
   Ae[1].resize(L.function_space(0)->dofmap()->max_element_dofs());
+
+  // Collect pointers to dof maps
+  for (std::size_t i = 0; i < 2; ++i)
+    dofmaps[0].push_back(a.function_space(i)->dofmap().get());
+  dofmaps[1].push_back(L.function_space(0)->dofmap().get());
+
+  // Size dof holders
+  for (std::size_t c = 0; c < 2; ++c)
+  {
+    cell_dofs[0][c].resize(2);
+    cell_dofs[1][c].resize(1);
+  }
+  macro_dofs[0].resize(2);
+  macro_dofs[1].resize(1);
 }
 //-----------------------------------------------------------------------------
 SystemAssembler::Scratch::~Scratch()
@@ -1172,3 +1404,95 @@ SystemAssembler::Scratch::~Scratch()
   // Do nothing
 }
 //-----------------------------------------------------------------------------
+SystemAssembler::TensorBuffer::TensorBuffer(
+  const std::array<GenericTensor*, 2>& tensors, bool staged)
+  : _tensors(tensors), _staged(staged)
+{
+  // Do nothing
+}
+//-----------------------------------------------------------------------------
+void SystemAssembler::TensorBuffer::add_local(
+  std::size_t form, const double* A,
+  const std::vector<ArrayView<const la_index>>& dofs)
+{
+  dolfin_assert(_tensors[form]);
+  if (!_staged)
+  {
+    _tensors[form]->add_local(A, dofs);
+    return;
+  }
+
+  // Copy tensor and dofs
+  std::array<std::size_t, 3> entry = {{form, _values.size(),
+                                       _dof_sizes.size()}};
+  _entries.push_back(entry);
+  std::size_t size = 1;
+  for (std::size_t i = 0; i < dofs.size(); ++i)
+  {
+    _dof_sizes.push_back(dofs[i].size());
+    _dofs.insert(_dofs.end(), dofs[i].begin(), dofs[i].end());
+    size *= dofs[i].size();
+  }
+  _values.insert(_values.end(), A, A + size);
+}
+//-----------------------------------------------------------------------------
+void SystemAssembler::TensorBuffer::add_direct(double* values,
+                                               const la_index* positions,
+                                               const double* A,
+                                               std::size_t size)
+{
+  if (!_staged)
+  {
+    for (std::size_t j = 0; j < size; ++j)
+      values[positions[j]] += A[j];
+    return;
+  }
+
+  // Copy tensor and keep pointer to positions
+  std::array<std::size_t, 3> entry = {{2, _values.size(), _positions.size()}};
+  _entries.push_back(entry);
+  _positions.push_back(std::make_pair(values, positions));
+  _values.insert(_values.end(), A, A + size);
+}
+//-----------------------------------------------------------------------------
+void SystemAssembler::TensorBuffer::flush()
+{
+  std::vector<ArrayView<const la_index>> dofs;
+  std::size_t dof_offset = 0;
+  for (std::size_t k = 0; k < _entries.size(); ++k)
+  {
+    const std::size_t form = _entries[k][0];
+    const double* A = _values.data() + _entries[k][1];
+    if (form == 2)
+    {
+      // Add directly into matrix storage
+      const std::size_t end = (k + 1 < _entries.size())
+        ? _entries[k + 1][1] : _values.size();
+      double* values = _positions[_entries[k][2]].first;
+      const la_index* positions = _positions[_entries[k][2]].second;
+      for (std::size_t j = 0; j < end - _entries[k][1]; ++j)
+        values[positions[j]] += A[j];
+    }
+    else
+    {
+      // Add through tensor interface
+      const std::size_t rank = (form == 0) ? 2 : 1;
+      dofs.resize(rank);
+      for (std::size_t i = 0; i < rank; ++i)
+      {
+        const std::size_t n = _dof_sizes[_entries[k][2] + i];
+        dofs[i].set(n, _dofs.data() + dof_offset);
+        dof_offset += n;
+      }
+      _tensors[form]->add_local(A, dofs);
+    }
+  }
+
+  // Clear staged data (keeping storage)
+  _entries.clear();
+  _values.clear();
+  _dofs.clear();
+  _dof_sizes.clear();
+  _positions.clear();
+}
+//-----------------------------------------------------------------------------
@@ -26,7 +26,10 @@
 #include <array>
 #include <map>
 #include <memory>
+#include <utility>
 #include <vector>
+#include <dolfin/common/ArrayView.h>
+#include <dolfin/common/types.h>
 
 #include "DirichletBC.h"
 #include "AssemblerBase.h"
@@ -43,7 +46,7 @@ namespace dolfin
 {
 
   // Forward declarations
-  template<typename T> class ArrayView;
+  class AssemblyPlan;
   class Cell;
   class Facet;
   class Form;
@@ -57,6 +60,10 @@ namespace dolfin
   /// Ax = b. It differs from the default DOLFIN assembler in that it
   /// applies boundary conditions at the time of assembly, which
   /// preserves any symmetries in A.
+  ///
+  /// If the global parameter "num_threads" is positive (and DOLFIN
+  /// is built with OpenMP), cells or facets are assembled in blocks
+  /// by multiple threads in the same way as by OpenMpAssembler.
 
   class SystemAssembler : public AssemblerBase
   {
@@ -105,6 +112,14 @@ namespace dolfin
     /// Suitable for use inside a (quasi-)Newton solver.
     void assemble(GenericVector& b, const GenericVector& x0);
 
+    /// Reuse assembly plans for the bilinear and linear forms in
+    /// subsequent calls to assemble. The UFC data of the plans is
+    /// reused and, if supported by the backend, cell matrices are
+    /// added directly into the matrix storage. The plans must have
+    /// been created for the forms of this assembler.
+    void set_assembly_plans(std::shared_ptr<AssemblyPlan> a_plan,
+                            std::shared_ptr<AssemblyPlan> L_plan);
+
   private:
 
     // Class to hold temporary data
@@ -114,6 +129,56 @@ namespace dolfin
       Scratch(const Form& a, const Form& L);
       ~Scratch();
       std::array<std::vector<double>, 2> Ae;
+
+      // Dof maps [form][dim]
+      std::array<std::vector<const GenericDofMap*>, 2> dofmaps;
+
+      // Cell dofs [form][cell][dim]
+      std::array<std::array<std::vector<ArrayView<const dolfin::la_index>>,
+                            2>, 2> cell_dofs;
+
+      // Dofs for macro cells [form][dim]
+      std::array<std::vector<std::vector<dolfin::la_index>>, 2> macro_dofs;
+    };
+
+    // Class to add local tensors to the global tensors. Tensors are
+    // added immediately, or staged and added by flush() (used by
+    // multithreaded assembly to add a block of cells at once while
+    // holding locks for the rows of the block).
+    class TensorBuffer
+    {
+    public:
+      TensorBuffer(const std::array<GenericTensor*, 2>& tensors,
+                   bool staged);
+
+      // Return global tensor for form (may be null)
+      GenericTensor* tensor(std::size_t form) const
+      { return _tensors[form]; }
+
+      // Add local tensor A for form
+      void add_local(std::size_t form, const double* A,
+                     const std::vector<ArrayView<const la_index>>& dofs);
+
+      // Add local tensor A directly into matrix storage at given
+      // positions
+      void add_direct(double* values, const la_index* positions,
+                      const double* A, std::size_t size);
+
+      // Add staged tensors to global tensors
+      void flush();
+
+    private:
+
+      std::array<GenericTensor*, 2> _tensors;
+      bool _staged;
+
+      // Staged tensors: form (2 for direct insertion), offset into
+      // _values and offset into _dofs (or _positions) for each entry
+      std::vector<std::array<std::size_t, 3>> _entries;
+      std::vector<double> _values;
+      std::vector<la_index> _dofs;
+      std::vector<std::size_t> _dof_sizes;
+      std::vector<std::pair<double*, const la_index*>> _positions;
     };
 
     // Check form arity
@@ -134,9 +199,13 @@ namespace dolfin
     // Boundary conditions
     std::vector<const DirichletBC*> _bcs;
 
+    // Assembly plans for bilinear and linear forms (optional)
+    std::shared_ptr<AssemblyPlan> _a_plan, _l_plan;
+
     static void cell_wise_assembly(
       std::array<GenericTensor*, 2>& tensors,
       std::array<UFC*, 2>& ufc,
+      AssemblyPlan* a_plan,
       Scratch& data,
       const std::vector<DirichletBC::Map>& boundary_values,
       std::shared_ptr<const MeshFunction<std::size_t>> cell_domains,
@@ -151,6 +220,36 @@ namespace dolfin
       std::shared_ptr<const MeshFunction<std::size_t>> exterior_facet_domains,
       std::shared_ptr<const MeshFunction<std::size_t>> interior_facet_domains);
 
+    // Compute cell (and exterior facet) contributions of a cell,
+    // apply boundary conditions and add to global tensors
+    static void assemble_cell(
+      TensorBuffer& buffer,
+      std::array<UFC*, 2>& ufc,
+      Scratch& data,
+      ufc::cell& ufc_cell,
+      std::vector<double>& coordinate_dofs,
+      const Cell& cell,
+      AssemblyPlan* a_plan,
+      const std::vector<DirichletBC::Map>& boundary_values,
+      const MeshFunction<std::size_t>* cell_domains,
+      const MeshFunction<std::size_t>* exterior_facet_domains,
+      bool has_exterior_facet_integrals);
+
+    // Compute facet contributions (and cell contributions for cells
+    // for which this is the first facet), apply boundary conditions
+    // and add to global tensors
+    static void assemble_facet(
+      TensorBuffer& buffer,
+      std::array<UFC*, 2>& ufc,
+      Scratch& data,
+      std::array<ufc::cell, 2>& ufc_cell,
+      std::array<std::vector<double>, 2>& coordinate_dofs,
+      const Facet& facet,
+      const std::vector<DirichletBC::Map>& boundary_values,
+      const MeshFunction<std::size_t>* cell_domains,
+      const MeshFunction<std::size_t>* exterior_facet_domains,
+      const MeshFunction<std::size_t>* interior_facet_domains);
+
     // Compute exterior facet (and possibly connected cell)
     // contribution
     static void compute_exterior_facet_tensor(
@@ -183,10 +282,13 @@ namespace dolfin
       const std::size_t vector_size,
       const std::array<bool, 2> compute_cell_tensor);
 
+    // Return true if facet is the facet of cell with lowest index
+    static bool is_first_facet(const Cell& cell, const Facet& facet);
+
     // Modified matrix insertion for case when rhs has facet integrals
     // and lhs has no facet integrals
     static void matrix_block_add(
-      GenericTensor& tensor,
+      TensorBuffer& buffer,
       std::vector<double>& Ae,
       std::vector<double>& macro_A,
       const std::array<bool, 2>& add_local_tensor,
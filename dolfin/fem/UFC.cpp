@@ -201,3 +201,25 @@ void UFC::update(const Cell& c0, const std::vector<double>& coordinate_dofs0,
   }
 }
 //-----------------------------------------------------------------------------
+void UFC::restrict_coefficients(const Cell& c, const double* coordinate_dofs,
+                                const ufc::cell& ufc_cell,
+                                const std::vector<bool>& enabled_coefficients,
+                                double* const * w) const
+{
+  // Restrict coefficients to cell
+  for (std::size_t i = 0; i < coefficients.size(); ++i)
+  {
+    if (!enabled_coefficients[i])
+      continue;
+    dolfin_assert(coefficients[i]);
+    coefficients[i]->restrict(w[i], coefficient_elements[i], c,
+                              coordinate_dofs, ufc_cell);
+  }
+}
+//-----------------------------------------------------------------------------
+std::size_t UFC::coefficient_dimension(std::size_t i) const
+{
+  dolfin_assert(i < coefficient_elements.size());
+  return coefficient_elements[i].space_dimension();
+}
+//-----------------------------------------------------------------------------
@@ -91,6 +91,18 @@ namespace dolfin
                 const std::vector<double>& coordinate_dofs1,
                 const ufc::cell& ufc_cell1);
 
+    /// Restrict coefficients on given cell to the given coefficient
+    /// arrays (one array for each coefficient). Used by assemblers
+    /// that stage coefficient data for a block of cells.
+    void restrict_coefficients(const Cell& cell,
+                               const double* coordinate_dofs,
+                               const ufc::cell& ufc_cell,
+                               const std::vector<bool>& enabled_coefficients,
+                               double* const * w) const;
+
+    /// Return dimension of the element for coefficient i
+    std::size_t coefficient_dimension(std::size_t i) const;
+
     /// Pointer to coefficient data. Used to support UFC interface.
     const double* const * w() const
     { return w_pointer.data(); }
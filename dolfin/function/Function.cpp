@@ -20,12 +20,15 @@
 // Modified by Andre Massing 2009
 
 #include <algorithm>
+#include <cstdint>
+#include <limits>
 #include <map>
 #include <utility>
 #include <vector>
 
 #include <dolfin/adaptivity/Extrapolation.h>
 #include <dolfin/common/Array.h>
+#include <dolfin/common/MPI.h>
 #include <dolfin/common/Timer.h>
 #include <dolfin/common/utils.h>
 #include <dolfin/fem/FiniteElement.h>
@@ -41,12 +44,71 @@
 #include <dolfin/mesh/Vertex.h>
 #include <dolfin/parameter/GlobalParameters.h>
 #include <dolfin/geometry/BoundingBoxTree.h>
+#include <dolfin/geometry/PointLocator.h>
 #include "Expression.h"
 #include "FunctionSpace.h"
 #include "Function.h"
 
 using namespace dolfin;
 
+// Number of consecutive points (in Morton order) located by a thread
+// at a time
+static const std::size_t locate_block_size = 256;
+
+// Return permutation of points sorting them by Morton code
+static std::vector<std::size_t> morton_order(const std::vector<double>& x,
+                                             std::size_t gdim)
+{
+  dolfin_assert(gdim <= 3);
+  const std::size_t num_points = x.size()/gdim;
+
+  // Compute bounding box of points
+  double xmin[3] = {0.0, 0.0, 0.0};
+  double xmax[3] = {0.0, 0.0, 0.0};
+  if (num_points > 0)
+  {
+    std::copy(x.begin(), x.begin() + gdim, xmin);
+    std::copy(x.begin(), x.begin() + gdim, xmax);
+  }
+  for (std::size_t i = 0; i < num_points; ++i)
+  {
+    for (std::size_t d = 0; d < gdim; ++d)
+    {
+      xmin[d] = std::min(xmin[d], x[i*gdim + d]);
+      xmax[d] = std::max(xmax[d], x[i*gdim + d]);
+    }
+  }
+
+  // Quantize coordinates to 21 bits and interleave bits
+  const std::uint32_t max_q = (1 << 21) - 1;
+  double scale[3] = {0.0, 0.0, 0.0};
+  for (std::size_t d = 0; d < gdim; ++d)
+  {
+    if (xmax[d] > xmin[d])
+      scale[d] = max_q/(xmax[d] - xmin[d]);
+  }
+  std::vector<std::pair<std::uint64_t, std::size_t>> codes(num_points);
+  for (std::size_t i = 0; i < num_points; ++i)
+  {
+    std::uint32_t q[3] = {0, 0, 0};
+    for (std::size_t d = 0; d < gdim; ++d)
+    {
+      q[d] = std::min((std::uint32_t) ((x[i*gdim + d] - xmin[d])*scale[d]),
+                      max_q);
+    }
+    std::uint64_t code = 0;
+    for (int bit = 20; bit >= 0; --bit)
+      for (std::size_t d = 0; d < gdim; ++d)
+        code = (code << 1) | ((q[d] >> bit) & 1);
+    codes[i] = std::make_pair(code, i);
+  }
+  std::sort(codes.begin(), codes.end());
+
+  std::vector<std::size_t> order(num_points);
+  for (std::size_t i = 0; i < num_points; ++i)
+    order[i] = codes[i].second;
+  return order;
+}
 //-----------------------------------------------------------------------------
 Function::Function(const FunctionSpace& V) : Hierarchical<Function>(*this),
   _function_space(reference_to_no_delete_pointer(V)),
@@ -428,6 +490,205 @@ void Function::eval(Array<double>& values, const Array<double>& x,
   }
 }
 //-----------------------------------------------------------------------------
+void Function::eval_points(std::vector<double>& values,
+                           const std::vector<double>& x) const
+{
+  dolfin_assert(_function_space);
+  dolfin_assert(_function_space->mesh());
+  const Mesh& mesh = *_function_space->mesh();
+  const std::size_t gdim = mesh.geometry().dim();
+  const std::size_t value_size_loc = value_size();
+
+  if (x.size() % gdim != 0)
+  {
+    dolfin_error("Function.cpp",
+                 "evaluate function at points",
+                 "Number of coordinates (%d) is not a multiple of the geometric dimension (%d)",
+                 x.size(), gdim);
+  }
+
+  Timer timer("Evaluate function at points");
+
+  const MPI_Comm mpi_comm = mesh.mpi_comm();
+  const std::size_t num_processes = MPI::size(mpi_comm);
+  values.assign((x.size()/gdim)*value_size_loc, 0.0);
+  std::vector<std::size_t> missing;
+  if (num_processes == 1)
+  {
+    // Evaluate at points found in the mesh (or extrapolate)
+    missing = eval_local_points(values.data(), x, _allow_extrapolation);
+  }
+  else
+  {
+    // Points are located with reference coordinates of simplex cells
+    const CellType::Type cell_type = mesh.type().cell_type();
+    if (cell_type != CellType::interval && cell_type != CellType::triangle
+        && cell_type != CellType::tetrahedron)
+    {
+      dolfin_error("Function.cpp",
+                   "evaluate function at points",
+                   "Evaluation at points in parallel is only implemented for simplex cells");
+    }
+
+    // Locate points on the processes owning the cells containing them
+    std::vector<int> processes;
+    std::vector<std::size_t> cells;
+    std::vector<double> X;
+    PointLocator::locate(processes, cells, X, mesh, x);
+
+    // Send coordinates and cell of each point to the owning process
+    const std::size_t num_points = x.size()/gdim;
+    std::vector<std::vector<double>> send_x(num_processes);
+    std::vector<std::vector<std::size_t>> sent_points(num_processes);
+    for (std::size_t i = 0; i < num_points; ++i)
+    {
+      const int p = processes[i];
+      if (p < 0)
+      {
+        missing.push_back(i);
+        continue;
+      }
+      send_x[p].push_back(cells[i]);
+      send_x[p].insert(send_x[p].end(), x.begin() + i*gdim,
+                       x.begin() + (i + 1)*gdim);
+      sent_points[p].push_back(i);
+    }
+    std::vector<std::vector<double>> recv_x;
+    MPI::all_to_all(mpi_comm, send_x, recv_x);
+
+    // Evaluate at received points in the given cells and return values
+    std::vector<std::vector<double>> send_values(num_processes);
+    std::vector<double> remote_x;
+    std::vector<unsigned int> remote_cells;
+    for (std::size_t p = 0; p < num_processes; ++p)
+    {
+      const std::size_t num_remote = recv_x[p].size()/(gdim + 1);
+      remote_x.resize(num_remote*gdim);
+      remote_cells.resize(num_remote);
+      for (std::size_t k = 0; k < num_remote; ++k)
+      {
+        const double* d = recv_x[p].data() + k*(gdim + 1);
+        remote_cells[k] = d[0];
+        std::copy(d + 1, d + 1 + gdim, remote_x.begin() + k*gdim);
+      }
+      send_values[p].resize(num_remote*value_size_loc);
+      eval_cell_points(send_values[p].data(), remote_x, remote_cells);
+    }
+    std::vector<std::vector<double>> recv_values;
+    MPI::all_to_all(mpi_comm, send_values, recv_values);
+
+    // Copy values returned by the owning processes
+    for (std::size_t p = 0; p < num_processes; ++p)
+    {
+      dolfin_assert(recv_values[p].size()
+                    == sent_points[p].size()*value_size_loc);
+      for (std::size_t k = 0; k < sent_points[p].size(); ++k)
+      {
+        std::copy(recv_values[p].begin() + k*value_size_loc,
+                  recv_values[p].begin() + (k + 1)*value_size_loc,
+                  values.begin() + sent_points[p][k]*value_size_loc);
+      }
+    }
+
+    // Extrapolate points not found on any process from the closest
+    // cell over all processes (the lowest rank in case of a tie), so
+    // that the value does not depend on the process asking for it
+    if (_allow_extrapolation && MPI::max(mpi_comm, missing.size()) > 0)
+      extrapolate_missing_points(values, x, missing);
+  }
+
+  if (!missing.empty())
+  {
+    dolfin_error("Function.cpp",
+                 "evaluate function at points",
+                 "%d points are not inside the domain. Consider calling \"Function::set_allow_extrapolation(true)\" on this Function to allow extrapolation",
+                 missing.size());
+  }
+}
+//-----------------------------------------------------------------------------
+void Function::extrapolate_missing_points(std::vector<double>& values,
+                                          const std::vector<double>& x,
+                                          std::vector<std::size_t>& missing) const
+{
+  dolfin_assert(_function_space);
+  dolfin_assert(_function_space->mesh());
+  const Mesh& mesh = *_function_space->mesh();
+  const std::size_t gdim = mesh.geometry().dim();
+  const std::size_t value_size_loc = value_size();
+  const MPI_Comm mpi_comm = mesh.mpi_comm();
+  const std::size_t num_processes = MPI::size(mpi_comm);
+
+  // Send coordinates of missing points to all processes
+  std::vector<double> missing_x;
+  missing_x.reserve(missing.size()*gdim);
+  for (std::size_t k = 0; k < missing.size(); ++k)
+  {
+    missing_x.insert(missing_x.end(), x.begin() + missing[k]*gdim,
+                     x.begin() + (missing[k] + 1)*gdim);
+  }
+  std::vector<std::vector<double>> send_x(num_processes, missing_x);
+  std::vector<std::vector<double>> recv_x;
+  MPI::all_to_all(mpi_comm, send_x, recv_x);
+
+  // Return distance to the closest local cell of each received point
+  // followed by the value extrapolated from this cell
+  std::shared_ptr<BoundingBoxTree> tree = mesh.bounding_box_tree();
+  std::vector<std::vector<double>> send_values(num_processes);
+  for (std::size_t p = 0; p < num_processes; ++p)
+  {
+    const std::size_t num_remote = recv_x[p].size()/gdim;
+    std::vector<unsigned int> closest_cells(num_remote);
+    std::vector<double> closest_values(num_remote*value_size_loc);
+    send_values[p].resize(num_remote*(value_size_loc + 1));
+    if (mesh.num_cells() == 0)
+    {
+      // No cells to extrapolate from
+      for (std::size_t k = 0; k < num_remote; ++k)
+      {
+        send_values[p][k*(value_size_loc + 1)]
+          = std::numeric_limits<double>::max();
+      }
+      continue;
+    }
+    for (std::size_t k = 0; k < num_remote; ++k)
+    {
+      const Point point(gdim, recv_x[p].data() + k*gdim);
+      const std::pair<unsigned int, double> closest
+        = tree->compute_closest_entity(point);
+      closest_cells[k] = closest.first;
+      send_values[p][k*(value_size_loc + 1)] = closest.second;
+    }
+    eval_cell_points(closest_values.data(), recv_x[p], closest_cells);
+    for (std::size_t k = 0; k < num_remote; ++k)
+    {
+      std::copy(closest_values.begin() + k*value_size_loc,
+                closest_values.begin() + (k + 1)*value_size_loc,
+                send_values[p].begin() + k*(value_size_loc + 1) + 1);
+    }
+  }
+  std::vector<std::vector<double>> recv_values;
+  MPI::all_to_all(mpi_comm, send_values, recv_values);
+
+  // Use value of the process with the closest cell
+  for (std::size_t k = 0; k < missing.size(); ++k)
+  {
+    std::size_t closest_process = 0;
+    for (std::size_t p = 1; p < num_processes; ++p)
+    {
+      if (recv_values[p][k*(value_size_loc + 1)]
+          < recv_values[closest_process][k*(value_size_loc + 1)])
+      {
+        closest_process = p;
+      }
+    }
+    const double* v = recv_values[closest_process].data()
+      + k*(value_size_loc + 1) + 1;
+    std::copy(v, v + value_size_loc,
+              values.begin() + missing[k]*value_size_loc);
+  }
+  missing.clear();
+}
+//-----------------------------------------------------------------------------
 void Function::interpolate(const GenericFunction& v)
 {
   dolfin_assert(_vector);
@@ -583,6 +844,153 @@ void Function::compute_vertex_values(std::vector<double>& vertex_values)
   compute_vertex_values(vertex_values, *_function_space->mesh());
 }
 //-----------------------------------------------------------------------------
+std::vector<std::size_t>
+Function::eval_local_points(double* values, const std::vector<double>& x,
+                            bool extrapolate) const
+{
+  dolfin_assert(_function_space);
+  dolfin_assert(_function_space->mesh());
+  const Mesh& mesh = *_function_space->mesh();
+  const std::size_t gdim = mesh.geometry().dim();
+  const std::size_t num_points = x.size()/gdim;
+  const std::size_t num_threads_param = dolfin::parameters["num_threads"];
+  const int num_threads = std::max((int) num_threads_param, 1);
+
+  // Build bounding box tree before threads query it
+  std::shared_ptr<BoundingBoxTree> tree = mesh.bounding_box_tree();
+
+  // Sort points spatially so that consecutive points are likely to be
+  // in the same or in neighbouring cells
+  const std::vector<std::size_t> order = morton_order(x, gdim);
+
+  // Locate points in blocks of consecutive points, trying the cell of
+  // the previous point first
+  const unsigned int not_found = std::numeric_limits<unsigned int>::max();
+  std::vector<unsigned int> cells(num_points, not_found);
+  const int num_blocks = (num_points + locate_block_size - 1)/locate_block_size;
+  #pragma omp parallel for schedule(dynamic) num_threads(num_threads)
+  for (int b = 0; b < num_blocks; ++b)
+  {
+    unsigned int previous = not_found;
+    const std::size_t last = std::min((b + 1)*locate_block_size, num_points);
+    for (std::size_t k = b*locate_block_size; k < last; ++k)
+    {
+      const std::size_t i = order[k];
+      const Point point(gdim, x.data() + i*gdim);
+      if (previous != not_found && Cell(mesh, previous).collides(point))
+        cells[i] = previous;
+      else
+      {
+        cells[i] = tree->compute_first_entity_collision(point);
+        if (cells[i] != not_found)
+          previous = cells[i];
+      }
+    }
+  }
+
+  // Use closest cell for points not found, or report these points
+  std::vector<std::size_t> missing;
+  for (std::size_t i = 0; i < num_points; ++i)
+  {
+    if (cells[i] != not_found)
+      continue;
+    if (extrapolate)
+    {
+      const Point point(gdim, x.data() + i*gdim);
+      cells[i] = tree->compute_closest_entity(point).first;
+    }
+    else
+      missing.push_back(i);
+  }
+
+  // Evaluate at the points found
+  eval_cell_points(values, x, cells);
+
+  return missing;
+}
+//-----------------------------------------------------------------------------
+void Function::eval_cell_points(double* values, const std::vector<double>& x,
+                                const std::vector<unsigned int>& cells) const
+{
+  dolfin_assert(_function_space);
+  dolfin_assert(_function_space->mesh());
+  dolfin_assert(_function_space->element());
+  dolfin_assert(_function_space->dofmap());
+  const Mesh& mesh = *_function_space->mesh();
+  const FiniteElement& element = *_function_space->element();
+  const GenericDofMap& dofmap = *_function_space->dofmap();
+  const std::size_t gdim = mesh.geometry().dim();
+  const std::size_t value_size_loc = value_size();
+  const std::size_t space_dim = element.space_dimension();
+  const std::size_t num_points = x.size()/gdim;
+  const std::size_t num_threads_param = dolfin::parameters["num_threads"];
+  const int num_threads = std::max((int) num_threads_param, 1);
+  dolfin_assert(cells.size() == num_points);
+
+  // Group points by cell
+  const unsigned int not_found = std::numeric_limits<unsigned int>::max();
+  std::vector<std::pair<unsigned int, std::size_t>> cell_points;
+  cell_points.reserve(num_points);
+  for (std::size_t i = 0; i < num_points; ++i)
+  {
+    if (cells[i] != not_found)
+      cell_points.push_back(std::make_pair(cells[i], i));
+  }
+  std::sort(cell_points.begin(), cell_points.end());
+  std::vector<std::size_t> group_offsets;
+  for (std::size_t k = 0; k < cell_points.size(); ++k)
+  {
+    if (k == 0 || cell_points[k].first != cell_points[k - 1].first)
+      group_offsets.push_back(k);
+  }
+  const int num_groups = group_offsets.size();
+  group_offsets.push_back(cell_points.size());
+
+  // Fetch expansion coefficients of all cells with one call
+  std::vector<dolfin::la_index> dofs(num_groups*space_dim);
+  for (int g = 0; g < num_groups; ++g)
+  {
+    const ArrayView<const dolfin::la_index> cell_dofs
+      = dofmap.cell_dofs(cell_points[group_offsets[g]].first);
+    dolfin_assert(cell_dofs.size() == space_dim);
+    std::copy(cell_dofs.data(), cell_dofs.data() + space_dim,
+              dofs.begin() + g*space_dim);
+  }
+  std::vector<double> coefficients(dofs.size());
+  if (!dofs.empty())
+    _vector->get_local(coefficients.data(), dofs.size(), dofs.data());
+
+  // Evaluate basis functions at all points of each cell
+  #pragma omp parallel num_threads(num_threads)
+  {
+    ufc::cell ufc_cell;
+    std::vector<double> coordinate_dofs;
+    std::vector<double> basis(space_dim*value_size_loc);
+
+    #pragma omp for schedule(dynamic, 16)
+    for (int g = 0; g < num_groups; ++g)
+    {
+      const Cell cell(mesh, cell_points[group_offsets[g]].first);
+      cell.get_cell_data(ufc_cell);
+      cell.get_coordinate_dofs(coordinate_dofs);
+      const double* w = coefficients.data() + g*space_dim;
+
+      for (std::size_t k = group_offsets[g]; k < group_offsets[g + 1]; ++k)
+      {
+        const std::size_t i = cell_points[k].second;
+        element.evaluate_basis_all(basis.data(), x.data() + i*gdim,
+                                   coordinate_dofs.data(),
+                                   ufc_cell.orientation);
+        double* v = values + i*value_size_loc;
+        std::fill(v, v + value_size_loc, 0.0);
+        for (std::size_t d = 0; d < space_dim; ++d)
+          for (std::size_t j = 0; j < value_size_loc; ++j)
+            v[j] += w[d]*basis[d*value_size_loc + j];
+      }
+    }
+  }
+}
+//-----------------------------------------------------------------------------
 void Function::init_vector()
 {
   Timer timer("Init dof vector");
@@ -280,6 +280,30 @@ namespace dolfin
               const Cell& dolfin_cell,
               const ufc::cell& ufc_cell) const;
 
+    /// Evaluate function at many points. The points are sorted
+    /// spatially (by Morton code) and located in the mesh in bulk,
+    /// and points in the same cell are grouped such that the
+    /// expansion coefficients and coordinates of each cell are
+    /// fetched once. Evaluation is multithreaded if the global
+    /// parameter "num_threads" is positive. In parallel, the points
+    /// are located with PointLocator::locate (simplex cells only)
+    /// and evaluated on the process owning the cell containing each
+    /// point, and the call is collective. Points outside the mesh
+    /// are an error unless extrapolation is allowed (see
+    /// set_allow_extrapolation). In parallel, such points are then
+    /// extrapolated from the closest cell over all processes (the
+    /// process of lowest rank in case of a tie), so that the value
+    /// does not depend on the process evaluating the point.
+    ///
+    /// *Arguments*
+    ///     values (std::vector<double>)
+    ///         The values, value_size() values for each point.
+    ///     x (std::vector<double>)
+    ///         The coordinates, geometric_dimension() coordinates for
+    ///         each point.
+    void eval_points(std::vector<double>& values,
+                     const std::vector<double>& x) const;
+
     /// Interpolate function (on possibly non-matching meshes)
     ///
     /// *Arguments*
@@ -391,6 +415,26 @@ namespace dolfin
     // Initialize vector
     void init_vector();
 
+    // Locate given points (coordinates x) in the mesh, and evaluate
+    // the function at the points that are found. Returns a list of
+    // the points that are not found.
+    std::vector<std::size_t>
+      eval_local_points(double* values, const std::vector<double>& x,
+                        bool extrapolate) const;
+
+    // Evaluate the function at points in the given local cells
+    // (skipping points with cell std::numeric_limits<unsigned
+    // int>::max()), grouping the points by cell
+    void eval_cell_points(double* values, const std::vector<double>& x,
+                          const std::vector<unsigned int>& cells) const;
+
+    // Extrapolate the function at given points (indices into the
+    // coordinates x) from the closest cell over all processes, and
+    // clear the list of points (collective)
+    void extrapolate_missing_points(std::vector<double>& values,
+                                    const std::vector<double>& x,
+                                    std::vector<std::size_t>& missing) const;
+
     // Get coefficients from the vector(s)
     void compute_ghost_indices(std::pair<std::size_t, std::size_t> range,
                                std::vector<la_index>& ghost_indices) const;
@@ -82,6 +82,24 @@ void BoundingBoxTree::build(const std::vector<Point>& points, std::size_t gdim)
   // Build tree
   dolfin_assert(_tree);
   _tree->build(points);
+
+  // Tree is not built for a mesh
+  _mesh = 0;
+}
+//-----------------------------------------------------------------------------
+void BoundingBoxTree::refit()
+{
+  // Check that tree has been built for a mesh
+  _check_built();
+  if (!_mesh)
+  {
+    dolfin_error("BoundingBoxTree.cpp",
+                 "refit bounding box tree",
+                 "Bounding box tree has not been built for a mesh");
+  }
+
+  // Update bounding boxes
+  _tree->refit(*_mesh);
 }
 //-----------------------------------------------------------------------------
 std::vector<unsigned int>
@@ -167,6 +185,19 @@ BoundingBoxTree::compute_first_entity_collision(const Point& point) const
   return _tree->compute_first_entity_collision(point, *_mesh);
 }
 //-----------------------------------------------------------------------------
+std::vector<unsigned int>
+BoundingBoxTree::compute_first_entity_collisions(
+  const std::vector<Point>& points) const
+{
+  // Check that tree has been built
+  _check_built();
+
+  // Delegate call to implementation
+  dolfin_assert(_tree);
+  dolfin_assert(_mesh);
+  return _tree->compute_first_entity_collisions(points, *_mesh);
+}
+//-----------------------------------------------------------------------------
 std::pair<unsigned int, double>
 BoundingBoxTree::compute_closest_entity(const Point& point) const
 {
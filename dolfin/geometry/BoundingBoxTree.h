@@ -73,6 +73,13 @@ namespace dolfin
     ///         The geometric dimension.
     void build(const std::vector<Point>& points, std::size_t gdim);
 
+    /// Update bounding box tree after the mesh has been moved. The
+    /// structure of the tree is kept and only the bounding boxes are
+    /// recomputed, which is faster than building a new tree but may
+    /// give a less efficient tree for large deformations. The mesh
+    /// must have the same entities as when the tree was built.
+    void refit();
+
     /// Compute all collisions between bounding boxes and _Point_.
     ///
     /// *Returns*
@@ -198,6 +205,23 @@ namespace dolfin
     unsigned int
     compute_first_entity_collision(const Point& point) const;
 
+    /// Compute first collision between entities and each of the
+    /// given points. This is equivalent to calling
+    /// compute_first_entity_collision for each point.
+    ///
+    /// *Returns*
+    ///     std::vector<unsigned int>
+    ///         The local index for the first found entity that
+    ///         collides with (intersects) each point. If not found,
+    ///         std::numeric_limits<unsigned int>::max() is
+    ///         returned for the point.
+    ///
+    /// *Arguments*
+    ///     points (std::vector<_Point_>)
+    ///         The list of points.
+    std::vector<unsigned int>
+    compute_first_entity_collisions(const std::vector<Point>& points) const;
+
     /// Compute closest entity to _Point_.
     ///
     /// *Returns*
@@ -80,68 +80,6 @@ namespace dolfin
     // Return geometric dimension
     std::size_t gdim() const { return 3; }
 
-    // Return bounding box coordinates for node
-    const double* get_bbox_coordinates(unsigned int node) const
-    {
-      return _bbox_coordinates.data() + 6*node;
-    }
-
-    // Check whether point (x) is in bounding box (node)
-    bool point_in_bbox(const double* x, const unsigned int node) const
-    {
-      const double* b = _bbox_coordinates.data() + 6*node;
-      const double eps0 = DOLFIN_EPS_LARGE*(b[3] - b[0]);
-      const double eps1 = DOLFIN_EPS_LARGE*(b[4] - b[1]);
-      const double eps2 = DOLFIN_EPS_LARGE*(b[5] - b[2]);
-      return (b[0] - eps0 <= x[0] && x[0] <= b[3] + eps0 &&
-              b[1] - eps1 <= x[1] && x[1] <= b[4] + eps1 &&
-              b[2] - eps2 <= x[2] && x[2] <= b[5] + eps2);
-    }
-
-    // Check whether bounding box (a) collides with bounding box (node)
-    bool bbox_in_bbox(const double* a, unsigned int node) const
-    {
-      const double* b = _bbox_coordinates.data() + 6*node;
-      const double eps0 = DOLFIN_EPS_LARGE*(b[3] - b[0]);
-      const double eps1 = DOLFIN_EPS_LARGE*(b[4] - b[1]);
-      const double eps2 = DOLFIN_EPS_LARGE*(b[5] - b[2]);
-      return (b[0] - eps0 <= a[3] && a[0] <= b[3] + eps0 &&
-              b[1] - eps1 <= a[4] && a[1] <= b[4] + eps1 &&
-              b[2] - eps2 <= a[5] && a[2] <= b[5] + eps2);
-    }
-
-    // Compute squared distance between point and bounding box
-    double compute_squared_distance_bbox(const double* x,
-                                         unsigned int node) const
-    {
-      // Note: Some else-if might be in order here but I assume the
-      // compiler can do a better job at optimizing/parallelizing this
-      // version. This is also the way the algorithm is presented in
-      // Ericsson.
-
-      const double* b = _bbox_coordinates.data() + 6*node;
-      double r2 = 0.0;
-
-      if (x[0] < b[0]) r2 += (x[0] - b[0])*(x[0] - b[0]);
-      if (x[0] > b[3]) r2 += (x[0] - b[3])*(x[0] - b[3]);
-      if (x[1] < b[1]) r2 += (x[1] - b[1])*(x[1] - b[1]);
-      if (x[1] > b[4]) r2 += (x[1] - b[4])*(x[1] - b[4]);
-      if (x[2] < b[2]) r2 += (x[2] - b[2])*(x[2] - b[2]);
-      if (x[2] > b[5]) r2 += (x[2] - b[5])*(x[2] - b[5]);
-
-      return r2;
-    }
-
-    // Compute squared distance between point and point
-    double compute_squared_distance_point(const double* x,
-                                          unsigned int node) const
-    {
-      const double* p = _bbox_coordinates.data() + 6*node;
-      return ((x[0] - p[0])*(x[0] - p[0]) +
-              (x[1] - p[1])*(x[1] - p[1]) +
-              (x[2] - p[2])*(x[2] - p[2]));
-    }
-
     // Compute bounding box of bounding boxes
     void compute_bbox_of_bboxes(double* bbox,
                                 std::size_t& axis,
@@ -56,12 +56,36 @@
 //
 //-----------------------------------------------------------------------------
 
+#include <algorithm>
+#include <cmath>
+#include <dolfin/mesh/Mesh.h>
 #include <dolfin/mesh/MeshEntity.h>
 #include "Point.h"
 #include "CollisionDetection.h"
 
 using namespace dolfin;
 
+//-----------------------------------------------------------------------------
+// Minimum and maximum of values and clamping of values to zero for
+// the batched collision tests. These are written as selects of values
+// and not with std::min and std::max (which return references) so
+// that GCC can vectorize the loops of the batched tests.
+//-----------------------------------------------------------------------------
+static inline double min_value(double a, double b)
+{
+  return b < a ? b : a;
+}
+//-----------------------------------------------------------------------------
+static inline double max_value(double a, double b)
+{
+  return a < b ? b : a;
+}
+//-----------------------------------------------------------------------------
+static inline double zero_if_small(double a, double eps2)
+{
+  return a*a < eps2 ? 0.0 : a;
+}
+
 //-----------------------------------------------------------------------------
 bool CollisionDetection::collides(const MeshEntity& entity,
                                   const Point& point)
@@ -309,12 +333,37 @@ CollisionDetection::collides_tetrahedron_tetrahedron
   const unsigned int* vertices = tetrahedron_0.entities(0);
   const MeshGeometry& geometry_q = tetrahedron_1.mesh().geometry();
   const unsigned int* vertices_q = tetrahedron_1.entities(0);
+
+  return collides_tetrahedron_tetrahedron(geometry.point(vertices[0]),
+                                          geometry.point(vertices[1]),
+                                          geometry.point(vertices[2]),
+                                          geometry.point(vertices[3]),
+                                          geometry_q.point(vertices_q[0]),
+                                          geometry_q.point(vertices_q[1]),
+                                          geometry_q.point(vertices_q[2]),
+                                          geometry_q.point(vertices_q[3]));
+}
+//-----------------------------------------------------------------------------
+bool
+CollisionDetection::collides_tetrahedron_tetrahedron(const Point& p0,
+                                                     const Point& p1,
+                                                     const Point& p2,
+                                                     const Point& p3,
+                                                     const Point& q0,
+                                                     const Point& q1,
+                                                     const Point& q2,
+                                                     const Point& q3)
+{
+  // See the MeshEntity version above for the origin of the algorithm
   std::vector<Point> V1(4), V2(4);
-  for (std::size_t i = 0; i < 4; ++i)
-  {
-    V1[i] = geometry.point(vertices[i]);
-    V2[i] = geometry_q.point(vertices_q[i]);
-  }
+  V1[0] = p0;
+  V1[1] = p1;
+  V1[2] = p2;
+  V1[3] = p3;
+  V2[0] = q0;
+  V2[1] = q1;
+  V2[2] = q2;
+  V2[3] = q3;
 
   // Get the vectors between V2 and V1[0]
   std::vector<Point> P_V1(4);
@@ -415,6 +464,245 @@ CollisionDetection::collides_tetrahedron_tetrahedron
   return true;
 }
 //-----------------------------------------------------------------------------
+void CollisionDetection::collides_tetrahedron_tetrahedron
+(const MeshEntity& tetrahedron,
+ const std::vector<double>& coordinates,
+ std::vector<unsigned int>& collisions)
+{
+  dolfin_assert(tetrahedron.mesh().topology().dim() == 3);
+  dolfin_assert(coordinates.size() % 12 == 0);
+  const std::size_t n = coordinates.size()/12;
+
+  // Get the vertices as points
+  const MeshGeometry& geometry = tetrahedron.mesh().geometry();
+  const unsigned int* vertices = tetrahedron.entities(0);
+  Point V1[4];
+  for (std::size_t i = 0; i < 4; ++i)
+    V1[i] = geometry.point(vertices[i]);
+
+  // Compute the outward normals of the faces of the tetrahedron and
+  // a point on each face, as in collides_tetrahedron_tetrahedron
+  const Point e0 = V1[1] - V1[0];
+  const Point e1 = V1[2] - V1[0];
+  const Point e2 = V1[3] - V1[0];
+  const Point e3 = V1[2] - V1[1];
+  const Point e4 = V1[3] - V1[1];
+  Point normals[4] = {e1.cross(e0), e0.cross(e2), e2.cross(e1), e3.cross(e4)};
+  if (normals[0].dot(e2) > 0)
+    normals[0] *= -1;
+  if (normals[1].dot(e1) > 0)
+    normals[1] *= -1;
+  if (normals[2].dot(e0) > 0)
+    normals[2] *= -1;
+  if (normals[3].dot(e0) < 0)
+    normals[3] *= -1;
+  const Point* base[4] = {&V1[0], &V1[0], &V1[0], &V1[1]};
+
+  // Coordinates of the batch (coordinate k of vertex v of item j
+  // is stored at position (3*v + k)*n + j)
+  const double* c = coordinates.data();
+
+  // Check batch in blocks
+  const std::size_t block_size = 64;
+  double separated[block_size];
+  for (std::size_t first = 0; first < n; first += block_size)
+  {
+    const std::size_t size = std::min(block_size, n - first);
+
+    // Reject tetrahedra that have all vertices on the outside of a
+    // face, i.e., for which the largest over the faces of the
+    // smallest distance of the vertices to the face is positive. The
+    // loop has no branches and is marked for vectorization (also at
+    // -O2, where GCC does not vectorize loops by default).
+    for (std::size_t i = 0; i < size; ++i)
+      separated[i] = 0.0;
+    for (std::size_t f = 0; f < 4; ++f)
+    {
+      const double b0 = (*base[f])[0];
+      const double b1 = (*base[f])[1];
+      const double b2 = (*base[f])[2];
+      const double n0 = normals[f][0];
+      const double n1 = normals[f][1];
+      const double n2 = normals[f][2];
+      #pragma omp simd
+      for (std::size_t i = 0; i < size; ++i)
+      {
+        const std::size_t j = first + i;
+        const double d0 = (c[j] - b0)*n0 + (c[n + j] - b1)*n1
+          + (c[2*n + j] - b2)*n2;
+        const double d1 = (c[3*n + j] - b0)*n0 + (c[4*n + j] - b1)*n1
+          + (c[5*n + j] - b2)*n2;
+        const double d2 = (c[6*n + j] - b0)*n0 + (c[7*n + j] - b1)*n1
+          + (c[8*n + j] - b2)*n2;
+        const double d3 = (c[9*n + j] - b0)*n0 + (c[10*n + j] - b1)*n1
+          + (c[11*n + j] - b2)*n2;
+        separated[i] = max_value(separated[i],
+                                 min_value(min_value(d0, d1),
+                                           min_value(d2, d3)));
+      }
+    }
+
+    // Check remaining tetrahedra
+    for (std::size_t i = 0; i < size; ++i)
+    {
+      if (separated[i] > 0.0)
+        continue;
+
+      const std::size_t j = first + i;
+      if (collides_tetrahedron_tetrahedron(V1[0], V1[1], V1[2], V1[3],
+                                           Point(c[j], c[n + j], c[2*n + j]),
+                                           Point(c[3*n + j], c[4*n + j], c[5*n + j]),
+                                           Point(c[6*n + j], c[7*n + j], c[8*n + j]),
+                                           Point(c[9*n + j], c[10*n + j], c[11*n + j])))
+      {
+        collisions.push_back(j);
+      }
+    }
+  }
+}
+//-----------------------------------------------------------------------------
+void
+CollisionDetection::collides_triangle_triangle(const MeshEntity& triangle,
+                                               const std::vector<double>& coordinates,
+                                               std::vector<unsigned int>& collisions)
+{
+  dolfin_assert(triangle.mesh().topology().dim() == 2);
+  dolfin_assert(coordinates.size() % 9 == 0);
+  const std::size_t n = coordinates.size()/9;
+
+  // Get the vertices as points
+  const MeshGeometry& geometry = triangle.mesh().geometry();
+  const unsigned int* vertices = triangle.entities(0);
+  const Point p0 = geometry.point(vertices[0]);
+  const Point p1 = geometry.point(vertices[1]);
+  const Point p2 = geometry.point(vertices[2]);
+
+  // Compute midpoint and plane equation N1.X + d1 = 0 of the
+  // triangle, as in collides_triangle_triangle
+  const Point Vmid = (p0 + p1 + p2) / 3.;
+  const Point N1 = (p1 - p0).cross(p2 - p0);
+  const double d1 = -N1.dot(p0);
+  const double m0 = Vmid[0], m1 = Vmid[1], m2 = Vmid[2];
+  const double n0 = N1[0], n1 = N1[1], n2 = N1[2];
+  const double v00 = p0[0], v01 = p0[1], v02 = p0[2];
+  const double v10 = p1[0], v11 = p1[1], v12 = p1[2];
+  const double v20 = p2[0], v21 = p2[1], v22 = p2[2];
+  const double eps2 = DOLFIN_EPS_LARGE*DOLFIN_EPS_LARGE;
+
+  // Coordinates of the batch (coordinate k of vertex v of item j
+  // is stored at position (3*v + k)*n + j)
+  const double* c = coordinates.data();
+
+  // Triangles in the plane are never rejected by the tests against
+  // the planes of the triangles, so check them one by one
+  if (geometry.dim() == 2)
+  {
+    for (std::size_t j = 0; j < n; ++j)
+    {
+      if (collides_triangle_triangle(p0, p1, p2,
+                                     Point(c[j], c[n + j], c[2*n + j]),
+                                     Point(c[3*n + j], c[4*n + j], c[5*n + j]),
+                                     Point(c[6*n + j], c[7*n + j], c[8*n + j])))
+      {
+        collisions.push_back(j);
+      }
+    }
+    return;
+  }
+
+  // Check batch in blocks
+  const std::size_t block_size = 64;
+  double separated[block_size];
+  for (std::size_t first = 0; first < n; first += block_size)
+  {
+    const std::size_t size = std::min(block_size, n - first);
+
+    // Reject triangles that are not the same triangle and have all
+    // vertices strictly on one side of the plane of the other
+    // triangle (for which separated is positive). The tolerance
+    // tests are done on squared distances and the loop has no
+    // branches and is marked for vectorization.
+    #pragma omp simd
+    for (std::size_t i = 0; i < size; ++i)
+    {
+      const std::size_t j = first + i;
+      const double q00 = c[j], q01 = c[n + j], q02 = c[2*n + j];
+      const double q10 = c[3*n + j], q11 = c[4*n + j], q12 = c[5*n + j];
+      const double q20 = c[6*n + j], q21 = c[7*n + j], q22 = c[8*n + j];
+
+      // Distance between midpoints
+      const double dm0 = m0 - (q00 + q10 + q20) / 3.;
+      const double dm1 = m1 - (q01 + q11 + q21) / 3.;
+      const double dm2 = m2 - (q02 + q12 + q22) / 3.;
+
+      // Signed distances of vertices to plane of triangle (zero if
+      // within tolerance)
+      const double du0 = zero_if_small(n0*q00 + n1*q01 + n2*q02 + d1, eps2);
+      const double du1 = zero_if_small(n0*q10 + n1*q11 + n2*q12 + d1, eps2);
+      const double du2 = zero_if_small(n0*q20 + n1*q21 + n2*q22 + d1, eps2);
+
+      // Plane of triangle in batch
+      const double e10 = q10 - q00, e11 = q11 - q01, e12 = q12 - q02;
+      const double e20 = q20 - q00, e21 = q21 - q01, e22 = q22 - q02;
+      const double N20 = e11*e22 - e12*e21;
+      const double N21 = e12*e20 - e10*e22;
+      const double N22 = e10*e21 - e11*e20;
+      const double d2 = -(N20*q00 + N21*q01 + N22*q02);
+
+      // Signed distances of vertices of triangle to plane of
+      // triangle in batch (zero if within tolerance)
+      const double dv0 = zero_if_small(N20*v00 + N21*v01 + N22*v02 + d2, eps2);
+      const double dv1 = zero_if_small(N20*v10 + N21*v11 + N22*v12 + d2, eps2);
+      const double dv2 = zero_if_small(N20*v20 + N21*v21 + N22*v22 + d2, eps2);
+
+      // All vertices on one side if the products are positive
+      const double side = max_value(min_value(du0*du1, du0*du2),
+                                    min_value(dv0*dv1, dv0*dv2));
+      separated[i] = dm0*dm0 + dm1*dm1 + dm2*dm2 < eps2 ? -1.0 : side;
+    }
+
+    // Check remaining triangles
+    for (std::size_t i = 0; i < size; ++i)
+    {
+      if (separated[i] > 0.0)
+        continue;
+
+      const std::size_t j = first + i;
+      if (collides_triangle_triangle(p0, p1, p2,
+                                     Point(c[j], c[n + j], c[2*n + j]),
+                                     Point(c[3*n + j], c[4*n + j], c[5*n + j]),
+                                     Point(c[6*n + j], c[7*n + j], c[8*n + j])))
+      {
+        collisions.push_back(j);
+      }
+    }
+  }
+}
+//-----------------------------------------------------------------------------
+void CollisionDetection::get_coordinates(const Mesh& mesh,
+                                         const std::vector<unsigned int>& cells,
+                                         std::vector<double>& coordinates)
+{
+  const std::size_t n = cells.size();
+  const std::size_t tdim = mesh.topology().dim();
+  const std::size_t gdim = mesh.geometry().dim();
+  const std::size_t num_vertices = tdim + 1;
+  const MeshConnectivity& connectivity = mesh.topology()(tdim, 0);
+  const MeshGeometry& geometry = mesh.geometry();
+
+  coordinates.assign(3*num_vertices*n, 0.0);
+  for (std::size_t i = 0; i < n; ++i)
+  {
+    const unsigned int* vertices = connectivity(cells[i]);
+    for (std::size_t v = 0; v < num_vertices; ++v)
+    {
+      const double* x = geometry.x(vertices[v]);
+      for (std::size_t j = 0; j < gdim; ++j)
+        coordinates[(3*v + j)*n + i] = x[j];
+    }
+  }
+}
+//-----------------------------------------------------------------------------
 bool
 CollisionDetection::collides_edge_edge(const Point& a,
 				       const Point& b,
@@ -20,6 +20,7 @@
 
 #include <vector>
 #include <dolfin/log/log.h>
+#include "Point.h"
 
 #ifndef __COLLISION_DETECTION_H
 #define __COLLISION_DETECTION_H
@@ -28,6 +29,7 @@ namespace dolfin
 {
 
   // Forward declarations
+  class Mesh;
   class MeshEntity;
 
   /// This class implements algorithms for detecting pairwise
@@ -163,6 +165,65 @@ namespace dolfin
     static bool collides_tetrahedron_tetrahedron(const MeshEntity& tetrahedron_0,
                                                  const MeshEntity& tetrahedron_1);
 
+    /// Check whether tetrahedron collides with each tetrahedron of a
+    /// batch. The batch is checked in two passes: a loop without
+    /// branches over the batch (vectorized with OpenMP SIMD)
+    /// rejects the tetrahedra that are separated by a face plane of
+    /// the given tetrahedron, and the remaining tetrahedra are
+    /// checked by collides_tetrahedron_tetrahedron. The rejection
+    /// test is the first test of collides_tetrahedron_tetrahedron, so
+    /// the results are the same as checking pair by pair.
+    ///
+    /// *Arguments*
+    ///     tetrahedron (_MeshEntity_)
+    ///         The tetrahedron.
+    ///     coordinates (std::vector<double>)
+    ///         Vertex coordinates of the batch, as computed by
+    ///         get_coordinates.
+    ///     collisions (std::vector<unsigned int>)
+    ///         Positions in the batch of the colliding tetrahedra
+    ///         (appended in increasing order).
+    static void
+    collides_tetrahedron_tetrahedron(const MeshEntity& tetrahedron,
+                                     const std::vector<double>& coordinates,
+                                     std::vector<unsigned int>& collisions);
+
+    /// Check whether triangle collides with each triangle of a batch.
+    /// As for tetrahedra, triangles that are separated by the plane
+    /// of one of the triangles are rejected in a first pass, with the
+    /// same tests as collides_triangle_triangle. Triangles in the
+    /// plane can not be rejected this way and are checked one by one.
+    ///
+    /// *Arguments*
+    ///     triangle (_MeshEntity_)
+    ///         The triangle.
+    ///     coordinates (std::vector<double>)
+    ///         Vertex coordinates of the batch, as computed by
+    ///         get_coordinates.
+    ///     collisions (std::vector<unsigned int>)
+    ///         Positions in the batch of the colliding triangles
+    ///         (appended in increasing order).
+    static void
+    collides_triangle_triangle(const MeshEntity& triangle,
+                               const std::vector<double>& coordinates,
+                               std::vector<unsigned int>& collisions);
+
+    /// Get vertex coordinates of a batch of cells in
+    /// structure-of-arrays layout: coordinates[(3*v + j)*n + i] is
+    /// coordinate j of vertex v of cell i, for n cells. Coordinates
+    /// beyond the geometric dimension are zero.
+    ///
+    /// *Arguments*
+    ///     mesh (_Mesh_)
+    ///         The mesh.
+    ///     cells (std::vector<unsigned int>)
+    ///         Indices of the cells.
+    ///     coordinates (std::vector<double>)
+    ///         The coordinates.
+    static void get_coordinates(const Mesh& mesh,
+                                const std::vector<unsigned int>& cells,
+                                std::vector<double>& coordinates);
+
     /// Check whether edge a-b collides with edge c-d.
     static bool collides_edge_edge(const Point& a, const Point& b,
 				   const Point& c, const Point& d);
@@ -192,6 +253,16 @@ namespace dolfin
 					   const Point& point);
   private:
 
+    // The implementation of collides_tetrahedron_tetrahedron
+    static bool collides_tetrahedron_tetrahedron(const Point& p0,
+                                                 const Point& p1,
+                                                 const Point& p2,
+                                                 const Point& p3,
+                                                 const Point& q0,
+                                                 const Point& q1,
+                                                 const Point& q2,
+                                                 const Point& q3);
+
     // The implementation of collides_triangle_triangle
     static bool collides_triangle_triangle(const Point& p0,
 					   const Point& p1,
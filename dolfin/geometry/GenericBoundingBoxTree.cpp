@@ -23,12 +23,15 @@
 // recursion and is more convenient than sending it around.
 #define MAX_DIM 6
 
+#include <cstdint>
 #include <dolfin/common/MPI.h>
+#include <dolfin/geometry/CollisionDetection.h>
 #include <dolfin/geometry/Point.h>
 #include <dolfin/mesh/Mesh.h>
 #include <dolfin/mesh/Cell.h>
 #include <dolfin/mesh/MeshEntity.h>
 #include <dolfin/mesh/MeshEntityIterator.h>
+#include <dolfin/parameter/GlobalParameters.h>
 #include "BoundingBoxTree1D.h" // used for internal point search tree
 #include "BoundingBoxTree2D.h" // used for internal point search tree
 #include "BoundingBoxTree3D.h" // used for internal point search tree
@@ -37,7 +40,270 @@
 using namespace dolfin;
 
 //-----------------------------------------------------------------------------
-GenericBoundingBoxTree::GenericBoundingBoxTree() : _tdim(0)
+// Functions for traversal of the depth-first nodes of a tree, see
+// build_traversal_nodes(). Node i starts at position i*node_size(gdim)
+// with the bounding box [xmin, xmax], followed by the position of the
+// node following the subtree of node i and the entity index (-1 for
+// internal nodes). The first child of an internal node i is node
+// i + 1 and the second child is the node following the subtree of
+// the first child.
+//-----------------------------------------------------------------------------
+static inline std::size_t node_size(std::size_t gdim)
+{
+  return gdim == 1 ? 4 : 8;
+}
+//-----------------------------------------------------------------------------
+template<std::size_t gdim>
+static inline bool point_in_node(const double* x, const double* b)
+{
+  for (std::size_t j = 0; j < gdim; ++j)
+  {
+    const double eps = DOLFIN_EPS_LARGE*(b[gdim + j] - b[j]);
+    if (!(b[j] - eps <= x[j] && x[j] <= b[gdim + j] + eps))
+      return false;
+  }
+  return true;
+}
+//-----------------------------------------------------------------------------
+template<std::size_t gdim>
+static inline bool bbox_in_node(const double* a, const double* b)
+{
+  for (std::size_t j = 0; j < gdim; ++j)
+  {
+    const double eps = DOLFIN_EPS_LARGE*(b[gdim + j] - b[j]);
+    if (!(b[j] - eps <= a[gdim + j] && a[j] <= b[gdim + j] + eps))
+      return false;
+  }
+  return true;
+}
+//-----------------------------------------------------------------------------
+template<std::size_t gdim>
+static inline double squared_distance_node(const double* x, const double* b)
+{
+  double r2 = 0.0;
+  for (std::size_t j = 0; j < gdim; ++j)
+  {
+    if (x[j] < b[j]) r2 += (x[j] - b[j])*(x[j] - b[j]);
+    if (x[j] > b[gdim + j]) r2 += (x[j] - b[gdim + j])*(x[j] - b[gdim + j]);
+  }
+  return r2;
+}
+//-----------------------------------------------------------------------------
+template<std::size_t gdim>
+static inline double squared_distance_point(const double* x, const double* b)
+{
+  double r2 = 0.0;
+  for (std::size_t j = 0; j < gdim; ++j)
+    r2 += (x[j] - b[j])*(x[j] - b[j]);
+  return r2;
+}
+//-----------------------------------------------------------------------------
+template<std::size_t gdim>
+static void traverse_collisions(const double* nodes,
+                                unsigned int num_nodes,
+                                const Point& point,
+                                std::vector<unsigned int>& entities,
+                                const Mesh* mesh)
+{
+  const double* x = point.coordinates();
+  unsigned int node = 0;
+  while (node < num_nodes)
+  {
+    const double* b = nodes + node_size(gdim)*node;
+
+    // If point is not in bounding box, then skip subtree
+    if (!point_in_node<gdim>(x, b))
+      node = b[2*gdim];
+
+    // Descend to first child of internal node
+    else if (b[2*gdim + 1] < 0.0)
+      ++node;
+
+    // If box is a leaf (which we know contains the point), then add
+    // it if the entity collides with the point (or if we have no
+    // mesh)
+    else
+    {
+      const unsigned int entity_index = b[2*gdim + 1];
+      if (!mesh || Cell(*mesh, entity_index).collides(point))
+        entities.push_back(entity_index);
+      node = b[2*gdim];
+    }
+  }
+}
+//-----------------------------------------------------------------------------
+template<std::size_t gdim>
+static unsigned int traverse_first_collision(const double* nodes,
+                                             unsigned int num_nodes,
+                                             const Point& point,
+                                             const Mesh* mesh)
+{
+  const double* x = point.coordinates();
+  unsigned int node = 0;
+  while (node < num_nodes)
+  {
+    const double* b = nodes + node_size(gdim)*node;
+    if (!point_in_node<gdim>(x, b))
+      node = b[2*gdim];
+    else if (b[2*gdim + 1] < 0.0)
+      ++node;
+    else
+    {
+      const unsigned int entity_index = b[2*gdim + 1];
+      if (!mesh || Cell(*mesh, entity_index).collides(point))
+        return entity_index;
+      node = b[2*gdim];
+    }
+  }
+
+  // Point not found
+  return std::numeric_limits<unsigned int>::max();
+}
+//-----------------------------------------------------------------------------
+template<std::size_t gdim>
+static void traverse_closest_entity(const double* nodes,
+                                    unsigned int num_nodes,
+                                    const Point& point,
+                                    const Mesh& mesh,
+                                    unsigned int& closest_entity,
+                                    double& R2)
+{
+  const double* x = point.coordinates();
+  unsigned int node = 0;
+  while (node < num_nodes)
+  {
+    const double* b = nodes + node_size(gdim)*node;
+
+    // If bounding box is outside radius, then skip subtree
+    if (squared_distance_node<gdim>(x, b) > R2)
+      node = b[2*gdim];
+
+    // Descend to first child of internal node
+    else if (b[2*gdim + 1] < 0.0)
+      ++node;
+
+    // If box is leaf (which we know is inside radius), then shrink
+    // radius if entity is closer than best result so far
+    else
+    {
+      const unsigned int entity_index = b[2*gdim + 1];
+      const double r2 = Cell(mesh, entity_index).squared_distance(point);
+      if (r2 < R2)
+      {
+        closest_entity = entity_index;
+        R2 = r2;
+      }
+      node = b[2*gdim];
+    }
+  }
+}
+//-----------------------------------------------------------------------------
+template<std::size_t gdim>
+static void traverse_closest_point(const double* nodes,
+                                   unsigned int num_nodes,
+                                   const Point& point,
+                                   unsigned int& closest_point,
+                                   double& R2)
+{
+  const double* x = point.coordinates();
+  unsigned int node = 0;
+  while (node < num_nodes)
+  {
+    const double* b = nodes + node_size(gdim)*node;
+
+    // If box is leaf, then compute distance and shrink radius
+    if (b[2*gdim + 1] >= 0.0)
+    {
+      const double r2 = squared_distance_point<gdim>(x, b);
+      if (r2 < R2)
+      {
+        closest_point = b[2*gdim + 1];
+        R2 = r2;
+      }
+      node = b[2*gdim];
+    }
+
+    // If bounding box is outside radius, then skip subtree
+    else if (squared_distance_node<gdim>(x, b) > R2)
+      node = b[2*gdim];
+
+    // Descend to first child
+    else
+      ++node;
+  }
+}
+//-----------------------------------------------------------------------------
+template<std::size_t gdim>
+static void traverse_tree_collisions(const double* nodes_A,
+                                     const double* nodes_B,
+                                     unsigned int node_A,
+                                     unsigned int node_B,
+                                     unsigned int depth_A,
+                                     unsigned int depth_B,
+                                     std::vector<unsigned int>& entities_A,
+                                     std::vector<unsigned int>& entities_B,
+                                     const Mesh* mesh_A,
+                                     const Mesh* mesh_B)
+{
+  const double* a = nodes_A + node_size(gdim)*node_A;
+  const double* b = nodes_B + node_size(gdim)*node_B;
+
+  // If bounding boxes don't collide, then don't search further
+  if (!bbox_in_node<gdim>(a, b))
+    return;
+
+  // Check whether we've reached a leaf in A or B
+  const bool is_leaf_A = a[2*gdim + 1] >= 0.0;
+  const bool is_leaf_B = b[2*gdim + 1] >= 0.0;
+
+  // If both boxes are leaves (which we know collide), then add them
+  // if the entities collide (or if we have no meshes)
+  if (is_leaf_A && is_leaf_B)
+  {
+    const unsigned int entity_index_A = a[2*gdim + 1];
+    const unsigned int entity_index_B = b[2*gdim + 1];
+    if (!mesh_A || Cell(*mesh_A, entity_index_A).collides(Cell(*mesh_B,
+                                                               entity_index_B)))
+    {
+      entities_A.push_back(entity_index_A);
+      entities_B.push_back(entity_index_B);
+    }
+    return;
+  }
+
+  // Descend A if we reached a leaf in B. If neither is a leaf,
+  // descend the node with the largest number in post-order (the
+  // order in which the tree is built, with the root last), which is
+  // the position of the node following the subtree minus the depth
+  // minus one.
+  const bool descend_A = !is_leaf_A
+    && (is_leaf_B || a[2*gdim] - depth_A > b[2*gdim] - depth_B);
+  if (descend_A)
+  {
+    const unsigned int child_0 = node_A + 1;
+    const unsigned int child_1 = nodes_A[node_size(gdim)*child_0 + 2*gdim];
+    traverse_tree_collisions<gdim>(nodes_A, nodes_B, child_0, node_B,
+                                   depth_A + 1, depth_B,
+                                   entities_A, entities_B, mesh_A, mesh_B);
+    traverse_tree_collisions<gdim>(nodes_A, nodes_B, child_1, node_B,
+                                   depth_A + 1, depth_B,
+                                   entities_A, entities_B, mesh_A, mesh_B);
+  }
+  else
+  {
+    const unsigned int child_0 = node_B + 1;
+    const unsigned int child_1 = nodes_B[node_size(gdim)*child_0 + 2*gdim];
+    traverse_tree_collisions<gdim>(nodes_A, nodes_B, node_A, child_0,
+                                   depth_A, depth_B + 1,
+                                   entities_A, entities_B, mesh_A, mesh_B);
+    traverse_tree_collisions<gdim>(nodes_A, nodes_B, node_A, child_1,
+                                   depth_A, depth_B + 1,
+                                   entities_A, entities_B, mesh_A, mesh_B);
+  }
+}
+//-----------------------------------------------------------------------------
+GenericBoundingBoxTree::GenericBoundingBoxTree() : _tdim(0),
+  _traversal_offset(0), _num_nodes(0)
 {
   // Do nothing
 }
@@ -88,12 +354,20 @@ void GenericBoundingBoxTree::build(const Mesh& mesh, std::size_t tdim)
   // Initialize entities of given dimension if they don't exist
   mesh.init(tdim);
 
-  // Create bounding boxes for all entities (leaves)
+  // Create bounding boxes for all entities (leaves). The bounding
+  // boxes of ghost entities are left zero.
   const std::size_t _gdim = gdim();
   const unsigned int num_leaves = mesh.num_entities(tdim);
+  const int num_regular = mesh.topology().ghost_offset(tdim);
+  const std::size_t num_threads_param = parameters["num_threads"];
+  const int num_threads = std::max((int) num_threads_param, 1);
   std::vector<double> leaf_bboxes(2*_gdim*num_leaves);
-  for (MeshEntityIterator it(mesh, tdim); !it.end(); ++it)
-    compute_bbox_of_entity(leaf_bboxes.data() + 2*_gdim*it->index(), *it, _gdim);
+  #pragma omp parallel for num_threads(num_threads)
+  for (int i = 0; i < num_regular; ++i)
+  {
+    const MeshEntity entity(mesh, tdim, i);
+    compute_bbox_of_entity(leaf_bboxes.data() + 2*_gdim*i, entity, _gdim);
+  }
 
   // Create leaf partition (to be sorted)
   std::vector<unsigned int> leaf_partition(num_leaves);
@@ -102,34 +376,13 @@ void GenericBoundingBoxTree::build(const Mesh& mesh, std::size_t tdim)
 
   // Recursively build the bounding box tree from the leaves
   _build(leaf_bboxes, leaf_partition.begin(), leaf_partition.end(), _gdim);
+  build_traversal_nodes();
 
   log(PROGRESS,
       "Computed bounding box tree with %d nodes for %d entities.",
-      num_bboxes(), num_leaves);
+      num_nodes(), num_leaves);
 
-  const std::size_t mpi_size = MPI::size(mesh.mpi_comm());
-  if (mpi_size > 1)
-  {
-    // Send root node coordinates to all processes
-    std::vector<double> send_bbox(_bbox_coordinates.end() - _gdim*2,
-                                  _bbox_coordinates.end());
-    std::vector<double> recv_bbox;
-    MPI::all_gather(mesh.mpi_comm(), send_bbox, recv_bbox);
-    std::vector<unsigned int> global_leaves(mpi_size);
-    for (std::size_t i = 0; i != mpi_size; ++i)
-      global_leaves[i] = i;
-
-    _global_tree = create(_gdim);
-    _global_tree->_build(recv_bbox,
-                         global_leaves.begin(), global_leaves.end(), _gdim);
-
-    info("Computed global bounding box tree with %d boxes.",
-         _global_tree->num_bboxes());
-    // Print on rank 0
-    //    if(MPI::rank(mesh.mpi_comm()) == 0)
-    //      std::cout << _global_tree->str() << "\n";
-
-  }
+  build_global_tree(mesh);
 }
 //-----------------------------------------------------------------------------
 void GenericBoundingBoxTree::build(const std::vector<Point>& points)
@@ -145,17 +398,82 @@ void GenericBoundingBoxTree::build(const std::vector<Point>& points)
 
   // Recursively build the bounding box tree from the leaves
   _build(points, leaf_partition.begin(), leaf_partition.end(), gdim());
+  build_traversal_nodes();
 
   info("Computed bounding box tree with %d nodes for %d points.",
-       num_bboxes(), num_leaves);
+       num_nodes(), num_leaves);
+}
+//-----------------------------------------------------------------------------
+void GenericBoundingBoxTree::refit(const Mesh& mesh)
+{
+  // Check that the tree was built for the entities of the mesh
+  if (_tdim == 0 || _tdim > mesh.topology().dim()
+      || num_nodes() != 2*mesh.num_entities(_tdim) - 1)
+  {
+    dolfin_error("GenericBoundingBoxTree.cpp",
+                 "refit bounding box tree",
+                 "Tree was not built for the entities of this mesh");
+  }
+
+  // Update bounding boxes of leaves (except for ghost entities)
+  const std::size_t _gdim = gdim();
+  const std::size_t n = node_size(_gdim);
+  const int num_nodes = _num_nodes;
+  double* nodes = _traversal_nodes.data() + _traversal_offset;
+  const unsigned int num_regular = mesh.topology().ghost_offset(_tdim);
+  const std::size_t num_threads_param = parameters["num_threads"];
+  const int num_threads = std::max((int) num_threads_param, 1);
+  #pragma omp parallel for num_threads(num_threads)
+  for (int node = 0; node < num_nodes; ++node)
+  {
+    double* b = nodes + n*node;
+    if (b[2*_gdim + 1] >= 0.0 && b[2*_gdim + 1] < num_regular)
+    {
+      const MeshEntity entity(mesh, _tdim, (unsigned int) b[2*_gdim + 1]);
+      compute_bbox_of_entity(b, entity, _gdim);
+    }
+  }
+
+  // Update bounding boxes of the other nodes from their children,
+  // which are stored after the node
+  for (int node = num_nodes - 1; node >= 0; --node)
+  {
+    double* b = nodes + n*node;
+    if (b[2*_gdim + 1] >= 0.0)
+      continue;
+
+    const double* b0 = b + n;
+    const double* b1 = nodes + n*((unsigned int) b0[2*_gdim]);
+    for (std::size_t j = 0; j < _gdim; ++j)
+    {
+      b[j] = std::min(b0[j], b1[j]);
+      b[_gdim + j] = std::max(b0[_gdim + j], b1[_gdim + j]);
+    }
+  }
+
+  // Point search tree is built from the vertices and is rebuilt when
+  // needed
+  _point_search_tree.reset();
+
+  build_global_tree(mesh);
 }
 //-----------------------------------------------------------------------------
 std::vector<unsigned int>
 GenericBoundingBoxTree::compute_collisions(const Point& point) const
 {
-  // Call recursive find function
+  // Traverse tree
   std::vector<unsigned int> entities;
-  _compute_collisions(*this, point, num_bboxes() - 1, entities, 0);
+  switch (gdim())
+  {
+  case 1:
+    traverse_collisions<1>(traversal_nodes(), num_nodes(), point, entities, 0);
+    break;
+  case 2:
+    traverse_collisions<2>(traversal_nodes(), num_nodes(), point, entities, 0);
+    break;
+  default:
+    traverse_collisions<3>(traversal_nodes(), num_nodes(), point, entities, 0);
+  }
 
   return entities;
 }
@@ -172,10 +490,8 @@ std::pair<std::vector<unsigned int>, std::vector<unsigned int>>
   std::vector<unsigned int> entities_A;
   std::vector<unsigned int> entities_B;
 
-  // Call recursive find function
-  _compute_collisions(A, B,
-                      A.num_bboxes() - 1, B.num_bboxes() - 1,
-                      entities_A, entities_B, 0, 0);
+  // Traverse trees
+  _compute_collisions(A, B, entities_A, entities_B, 0, 0);
 
   return std::make_pair(entities_A, entities_B);
 }
@@ -192,9 +508,22 @@ GenericBoundingBoxTree::compute_entity_collisions(const Point& point,
                  "Point-in-entity is only implemented for cells");
   }
 
-  // Call recursive find function to compute bounding box candidates
+  // Traverse tree, checking bounding box candidates
   std::vector<unsigned int> entities;
-  _compute_collisions(*this, point, num_bboxes() - 1, entities, &mesh);
+  switch (gdim())
+  {
+  case 1:
+    traverse_collisions<1>(traversal_nodes(), num_nodes(), point, entities,
+                           &mesh);
+    break;
+  case 2:
+    traverse_collisions<2>(traversal_nodes(), num_nodes(), point, entities,
+                           &mesh);
+    break;
+  default:
+    traverse_collisions<3>(traversal_nodes(), num_nodes(), point, entities,
+                           &mesh);
+  }
 
   return entities;
 }
@@ -222,10 +551,61 @@ GenericBoundingBoxTree::compute_entity_collisions(
   std::vector<unsigned int> entities_A;
   std::vector<unsigned int> entities_B;
 
-  // Call recursive find function
-  _compute_collisions(A, B,
-                      A.num_bboxes() - 1, B.num_bboxes() - 1,
-                      entities_A, entities_B, &mesh_A, &mesh_B);
+  // Check pairs of tetrahedra and of triangles in batches
+  const CellType::Type type_A = mesh_A.type().cell_type();
+  const CellType::Type type_B = mesh_B.type().cell_type();
+  if (type_A == type_B && (type_A == CellType::tetrahedron
+                           || type_A == CellType::triangle))
+  {
+    // Compute bounding box candidates
+    std::vector<unsigned int> candidates_A;
+    std::vector<unsigned int> candidates_B;
+    _compute_collisions(A, B, candidates_A, candidates_B, 0, 0);
+
+    // Check candidates of B for each run of candidates with the same
+    // entity of A (keeping the order of the candidates)
+    std::vector<unsigned int> batch;
+    std::vector<double> coordinates;
+    std::vector<unsigned int> collisions;
+    std::size_t first = 0;
+    while (first < candidates_A.size())
+    {
+      std::size_t last = first + 1;
+      while (last < candidates_A.size()
+             && candidates_A[last] == candidates_A[first])
+      {
+        ++last;
+      }
+
+      batch.assign(candidates_B.begin() + first, candidates_B.begin() + last);
+      CollisionDetection::get_coordinates(mesh_B, batch, coordinates);
+      collisions.clear();
+      const Cell cell_A(mesh_A, candidates_A[first]);
+      if (type_A == CellType::tetrahedron)
+      {
+        CollisionDetection::collides_tetrahedron_tetrahedron(cell_A,
+                                                             coordinates,
+                                                             collisions);
+      }
+      else
+      {
+        CollisionDetection::collides_triangle_triangle(cell_A, coordinates,
+                                                       collisions);
+      }
+
+      for (std::size_t i = 0; i < collisions.size(); ++i)
+      {
+        entities_A.push_back(candidates_A[first]);
+        entities_B.push_back(batch[collisions[i]]);
+      }
+      first = last;
+    }
+
+    return std::make_pair(entities_A, entities_B);
+  }
+
+  // Traverse trees, checking bounding box candidates
+  _compute_collisions(A, B, entities_A, entities_B, &mesh_A, &mesh_B);
 
   return std::make_pair(entities_A, entities_B);
 }
@@ -233,8 +613,19 @@ GenericBoundingBoxTree::compute_entity_collisions(
 unsigned int
 GenericBoundingBoxTree::compute_first_collision(const Point& point) const
 {
-  // Call recursive find function
-  return _compute_first_collision(*this, point, num_bboxes() - 1);
+  // Traverse tree
+  switch (gdim())
+  {
+  case 1:
+    return traverse_first_collision<1>(traversal_nodes(), num_nodes(), point,
+                                       0);
+  case 2:
+    return traverse_first_collision<2>(traversal_nodes(), num_nodes(), point,
+                                       0);
+  default:
+    return traverse_first_collision<3>(traversal_nodes(), num_nodes(), point,
+                                       0);
+  }
 }
 //-----------------------------------------------------------------------------
 unsigned int
@@ -249,8 +640,56 @@ GenericBoundingBoxTree::compute_first_entity_collision(const Point& point,
                  "Point-in-entity is only implemented for cells");
   }
 
-  // Call recursive find function
-  return _compute_first_entity_collision(*this, point, num_bboxes() - 1, mesh);
+  // Traverse tree
+  switch (gdim())
+  {
+  case 1:
+    return traverse_first_collision<1>(traversal_nodes(), num_nodes(), point,
+                                       &mesh);
+  case 2:
+    return traverse_first_collision<2>(traversal_nodes(), num_nodes(), point,
+                                       &mesh);
+  default:
+    return traverse_first_collision<3>(traversal_nodes(), num_nodes(), point,
+                                       &mesh);
+  }
+}
+//-----------------------------------------------------------------------------
+std::vector<unsigned int>
+GenericBoundingBoxTree::compute_first_entity_collisions(
+  const std::vector<Point>& points,
+  const Mesh& mesh) const
+{
+  // Point in entity only implemented for cells. Consider extending this.
+  if (_tdim != mesh.topology().dim())
+  {
+    dolfin_error("GenericBoundingBoxTree.cpp",
+                 "compute collision between points and mesh entities",
+                 "Point-in-entity is only implemented for cells");
+  }
+
+  // Traverse tree for each point
+  std::vector<unsigned int> entities(points.size());
+  const double* nodes = traversal_nodes();
+  for (std::size_t i = 0; i < points.size(); ++i)
+  {
+    switch (gdim())
+    {
+    case 1:
+      entities[i] = traverse_first_collision<1>(nodes, num_nodes(), points[i],
+                                                &mesh);
+      break;
+    case 2:
+      entities[i] = traverse_first_collision<2>(nodes, num_nodes(), points[i],
+                                                &mesh);
+      break;
+    default:
+      entities[i] = traverse_first_collision<3>(nodes, num_nodes(), points[i],
+                                                &mesh);
+    }
+  }
+
+  return entities;
 }
 //-----------------------------------------------------------------------------
 std::pair<unsigned int, double>
@@ -276,9 +715,21 @@ GenericBoundingBoxTree::compute_closest_entity(const Point& point,
   unsigned int closest_entity = std::numeric_limits<unsigned int>::max();
   double R2 = r*r;
 
-  // Call recursive find function
-  _compute_closest_entity(*this, point, num_bboxes() - 1,
-                          mesh, closest_entity, R2);
+  // Traverse tree
+  switch (gdim())
+  {
+  case 1:
+    traverse_closest_entity<1>(traversal_nodes(), num_nodes(), point, mesh,
+                               closest_entity, R2);
+    break;
+  case 2:
+    traverse_closest_entity<2>(traversal_nodes(), num_nodes(), point, mesh,
+                               closest_entity, R2);
+    break;
+  default:
+    traverse_closest_entity<3>(traversal_nodes(), num_nodes(), point, mesh,
+                               closest_entity, R2);
+  }
 
   // Sanity check
   dolfin_assert(closest_entity < std::numeric_limits<unsigned int>::max());
@@ -302,12 +753,33 @@ GenericBoundingBoxTree::compute_closest_point(const Point& point) const
   // be weird.
 
   // Get initial guess by picking the distance to a "random" point
-  unsigned int closest_point = 0;
-  double R2 = compute_squared_distance_point(point.coordinates(),
-                                             closest_point);
-
-  // Call recursive find function
-  _compute_closest_point(*this, point, num_bboxes() - 1, closest_point, R2);
+  // (the first leaf)
+  const std::size_t _gdim = gdim();
+  const double* nodes = traversal_nodes();
+  unsigned int node = 0;
+  while (nodes[node_size(_gdim)*node + 2*_gdim + 1] < 0.0)
+    ++node;
+  const double* p = nodes + node_size(_gdim)*node;
+  unsigned int closest_point = p[2*_gdim + 1];
+  double R2 = 0.0;
+  for (std::size_t j = 0; j < _gdim; ++j)
+    R2 += (point[j] - p[j])*(point[j] - p[j]);
+
+  // Traverse tree
+  switch (gdim())
+  {
+  case 1:
+    traverse_closest_point<1>(traversal_nodes(), num_nodes(), point,
+                              closest_point, R2);
+    break;
+  case 2:
+    traverse_closest_point<2>(traversal_nodes(), num_nodes(), point,
+                              closest_point, R2);
+    break;
+  default:
+    traverse_closest_point<3>(traversal_nodes(), num_nodes(), point,
+                              closest_point, R2);
+  }
 
   std::pair<unsigned int, double> ret(closest_point, sqrt(R2));
   return ret;
@@ -320,9 +792,94 @@ void GenericBoundingBoxTree::clear()
   _tdim = 0;
   _bboxes.clear();
   _bbox_coordinates.clear();
+  _traversal_nodes.clear();
+  _traversal_offset = 0;
+  _num_nodes = 0;
   _point_search_tree.reset();
 }
 //-----------------------------------------------------------------------------
+void GenericBoundingBoxTree::build_global_tree(const Mesh& mesh)
+{
+  const std::size_t mpi_size = MPI::size(mesh.mpi_comm());
+  if (mpi_size > 1)
+  {
+    // Send root node coordinates to all processes
+    const std::size_t _gdim = gdim();
+    std::vector<double> send_bbox(traversal_nodes(),
+                                  traversal_nodes() + 2*_gdim);
+    std::vector<double> recv_bbox;
+    MPI::all_gather(mesh.mpi_comm(), send_bbox, recv_bbox);
+    std::vector<unsigned int> global_leaves(mpi_size);
+    for (std::size_t i = 0; i != mpi_size; ++i)
+      global_leaves[i] = i;
+
+    _global_tree = create(_gdim);
+    _global_tree->_build(recv_bbox,
+                         global_leaves.begin(), global_leaves.end(), _gdim);
+    _global_tree->build_traversal_nodes();
+
+    info("Computed global bounding box tree with %d boxes.",
+         _global_tree->num_nodes());
+    // Print on rank 0
+    //    if(MPI::rank(mesh.mpi_comm()) == 0)
+    //      std::cout << _global_tree->str() << "\n";
+
+  }
+}
+//-----------------------------------------------------------------------------
+void GenericBoundingBoxTree::build_traversal_nodes()
+{
+  const std::size_t _gdim = gdim();
+  const std::size_t n = node_size(_gdim);
+  const unsigned int num_nodes = num_bboxes();
+
+  // Compute number of nodes in subtree of each node (children are
+  // stored before their parent)
+  std::vector<unsigned int> subtree_size(num_nodes, 1);
+  for (unsigned int node = 0; node < num_nodes; ++node)
+  {
+    const BBox& bbox = _bboxes[node];
+    if (!is_leaf(bbox, node))
+      subtree_size[node] += subtree_size[bbox.child_0] + subtree_size[bbox.child_1];
+  }
+
+  // Compute depth-first position of each node, starting from the
+  // root (stored last)
+  std::vector<unsigned int> position(num_nodes, 0);
+  for (unsigned int node = num_nodes; node-- > 0; )
+  {
+    const BBox& bbox = _bboxes[node];
+    if (!is_leaf(bbox, node))
+    {
+      position[bbox.child_0] = position[node] + 1;
+      position[bbox.child_1] = position[node] + 1 + subtree_size[bbox.child_0];
+    }
+  }
+
+  // Allocate nodes, with the first node aligned to 64 bytes
+  _traversal_nodes.assign(n*num_nodes + 8, 0.0);
+  const std::uintptr_t address
+    = reinterpret_cast<std::uintptr_t>(_traversal_nodes.data());
+  _traversal_offset = ((64 - address % 64) % 64)/sizeof(double);
+
+  // Store bounding box, position of node following subtree and entity
+  for (unsigned int node = 0; node < num_nodes; ++node)
+  {
+    const BBox& bbox = _bboxes[node];
+    const double* b = _bbox_coordinates.data() + 2*_gdim*node;
+    double* t = _traversal_nodes.data() + _traversal_offset
+      + n*position[node];
+    std::copy(b, b + 2*_gdim, t);
+    t[2*_gdim] = position[node] + subtree_size[node];
+    t[2*_gdim + 1] = is_leaf(bbox, node) ? (double) bbox.child_1 : -1.0;
+  }
+  _num_nodes = num_nodes;
+
+  // Clear bounding boxes (only needed while building)
+  std::vector<BBox>().swap(_bboxes);
+  std::vector<double>().swap(_bbox_coordinates);
+}
+//-----------------------------------------------------------------------------
 unsigned int
 GenericBoundingBoxTree::_build(const std::vector<double>& leaf_bboxes,
                                const std::vector<unsigned int>::iterator& begin,
@@ -331,6 +888,51 @@ GenericBoundingBoxTree::_build(const std::vector<double>& leaf_bboxes,
 {
   dolfin_assert(begin < end);
 
+  // Allocate nodes (a binary tree with n leaves has 2n - 1 nodes)
+  const unsigned int first = num_bboxes();
+  const unsigned int num_nodes = 2*(end - begin) - 1;
+  _bboxes.resize(first + num_nodes);
+  _bbox_coordinates.resize(2*gdim*(first + num_nodes));
+
+  // Build top levels of tree, with about four subtrees per thread
+  const std::size_t num_threads_param = parameters["num_threads"];
+  const int num_threads = std::max((int) num_threads_param, 1);
+  std::size_t depth = 0;
+  if (num_threads > 1)
+  {
+    while ((1 << depth) < 4*num_threads)
+      ++depth;
+  }
+  std::vector<Subtree> subtrees;
+  _build(leaf_bboxes, begin, end, gdim, first, depth, &subtrees);
+
+  // Build subtrees in parallel
+  const int num_subtrees = subtrees.size();
+  #pragma omp parallel for schedule(dynamic) num_threads(num_threads)
+  for (int i = 0; i < num_subtrees; ++i)
+  {
+    _build(leaf_bboxes, subtrees[i].begin, subtrees[i].end, gdim,
+           subtrees[i].first, 0, 0);
+  }
+
+  // Root box is stored last
+  return first + num_nodes - 1;
+}
+//-----------------------------------------------------------------------------
+void
+GenericBoundingBoxTree::_build(const std::vector<double>& leaf_bboxes,
+                               const std::vector<unsigned int>::iterator& begin,
+                               const std::vector<unsigned int>::iterator& end,
+                               std::size_t gdim,
+                               unsigned int first,
+                               std::size_t depth,
+                               std::vector<Subtree>* subtrees)
+{
+  dolfin_assert(begin < end);
+
+  // Position of node (stored after the nodes of its subtrees)
+  const unsigned int node = first + 2*(end - begin) - 2;
+
   // Create empty bounding box data
   BBox bbox;
 
@@ -342,9 +944,21 @@ GenericBoundingBoxTree::_build(const std::vector<double>& leaf_bboxes,
     const double* b = leaf_bboxes.data() + 2*gdim*entity_index;
 
     // Store bounding box data
-    bbox.child_0 = num_bboxes(); // child_0 == node denotes a leaf
+    bbox.child_0 = node;         // child_0 == node denotes a leaf
     bbox.child_1 = entity_index; // index of entity contained in leaf
-    return add_bbox(bbox, b, gdim);
+    set_bbox(node, bbox, b, gdim);
+    return;
+  }
+
+  // Leave subtree to be built later
+  if (subtrees && depth == 0)
+  {
+    Subtree subtree;
+    subtree.begin = begin;
+    subtree.end = end;
+    subtree.first = first;
+    subtrees->push_back(subtree);
+    return;
   }
 
   // Compute bounding box of all bounding boxes
@@ -356,12 +970,16 @@ GenericBoundingBoxTree::_build(const std::vector<double>& leaf_bboxes,
   std::vector<unsigned int>::iterator middle = begin + (end - begin) / 2;
   sort_bboxes(axis, leaf_bboxes, begin, middle, end);
 
-  // Split bounding boxes into two groups and call recursively
-  bbox.child_0 = _build(leaf_bboxes, begin, middle, gdim);
-  bbox.child_1 = _build(leaf_bboxes, middle, end, gdim);
+  // Split bounding boxes into two groups and call recursively. The
+  // nodes of the first group are stored first.
+  const unsigned int first_1 = first + 2*(middle - begin) - 1;
+  _build(leaf_bboxes, begin, middle, gdim, first, depth - 1, subtrees);
+  _build(leaf_bboxes, middle, end, gdim, first_1, depth - 1, subtrees);
+  bbox.child_0 = first_1 - 1;
+  bbox.child_1 = node - 1;
 
   // Store bounding box data. Note that root box will be added last.
-  return add_bbox(bbox, b, gdim);
+  set_bbox(node, bbox, b, gdim);
 }
 //-----------------------------------------------------------------------------
 unsigned int
@@ -403,298 +1021,34 @@ GenericBoundingBoxTree::_build(const std::vector<Point>& points,
 }
 //-----------------------------------------------------------------------------
 void
-GenericBoundingBoxTree::_compute_collisions(const GenericBoundingBoxTree& tree,
-                                            const Point& point,
-                                            unsigned int node,
-                                            std::vector<unsigned int>& entities,
-                                            const Mesh* mesh)
-{
-  // Get bounding box for current node
-  const BBox& bbox = tree.get_bbox(node);
-
-  // If point is not in bounding box, then don't search further
-  if (!tree.point_in_bbox(point.coordinates(), node))
-    return;
-
-  // If box is a leaf (which we know contains the point), then add it
-  else if (tree.is_leaf(bbox, node))
-  {
-    // child_1 denotes entity for leaves
-    const unsigned int entity_index = bbox.child_1;
-
-    // If we have a mesh, check that the candidate is really a collision
-    if (mesh)
-    {
-      // Get cell
-      Cell cell(*mesh, entity_index);
-      if (cell.collides(point))
-        entities.push_back(entity_index);
-    }
-
-    // Otherwise, add the candidate
-    else
-      entities.push_back(entity_index);
-  }
-
-  // Check both children
-  else
-  {
-    _compute_collisions(tree, point, bbox.child_0, entities, mesh);
-    _compute_collisions(tree, point, bbox.child_1, entities, mesh);
-  }
-}
-//-----------------------------------------------------------------------------
-void
 GenericBoundingBoxTree::_compute_collisions(const GenericBoundingBoxTree& A,
                                             const GenericBoundingBoxTree& B,
-                                            unsigned int node_A,
-                                            unsigned int node_B,
                                             std::vector<unsigned int>& entities_A,
                                             std::vector<unsigned int>& entities_B,
                                             const Mesh* mesh_A,
                                             const Mesh* mesh_B)
 {
-  // Get bounding boxes for current nodes
-  const BBox& bbox_A = A.get_bbox(node_A);
-  const BBox& bbox_B = B.get_bbox(node_B);
-
-  // If bounding boxes don't collide, then don't search further
-  if (!B.bbox_in_bbox(A.get_bbox_coordinates(node_A), node_B))
+  dolfin_assert(A.gdim() == B.gdim());
+  if (A.num_nodes() == 0 || B.num_nodes() == 0)
     return;
 
-  // Check whether we've reached a leaf in A or B
-  const bool is_leaf_A = A.is_leaf(bbox_A, node_A);
-  const bool is_leaf_B = B.is_leaf(bbox_B, node_B);
-
-  // If both boxes are leaves (which we know collide), then add them
-  if (is_leaf_A && is_leaf_B)
+  // Traverse trees from the roots
+  switch (A.gdim())
   {
-    // child_1 denotes entity for leaves
-    const unsigned int entity_index_A = bbox_A.child_1;
-    const unsigned int entity_index_B = bbox_B.child_1;
-
-    // If we have a mesh, check that the candidate is really a collision
-    if (mesh_A)
-    {
-      dolfin_assert(mesh_B);
-      Cell cell_A(*mesh_A, entity_index_A);
-      Cell cell_B(*mesh_B, entity_index_B);
-      if (cell_A.collides(cell_B))
-      {
-        entities_A.push_back(entity_index_A);
-        entities_B.push_back(entity_index_B);
-      }
-    }
-
-    // Otherwise, add the candidate
-    else
-    {
-      entities_A.push_back(entity_index_A);
-      entities_B.push_back(entity_index_B);
-    }
-  }
-
-  // If we reached the leaf in A, then descend B
-  else if (is_leaf_A)
-  {
-    _compute_collisions(A, B, node_A, bbox_B.child_0,
-                        entities_A, entities_B, mesh_A, mesh_B);
-    _compute_collisions(A, B, node_A, bbox_B.child_1,
-                        entities_A, entities_B, mesh_A, mesh_B);
-  }
-
-  // If we reached the leaf in B, then descend A
-  else if (is_leaf_B)
-  {
-    _compute_collisions(A, B, bbox_A.child_0, node_B,
-                        entities_A, entities_B, mesh_A, mesh_B);
-    _compute_collisions(A, B, bbox_A.child_1, node_B,
-                        entities_A, entities_B, mesh_A, mesh_B);
-  }
-
-  // At this point, we know neither is a leaf so descend the largest
-  // tree first. Note that nodes are added in reverse order with the
-  // top bounding box at the end so the largest tree (the one with the
-  // the most boxes left to traverse) has the largest node number.
-  else if (node_A > node_B)
-  {
-    _compute_collisions(A, B, bbox_A.child_0, node_B,
-                        entities_A, entities_B, mesh_A, mesh_B);
-    _compute_collisions(A, B, bbox_A.child_1, node_B,
-                        entities_A, entities_B, mesh_A, mesh_B);
-  }
-  else
-  {
-    _compute_collisions(A, B, node_A, bbox_B.child_0,
-                        entities_A, entities_B, mesh_A, mesh_B);
-    _compute_collisions(A, B, node_A, bbox_B.child_1,
-                        entities_A, entities_B, mesh_A, mesh_B);
-  }
-
-  // Note that cases above can be collected in fewer cases but this
-  // way the logic is easier to follow.
-}
-//-----------------------------------------------------------------------------
-unsigned int
-GenericBoundingBoxTree::_compute_first_collision(const GenericBoundingBoxTree& tree,
-                                                 const Point& point,
-                                                 unsigned int node)
-{
-  // Get max integer to signify not found
-  unsigned int not_found = std::numeric_limits<unsigned int>::max();
-
-  // Get bounding box for current node
-  const BBox& bbox = tree.get_bbox(node);
-
-  // If point is not in bounding box, then don't search further
-  if (!tree.point_in_bbox(point.coordinates(), node))
-    return not_found;
-
-  // If box is a leaf (which we know contains the point), then return it
-  else if (tree.is_leaf(bbox, node))
-    return bbox.child_1; // child_1 denotes entity for leaves
-
-  // Check both children
-  else
-  {
-    unsigned int c0 = _compute_first_collision(tree, point, bbox.child_0);
-    if (c0 != not_found)
-      return c0;
-
-    // Check second child
-    unsigned int c1 = _compute_first_collision(tree, point, bbox.child_1);
-    if (c1 != not_found)
-      return c1;
-  }
-
-  // Point not found
-  return not_found;
-}
-//-----------------------------------------------------------------------------
-unsigned int
-GenericBoundingBoxTree::_compute_first_entity_collision(const GenericBoundingBoxTree& tree,
-                                                        const Point& point,
-                                                        unsigned int node,
-                                                        const Mesh& mesh)
-{
-  // Get max integer to signify not found
-  unsigned int not_found = std::numeric_limits<unsigned int>::max();
-
-  // Get bounding box for current node
-  const BBox& bbox = tree.get_bbox(node);
-
-  // If point is not in bounding box, then don't search further
-  if (!tree.point_in_bbox(point.coordinates(), node))
-    return not_found;
-
-  // If box is a leaf (which we know contains the point), then check entity
-  else if (tree.is_leaf(bbox, node))
-  {
-    // Get entity (child_1 denotes entity index for leaves)
-    dolfin_assert(tree._tdim == mesh.topology().dim());
-    const unsigned int entity_index = bbox.child_1;
-    Cell cell(mesh, entity_index);
-
-    // Check entity
-    if (cell.collides(point))
-      return entity_index;
-  }
-
-  // Check both children
-  else
-  {
-    const unsigned int c0 = _compute_first_entity_collision(tree,
-                                                            point,
-                                                            bbox.child_0,
-                                                            mesh);
-    if (c0 != not_found)
-      return c0;
-
-    const unsigned int c1 = _compute_first_entity_collision(tree,
-                                                            point,
-                                                            bbox.child_1,
-                                                            mesh);
-    if (c1 != not_found)
-      return c1;
-  }
-
-  // Point not found
-  return not_found;
-}
-//-----------------------------------------------------------------------------
-void
-GenericBoundingBoxTree::_compute_closest_entity(const GenericBoundingBoxTree& tree,
-                                                const Point& point,
-                                                unsigned int node,
-                                                const Mesh& mesh,
-                                                unsigned int& closest_entity,
-                                                double& R2)
-{
-  // Get bounding box for current node
-  const BBox& bbox = tree.get_bbox(node);
-
-  // If bounding box is outside radius, then don't search further
-  const double r2 = tree.compute_squared_distance_bbox(point.coordinates(), node);
-  if (r2 > R2)
-    return;
-
-  // If box is leaf (which we know is inside radius), then shrink radius
-  else if (tree.is_leaf(bbox, node))
-  {
-    // Get entity (child_1 denotes entity index for leaves)
-    dolfin_assert(tree._tdim == mesh.topology().dim());
-    const unsigned int entity_index = bbox.child_1;
-    Cell cell(mesh, entity_index);
-
-    // If entity is closer than best result so far, then return it
-    const double r2 = cell.squared_distance(point);
-    if (r2 < R2)
-    {
-      closest_entity = entity_index;
-      R2 = r2;
-    }
-  }
-
-  // Check both children
-  else
-  {
-    _compute_closest_entity(tree, point, bbox.child_0, mesh, closest_entity, R2);
-    _compute_closest_entity(tree, point, bbox.child_1, mesh, closest_entity, R2);
-  }
-}
-//-----------------------------------------------------------------------------
-void
-GenericBoundingBoxTree::_compute_closest_point(const GenericBoundingBoxTree& tree,
-                                               const Point& point,
-                                               unsigned int node,
-                                               unsigned int& closest_point,
-                                               double& R2)
-{
-  // Get bounding box for current node
-  const BBox& bbox = tree.get_bbox(node);
-
-  // If box is leaf, then compute distance and shrink radius
-  if (tree.is_leaf(bbox, node))
-  {
-    const double r2 = tree.compute_squared_distance_point(point.coordinates(),
-                                                          node);
-    if (r2 < R2)
-    {
-      closest_point = bbox.child_1;
-      R2 = r2;
-    }
-  }
-  else
-  {
-    // If bounding box is outside radius, then don't search further
-    const double r2 = tree.compute_squared_distance_bbox(point.coordinates(),
-                                                         node);
-    if (r2 > R2)
-      return;
-
-    // Check both children
-    _compute_closest_point(tree, point, bbox.child_0, closest_point, R2);
-    _compute_closest_point(tree, point, bbox.child_1, closest_point, R2);
+  case 1:
+    traverse_tree_collisions<1>(A.traversal_nodes(), B.traversal_nodes(),
+                                0, 0, 0, 0, entities_A, entities_B,
+                                mesh_A, mesh_B);
+    break;
+  case 2:
+    traverse_tree_collisions<2>(A.traversal_nodes(), B.traversal_nodes(),
+                                0, 0, 0, 0, entities_A, entities_B,
+                                mesh_A, mesh_B);
+    break;
+  default:
+    traverse_tree_collisions<3>(A.traversal_nodes(), B.traversal_nodes(),
+                                0, 0, 0, 0, entities_A, entities_B,
+                                mesh_A, mesh_B);
   }
 }
 //-----------------------------------------------------------------------------
@@ -772,27 +1126,28 @@ GenericBoundingBoxTree::sort_points(std::size_t axis,
 std::string GenericBoundingBoxTree::str(bool verbose)
 {
   std::stringstream s;
-  tree_print(s, _bboxes.size() - 1);
+  if (num_nodes() > 0)
+    tree_print(s, 0);
   return s.str();
 }
 //-----------------------------------------------------------------------------
 void GenericBoundingBoxTree::tree_print(std::stringstream& s, unsigned int i)
 {
-  std::size_t dim = _bbox_coordinates.size() / _bboxes.size();
-  std::size_t idx = i*dim;
+  const std::size_t _gdim = gdim();
+  const double* b = traversal_nodes() + node_size(_gdim)*i;
   s << "[";
-  for (unsigned int j = idx; j != idx + dim; ++j)
-    s << _bbox_coordinates[j] << " ";
+  for (std::size_t j = 0; j < 2*_gdim; ++j)
+    s << b[j] << " ";
   s << "]\n";
 
-  if (_bboxes[i].child_0 == i)
-    s << "leaf containing entity (" << _bboxes[i].child_1 << ")";
+  if (b[2*_gdim + 1] >= 0.0)
+    s << "leaf containing entity (" << (unsigned int) b[2*_gdim + 1] << ")";
   else
   {
     s << "{";
-    tree_print(s, _bboxes[i].child_0);
+    tree_print(s, i + 1);
     s << ", \n";
-    tree_print(s, _bboxes[i].child_1);
+    tree_print(s, b[node_size(_gdim) + 2*_gdim]);
     s << "}\n";
   }
 }
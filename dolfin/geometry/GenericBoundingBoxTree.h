@@ -21,6 +21,7 @@
 #ifndef __GENERIC_BOUNDING_BOX_TREE_H
 #define __GENERIC_BOUNDING_BOX_TREE_H
 
+#include <algorithm>
 #include <memory>
 #include <sstream>
 #include <set>
@@ -56,6 +57,11 @@ namespace dolfin
     /// Build bounding box tree for point cloud
     void build(const std::vector<Point>& points);
 
+    /// Update bounding boxes for moved mesh, keeping the structure
+    /// of the tree (the mesh must have the same entities as when the
+    /// tree was built)
+    void refit(const Mesh& mesh);
+
     /// Compute all collisions between bounding boxes and _Point_
     std::vector<unsigned int>
     compute_collisions(const Point& point) const;
@@ -85,6 +91,12 @@ namespace dolfin
     unsigned int compute_first_entity_collision(const Point& point,
                                               const Mesh& mesh) const;
 
+    /// Compute first collision between entities and each of the
+    /// _Point_s
+    std::vector<unsigned int>
+    compute_first_entity_collisions(const std::vector<Point>& points,
+                                    const Mesh& mesh) const;
+
     /// Compute closest entity and distance to _Point_
     std::pair<unsigned int, double> compute_closest_entity(const Point& point,
                                                            const Mesh& mesh) const;
@@ -97,9 +109,10 @@ namespace dolfin
 
   protected:
 
-    // Bounding box data. Leaf nodes are indicated by setting child_0
-    // equal to the node itself. For leaf nodes, child_1 is set to the
-    // index of the entity contained in the leaf bounding box.
+    // Bounding box data, used while building the tree. Leaf nodes are
+    // indicated by setting child_0 equal to the node itself. For leaf
+    // nodes, child_1 is set to the index of the entity contained in
+    // the leaf bounding box.
     struct BBox
     {
       unsigned int child_0;
@@ -109,12 +122,29 @@ namespace dolfin
     // Topological dimension of leaf entities
     std::size_t _tdim;
 
-    // List of bounding boxes (parent-child-entity relations)
+    // List of bounding boxes (parent-child-entity relations) and
+    // bounding box coordinates, stored in post-order with the root
+    // last while building the tree. These are cleared when the tree
+    // has been built (see build_traversal_nodes).
     std::vector<BBox> _bboxes;
-
-    // List of bounding box coordinates
     std::vector<double> _bbox_coordinates;
 
+    // Bounding boxes in depth-first order, which is the only storage
+    // of a built tree. Each node stores the bounding box coordinates,
+    // the position of the node following its subtree and the entity
+    // index (or -1 for internal nodes), padded to 4 (1D) or 8
+    // doubles, such that a node of a 2D or 3D tree fills one cache
+    // line. The first child of a node follows the node and the second
+    // child follows the subtree of the first child, so the tree is
+    // traversed with points without recursion or stack.
+    std::vector<double> _traversal_nodes;
+
+    // Position of first traversal node (aligned to 64 bytes)
+    std::size_t _traversal_offset;
+
+    // Number of nodes of built tree
+    unsigned int _num_nodes;
+
     // Point search tree used to accelerate distance queries
     mutable std::shared_ptr<GenericBoundingBoxTree> _point_search_tree;
 
@@ -124,14 +154,45 @@ namespace dolfin
     // Clear existing data if any
     void clear();
 
+    // Build global tree of processes from root bounding boxes
+    void build_global_tree(const Mesh& mesh);
+
+    // Build traversal nodes from bounding boxes and clear bounding
+    // boxes
+    void build_traversal_nodes();
+
     //--- Recursive build functions ---
 
-    // Build bounding box tree for entities (recursive)
+    // Range of leaves of a subtree and position of its first node
+    struct Subtree
+    {
+      std::vector<unsigned int>::iterator begin;
+      std::vector<unsigned int>::iterator end;
+      unsigned int first;
+    };
+
+    // Build bounding box tree for entities. The levels of the tree
+    // above the subtrees are built first, and the subtrees are then
+    // built in parallel (with the number of threads given by the
+    // global parameter "num_threads").
     unsigned int _build(const std::vector<double>& leaf_bboxes,
                         const std::vector<unsigned int>::iterator& begin,
                         const std::vector<unsigned int>::iterator& end,
                         std::size_t gdim);
 
+    // Build bounding box tree for entities (recursive). Nodes are
+    // stored in post-order from position first, so the position of
+    // each node is given by the number of leaves of the subtrees.
+    // Below the given depth, the subtrees are added to the list of
+    // subtrees to be built instead (if the list is given).
+    void _build(const std::vector<double>& leaf_bboxes,
+                const std::vector<unsigned int>::iterator& begin,
+                const std::vector<unsigned int>::iterator& end,
+                std::size_t gdim,
+                unsigned int first,
+                std::size_t depth,
+                std::vector<Subtree>* subtrees);
+
     // Build bounding box tree for points (recursive)
     unsigned int _build(const std::vector<Point>& points,
                         const std::vector<unsigned int>::iterator& begin,
@@ -143,54 +204,15 @@ namespace dolfin
     // Note that these functions are made static for consistency as
     // some of them need to deal with more than tree.
 
-    /// Compute collisions with point (recursive)
-    static void
-    _compute_collisions(const GenericBoundingBoxTree& tree,
-                        const Point& point,
-                        unsigned int node,
-                        std::vector<unsigned int>& entities,
-                        const Mesh* mesh);
-
-    /// Compute collisions with tree (recursive)
+    /// Compute collisions with tree
     static void
     _compute_collisions(const GenericBoundingBoxTree& A,
                         const GenericBoundingBoxTree& B,
-                        unsigned int node_A,
-                        unsigned int node_B,
                         std::vector<unsigned int>& entities_A,
                         std::vector<unsigned int>& entities_B,
                         const Mesh* mesh_A,
                         const Mesh* mesh_B);
 
-    /// Compute first collision (recursive)
-    static unsigned int
-    _compute_first_collision(const GenericBoundingBoxTree& tree,
-                             const Point& point,
-                             unsigned int node);
-
-    /// Compute first entity collision (recursive)
-    static unsigned int
-    _compute_first_entity_collision(const GenericBoundingBoxTree& tree,
-                                    const Point& point,
-                                    unsigned int node,
-                                    const Mesh& mesh);
-
-    /// Compute closest entity (recursive)
-    static void _compute_closest_entity(const GenericBoundingBoxTree& tree,
-                                        const Point& point,
-                                        unsigned int node,
-                                        const Mesh& mesh,
-                                        unsigned int& closest_entity,
-                                        double& R2);
-
-    /// Compute closest point (recursive)
-    static void
-    _compute_closest_point(const GenericBoundingBoxTree& tree,
-                           const Point& point,
-                           unsigned int node,
-                           unsigned int& closest_point,
-                           double& R2);
-
     //--- Utility functions ---
 
     // Compute point search tree if not already done
@@ -223,13 +245,29 @@ namespace dolfin
       return _bboxes.size() - 1;
     }
 
-    // Return bounding box for given node
-    inline const BBox& get_bbox(unsigned int node) const
+    // Set bounding box and coordinates of node
+    inline void set_bbox(unsigned int node,
+                         const BBox& bbox,
+                         const double* b,
+                         std::size_t gdim)
+    {
+      _bboxes[node] = bbox;
+      std::copy(b, b + 2*gdim, _bbox_coordinates.begin() + 2*gdim*node);
+    }
+
+    // Return traversal nodes
+    inline const double* traversal_nodes() const
+    {
+      return _traversal_nodes.data() + _traversal_offset;
+    }
+
+    // Return number of nodes of built tree
+    inline unsigned int num_nodes() const
     {
-      return _bboxes[node];
+      return _num_nodes;
     }
 
-    // Return number of bounding boxes
+    // Return number of bounding boxes (while building the tree)
     inline unsigned int num_bboxes() const
     {
       return _bboxes.size();
@@ -308,25 +346,6 @@ namespace dolfin
     // Return geometric dimension
     virtual std::size_t gdim() const = 0;
 
-    // Return bounding box coordinates for node
-    virtual const double* get_bbox_coordinates(unsigned int node) const = 0;
-
-    // Check whether point (x) is in bounding box (node)
-    virtual bool
-    point_in_bbox(const double* x, unsigned int node) const = 0;
-
-    // Check whether bounding box (a) collides with bounding box (node)
-    virtual bool
-    bbox_in_bbox(const double* a, unsigned int node) const = 0;
-
-    // Compute squared distance between point and bounding box
-    virtual double
-    compute_squared_distance_bbox(const double* x, unsigned int node) const = 0;
-
-    // Compute squared distance between point and point
-    virtual double
-    compute_squared_distance_point(const double* x, unsigned int node) const = 0;
-
     // Compute bounding box of bounding boxes
     virtual void
     compute_bbox_of_bboxes(double* bbox,
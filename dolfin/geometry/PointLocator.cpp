@@ -0,0 +1,254 @@
+// Copyright (C) 2016 The FEniCS Project
+//
+// This file is part of DOLFIN.
+//
+// DOLFIN is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// DOLFIN is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with DOLFIN. If not, see <http://www.gnu.org/licenses/>.
+//
+// First added:  2016-10-18
+// Last changed: 2016-10-18
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <dolfin/common/MPI.h>
+#include <dolfin/common/Timer.h>
+#include <dolfin/log/log.h>
+#include <dolfin/mesh/Cell.h>
+#include <dolfin/mesh/Mesh.h>
+#include "BoundingBoxTree.h"
+#include "PointLocator.h"
+
+using namespace dolfin;
+
+//-----------------------------------------------------------------------------
+void PointLocator::locate(std::vector<int>& processes,
+                          std::vector<std::size_t>& cells,
+                          std::vector<double>& X,
+                          const Mesh& mesh,
+                          const std::vector<double>& x)
+{
+  const std::size_t gdim = mesh.geometry().dim();
+  const std::size_t tdim = mesh.topology().dim();
+  const std::size_t num_points = x.size()/gdim;
+
+  if (x.size() % gdim != 0)
+  {
+    dolfin_error("PointLocator.cpp",
+                 "locate points",
+                 "Number of coordinates (%d) is not a multiple of the geometric dimension (%d)",
+                 x.size(), gdim);
+  }
+
+  const CellType::Type cell_type = mesh.type().cell_type();
+  if (cell_type != CellType::interval && cell_type != CellType::triangle
+      && cell_type != CellType::tetrahedron)
+  {
+    dolfin_error("PointLocator.cpp",
+                 "locate points",
+                 "Reference coordinates are only implemented for simplex cells");
+  }
+
+  Timer timer("Locate points");
+
+  // Build bounding box tree (collective) and get global tree of
+  // process bounding boxes
+  std::shared_ptr<BoundingBoxTree> tree = mesh.bounding_box_tree();
+
+  // Send each point to the processes whose bounding box contains it
+  const MPI_Comm mpi_comm = mesh.mpi_comm();
+  const std::size_t num_processes = MPI::size(mpi_comm);
+  std::vector<std::vector<double>> send_x(num_processes);
+  std::vector<std::vector<std::size_t>> sent_points(num_processes);
+  for (std::size_t i = 0; i < num_points; ++i)
+  {
+    const Point point(gdim, x.data() + i*gdim);
+    const std::vector<unsigned int> candidates
+      = tree->compute_process_collisions(point);
+    for (std::size_t j = 0; j < candidates.size(); ++j)
+    {
+      const std::size_t p = candidates[j];
+      send_x[p].insert(send_x[p].end(), x.begin() + i*gdim,
+                       x.begin() + (i + 1)*gdim);
+      sent_points[p].push_back(i);
+    }
+  }
+  std::vector<std::vector<double>> recv_x;
+  MPI::all_to_all(mpi_comm, send_x, recv_x);
+
+  // Locate received points and return cell index and reference
+  // coordinates of each point (cell index -1 if not found)
+  const unsigned int not_found = std::numeric_limits<unsigned int>::max();
+  std::vector<std::vector<double>> send_cells(num_processes);
+  for (std::size_t p = 0; p < num_processes; ++p)
+  {
+    const std::size_t num_received = recv_x[p].size()/gdim;
+    const std::vector<unsigned int> local_cells
+      = locate_local(mesh, recv_x[p]);
+    send_cells[p].resize(num_received*(tdim + 1), 0.0);
+    for (std::size_t i = 0; i < num_received; ++i)
+    {
+      double* data = send_cells[p].data() + i*(tdim + 1);
+      if (local_cells[i] == not_found)
+      {
+        data[0] = -1.0;
+        continue;
+      }
+
+      data[0] = local_cells[i];
+      const Cell cell(mesh, local_cells[i]);
+      const Point point(gdim, recv_x[p].data() + i*gdim);
+      compute_reference_coordinates(data + 1, cell, point);
+    }
+  }
+  std::vector<std::vector<double>> recv_cells;
+  MPI::all_to_all(mpi_comm, send_cells, recv_cells);
+
+  // Take cell from the lowest numbered process that found each point
+  processes.assign(num_points, -1);
+  cells.assign(num_points, 0);
+  X.assign(num_points*tdim, 0.0);
+  for (std::size_t p = 0; p < num_processes; ++p)
+  {
+    const std::vector<double>& data = recv_cells[p];
+    dolfin_assert(data.size() == sent_points[p].size()*(tdim + 1));
+    for (std::size_t j = 0; j < sent_points[p].size(); ++j)
+    {
+      const std::size_t i = sent_points[p][j];
+      const double* d = data.data() + j*(tdim + 1);
+      if (processes[i] != -1 || d[0] < 0.0)
+        continue;
+
+      processes[i] = p;
+      cells[i] = d[0];
+      std::copy(d + 1, d + 1 + tdim, X.begin() + i*tdim);
+    }
+  }
+}
+//-----------------------------------------------------------------------------
+std::vector<unsigned int>
+PointLocator::locate_local(const Mesh& mesh, const std::vector<double>& x)
+{
+  const std::size_t gdim = mesh.geometry().dim();
+  const std::size_t tdim = mesh.topology().dim();
+  const std::size_t num_points = x.size()/gdim;
+  const unsigned int num_regular = mesh.topology().ghost_offset(tdim);
+
+  std::vector<Point> points(num_points);
+  for (std::size_t i = 0; i < num_points; ++i)
+    points[i] = Point(gdim, x.data() + i*gdim);
+
+  // Locate points with groups of points traversing the tree
+  std::shared_ptr<BoundingBoxTree> tree = mesh.bounding_box_tree();
+  std::vector<unsigned int> cells
+    = tree->compute_first_entity_collisions(points);
+
+  // Replace ghost cells by a cell owned by this process, if any
+  const unsigned int not_found = std::numeric_limits<unsigned int>::max();
+  for (std::size_t i = 0; i < num_points; ++i)
+  {
+    if (cells[i] == not_found || cells[i] < num_regular)
+      continue;
+
+    const std::vector<unsigned int> candidates
+      = tree->compute_entity_collisions(points[i]);
+    cells[i] = not_found;
+    for (std::size_t j = 0; j < candidates.size(); ++j)
+    {
+      if (candidates[j] < num_regular)
+      {
+        cells[i] = candidates[j];
+        break;
+      }
+    }
+  }
+
+  return cells;
+}
+//-----------------------------------------------------------------------------
+void PointLocator::compute_reference_coordinates(double* X,
+                                                 const Cell& cell,
+                                                 const Point& point)
+{
+  const MeshGeometry& geometry = cell.mesh().geometry();
+  const std::size_t gdim = geometry.dim();
+  const std::size_t tdim = cell.dim();
+  const unsigned int* vertices = cell.entities(0);
+  dolfin_assert(tdim <= 3);
+  dolfin_assert(cell.num_entities(0) == tdim + 1);
+
+  // Compute Jacobian (gdim x tdim) of affine map from reference cell
+  const double* x0 = geometry.x(vertices[0]);
+  double J[9];
+  for (std::size_t j = 0; j < tdim; ++j)
+  {
+    const double* xj = geometry.x(vertices[j + 1]);
+    for (std::size_t k = 0; k < gdim; ++k)
+      J[k*tdim + j] = xj[k] - x0[k];
+  }
+
+  // Solve normal equations J^T J X = J^T (x - x0)
+  double A[9];
+  double b[3];
+  const double* x = point.coordinates();
+  for (std::size_t i = 0; i < tdim; ++i)
+  {
+    b[i] = 0.0;
+    for (std::size_t k = 0; k < gdim; ++k)
+      b[i] += J[k*tdim + i]*(x[k] - x0[k]);
+    for (std::size_t j = 0; j < tdim; ++j)
+    {
+      A[i*tdim + j] = 0.0;
+      for (std::size_t k = 0; k < gdim; ++k)
+        A[i*tdim + j] += J[k*tdim + i]*J[k*tdim + j];
+    }
+  }
+
+  // Gaussian elimination with partial pivoting
+  for (std::size_t i = 0; i < tdim; ++i)
+  {
+    std::size_t pivot = i;
+    for (std::size_t r = i + 1; r < tdim; ++r)
+    {
+      if (std::abs(A[r*tdim + i]) > std::abs(A[pivot*tdim + i]))
+        pivot = r;
+    }
+    if (A[pivot*tdim + i] == 0.0)
+    {
+      dolfin_error("PointLocator.cpp",
+                   "compute reference coordinates",
+                   "Cell %d is degenerate", cell.index());
+    }
+    if (pivot != i)
+    {
+      for (std::size_t j = 0; j < tdim; ++j)
+        std::swap(A[i*tdim + j], A[pivot*tdim + j]);
+      std::swap(b[i], b[pivot]);
+    }
+    for (std::size_t r = i + 1; r < tdim; ++r)
+    {
+      const double f = A[r*tdim + i]/A[i*tdim + i];
+      for (std::size_t j = i; j < tdim; ++j)
+        A[r*tdim + j] -= f*A[i*tdim + j];
+      b[r] -= f*b[i];
+    }
+  }
+  for (std::size_t i = tdim; i-- > 0; )
+  {
+    double s = b[i];
+    for (std::size_t j = i + 1; j < tdim; ++j)
+      s -= A[i*tdim + j]*X[j];
+    X[i] = s/A[i*tdim + i];
+  }
+}
+//-----------------------------------------------------------------------------
@@ -0,0 +1,112 @@
+// Copyright (C) 2016 The FEniCS Project
+//
+// This file is part of DOLFIN.
+//
+// DOLFIN is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// DOLFIN is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with DOLFIN. If not, see <http://www.gnu.org/licenses/>.
+//
+// First added:  2016-10-18
+// Last changed: 2016-10-18
+
+#ifndef __POINT_LOCATOR_H
+#define __POINT_LOCATOR_H
+
+#include <vector>
+#include "Point.h"
+
+namespace dolfin
+{
+
+  // Forward declarations
+  class Cell;
+  class Mesh;
+
+  /// This class locates points in a distributed mesh. Each process
+  /// gives a list of points, which are sent to the processes whose
+  /// bounding box contains them (found with the global tree of
+  /// process bounding boxes of the bounding box tree of the mesh)
+  /// in one all-to-all exchange, located there with the local
+  /// bounding box tree and returned in a second exchange. This is
+  /// the basis for evaluating functions and transferring data
+  /// between non-matching distributed meshes.
+
+  class PointLocator
+  {
+  public:
+
+    /// Locate points in mesh (collective). For each point, the
+    /// process owning the cell containing the point, the local
+    /// index of the cell on that process and the reference
+    /// coordinates of the point in the cell are returned. If the
+    /// point is found on several processes (on the boundary between
+    /// cells of different processes), the lowest numbered process
+    /// is returned. Only cells owned by a process (not ghost cells)
+    /// are returned.
+    ///
+    /// *Arguments*
+    ///     processes (std::vector<int>)
+    ///         The process owning the cell containing each point,
+    ///         or -1 if the point is not found.
+    ///     cells (std::vector<std::size_t>)
+    ///         The local index of the cell on the owning process.
+    ///     X (std::vector<double>)
+    ///         The reference coordinates of each point in the cell,
+    ///         topological dimension values for each point.
+    ///     mesh (_Mesh_)
+    ///         The mesh (simplex cells).
+    ///     x (std::vector<double>)
+    ///         The coordinates, geometric dimension values for each
+    ///         point.
+    static void locate(std::vector<int>& processes,
+                       std::vector<std::size_t>& cells,
+                       std::vector<double>& X,
+                       const Mesh& mesh,
+                       const std::vector<double>& x);
+
+    /// Locate points in the cells owned by this process. Not found
+    /// points are marked by std::numeric_limits<unsigned int>::max().
+    ///
+    /// *Arguments*
+    ///     mesh (_Mesh_)
+    ///         The mesh.
+    ///     x (std::vector<double>)
+    ///         The coordinates, geometric dimension values for each
+    ///         point.
+    ///
+    /// *Returns*
+    ///     std::vector<unsigned int>
+    ///         The local index of the cell containing each point.
+    static std::vector<unsigned int>
+    locate_local(const Mesh& mesh, const std::vector<double>& x);
+
+    /// Compute reference coordinates of point in simplex cell. For
+    /// cells of lower topological than geometric dimension, the
+    /// point is projected onto the cell.
+    ///
+    /// *Arguments*
+    ///     X (double*)
+    ///         The reference coordinates (topological dimension
+    ///         values).
+    ///     cell (_Cell_)
+    ///         The cell.
+    ///     point (_Point_)
+    ///         The point.
+    static void compute_reference_coordinates(double* X,
+                                              const Cell& cell,
+                                              const Point& point);
+
+  };
+
+}
+
+#endif
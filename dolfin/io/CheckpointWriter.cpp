@@ -0,0 +1,244 @@
+// Copyright (C) 2016 The FEniCS Project
+//
+// This file is part of DOLFIN.
+//
+// DOLFIN is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// DOLFIN is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with DOLFIN. If not, see <http://www.gnu.org/licenses/>.
+//
+// First added:  2016-10-18
+// Last changed: 2016-10-18
+
+#ifdef HAS_HDF5
+
+#include <utility>
+#include <dolfin/function/Function.h>
+#include <dolfin/la/GenericVector.h>
+#include <dolfin/log/log.h>
+#include "CheckpointWriter.h"
+
+using namespace dolfin;
+
+//-----------------------------------------------------------------------------
+struct CheckpointWriter::Snapshot
+{
+  // Series name and timestamp
+  std::string name;
+  double timestamp;
+
+  // Local values, local range and global size of vector
+  std::vector<double> values;
+  std::pair<std::size_t, std::size_t> local_range;
+  std::size_t global_size;
+
+  // Dofs of Function (tabulated for the first write of a series)
+  HDF5File::FunctionDofs dofs;
+};
+//-----------------------------------------------------------------------------
+CheckpointWriter::CheckpointWriter(MPI_Comm comm, const std::string filename,
+                                   const std::string file_mode)
+  : _filename(filename), _file_mode(file_mode), _mpi_comm(comm),
+    _asynchronous(false), _stop(false)
+{
+  parameters = default_parameters();
+
+  if (file_mode != "w" && file_mode != "a")
+  {
+    dolfin_error("CheckpointWriter.cpp",
+                 "create checkpoint writer",
+                 "Unknown file mode \"%s\"", file_mode.c_str());
+  }
+
+  // Duplicate communicator such that collective operations of the
+  // background thread do not interfere with those of the caller
+  #ifdef HAS_MPI
+  MPI_Comm_dup(comm, &_mpi_comm);
+  #endif
+}
+//-----------------------------------------------------------------------------
+CheckpointWriter::~CheckpointWriter()
+{
+  // Let background thread write pending data and stop
+  if (_thread)
+  {
+    {
+      boost::unique_lock<boost::mutex> lock(_mutex);
+      _stop = true;
+    }
+    _condition.notify_all();
+    _thread->join();
+  }
+
+  // Close file before freeing its communicator
+  _file.reset();
+
+  #ifdef HAS_MPI
+  MPI_Comm_free(&_mpi_comm);
+  #endif
+}
+//-----------------------------------------------------------------------------
+void CheckpointWriter::write(const Function& u, const std::string name,
+                             double timestamp)
+{
+  check_error();
+  if (!_file)
+    init();
+
+  // Get a free buffer, waiting for the oldest pending write if the
+  // limit is reached
+  const std::size_t max_pending = (int) parameters["max_pending"];
+  std::unique_ptr<Snapshot> snapshot;
+  {
+    boost::unique_lock<boost::mutex> lock(_mutex);
+    while (_pending.size() >= max_pending)
+      _condition.wait(lock);
+    if (!_free.empty())
+    {
+      snapshot = std::move(_free.back());
+      _free.pop_back();
+    }
+  }
+  if (!snapshot)
+    snapshot.reset(new Snapshot);
+
+  // Copy data (the dofs are only needed when a series is created)
+  dolfin_assert(u.vector());
+  const GenericVector& x = *u.vector();
+  snapshot->name = name;
+  snapshot->timestamp = timestamp;
+  x.get_local(snapshot->values);
+  snapshot->local_range = x.local_range();
+  snapshot->global_size = x.size();
+  if (_series.insert(name).second)
+    HDF5File::tabulate_function_dofs(u, snapshot->dofs);
+  else
+    snapshot->dofs = HDF5File::FunctionDofs();
+
+  if (!_asynchronous)
+  {
+    write_snapshot(*snapshot);
+    _free.push_back(std::move(snapshot));
+    return;
+  }
+
+  // Hand over to background thread
+  {
+    boost::unique_lock<boost::mutex> lock(_mutex);
+    _pending.push_back(std::move(snapshot));
+  }
+  _condition.notify_all();
+}
+//-----------------------------------------------------------------------------
+void CheckpointWriter::flush()
+{
+  {
+    boost::unique_lock<boost::mutex> lock(_mutex);
+    while (!_pending.empty())
+      _condition.wait(lock);
+  }
+  check_error();
+
+  if (_file)
+    _file->flush();
+}
+//-----------------------------------------------------------------------------
+std::size_t CheckpointWriter::num_pending() const
+{
+  boost::unique_lock<boost::mutex> lock(_mutex);
+  return _pending.size();
+}
+//-----------------------------------------------------------------------------
+void CheckpointWriter::init()
+{
+  // Open file (collective)
+  const Parameters& p = parameters("hdf5_file");
+  _file.reset(new HDF5File(_mpi_comm, _filename, _file_mode, p));
+
+  // Writing in the background requires MPI calls from two threads
+  _asynchronous = parameters["asynchronous"];
+  #ifdef HAS_MPI
+  int provided;
+  MPI_Query_thread(&provided);
+  if (_asynchronous && provided < MPI_THREAD_MULTIPLE)
+  {
+    warning("MPI does not support MPI_THREAD_MULTIPLE, checkpoints are written synchronously");
+    _asynchronous = false;
+  }
+  #endif
+
+  if (_asynchronous)
+    _thread.reset(new boost::thread(&CheckpointWriter::run, this));
+}
+//-----------------------------------------------------------------------------
+void CheckpointWriter::run()
+{
+  while (true)
+  {
+    // Wait for data
+    Snapshot* snapshot = NULL;
+    bool failed = false;
+    {
+      boost::unique_lock<boost::mutex> lock(_mutex);
+      while (_pending.empty() && !_stop)
+        _condition.wait(lock);
+      if (_pending.empty())
+        return;
+      snapshot = _pending.front().get();
+      failed = static_cast<bool>(_error);
+    }
+
+    // Write data, keeping the first error (later writes are skipped
+    // since the file may be inconsistent)
+    if (!failed)
+    {
+      try
+      {
+        write_snapshot(*snapshot);
+      }
+      catch (...)
+      {
+        boost::unique_lock<boost::mutex> lock(_mutex);
+        _error = std::current_exception();
+      }
+    }
+
+    // Release buffer
+    {
+      boost::unique_lock<boost::mutex> lock(_mutex);
+      _free.push_back(std::move(_pending.front()));
+      _pending.pop_front();
+    }
+    _condition.notify_all();
+  }
+}
+//-----------------------------------------------------------------------------
+void CheckpointWriter::write_snapshot(const Snapshot& snapshot)
+{
+  dolfin_assert(_file);
+  _file->write_function_series(snapshot.dofs, snapshot.values,
+                               snapshot.local_range, snapshot.global_size,
+                               snapshot.name, snapshot.timestamp);
+}
+//-----------------------------------------------------------------------------
+void CheckpointWriter::check_error()
+{
+  std::exception_ptr error;
+  {
+    boost::unique_lock<boost::mutex> lock(_mutex);
+    error = _error;
+  }
+  if (error)
+    std::rethrow_exception(error);
+}
+//-----------------------------------------------------------------------------
+
+#endif
@@ -0,0 +1,155 @@
+// Copyright (C) 2016 The FEniCS Project
+//
+// This file is part of DOLFIN.
+//
+// DOLFIN is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// DOLFIN is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with DOLFIN. If not, see <http://www.gnu.org/licenses/>.
+//
+// First added:  2016-10-18
+// Last changed: 2016-10-18
+
+#ifndef __DOLFIN_CHECKPOINT_WRITER_H
+#define __DOLFIN_CHECKPOINT_WRITER_H
+
+#ifdef HAS_HDF5
+
+#include <deque>
+#include <exception>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+#include <boost/thread.hpp>
+#include <dolfin/common/MPI.h>
+#include <dolfin/common/Variable.h>
+#include <dolfin/parameter/Parameters.h>
+#include "HDF5File.h"
+
+namespace dolfin
+{
+
+  class Function;
+
+  /// This class writes time series of Functions to a HDF5 file
+  /// asynchronously. A call to write() copies the local values of
+  /// the Function vector, and for the first write of a series the
+  /// dofs of the Function, to a staging buffer and returns, while a
+  /// background thread writes the buffered data to file. The solver
+  /// can thus compute the next time step while the previous one is
+  /// written.
+  ///
+  /// The number of buffered writes is bounded by the parameter
+  /// "max_pending" (two by default, i.e. double buffering). When the
+  /// limit is reached, write() waits until the oldest buffer has been
+  /// written. Buffers are reused, so memory is not reallocated for
+  /// each write.
+  ///
+  /// The file has the layout of HDF5File::write(u, name, timestamp)
+  /// and can be read with HDF5File. All processes must call write()
+  /// in the same order. The background thread communicates on a
+  /// duplicate of the communicator, which requires MPI to be
+  /// initialised with MPI_THREAD_MULTIPLE (as done by DOLFIN);
+  /// otherwise, or if the parameter "asynchronous" is false, data is
+  /// written in write(). Unless HDF5 is built thread-safe, other HDF5
+  /// files must not be accessed while writes are pending, see
+  /// flush().
+
+  class CheckpointWriter : public Variable
+  {
+  public:
+
+    /// Create writer for file, with file_mode "w" (write) or "a"
+    /// (append). The file is opened at the first write, with the
+    /// parameters of the nested parameter set "hdf5_file".
+    CheckpointWriter(MPI_Comm comm, const std::string filename,
+                     const std::string file_mode="w");
+
+    /// Destructor (waits for pending writes)
+    ~CheckpointWriter();
+
+    /// Stage values of Function for writing to series name with
+    /// timestamp and return without waiting for the data to be
+    /// written
+    void write(const Function& u, const std::string name, double timestamp);
+
+    /// Wait until all staged data has been written and flush file.
+    /// Errors raised while writing in the background are reported
+    /// here (or by the next call to write()).
+    void flush();
+
+    /// Return number of staged writes not yet written to file
+    std::size_t num_pending() const;
+
+    /// Default parameter values
+    static Parameters default_parameters()
+    {
+      Parameters p("checkpoint_writer");
+      p.add("asynchronous", true);
+      p.add("max_pending", 2, 1, 1024);
+      p.add(HDF5File::default_parameters());
+      return p;
+    }
+
+  private:
+
+    // Staged data of one write
+    struct Snapshot;
+
+    // Open file and start background thread
+    void init();
+
+    // Loop of background thread, writing staged data in order
+    void run();
+
+    // Write staged data to file
+    void write_snapshot(const Snapshot& snapshot);
+
+    // Rethrow first error raised in background thread
+    void check_error();
+
+    // File name and mode
+    const std::string _filename;
+    const std::string _file_mode;
+
+    // Communicator used for writing
+    MPI_Comm _mpi_comm;
+
+    // HDF5 file (accessed by the background thread while writes are
+    // pending)
+    std::unique_ptr<HDF5File> _file;
+
+    // Names of series staged with dofs
+    std::set<std::string> _series;
+
+    // Staged writes (in order) and reusable buffers
+    std::deque<std::unique_ptr<Snapshot>> _pending;
+    std::vector<std::unique_ptr<Snapshot>> _free;
+
+    // True if the background thread is used
+    bool _asynchronous;
+
+    // Background thread and synchronisation
+    std::unique_ptr<boost::thread> _thread;
+    mutable boost::mutex _mutex;
+    boost::condition_variable _condition;
+    bool _stop;
+
+    // First error raised in background thread
+    std::exception_ptr _error;
+
+  };
+
+}
+
+#endif
+#endif
@@ -25,16 +25,14 @@
 
 #ifdef HAS_ZLIB
 #include <zlib.h>
-extern "C"
-{
-  int compress(Bytef *dest, uLongf *destLen, const Bytef *source, uLong sourceLen);
-}
 #endif
 
+#include <algorithm>
+#include <ostream>
 #include <sstream>
 #include <vector>
 #include <utility>
-#include <boost/shared_array.hpp>
+#include <dolfin/log/log.h>
 #include "base64.h"
 
 namespace dolfin
@@ -65,30 +63,183 @@ namespace dolfin
                                     data.size()*sizeof(T));
     }
 
+    /// Base64 encoder writing to a stream as data is added. Complete
+    /// groups of three bytes are encoded as they arrive and at most
+    /// two bytes are kept between calls, so the output is identical
+    /// to encoding all data at once. Large blocks of data are encoded
+    /// by num_threads threads.
+    class Base64Stream
+    {
+    public:
+
+      /// Create encoder writing to stream
+      explicit Base64Stream(std::ostream& stream, int num_threads=1)
+        : _stream(stream), _num_pending(0),
+          _num_threads(std::max(num_threads, 1)) {}
+
+      /// Encode data
+      void write(const unsigned char* data, std::size_t length)
+      {
+        // Complete pending group
+        while (_num_pending > 0 && _num_pending < 3 && length > 0)
+        {
+          _pending[_num_pending++] = *data++;
+          --length;
+        }
+        if (_num_pending == 3)
+        {
+          encode(_pending, 3);
+          _num_pending = 0;
+        }
+
+        // Encode complete groups in blocks of bounded size
+        const std::size_t block_size = 3*65536*_num_threads;
+        const std::size_t num_complete = length - length % 3;
+        for (std::size_t i = 0; i < num_complete; i += block_size)
+          encode(data + i, std::min(block_size, num_complete - i));
+
+        // Keep remaining bytes
+        for (std::size_t i = num_complete; i < length; ++i)
+          _pending[_num_pending++] = data[i];
+      }
+
+      /// Encode remaining bytes (with padding)
+      void finish()
+      {
+        if (_num_pending > 0)
+          encode(_pending, _num_pending);
+        _num_pending = 0;
+      }
+
+    private:
+
+      // Encode data to buffer and write buffer to stream. The data is
+      // split into parts of complete groups, one per thread.
+      void encode(const unsigned char* data, std::size_t length)
+      {
+        _buffer.resize(4*((length + 2)/3));
+        const std::size_t num_groups = (length + 2)/3;
+        const int num_parts
+          = std::min((std::size_t) _num_threads, 1 + num_groups/16384);
+        const std::size_t groups_per_part = (num_groups + num_parts - 1)/num_parts;
+        #pragma omp parallel for num_threads(num_parts)
+        for (int p = 0; p < num_parts; ++p)
+        {
+          const std::size_t first = std::min(p*groups_per_part, num_groups);
+          const std::size_t last = std::min(first + groups_per_part, num_groups);
+          const std::size_t end = std::min(3*last, length);
+          if (first < last)
+            base64_encode(data + 3*first, end - 3*first, &_buffer[4*first]);
+        }
+        _stream.write(_buffer.data(), _buffer.size());
+      }
+
+      std::ostream& _stream;
+      unsigned char _pending[3];
+      std::size_t _num_pending;
+      const int _num_threads;
+      std::vector<char> _buffer;
+
+    };
+
     #ifdef HAS_ZLIB
-    template<typename T>
-    static std::pair<boost::shared_array<unsigned char>, std::size_t> compress_data(const std::vector<T>& data)
+    /// Zlib compressor for the multi-block format of VTK. Data is
+    /// split into blocks of block_size bytes (the last block may be
+    /// smaller), which are compressed independently by num_threads
+    /// threads, a batch of blocks at a time. The compressed blocks
+    /// are passed to a Base64Stream in order, and their sizes are
+    /// kept for the header of the data array.
+    class ZlibBlockStream
     {
-      // Compute length of uncompressed data
-      const unsigned long uncompressed_size = data.size()*sizeof(T);
+    public:
+
+      /// Create compressor writing to encoder
+      ZlibBlockStream(Base64Stream& stream, std::size_t block_size,
+                      int num_threads=1)
+        : _stream(stream), _block_size(block_size),
+          _num_threads(std::max(num_threads, 1)),
+          _num_batch_blocks(std::max<std::size_t>(4*_num_threads,
+                                                  1048576/block_size + 1))
+      {
+        _batch.reserve(_num_batch_blocks*_block_size);
+      }
 
-      // Compute maximum length of compressed data
-      unsigned long compressed_size = (uncompressed_size + (((uncompressed_size)/1000)+1)+12);;
+      /// Compress data
+      void write(const unsigned char* data, std::size_t length)
+      {
+        while (length > 0)
+        {
+          const std::size_t n = std::min(length,
+                                         _batch.capacity() - _batch.size());
+          _batch.insert(_batch.end(), data, data + n);
+          data += n;
+          length -= n;
+          if (_batch.size() == _batch.capacity())
+            compress_batch();
+        }
+      }
+
+      /// Compress remaining data
+      void finish()
+      { compress_batch(); }
 
-      // Allocate space for compressed data
-      boost::shared_array<unsigned char> compressed_data(new unsigned char[compressed_size]);
+      /// Return compressed size of each block
+      const std::vector<std::size_t>& compressed_sizes() const
+      { return _compressed_sizes; }
 
-      // Compress data
-      if (compress((Bytef*) compressed_data.get(), &compressed_size, (const Bytef*) &data[0], uncompressed_size) != Z_OK)
+    private:
+
+      // Compress blocks of batch in parallel and write them in order
+      void compress_batch()
       {
-        dolfin_error("Encoder.h",
-                     "compress data when writing file",
-                     "Zlib error while compressing data");
+        const std::size_t num_blocks
+          = (_batch.size() + _block_size - 1)/_block_size;
+        const std::size_t max_compressed_size = compressBound(_block_size);
+        _compressed.resize(num_blocks*max_compressed_size);
+        std::vector<std::size_t> sizes(num_blocks);
+        int error = Z_OK;
+
+        #pragma omp parallel for schedule(dynamic) num_threads(_num_threads)
+        for (std::size_t b = 0; b < num_blocks; ++b)
+        {
+          const std::size_t first = b*_block_size;
+          const std::size_t n = std::min(_block_size, _batch.size() - first);
+          uLongf size = max_compressed_size;
+          const int status = compress2(&_compressed[b*max_compressed_size],
+                                       &size, &_batch[first], n,
+                                       Z_DEFAULT_COMPRESSION);
+          sizes[b] = size;
+          if (status != Z_OK)
+          {
+            #pragma omp critical
+            error = status;
+          }
+        }
+
+        if (error != Z_OK)
+        {
+          dolfin_error("Encoder.h",
+                       "compress data when writing file",
+                       "Zlib error while compressing data (%d)", error);
+        }
+
+        for (std::size_t b = 0; b < num_blocks; ++b)
+        {
+          _stream.write(&_compressed[b*max_compressed_size], sizes[b]);
+          _compressed_sizes.push_back(sizes[b]);
+        }
+        _batch.clear();
       }
 
-      // Make pair and return
-      return std::make_pair(compressed_data, compressed_size);
-    }
+      Base64Stream& _stream;
+      const std::size_t _block_size;
+      const int _num_threads;
+      const std::size_t _num_batch_blocks;
+      std::vector<unsigned char> _batch;
+      std::vector<unsigned char> _compressed;
+      std::vector<std::size_t> _compressed_sizes;
+
+    };
     #endif
 
   }
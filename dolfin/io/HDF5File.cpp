@@ -24,6 +24,7 @@
 #include <iomanip>
 #include <iostream>
 #include <string>
+#include <boost/container/flat_map.hpp>
 #include <boost/unordered_map.hpp>
 #include <boost/filesystem.hpp>
 #include <boost/multi_array.hpp>
@@ -58,9 +59,26 @@ HDF5File::HDF5File(MPI_Comm comm, const std::string filename,
                    const std::string file_mode)
   : hdf5_file_open(false), hdf5_file_id(0), _mpi_comm(comm)
 {
-  // HDF5 chunking
-  parameters.add("chunking", false);
-
+  parameters = default_parameters();
+  open(filename, file_mode);
+}
+//-----------------------------------------------------------------------------
+HDF5File::HDF5File(MPI_Comm comm, const std::string filename,
+                   const std::string file_mode, const Parameters& params)
+  : hdf5_file_open(false), hdf5_file_id(0), _mpi_comm(comm)
+{
+  parameters = default_parameters();
+  parameters.update(params);
+  open(filename, file_mode);
+}
+//-----------------------------------------------------------------------------
+HDF5File::~HDF5File()
+{
+  close();
+}
+//-----------------------------------------------------------------------------
+void HDF5File::open(const std::string filename, const std::string file_mode)
+{
   // Create directory if required (create on rank 0)
   if (MPI::rank(_mpi_comm) == 0)
   {
@@ -82,18 +100,39 @@ HDF5File::HDF5File(MPI_Comm comm, const std::string filename,
   // Wait until directory has been created
   MPI::barrier(_mpi_comm);
 
+  // Get MPI-IO hints, given as "key=value,key=value"
+  HDF5Interface::FileOptions options;
+  const std::string hints = parameters["mpi_io_hints"];
+  std::size_t first = 0;
+  while (first < hints.size())
+  {
+    std::size_t last = hints.find(',', first);
+    if (last == std::string::npos)
+      last = hints.size();
+    const std::string hint = hints.substr(first, last - first);
+    const std::size_t split = hint.find('=');
+    if (split == std::string::npos || split == 0)
+    {
+      dolfin_error("HDF5File.cpp",
+                   "open file",
+                   "MPI-IO hint \"%s\" is not of the form key=value",
+                   hint.c_str());
+    }
+    options.mpi_io_hints.push_back(std::make_pair(hint.substr(0, split),
+                                                  hint.substr(split + 1)));
+    first = last + 1;
+  }
+  options.collective_metadata = parameters["collective_metadata"];
+  options.metadata_block_size = (int) parameters["metadata_block_size"];
+  options.alignment = (int) parameters["alignment"];
+
   // Open HDF5 file
   const bool mpi_io = MPI::size(_mpi_comm) > 1 ? true : false;
   hdf5_file_id = HDF5Interface::open_file(_mpi_comm, filename, file_mode,
-                                          mpi_io);
+                                          mpi_io, options);
   hdf5_file_open = true;
 }
 //-----------------------------------------------------------------------------
-HDF5File::~HDF5File()
-{
-  close();
-}
-//-----------------------------------------------------------------------------
 void HDF5File::close()
 {
   // Close HDF5 file
@@ -108,6 +147,23 @@ void HDF5File::flush()
   HDF5Interface::flush_file(hdf5_file_id);
 }
 //-----------------------------------------------------------------------------
+HDF5Interface::DatasetOptions HDF5File::dataset_options() const
+{
+  HDF5Interface::DatasetOptions options;
+  options.collective = collective_transfer();
+  options.chunking = parameters["chunking"];
+  options.chunk_size = (int) parameters["chunk_size"];
+  options.compression_level = parameters["compression_level"];
+  options.shuffle = parameters["shuffle"];
+  return options;
+}
+//-----------------------------------------------------------------------------
+bool HDF5File::collective_transfer() const
+{
+  const std::string transfer = parameters["mpi_io_transfer"];
+  return MPI::size(_mpi_comm) > 1 && transfer == "collective";
+}
+//-----------------------------------------------------------------------------
 void HDF5File::write(const std::vector<Point>& points,
                      const std::string dataset_name)
 {
@@ -155,12 +211,21 @@ void HDF5File::write(const GenericVector& x, const std::string dataset_name)
   x.get_local(local_data);
 
   // Write data to file
-  std::pair<std::size_t, std::size_t> local_range = x.local_range();
-  const bool chunking = parameters["chunking"];
-  const std::vector<std::size_t> global_size(1, x.size());
+  write_vector(local_data, x.local_range(), x.size(), dataset_name);
+}
+//-----------------------------------------------------------------------------
+void HDF5File::write_vector(const std::vector<double>& local_data,
+                            const std::pair<std::size_t, std::size_t>
+                            local_range,
+                            std::size_t global_size,
+                            const std::string dataset_name)
+{
+  // Write data to file
   const bool mpi_io = MPI::size(_mpi_comm) > 1 ? true : false;
   HDF5Interface::write_dataset(hdf5_file_id, dataset_name, local_data,
-                               local_range, global_size, mpi_io, chunking);
+                               local_range,
+                               std::vector<std::size_t>(1, global_size),
+                               mpi_io, dataset_options());
 
   // Add partitioning attribute to dataset
   std::vector<std::size_t> partitions;
@@ -242,7 +307,8 @@ void HDF5File::read(GenericVector& x, const std::string dataset_name,
 
   // Read data from file
   std::vector<double> data;
-  HDF5Interface::read_dataset(hdf5_file_id, dataset_name, local_range, data);
+  HDF5Interface::read_dataset(hdf5_file_id, dataset_name, local_range, data,
+                              collective_transfer());
 
   // Set data
   x.set_local(data);
@@ -464,13 +530,20 @@ void HDF5File::write(const Mesh& mesh, std::size_t cell_dim,
     // ---------- Markers
     for (std::size_t d = 0; d <= mesh.domains().max_dim(); d++)
     {
-      const std::map<std::size_t, std::size_t>& domain
+      const boost::container::flat_map<std::size_t, std::size_t>& domain
         = mesh.domains().markers(d);
 
-      MeshValueCollection<std::size_t> collection(mesh, d);
-      std::map<std::size_t, std::size_t>::const_iterator it;
+      std::vector<std::size_t> entities, values;
+      entities.reserve(domain.size());
+      values.reserve(domain.size());
+      boost::container::flat_map<std::size_t, std::size_t>::const_iterator it;
       for (it = domain.begin(); it != domain.end(); ++it)
-        collection.set_value(it->first, it->second);
+      {
+        entities.push_back(it->first);
+        values.push_back(it->second);
+      }
+      MeshValueCollection<std::size_t> collection(mesh, d);
+      collection.set_values(entities, values);
       const std::string marker_dataset
         = name + "/domain_" + std::to_string(d);
       write_mesh_value_collection(collection, marker_dataset);
@@ -622,7 +695,7 @@ void HDF5File::read_mesh_function(MeshFunction<T>& meshfunction,
   std::vector<std::size_t> topology_data;
   topology_data.reserve(num_read_cells*vert_per_cell);
   HDF5Interface::read_dataset(hdf5_file_id, topology_name, cell_range,
-                              topology_data);
+                              topology_data, collective_transfer());
 
   boost::multi_array_ref<std::size_t, 2>
     topology_array(topology_data.data(),
@@ -631,7 +704,7 @@ void HDF5File::read_mesh_function(MeshFunction<T>& meshfunction,
   std::vector<T> value_data;
   value_data.reserve(num_read_cells);
   HDF5Interface::read_dataset(hdf5_file_id, values_name, cell_range,
-                              value_data);
+                              value_data, collective_transfer());
 
   // Now send the read data to each process on the basis of the first
   // vertex of the entity, since we do not know the global_index
@@ -832,13 +905,36 @@ void HDF5File::write_mesh_function(const MeshFunction<T>& meshfunction,
 //-----------------------------------------------------------------------------
 void HDF5File::write(const Function& u,  const std::string name,
                      double timestamp)
+{
+  dolfin_assert(u.vector());
+  const GenericVector& x = *u.vector();
+
+  // Dofs are only written with the first vector of a series
+  FunctionDofs dofs;
+  if (!HDF5Interface::has_dataset(hdf5_file_id, name))
+    tabulate_function_dofs(u, dofs);
+
+  std::vector<double> local_data;
+  x.get_local(local_data);
+  write_function_series(dofs, local_data, x.local_range(), x.size(), name,
+                        timestamp);
+}
+//-----------------------------------------------------------------------------
+void HDF5File::write_function_series(const FunctionDofs& dofs,
+                                     const std::vector<double>& local_data,
+                                     const std::pair<std::size_t,
+                                                     std::size_t> local_range,
+                                     std::size_t global_size,
+                                     const std::string name,
+                                     double timestamp)
 {
   if (!HDF5Interface::has_dataset(hdf5_file_id, name))
   {
-    write(u, name);
+    write_function_dofs(dofs, name);
+    const std::string vec_name = name + "/vector_0";
+    write_vector(local_data, local_range, global_size, vec_name);
     const std::size_t vec_count = 1;
     attributes(name).set("count", vec_count);
-    const std::string vec_name = name + "/vector_0";
     attributes(vec_name).set("timestamp", timestamp);
   }
   else
@@ -859,7 +955,7 @@ void HDF5File::write(const Function& u,  const std::string name,
     attr.set("count", vec_count);
 
     // Write new vector and save timestamp
-    write(*u.vector(), vec_name);
+    write_vector(local_data, local_range, global_size, vec_name);
     attributes(vec_name).set("timestamp", timestamp);
 
   }
@@ -869,6 +965,17 @@ void HDF5File::write(const Function& u, const std::string name)
 {
   Timer t0("HDF5: write Function");
 
+  // Save dofs
+  FunctionDofs dofs;
+  tabulate_function_dofs(u, dofs);
+  write_function_dofs(dofs, name);
+
+  // Save vector
+  write(*u.vector(), name + "/vector_0");
+}
+//-----------------------------------------------------------------------------
+void HDF5File::tabulate_function_dofs(const Function& u, FunctionDofs& dofs)
+{
   // Get mesh and dofmap
   dolfin_assert(u.function_space()->mesh());
   const Mesh& mesh = *u.function_space()->mesh();
@@ -883,9 +990,11 @@ void HDF5File::write(const Function& u, const std::string name)
   // the start of each row
 
   const std::size_t tdim = mesh.topology().dim();
-  std::vector<dolfin::la_index> cell_dofs;
-  std::vector<std::size_t> x_cell_dofs;
+  std::vector<dolfin::la_index>& cell_dofs = dofs.cell_dofs;
+  std::vector<std::size_t>& x_cell_dofs = dofs.x_cell_dofs;
   const std::size_t n_cells = mesh.topology().ghost_offset(tdim);
+  cell_dofs.clear();
+  x_cell_dofs.clear();
   x_cell_dofs.reserve(n_cells);
 
   std::vector<std::size_t> local_to_global_map;
@@ -902,7 +1011,20 @@ void HDF5File::write(const Function& u, const std::string name)
     }
   }
 
+  // Copy cell ordering, cutting off ghosts
+  dofs.cells.assign(mesh.topology().global_indices(tdim).begin(),
+                    mesh.topology().global_indices(tdim).begin() + n_cells);
+  dofs.num_global_cells = mesh.size_global(tdim);
+
+  dofs.signature = u.function_space()->element()->signature();
+}
+//-----------------------------------------------------------------------------
+void HDF5File::write_function_dofs(const FunctionDofs& dofs,
+                                   const std::string name)
+{
   // Add offset to CSR index to be seamless in parallel
+  const std::vector<dolfin::la_index>& cell_dofs = dofs.cell_dofs;
+  std::vector<std::size_t> x_cell_dofs(dofs.x_cell_dofs);
   std::size_t offset = MPI::global_offset(_mpi_comm, cell_dofs.size(), true);
   std::transform(x_cell_dofs.begin(),
                  x_cell_dofs.end(),
@@ -917,21 +1039,15 @@ void HDF5File::write(const Function& u, const std::string name)
   write_data(name + "/cell_dofs", cell_dofs, global_size, mpi_io);
   if (MPI::rank(_mpi_comm) == MPI::size(_mpi_comm) - 1)
     x_cell_dofs.push_back(global_size[0]);
-  global_size[0] = mesh.size_global(tdim) + 1;
+  global_size[0] = dofs.num_global_cells + 1;
   write_data(name + "/x_cell_dofs", x_cell_dofs, global_size, mpi_io);
 
-  // Save cell ordering - copy to local vector and cut off ghosts
-  std::vector<std::size_t> cells(mesh.topology().global_indices(tdim).begin(),
-                       mesh.topology().global_indices(tdim).begin() + n_cells);
-
-  global_size[0] = mesh.size_global(tdim);
-  write_data(name + "/cells", cells, global_size, mpi_io);
+  // Save cell ordering
+  global_size[0] = dofs.num_global_cells;
+  write_data(name + "/cells", dofs.cells, global_size, mpi_io);
 
   HDF5Interface::add_attribute(hdf5_file_id, name, "signature",
-                               u.function_space()->element()->signature());
-
-  // Save vector
-  write(*u.vector(), name + "/vector_0");
+                               dofs.signature);
 }
 //-----------------------------------------------------------------------------
 void HDF5File::read(Function& u, const std::string name)
@@ -1025,21 +1141,21 @@ void HDF5File::read(Function& u, const std::string name)
   // Read cells
   std::vector<std::size_t> input_cells;
   HDF5Interface::read_dataset(hdf5_file_id, cells_dataset_name,
-                              cell_range, input_cells);
+                              cell_range, input_cells, collective_transfer());
 
   // Overlap reads of DOF indices, to get full range on each process
   std::vector<std::size_t> x_cell_dofs;
   HDF5Interface::read_dataset(hdf5_file_id, x_cell_dofs_dataset_name,
                               std::make_pair(cell_range.first,
                                              cell_range.second + 1),
-                              x_cell_dofs);
+                              x_cell_dofs, collective_transfer());
 
   // Read cell-DOF maps
   std::vector<dolfin::la_index> input_cell_dofs;
   HDF5Interface::read_dataset(hdf5_file_id, cell_dofs_dataset_name,
                               std::make_pair(x_cell_dofs.front(),
                                              x_cell_dofs.back()),
-                              input_cell_dofs);
+                              input_cell_dofs, collective_transfer());
 
   GenericVector& x = *u.vector();
 
@@ -1053,7 +1169,7 @@ void HDF5File::read(Function& u, const std::string name)
   std::vector<double> input_values;
   HDF5Interface::read_dataset(hdf5_file_id, vector_dataset_name,
                               input_vector_range,
-                              input_values);
+                              input_values, collective_transfer());
 
   // Calculate one (global cell, local_dof_index) to associate
   // with each item in the vector on this process
@@ -1169,16 +1285,20 @@ void HDF5File::write(const MeshValueCollection<bool>& mesh_values,
 {
   // HDF5 does not implement bool, use int and copy
 
-  MeshValueCollection<int> mvc_int(mesh_values.mesh(), mesh_values.dim());
-  const std::map<std::pair<std::size_t, std::size_t>, bool>& values
-    = mesh_values.values();
-  for (std::map<std::pair<std::size_t, std::size_t>,
+  const boost::container::flat_map<std::pair<std::size_t, std::size_t>,
+                                   bool>& values = mesh_values.values();
+  std::vector<std::size_t> cells, entities;
+  std::vector<int> int_values;
+  for (boost::container::flat_map<std::pair<std::size_t, std::size_t>,
                 bool>::const_iterator mesh_value_it = values.begin();
        mesh_value_it != values.end(); ++mesh_value_it)
   {
-    mvc_int.set_value(mesh_value_it->first.first, mesh_value_it->first.second,
-                      mesh_value_it->second ? 1 : 0);
+    cells.push_back(mesh_value_it->first.first);
+    entities.push_back(mesh_value_it->first.second);
+    int_values.push_back(mesh_value_it->second ? 1 : 0);
   }
+  MeshValueCollection<int> mvc_int(mesh_values.mesh(), mesh_values.dim());
+  mvc_int.set_values(cells, entities, int_values);
 
   write_mesh_value_collection(mvc_int, name);
 }
@@ -1191,24 +1311,27 @@ void HDF5File::read(MeshValueCollection<bool>& mesh_values,
   MeshValueCollection<int> mvc_int(mesh_values.mesh(), mesh_values.dim());
   read_mesh_value_collection(mvc_int, name);
 
-  const std::map<std::pair<std::size_t, std::size_t>, int>& values
-    = mvc_int.values();
-  for (std::map<std::pair<std::size_t, std::size_t>,
+  const boost::container::flat_map<std::pair<std::size_t, std::size_t>,
+                                   int>& values = mvc_int.values();
+  std::vector<std::size_t> cells, entities;
+  std::vector<bool> bool_values;
+  for (boost::container::flat_map<std::pair<std::size_t, std::size_t>,
                 int>::const_iterator mesh_value_it = values.begin();
       mesh_value_it != values.end(); ++mesh_value_it)
   {
-    mesh_values.set_value(mesh_value_it->first.first,
-                          mesh_value_it->first.second,
-                          (mesh_value_it->second != 0));
+    cells.push_back(mesh_value_it->first.first);
+    entities.push_back(mesh_value_it->first.second);
+    bool_values.push_back(mesh_value_it->second != 0);
   }
+  mesh_values.set_values(cells, entities, bool_values);
 
 }
 //-----------------------------------------------------------------------------
 template <typename T>
 void HDF5File::write_mesh_value_collection(const MeshValueCollection<T>& mesh_values, const std::string name)
 {
-  const std::map<std::pair<std::size_t, std::size_t>, T>& values
-    = mesh_values.values();
+  const boost::container::flat_map<std::pair<std::size_t, std::size_t>, T>&
+    values = mesh_values.values();
 
   const Mesh& mesh = *mesh_values.mesh();
   const std::vector<std::size_t>& global_cell_index
@@ -1218,8 +1341,8 @@ void HDF5File::write_mesh_value_collection(const MeshValueCollection<T>& mesh_va
   std::vector<std::size_t> entities;
   std::vector<std::size_t> cells;
 
-  for (typename std::map<std::pair<std::size_t, std::size_t>,
-         T>::const_iterator
+  for (typename boost::container::flat_map<std::pair<std::size_t,
+         std::size_t>, T>::const_iterator
          p = values.begin(); p != values.end(); ++p)
   {
     cells.push_back(global_cell_index[p->first.first]);
@@ -1308,23 +1431,25 @@ void HDF5File::read_mesh_value_collection(MeshValueCollection<T>& mesh_vc,
 
     std::vector<T> values_data;
     values_data.reserve(local_size);
-    HDF5Interface::read_dataset(hdf5_file_id, values_name, range, values_data);
+    HDF5Interface::read_dataset(hdf5_file_id, values_name, range, values_data,
+                                collective_transfer());
     std::vector<std::size_t> entities_data;
     entities_data.reserve(local_size);
     HDF5Interface::read_dataset(hdf5_file_id, entities_name, range,
-                                entities_data);
+                                entities_data, collective_transfer());
     std::vector<std::size_t> cells_data;
     cells_data.reserve(local_size);
-    HDF5Interface::read_dataset(hdf5_file_id, cells_name, range, cells_data);
+    HDF5Interface::read_dataset(hdf5_file_id, cells_name, range, cells_data,
+                                collective_transfer());
 
     // Get global mapping to restore values
     const Mesh& mesh = *mesh_vc.mesh();
     const std::vector<std::size_t>& global_cell_index
       = mesh.topology().global_indices(mesh.topology().dim());
 
-    // Reference to actual map of MeshValueCollection
-    std::map<std::pair<std::size_t, std::size_t>, T>& mvc_map
-      = mesh_vc.values();
+    // Values found on this process, inserted in bulk
+    std::vector<std::size_t> local_cells, local_entities;
+    std::vector<T> local_values;
 
     // Find cells which are on this process,
     // under the assumption that global_cell_index is ordered.
@@ -1365,10 +1490,13 @@ void HDF5File::read_mesh_value_collection(MeshValueCollection<T>& mesh_vc,
         // Here we do not increment j because cells_data_index is ordered
         // but not *strictly* ordered.
         std::size_t lidx = i - global_cell_index.begin();
-        mvc_map[std::make_pair(lidx, entities_data[*j])] = values_data[*j];
+        local_cells.push_back(lidx);
+        local_entities.push_back(entities_data[*j]);
+        local_values.push_back(values_data[*j]);
         ++j;
       }
     }
+    mesh_vc.set_values(local_cells, local_entities, local_values);
   }
   else
   {
@@ -1383,15 +1511,15 @@ void HDF5File::read_mesh_value_collection(MeshValueCollection<T>& mesh_vc,
     std::vector<T> values_data;
     values_data.reserve(local_size);
     HDF5Interface::read_dataset(hdf5_file_id, values_name, data_range,
-                                values_data);
+                                values_data, collective_transfer());
     std::vector<std::size_t> entities_data;
     entities_data.reserve(local_size);
     HDF5Interface::read_dataset(hdf5_file_id, entities_name, data_range,
-                                entities_data);
+                                entities_data, collective_transfer());
     std::vector<std::size_t> cells_data;
     cells_data.reserve(local_size);
     HDF5Interface::read_dataset(hdf5_file_id, cells_name, data_range,
-                                cells_data);
+                                cells_data, collective_transfer());
 
     std::vector<std::pair<std::size_t, std::size_t>> cell_ownership;
     cell_ownership = HDF5Utility::cell_owners(mesh, cells_data);
@@ -1415,24 +1543,21 @@ void HDF5File::read_mesh_value_collection(MeshValueCollection<T>& mesh_vc,
     MPI::all_to_all(_mpi_comm, send_local, recv_local);
     MPI::all_to_all(_mpi_comm, send_values, recv_values);
 
-    // Reference to actual map of MeshValueCollection
-    std::map<std::pair<std::size_t, std::size_t>, T>& mvc_map
-      = mesh_vc.values();
-
+    // Concatenate received values and insert in bulk
+    std::vector<std::size_t> local_index, local_entities;
+    std::vector<T> local_values;
     for (std::size_t i = 0; i < num_processes; ++i)
     {
-      const std::vector<std::size_t>& local_index = recv_local[i];
-      const std::vector<std::size_t>& local_entities = recv_entities[i];
-      const std::vector<T>& local_values = recv_values[i];
-      dolfin_assert(local_index.size() == local_entities.size());
-      dolfin_assert(local_index.size() == local_values.size());
-
-      for (std::size_t j = 0; j < local_index.size(); ++j)
-      {
-        mvc_map[std::make_pair(local_index[j], local_entities[j])]
-          = local_values[j];
-      }
+      dolfin_assert(recv_local[i].size() == recv_entities[i].size());
+      dolfin_assert(recv_local[i].size() == recv_values[i].size());
+      local_index.insert(local_index.end(), recv_local[i].begin(),
+                         recv_local[i].end());
+      local_entities.insert(local_entities.end(), recv_entities[i].begin(),
+                            recv_entities[i].end());
+      local_values.insert(local_values.end(), recv_values[i].begin(),
+                          recv_values[i].end());
     }
+    mesh_vc.set_values(local_index, local_entities, local_values);
 
   }
 }
@@ -1534,7 +1659,7 @@ void HDF5File::read(Mesh& input_mesh, const std::string topology_name,
   std::vector<std::size_t> topology_data;
   topology_data.reserve(num_local_cells*num_vertices_per_cell);
   HDF5Interface::read_dataset(hdf5_file_id, topology_name, cell_range,
-                              topology_data);
+                              topology_data, collective_transfer());
 
   // Reconstruct mesh_name from topology_name - needed for cell_indices
   // and domains
@@ -1545,7 +1670,8 @@ void HDF5File::read(Mesh& input_mesh, const std::string topology_name,
   if (HDF5Interface::has_dataset(hdf5_file_id, cell_indices_name))
   {
     HDF5Interface::read_dataset(hdf5_file_id, cell_indices_name,
-                                cell_range, mesh_data.global_cell_indices);
+                                cell_range, mesh_data.global_cell_indices,
+                                collective_transfer());
   }
   else
   {
@@ -1583,7 +1709,7 @@ void HDF5File::read(Mesh& input_mesh, const std::string topology_name,
   std::vector<double> coordinates_data;
   coordinates_data.reserve(num_local_vertices*mesh_data.gdim);
   HDF5Interface::read_dataset(hdf5_file_id, geometry_name, vertex_range,
-                              coordinates_data);
+                              coordinates_data, collective_transfer());
 
   // Copy to boost::multi_array
   mesh_data.vertex_coordinates.resize(boost::extents[num_local_vertices][mesh_data.gdim]);
@@ -1616,31 +1742,35 @@ void HDF5File::read(Mesh& input_mesh, const std::string topology_name,
     read_mesh_value_collection(mvc, marker_dataset);
 
     // Get mesh value collection data
-    const std::map<std::pair<std::size_t, std::size_t>, std::size_t>&
-      values = mvc.values();
+    const boost::container::flat_map<std::pair<std::size_t, std::size_t>,
+                                     std::size_t>& values = mvc.values();
 
     // Get mesh domain data and fill
-    std::map<std::size_t, std::size_t>& markers
-      = input_mesh.domains().markers(d);
-    std::map<std::pair<std::size_t, std::size_t>,
-             std::size_t>::const_iterator entry;
+    std::vector<std::size_t> entities, markers;
+    entities.reserve(values.size());
+    markers.reserve(values.size());
+    boost::container::flat_map<std::pair<std::size_t, std::size_t>,
+                               std::size_t>::const_iterator entry;
     if (d != input_mesh.topology().dim())
     {
       input_mesh.init(d);
       for (entry = values.begin(); entry != values.end(); ++entry)
       {
         const Cell cell(input_mesh, entry->first.first);
-        const std::size_t entity_index
-          = cell.entities(d)[entry->first.second];
-        markers[entity_index] = entry->second;
+        entities.push_back(cell.entities(d)[entry->first.second]);
+        markers.push_back(entry->second);
       }
     }
     else
     {
       // Special case for cells
       for (entry = values.begin(); entry != values.end(); ++entry)
-        markers[entry->first.first] = entry->second;
+      {
+        entities.push_back(entry->first.first);
+        markers.push_back(entry->second);
+      }
     }
+    input_mesh.domains().set_markers(entities, markers, d);
   }
 
 }
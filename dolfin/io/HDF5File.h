@@ -22,12 +22,14 @@
 
 #ifdef HAS_HDF5
 
+#include <limits>
 #include <string>
 #include <utility>
 #include <vector>
 
 #include <dolfin/common/MPI.h>
 #include <dolfin/common/Variable.h>
+#include <dolfin/common/types.h>
 #include <dolfin/geometry/Point.h>
 #include "HDF5Attribute.h"
 #include "HDF5Interface.h"
@@ -52,6 +54,13 @@ namespace dolfin
     HDF5File(MPI_Comm comm, const std::string filename,
              const std::string file_mode);
 
+    /// Constructor with parameters, which must be given here for
+    /// the options applied when opening the file ("mpi_io_hints",
+    /// "collective_metadata", "metadata_block_size" and
+    /// "alignment").
+    HDF5File(MPI_Comm comm, const std::string filename,
+             const std::string file_mode, const Parameters& parameters);
+
     /// Destructor
     ~HDF5File();
 
@@ -167,12 +176,80 @@ namespace dolfin
     /// Flush buffered I/O to disk
     void flush();
 
+    /// Default parameter values
+    static Parameters default_parameters()
+    {
+      Parameters p("hdf5_file");
+
+      // Dataset storage
+      p.add("chunking", false);
+      p.add("chunk_size", 0, 0, std::numeric_limits<int>::max());
+      p.add("compression_level", 0, 0, 9);
+      p.add("shuffle", false);
+
+      // Parallel I/O
+      p.add("mpi_io_transfer", "collective", {"collective", "independent"});
+      p.add("mpi_io_hints", "");
+      p.add("collective_metadata", true);
+      p.add("metadata_block_size", 0, 0, std::numeric_limits<int>::max());
+      p.add("alignment", 0, 0, std::numeric_limits<int>::max());
+
+      return p;
+    }
+
   private:
 
+    // Open file
+    void open(const std::string filename, const std::string file_mode);
+
+    // Return dataset options from parameters
+    HDF5Interface::DatasetOptions dataset_options() const;
+
+    // Return true if data is transferred with collective MPI-IO
+    bool collective_transfer() const;
+
     // Friend
+    friend class CheckpointWriter;
     friend class XDMFFile;
     friend class TimeSeries;
 
+    // Global dofs of the owned cells of a Function in compressed
+    // form, global indices of the cells and signature of the element,
+    // as written to file
+    struct FunctionDofs
+    {
+      std::vector<dolfin::la_index> cell_dofs;
+      std::vector<std::size_t> x_cell_dofs;
+      std::vector<std::size_t> cells;
+      std::size_t num_global_cells;
+      std::string signature;
+    };
+
+    // Tabulate dofs of Function (does not communicate)
+    static void tabulate_function_dofs(const Function& u,
+                                       FunctionDofs& dofs);
+
+    // Write tabulated dofs of Function to group name
+    void write_function_dofs(const FunctionDofs& dofs,
+                             const std::string name);
+
+    // Write local values of a vector with given local range and
+    // global size
+    void write_vector(const std::vector<double>& local_data,
+                      const std::pair<std::size_t, std::size_t> local_range,
+                      std::size_t global_size,
+                      const std::string dataset_name);
+
+    // Append local values of a Function vector with timestamp to
+    // series name. The dofs of the Function are written if the series
+    // does not exist, and are otherwise not used.
+    void write_function_series(const FunctionDofs& dofs,
+                               const std::vector<double>& local_data,
+                               const std::pair<std::size_t,
+                                               std::size_t> local_range,
+                               std::size_t global_size,
+                               const std::string name, double timestamp);
+
     // Write a MeshFunction to file
     template <typename T>
     void write_mesh_function(const MeshFunction<T>& meshfunction,
@@ -201,6 +278,14 @@ namespace dolfin
                     const std::vector<std::size_t> global_size,
                     bool use_mpi_io);
 
+    // Write contiguous data of one step of a series to extensible
+    // HDF5 data set with steps as first dimension (see write_data)
+    template <typename T>
+    void write_data_step(const std::string dataset_name,
+                         const std::vector<T>& data,
+                         const std::vector<std::size_t> global_size,
+                         std::size_t step, bool use_mpi_io);
+
     // HDF5 file descriptor/handle
     bool hdf5_file_open;
     hid_t hdf5_file_id;
@@ -232,15 +317,47 @@ namespace dolfin
     std::pair<std::size_t, std::size_t> range(offset,
                                               offset + num_local_items);
 
-    // Write data to HDF5 file
-    const bool chunking = parameters["chunking"];
     // Ensure dataset starts with '/'
     std::string dset_name(dataset_name);
     if (dset_name[0] != '/')
       dset_name = "/" + dataset_name;
 
+    // Write data to HDF5 file
     HDF5Interface::write_dataset(hdf5_file_id, dset_name, data,
-                                 range, global_size, use_mpi_io, chunking);
+                                 range, global_size, use_mpi_io,
+                                 dataset_options());
+  }
+  //---------------------------------------------------------------------------
+  template <typename T>
+  void HDF5File::write_data_step(const std::string dataset_name,
+                                 const std::vector<T>& data,
+                                 const std::vector<std::size_t> global_size,
+                                 std::size_t step, bool use_mpi_io)
+  {
+    dolfin_assert(hdf5_file_open);
+    dolfin_assert(global_size.size() > 0);
+
+    // Get number of 'items'
+    std::size_t num_local_items = 1;
+    for (std::size_t i = 1; i < global_size.size(); ++i)
+      num_local_items *= global_size[i];
+    num_local_items = data.size()/num_local_items;
+
+    // Compute offset
+    const std::size_t offset = MPI::global_offset(_mpi_comm, num_local_items,
+                                                  true);
+    std::pair<std::size_t, std::size_t> range(offset,
+                                              offset + num_local_items);
+
+    // Ensure dataset starts with '/'
+    std::string dset_name(dataset_name);
+    if (dset_name[0] != '/')
+      dset_name = "/" + dataset_name;
+
+    // Write data to HDF5 file
+    HDF5Interface::write_dataset_step(hdf5_file_id, dset_name, data, range,
+                                      global_size, step, use_mpi_io,
+                                      dataset_options());
   }
   //---------------------------------------------------------------------------
 
@@ -20,6 +20,7 @@
 // First Added: 2012-09-21
 // Last Changed: 2013-10-24
 
+#include <algorithm>
 #include <boost/filesystem.hpp>
 #include <dolfin/common/MPI.h>
 #include <dolfin/log/log.h>
@@ -36,18 +37,35 @@ using namespace dolfin;
 //-----------------------------------------------------------------------------
 hid_t HDF5Interface::open_file(MPI_Comm mpi_comm, const std::string filename,
                                const std::string mode,
-                               const bool use_mpi_io)
+                               const bool use_mpi_io,
+                               const FileOptions& options)
 {
   // Set parallel access with communicator
   const hid_t plist_id = H5Pcreate(H5P_FILE_ACCESS);
   if (use_mpi_io)
   {
     #ifdef HAS_MPI
+    // Pass hints to MPI-IO (unknown hints are ignored by MPI)
     MPI_Info info;
     MPI_Info_create(&info);
+    for (auto hint = options.mpi_io_hints.begin();
+         hint != options.mpi_io_hints.end(); ++hint)
+    {
+      MPI_Info_set(info, const_cast<char*>(hint->first.c_str()),
+                   const_cast<char*>(hint->second.c_str()));
+    }
     herr_t status = H5Pset_fapl_mpio(plist_id, mpi_comm, info);
     dolfin_assert(status != HDF5_FAIL);
     MPI_Info_free(&info);
+
+    // Aggregate metadata writes
+    #if H5_VERSION_GE(1, 10, 0)
+    if (options.collective_metadata)
+    {
+      status = H5Pset_coll_metadata_write(plist_id, true);
+      dolfin_assert(status != HDF5_FAIL);
+    }
+    #endif
     #else
     dolfin_error("HDF5Interface.cpp",
                  "create HDF5 file",
@@ -55,6 +73,20 @@ hid_t HDF5Interface::open_file(MPI_Comm mpi_comm, const std::string filename,
     #endif
   }
 
+  // Set allocation of metadata blocks and alignment of objects
+  if (options.metadata_block_size > 0)
+  {
+    herr_t status = H5Pset_meta_block_size(plist_id,
+                                           options.metadata_block_size);
+    dolfin_assert(status != HDF5_FAIL);
+  }
+  if (options.alignment > 0)
+  {
+    herr_t status = H5Pset_alignment(plist_id, options.alignment,
+                                     options.alignment);
+    dolfin_assert(status != HDF5_FAIL);
+  }
+
   hid_t file_id = HDF5_FAIL;
   if (mode == "w")
   {
@@ -108,6 +140,105 @@ void HDF5Interface::flush_file(const hid_t hdf5_file_handle)
   dolfin_assert(status != HDF5_FAIL);
 }
 //-----------------------------------------------------------------------------
+hid_t
+HDF5Interface::dataset_create_properties(const std::vector<hsize_t>& dims,
+                                         std::size_t value_size,
+                                         bool use_mpi_io,
+                                         const DatasetOptions& options,
+                                         bool extensible)
+{
+  const bool use_filters = options.compression_level > 0 || options.shuffle;
+
+  // Chunks cannot be empty, so empty datasets are stored contiguously
+  // (extensible datasets must be chunked)
+  if (!extensible
+      && ((!options.chunking && !use_filters) || dims.empty() || dims[0] == 0))
+  {
+    return H5P_DEFAULT;
+  }
+
+  if (use_filters && use_mpi_io)
+  {
+    // Filters require chunks to be written collectively
+    #if H5_VERSION_GE(1, 10, 2)
+    if (!options.collective)
+    {
+      dolfin_error("HDF5Interface.cpp",
+                   "create HDF5 dataset",
+                   "Compressed datasets must be written with collective MPI-IO transfer");
+    }
+    #else
+    dolfin_error("HDF5Interface.cpp",
+                 "create HDF5 dataset",
+                 "Writing compressed datasets in parallel requires HDF5 1.10.2 or later");
+    #endif
+  }
+
+  if (options.compression_level > 0
+      && !H5Zfilter_avail(H5Z_FILTER_DEFLATE))
+  {
+    dolfin_error("HDF5Interface.cpp",
+                 "create HDF5 dataset",
+                 "HDF5 library does not support deflate compression");
+  }
+
+  // Chunks span all but the first dimension. Unless given, the
+  // number of rows is chosen for chunks of about 1 MB. Chunks of
+  // extensible datasets hold a single entry of the first dimension,
+  // and rows are counted in the second dimension.
+  dolfin_assert(dims.size() > (extensible ? 1 : 0));
+  const std::size_t row_dim = extensible ? 1 : 0;
+  std::vector<hsize_t> chunk_dims(dims);
+  std::size_t row_size = value_size;
+  for (std::size_t i = row_dim + 1; i < dims.size(); ++i)
+    row_size *= dims[i];
+  hsize_t num_rows = options.chunk_size;
+  if (num_rows == 0)
+    num_rows = std::max((std::size_t) 1048576/std::max(row_size,
+                                                       (std::size_t) 1),
+                        (std::size_t) 1);
+  chunk_dims[row_dim] = std::max(std::min(num_rows, dims[row_dim]),
+                                 (hsize_t) 1);
+  if (extensible)
+    chunk_dims[0] = 1;
+
+  const hid_t plist_id = H5Pcreate(H5P_DATASET_CREATE);
+  dolfin_assert(plist_id != HDF5_FAIL);
+  herr_t status = H5Pset_chunk(plist_id, chunk_dims.size(),
+                               chunk_dims.data());
+  dolfin_assert(status != HDF5_FAIL);
+
+  // Filters are applied in the order set, and shuffling is only
+  // useful before compression
+  if (options.shuffle)
+  {
+    status = H5Pset_shuffle(plist_id);
+    dolfin_assert(status != HDF5_FAIL);
+  }
+  if (options.compression_level > 0)
+  {
+    status = H5Pset_deflate(plist_id, options.compression_level);
+    dolfin_assert(status != HDF5_FAIL);
+  }
+
+  return plist_id;
+}
+//-----------------------------------------------------------------------------
+hid_t HDF5Interface::transfer_properties(bool use_mpi_io, bool collective)
+{
+  const hid_t plist_id = H5Pcreate(H5P_DATASET_XFER);
+  dolfin_assert(plist_id != HDF5_FAIL);
+  if (use_mpi_io)
+  {
+    herr_t status = H5Pset_dxpl_mpio(plist_id,
+                                     collective ? H5FD_MPIO_COLLECTIVE
+                                     : H5FD_MPIO_INDEPENDENT);
+    dolfin_assert(status != HDF5_FAIL);
+  }
+
+  return plist_id;
+}
+//-----------------------------------------------------------------------------
 const std::string HDF5Interface::get_attribute_type(
                   const hid_t hdf5_file_handle,
                   const std::string dataset_name,
@@ -22,8 +22,10 @@
 
 #ifdef HAS_HDF5
 
-#include <vector>
+#include <algorithm>
 #include <string>
+#include <utility>
+#include <vector>
 
 // Note: dolfin/common/MPI.h is included before hdf5.h to avoid the
 // MPICH_IGNORE_CXX_SEEK issue
@@ -45,9 +47,56 @@ namespace dolfin
   #define HDF5_FAIL -1
   public:
 
+    /// Options for opening a file
+    struct FileOptions
+    {
+      FileOptions() : collective_metadata(false), metadata_block_size(0),
+        alignment(0) {}
+
+      /// MPI-IO hints (key, value), e.g. ("cb_nodes", "4") or
+      /// ("striping_factor", "16"), passed to MPI_File_open
+      std::vector<std::pair<std::string, std::string>> mpi_io_hints;
+
+      /// Write metadata collectively, such that metadata is
+      /// aggregated and written by few processes (requires HDF5 1.10,
+      /// ignored otherwise)
+      bool collective_metadata;
+
+      /// Minimum size in bytes of metadata block allocations (0 for
+      /// the HDF5 default)
+      std::size_t metadata_block_size;
+
+      /// Align objects of at least this size in bytes to multiples
+      /// of it, e.g. the file system stripe size (0 for no alignment)
+      std::size_t alignment;
+    };
+
+    /// Options for creating datasets and transferring data
+    struct DatasetOptions
+    {
+      DatasetOptions() : collective(true), chunking(false), chunk_size(0),
+        compression_level(0), shuffle(false) {}
+
+      /// Use collective (rather than independent) MPI-IO transfer
+      bool collective;
+
+      /// Store dataset in chunks (implied by compression and shuffle)
+      bool chunking;
+
+      /// Number of rows per chunk (0 for chunks of about 1 MB)
+      std::size_t chunk_size;
+
+      /// Level (1-9) of deflate compression (0 for no compression)
+      int compression_level;
+
+      /// Apply shuffle filter (improves compression of numbers)
+      bool shuffle;
+    };
+
     /// Open HDF5 and return file descriptor
     static hid_t open_file(MPI_Comm mpi_comm, const std::string filename,
-                           const std::string mode, const bool use_mpi_io);
+                           const std::string mode, const bool use_mpi_io,
+                           const FileOptions& options=FileOptions());
 
     /// Close HDF5 file
     static void close_file(const hid_t hdf5_file_handle);
@@ -62,23 +111,43 @@ namespace dolfin
     /// range: the local range on this processor
     /// global_size: the global multidimensional shape of the array
     /// use_mpio: whether using MPI or not
-    /// use_chunking: whether using chunking or not
+    /// options: chunking, filters and transfer mode
     template <typename T>
     static void write_dataset(const hid_t file_handle,
                               const std::string dataset_name,
                               const std::vector<T>& data,
                               const std::pair<std::size_t, std::size_t> range,
                               const std::vector<std::size_t> global_size,
-                              bool use_mpio, bool use_chunking);
+                              bool use_mpio,
+                              const DatasetOptions& options);
+
+    /// Write data of one step of a series to an extensible dataset
+    /// with dimensions (num_steps, global_size[0], global_size[1]),
+    /// as defined by range blocks on each process. The dataset is
+    /// created if it does not exist, and is extended if step is not
+    /// less than the number of steps in the dataset. Previously
+    /// written steps are not touched, so the cost does not depend on
+    /// the number of steps.
+    template <typename T>
+    static void write_dataset_step(const hid_t file_handle,
+                                   const std::string dataset_name,
+                                   const std::vector<T>& data,
+                                   const std::pair<std::size_t, std::size_t> range,
+                                   const std::vector<std::size_t> global_size,
+                                   std::size_t step,
+                                   bool use_mpio,
+                                   const DatasetOptions& options);
 
     /// Read data from a HDF5 dataset "dataset_name" as defined by
     /// range blocks on each process range: the local range on this
-    /// processor data: a flattened 1D array of values
+    /// processor data: a flattened 1D array of values. If collective
+    /// is true, the data is read with collective MPI-IO transfer and
+    /// all processes must call this function.
     template <typename T>
     static void read_dataset(const hid_t file_handle,
                              const std::string dataset_name,
                              const std::pair<std::size_t, std::size_t> range,
-                             std::vector<T>& data);
+                             std::vector<T>& data, bool collective=false);
 
     /// Check for existence of group in HDF5 file
     static bool has_group(const hid_t hdf5_file_handle,
@@ -171,6 +240,19 @@ namespace dolfin
                                       const hid_t attr_id,
                                       std::vector<T>& attribute_value);
 
+    // Create dataset creation property list with chunking and
+    // filters for dataset of given dimensions and value size, or
+    // return H5P_DEFAULT if neither is used. Extensible datasets are
+    // always chunked, with one entry of the first dimension per chunk.
+    static hid_t dataset_create_properties(const std::vector<hsize_t>& dims,
+                                           std::size_t value_size,
+                                           bool use_mpi_io,
+                                           const DatasetOptions& options,
+                                           bool extensible=false);
+
+    // Create data transfer property list
+    static hid_t transfer_properties(bool use_mpi_io, bool collective);
+
     // Return HDF5 data type
     template <typename T>
       static hid_t hdf5_type()
@@ -213,7 +295,8 @@ namespace dolfin
                                  const std::vector<T>& data,
                                  const std::pair<std::size_t,std::size_t> range,
                                  const std::vector<std::size_t> global_size,
-                                 bool use_mpi_io, bool use_chunking)
+                                 bool use_mpi_io,
+                                 const DatasetOptions& options)
   {
     // Data rank
     const std::size_t rank = global_size.size();
@@ -247,23 +330,9 @@ namespace dolfin
     const hid_t filespace0 = H5Screate_simple(rank, dimsf.data(), NULL);
     dolfin_assert(filespace0 != HDF5_FAIL);
 
-    // Set chunking parameters
-    hid_t chunking_properties;
-    if (use_chunking)
-    {
-      // Set chunk size and limit to 1kB min/1MB max
-      hsize_t chunk_size = dimsf[0]/2;
-      if (chunk_size > 1048576)
-        chunk_size = 1048576;
-      if (chunk_size < 1024)
-        chunk_size = 1024;
-
-      hsize_t chunk_dims[2] = {chunk_size, dimsf[1]};
-      chunking_properties = H5Pcreate(H5P_DATASET_CREATE);
-      H5Pset_chunk(chunking_properties, rank, chunk_dims);
-    }
-    else
-      chunking_properties = H5P_DEFAULT;
+    // Set chunking and filter parameters
+    const hid_t chunking_properties
+      = dataset_create_properties(dimsf, sizeof(T), use_mpi_io, options);
 
     // Check that group exists and recursively create if required
     const std::string group_name(dataset_name, 0, dataset_name.rfind('/'));
@@ -290,19 +359,14 @@ namespace dolfin
     dolfin_assert(status != HDF5_FAIL);
 
     // Set parallel access
-    const hid_t plist_id = H5Pcreate(H5P_DATASET_XFER);
-    if (use_mpi_io)
-    {
-      status = H5Pset_dxpl_mpio(plist_id, H5FD_MPIO_COLLECTIVE);
-      dolfin_assert(status != HDF5_FAIL);
-    }
+    const hid_t plist_id = transfer_properties(use_mpi_io, options.collective);
 
     // Write local dataset into selected hyperslab
     status = H5Dwrite(dset_id, h5type, memspace, filespace1, plist_id,
                       data.data());
     dolfin_assert(status != HDF5_FAIL);
 
-    if (use_chunking)
+    if (chunking_properties != H5P_DEFAULT)
     {
       // Close chunking properties
       status = H5Pclose(chunking_properties);
@@ -327,11 +391,150 @@ namespace dolfin
   }
   //---------------------------------------------------------------------------
   template <typename T>
+  inline void
+    HDF5Interface::write_dataset_step(const hid_t file_handle,
+                                      const std::string dataset_name,
+                                      const std::vector<T>& data,
+                                      const std::pair<std::size_t,std::size_t> range,
+                                      const std::vector<std::size_t> global_size,
+                                      std::size_t step,
+                                      bool use_mpi_io,
+                                      const DatasetOptions& options)
+  {
+    // Data rank (excluding step dimension)
+    const std::size_t rank = global_size.size();
+    dolfin_assert(rank != 0);
+
+    if (rank > 2)
+    {
+      dolfin_error("HDF5Interface.cpp",
+                   "write dataset step to HDF5 file",
+                   "Only rank 1 and rank 2 dataset are supported");
+    }
+
+    // Get HDF5 data type
+    const hid_t h5type = hdf5_type<T>();
+
+    // Dataset dimensions, with step as first dimension
+    std::vector<hsize_t> dimsf(1, step + 1);
+    dimsf.insert(dimsf.end(), global_size.begin(), global_size.end());
+
+    // Hyperslab selection parameters
+    std::vector<hsize_t> count(dimsf);
+    count[0] = 1;
+    count[1] = range.second - range.first;
+
+    // Data offsets
+    std::vector<hsize_t> offset(rank + 1, 0);
+    offset[0] = step;
+    offset[1] = range.first;
+
+    // Generic status report
+    herr_t status;
+
+    // Check that group exists and recursively create if required
+    const std::string group_name(dataset_name, 0, dataset_name.rfind('/'));
+    add_group(file_handle, group_name);
+
+    hid_t dset_id;
+    if (!has_dataset(file_handle, dataset_name))
+    {
+      // Create extensible global data space
+      const std::vector<hsize_t> max_dims(rank + 1, H5S_UNLIMITED);
+      const hid_t filespace0 = H5Screate_simple(rank + 1, dimsf.data(),
+                                                max_dims.data());
+      dolfin_assert(filespace0 != HDF5_FAIL);
+
+      // Set chunking and filter parameters
+      const hid_t chunking_properties
+        = dataset_create_properties(dimsf, sizeof(T), use_mpi_io, options,
+                                    true);
+
+      // Create global dataset (using dataset_name)
+      dset_id = H5Dcreate2(file_handle, dataset_name.c_str(), h5type,
+                           filespace0, H5P_DEFAULT, chunking_properties,
+                           H5P_DEFAULT);
+      dolfin_assert(dset_id != HDF5_FAIL);
+
+      // Close chunking properties and global data space
+      status = H5Pclose(chunking_properties);
+      dolfin_assert(status != HDF5_FAIL);
+      status = H5Sclose(filespace0);
+      dolfin_assert(status != HDF5_FAIL);
+    }
+    else
+    {
+      // Open existing dataset
+      dset_id = H5Dopen2(file_handle, dataset_name.c_str(), H5P_DEFAULT);
+      dolfin_assert(dset_id != HDF5_FAIL);
+
+      // Check shape of a step and get number of steps
+      const hid_t filespace0 = H5Dget_space(dset_id);
+      dolfin_assert(filespace0 != HDF5_FAIL);
+      std::vector<hsize_t> current_dims(rank + 1, 0);
+      const int ndims = H5Sget_simple_extent_dims(filespace0,
+                                                  current_dims.data(), NULL);
+      status = H5Sclose(filespace0);
+      dolfin_assert(status != HDF5_FAIL);
+      if (ndims != (int) (rank + 1)
+          || !std::equal(current_dims.begin() + 1, current_dims.end(),
+                         dimsf.begin() + 1))
+      {
+        dolfin_error("HDF5Interface.cpp",
+                     "write dataset step to HDF5 file",
+                     "Shape of data does not match existing dataset \"%s\"",
+                     dataset_name.c_str());
+      }
+
+      // Extend dataset (collective)
+      if (current_dims[0] <= step)
+      {
+        status = H5Dset_extent(dset_id, dimsf.data());
+        dolfin_assert(status != HDF5_FAIL);
+      }
+    }
+
+    // Create a local data space
+    const hid_t memspace = H5Screate_simple(rank + 1, count.data(), NULL);
+    dolfin_assert(memspace != HDF5_FAIL);
+
+    // Create a file dataspace within the global space - a hyperslab
+    const hid_t filespace1 = H5Dget_space(dset_id);
+    status = H5Sselect_hyperslab(filespace1, H5S_SELECT_SET, offset.data(),
+                                 NULL, count.data(), NULL);
+    dolfin_assert(status != HDF5_FAIL);
+
+    // Set parallel access
+    const hid_t plist_id = transfer_properties(use_mpi_io, options.collective);
+
+    // Write local data into selected hyperslab
+    status = H5Dwrite(dset_id, h5type, memspace, filespace1, plist_id,
+                      data.data());
+    dolfin_assert(status != HDF5_FAIL);
+
+    // Close dataset collectively
+    status = H5Dclose(dset_id);
+    dolfin_assert(status != HDF5_FAIL);
+
+    // Close hyperslab
+    status = H5Sclose(filespace1);
+    dolfin_assert(status != HDF5_FAIL);
+
+    // Close local dataset
+    status = H5Sclose(memspace);
+    dolfin_assert(status != HDF5_FAIL);
+
+    // Release file-access template
+    status = H5Pclose(plist_id);
+    dolfin_assert(status != HDF5_FAIL);
+  }
+  //---------------------------------------------------------------------------
+  template <typename T>
   inline void
     HDF5Interface::read_dataset(const hid_t file_handle,
                                 const std::string dataset_name,
                                 const std::pair<std::size_t, std::size_t> range,
-                                std::vector<T>& data)
+                                std::vector<T>& data, bool collective)
   {
     // Open the dataset
     const hid_t dset_id = H5Dopen2(file_handle, dataset_name.c_str(),
@@ -382,10 +585,15 @@ namespace dolfin
 
     // Read data on each process
     const int h5type = hdf5_type<T>();
-    status = H5Dread(dset_id, h5type, memspace, dataspace, H5P_DEFAULT,
+    const hid_t plist_id = transfer_properties(collective, true);
+    status = H5Dread(dset_id, h5type, memspace, dataspace, plist_id,
                      data.data());
     dolfin_assert(status != HDF5_FAIL);
 
+    // Release transfer properties
+    status = H5Pclose(plist_id);
+    dolfin_assert(status != HDF5_FAIL);
+
     // Close dataspace
     status = H5Sclose(dataspace);
     dolfin_assert(status != HDF5_FAIL);
@@ -314,8 +314,9 @@ void VTKFile::write_point_data(const GenericFunction& u, const Mesh& mesh,
   // Get number of components
   const std::size_t dim = u.value_size();
 
-  // Open file
-  std::ofstream fp(vtu_filename.c_str(), std::ios_base::app);
+  // Open file (at end, and seekable for compressed output)
+  std::ofstream fp(vtu_filename.c_str(),
+                   std::ios_base::in | std::ios_base::ate);
   fp.precision(16);
 
   // Allocate memory for function values at vertices
@@ -347,9 +348,9 @@ void VTKFile::write_point_data(const GenericFunction& u, const Mesh& mesh,
 
   if (_encoding == "ascii")
   {
-    std::ostringstream ss;
+    // Write to file directly
+    std::ostream& ss = fp;
     ss << std::scientific;
-    ss << std::setprecision(16);
     for (VertexIterator vertex(mesh); !vertex.end(); ++vertex)
     {
       if (rank == 1 && dim == 2)
@@ -380,9 +381,7 @@ void VTKFile::write_point_data(const GenericFunction& u, const Mesh& mesh,
         ss << " ";
       }
     }
-
-    // Send to file
-    fp << ss.str();
+    ss.unsetf(std::ios_base::floatfield);
   }
   else if (_encoding == "base64" || _encoding == "compressed")
   {
@@ -397,16 +396,21 @@ void VTKFile::write_point_data(const GenericFunction& u, const Mesh& mesh,
     const std::size_t num_data_per_point = dim + padding_per_point;
     const std::size_t num_total_data_points = num_vertices*num_data_per_point;
 
-    std::vector<double> data(num_total_data_points, 0);
+    // Encode data vertex by vertex (vertices are iterated in order of
+    // index, and ghost vertices are written as zero)
+    VTKWriter::EncodedArrayWriter<double> data(fp, num_total_data_points,
+                                               compress);
     for (VertexIterator vertex(mesh); !vertex.end(); ++vertex)
     {
       const std::size_t index = vertex->index();
+      dolfin_assert(index == vertex.pos());
       for(std::size_t i = 0; i < dim; i++)
-        data[index*num_data_per_point + i] = values[index + i*num_vertices];
+        data.add(values[index + i*num_vertices]);
+      for(std::size_t i = 0; i < padding_per_point; i++)
+        data.add(0.0);
     }
-
-    // Create encoded stream
-    fp << VTKWriter::encode_stream(data, compress) << std::endl;
+    data.finish();
+    fp << std::endl;
   }
 
   fp << "</DataArray> " << std::endl;
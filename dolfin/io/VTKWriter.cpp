@@ -82,8 +82,8 @@ void VTKWriter::write_cell_data(const Function& u, std::string filename,
   // Get number of components
   const std::size_t data_dim = u.value_size();
 
-  // Open file
-  std::ofstream fp(filename.c_str(), std::ios_base::app);
+  // Open file (at end, and seekable for compressed output)
+  std::ofstream fp(filename.c_str(), std::ios_base::in | std::ios_base::ate);
   fp.precision(16);
 
   // Write headers
@@ -146,22 +146,24 @@ void VTKWriter::write_cell_data(const Function& u, std::string filename,
 
   // Get cell data
   if (!binary)
-    fp << ascii_cell_data(mesh, offset, values, data_dim, rank);
+    ascii_cell_data(fp, mesh, offset, values, data_dim, rank);
   else
   {
-    fp << base64_cell_data(mesh, offset, values, data_dim, rank, compress)
-       << std::endl;
+    base64_cell_data(fp, mesh, offset, values, data_dim, rank, compress);
+    fp << std::endl;
   }
   fp << "</DataArray> " << std::endl;
   fp << "</CellData> " << std::endl;
 }
 //----------------------------------------------------------------------------
-std::string VTKWriter::ascii_cell_data(const Mesh& mesh,
-                                       const std::vector<std::size_t>& offset,
-                                       const std::vector<double>& values,
-                                       std::size_t data_dim, std::size_t rank)
+void VTKWriter::ascii_cell_data(std::ostream& ss, const Mesh& mesh,
+                                const std::vector<std::size_t>& offset,
+                                const std::vector<double>& values,
+                                std::size_t data_dim, std::size_t rank)
 {
-  std::ostringstream ss;
+  // Write to stream directly, restoring its format afterwards
+  const std::ios_base::fmtflags flags = ss.flags();
+  const std::streamsize precision = ss.precision();
   ss << std::scientific;
   ss << std::setprecision(16);
   std::vector<std::size_t>::const_iterator cell_offset = offset.begin();
@@ -196,14 +198,15 @@ std::string VTKWriter::ascii_cell_data(const Mesh& mesh,
     ++cell_offset;
   }
 
-  return ss.str();
+  ss.flags(flags);
+  ss.precision(precision);
 }
 //----------------------------------------------------------------------------
-std::string VTKWriter::base64_cell_data(const Mesh& mesh,
-                                        const std::vector<std::size_t>& offset,
-                                        const std::vector<double>& values,
-                                        std::size_t data_dim, std::size_t rank,
-                                        bool compress)
+void VTKWriter::base64_cell_data(std::ostream& stream, const Mesh& mesh,
+                                 const std::vector<std::size_t>& offset,
+                                 const std::vector<double>& values,
+                                 std::size_t data_dim, std::size_t rank,
+                                 bool compress)
 {
   const std::size_t num_cells = mesh.num_cells();
 
@@ -218,17 +221,20 @@ std::string VTKWriter::base64_cell_data(const Mesh& mesh,
   const std::size_t num_data_per_point = data_dim + padding_per_point;
   const std::size_t num_total_data_points = num_cells*num_data_per_point;
 
+  // Encode data cell by cell (cells are iterated in order of index,
+  // and ghost cells are written as zero)
   std::vector<std::size_t>::const_iterator cell_offset = offset.begin();
-  std::vector<double> data(num_total_data_points, 0);
+  EncodedArrayWriter<double> data(stream, num_total_data_points, compress);
   for (CellIterator cell(mesh); !cell.end(); ++cell)
   {
-    const std::size_t index = cell->index();
+    dolfin_assert(cell->index() == cell.pos());
     for(std::size_t i = 0; i < data_dim; i++)
-      data[index*num_data_per_point + i] = values[*cell_offset + i];
+      data.add(values[*cell_offset + i]);
+    for(std::size_t i = 0; i < padding_per_point; i++)
+      data.add(0.0);
     ++cell_offset;
   }
-
-  return encode_stream(data, compress);
+  data.finish();
 }
 //----------------------------------------------------------------------------
 void VTKWriter::write_ascii_mesh(const Mesh& mesh, std::size_t cell_dim,
@@ -305,8 +311,8 @@ void VTKWriter::write_base64_mesh(const Mesh& mesh, std::size_t cell_dim,
   // Get VTK cell type
   const boost::uint8_t _vtk_cell_type = vtk_cell_type(mesh, cell_dim);
 
-  // Open file
-  std::ofstream file(filename.c_str(), std::ios::app);
+  // Open file (at end, and seekable for compressed output)
+  std::ofstream file(filename.c_str(), std::ios::in | std::ios::ate);
   file.precision(16);
   if ( !file.is_open() )
   {
@@ -319,62 +325,60 @@ void VTKWriter::write_base64_mesh(const Mesh& mesh, std::size_t cell_dim,
   file << "<Points>" << std::endl;
   file << "<DataArray  type=\"Float64\"  NumberOfComponents=\"3\"  format=\""
        << "binary" << "\">" << std::endl;
-  std::vector<double> vertex_data(3*mesh.num_vertices());
-  std::vector<double>::iterator vertex_entry = vertex_data.begin();
+  EncodedArrayWriter<double> vertex_data(file, 3*mesh.num_vertices(),
+                                         compress);
   for (VertexIterator v(mesh); !v.end(); ++v)
   {
     const Point p = v->point();
-    *vertex_entry++ = p.x();
-    *vertex_entry++ = p.y();
-    *vertex_entry++ = p.z();
+    vertex_data.add(p.x());
+    vertex_data.add(p.y());
+    vertex_data.add(p.z());
   }
-  // Create encoded stream
-  file <<  encode_stream(vertex_data, compress) << std::endl;
+  vertex_data.finish();
+  file << std::endl;
   file << "</DataArray>" << std::endl <<  "</Points>" << std::endl;
 
   // Write cell connectivity
   file << "<Cells>" << std::endl;
   file << "<DataArray  type=\"UInt32\"  Name=\"connectivity\"  format=\""
        << "binary" << "\">" << std::endl;
-  const int size = num_cells*num_cell_vertices;
-  std::vector<boost::uint32_t> cell_data(size);
-  std::vector<boost::uint32_t>::iterator cell_entry = cell_data.begin();
-
+  EncodedArrayWriter<boost::uint32_t> cell_data(file,
+                                                num_cells*num_cell_vertices,
+                                                compress);
   std::unique_ptr<CellType>
     celltype(CellType::create(mesh.type().entity_type(cell_dim)));
   const std::vector<unsigned int> perm = celltype->vtk_mapping();
   for (MeshEntityIterator c(mesh, cell_dim); !c.end(); ++c)
   {
     for (unsigned int i = 0; i != c->num_entities(0); ++i)
-      *cell_entry++ = c->entities(0)[perm[i]];
+      cell_data.add(c->entities(0)[perm[i]]);
   }
-
-  // Create encoded stream
-  file << encode_stream(cell_data, compress) << std::endl;
+  cell_data.finish();
+  file << std::endl;
   file << "</DataArray>" << std::endl;
 
   // Write offset into connectivity array for the end of each cell
+  // (the array has the length of the connectivity array, with zeros
+  // after the last offset)
   file << "<DataArray  type=\"UInt32\"  Name=\"offsets\"  format=\""
        << "binary" << "\">" << std::endl;
-  std::vector<boost::uint32_t> offset_data(num_cells*num_cell_vertices);
-  std::vector<boost::uint32_t>::iterator offset_entry = offset_data.begin();
+  EncodedArrayWriter<boost::uint32_t> offset_data(file,
+                                                  num_cells*num_cell_vertices,
+                                                  compress);
   for (std::size_t offsets = 1; offsets <= num_cells; offsets++)
-    *offset_entry++ = offsets*num_cell_vertices;
-
-  // Create encoded stream
-  file << encode_stream(offset_data, compress) << std::endl;
+    offset_data.add(offsets*num_cell_vertices);
+  offset_data.finish();
+  file << std::endl;
   file << "</DataArray>" << std::endl;
 
   // Write cell type
   file << "<DataArray  type=\"UInt8\"  Name=\"types\"  format=\"" << "binary"
        << "\">" << std::endl;
-  std::vector<boost::uint8_t> type_data(num_cells);
-  std::vector<boost::uint8_t>::iterator type_entry = type_data.begin();
+  EncodedArrayWriter<boost::uint8_t> type_data(file, num_cells, compress);
   for (std::size_t types = 0; types < num_cells; types++)
-    *type_entry++ = _vtk_cell_type;
-
-  // Create encoded stream
-  file << encode_stream(type_data, compress) << std::endl;
+    type_data.add(_vtk_cell_type);
+  type_data.finish();
+  file << std::endl;
 
   file  << "</DataArray>" << std::endl;
   file  << "</Cells>" << std::endl;
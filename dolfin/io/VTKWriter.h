@@ -21,9 +21,13 @@
 #ifndef __VTK_WRITER_H
 #define __VTK_WRITER_H
 
+#include <memory>
+#include <ostream>
 #include <string>
 #include <vector>
 #include <boost/cstdint.hpp>
+#include <dolfin/log/log.h>
+#include <dolfin/parameter/GlobalParameters.h>
 #include "Encoder.h"
 
 namespace dolfin
@@ -45,26 +49,81 @@ namespace dolfin
     static void write_cell_data(const Function& u, std::string file,
                                 bool binary, bool compress);
 
-    // Form (compressed) base64 encoded string for VTK
-    template<typename T>
-    static std::string encode_stream(const std::vector<T>& data,
-                                     bool compress);
   //friend class VTKFile;
 
+    // Writer of (compressed) base64 encoded array for VTK to a file
+    // stream. Values are added one by one and are encoded (and
+    // compressed) in chunks of fixed size, so the memory used does
+    // not depend on the size of the array. Values that are not added
+    // before finish() are written as zero. Uncompressed output is a
+    // single base64 block with its size as header. Compressed output
+    // uses the multi-block format of VTK, with blocks compressed in
+    // parallel by the number of threads given by the global parameter
+    // "num_threads". The header of compressed output is written when
+    // the array is finished, which requires that the stream is
+    // seekable.
+    template<typename T>
+    class EncodedArrayWriter
+    {
+    public:
+
+      // Create writer for array with given number of values
+      EncodedArrayWriter(std::ostream& stream, std::size_t size,
+                         bool compress);
+
+      // Add value
+      void add(T value)
+      {
+        _chunk.push_back(value);
+        if (_chunk.size() == _chunk.capacity())
+          write_chunk();
+      }
+
+      // Write remaining values (padded with zeros) and header
+      void finish();
+
+    private:
+
+      // Encode values in chunk
+      void write_chunk();
+
+      #ifdef HAS_ZLIB
+      // Write header of compressed array, with number of blocks,
+      // block size, size of last block and compressed size of each
+      // block
+      void write_compressed_header(const std::vector<std::size_t>&
+                                   compressed_sizes);
+
+      // Uncompressed size of blocks of compressed output (as VTK)
+      static const std::size_t block_size = 32768;
+      #endif
+
+      std::ostream& _stream;
+      const std::size_t _size;
+      std::size_t _num_values;
+      std::vector<T> _chunk;
+      Encoder::Base64Stream _base64;
+      #ifdef HAS_ZLIB
+      std::unique_ptr<Encoder::ZlibBlockStream> _zlib;
+      std::streampos _header_position;
+      #endif
+
+    };
+
   private:
 
     // Write cell data (ascii)
-    static std::string ascii_cell_data(const Mesh& mesh,
-                                       const std::vector<std::size_t>& offset,
-                                       const std::vector<double>& values,
-                                       std::size_t dim, std::size_t rank);
+    static void ascii_cell_data(std::ostream& stream, const Mesh& mesh,
+                                const std::vector<std::size_t>& offset,
+                                const std::vector<double>& values,
+                                std::size_t dim, std::size_t rank);
 
     // Write cell data (base64)
-    static std::string base64_cell_data(const Mesh& mesh,
-                                        const std::vector<std::size_t>& offset,
-                                        const std::vector<double>& values,
-                                        std::size_t dim, std::size_t rank,
-                                        bool compress);
+    static void base64_cell_data(std::ostream& stream, const Mesh& mesh,
+                                 const std::vector<std::size_t>& offset,
+                                 const std::vector<double>& values,
+                                 std::size_t dim, std::size_t rank,
+                                 bool compress);
 
     // Mesh writer (ascii)
     static void write_ascii_mesh(const Mesh& mesh, std::size_t cell_dim,
@@ -77,76 +136,113 @@ namespace dolfin
     // Get VTK cell type
     static boost::uint8_t vtk_cell_type(const Mesh& mesh, std::size_t cell_dim);
 
-    // Compute base64 encoded stream for VTK
-    template<typename T>
-    static std::string encode_inline_base64(const std::vector<T>& data);
-
-    // Compute compressed base64 encoded stream for VTK
-    template<typename T>
-    static std::string encode_inline_compressed_base64(const std::vector<T>&
-                                                       data);
-
   };
 
   //--------------------------------------------------------------------------
   template<typename T>
-  std::string VTKWriter::encode_stream(const std::vector<T>& data,
-                                       bool compress)
+  VTKWriter::EncodedArrayWriter<T>::EncodedArrayWriter(std::ostream& stream,
+                                                        std::size_t size,
+                                                        bool compress)
+    : _stream(stream), _size(size), _num_values(0),
+      _base64(stream, std::max((int) parameters["num_threads"], 1))
   {
-    std::stringstream stream;
+    // Encode about 1 MB at a time
+    _chunk.reserve(std::max<std::size_t>(1, 1048576/sizeof(T)));
 
     if (compress)
     {
       #ifdef HAS_ZLIB
-      return encode_inline_compressed_base64(data);
+      // Write header with placeholder for compressed sizes, which
+      // has the same length when encoded
+      const std::size_t num_blocks
+        = (size*sizeof(T) + block_size - 1)/block_size;
+      _header_position = _stream.tellp();
+      write_compressed_header(std::vector<std::size_t>(num_blocks, 0));
+
+      const int num_threads = parameters["num_threads"];
+      _zlib.reset(new Encoder::ZlibBlockStream(_base64, block_size,
+                                               num_threads));
+      return;
       #else
       warning("zlib must be configured to enable compressed VTK output. Using uncompressed base64 encoding instead.");
-      return encode_inline_base64(data);
       #endif
     }
-    else
-      return encode_inline_base64(data);
+
+    // Write header with size of data
+    const boost::uint32_t num_bytes = size*sizeof(T);
+    Encoder::Base64Stream header(_stream);
+    header.write((const unsigned char*) &num_bytes, sizeof(num_bytes));
+    header.finish();
   }
   //--------------------------------------------------------------------------
   template<typename T>
-  std::string VTKWriter::encode_inline_base64(const std::vector<T>& data)
+  void VTKWriter::EncodedArrayWriter<T>::finish()
   {
-    std::stringstream stream;
+    // Pad with zeros
+    while (_num_values + _chunk.size() < _size)
+      add(T(0));
+    write_chunk();
+
+    if (_num_values != _size)
+    {
+      dolfin_error("VTKWriter.h",
+                   "write data to VTK file",
+                   "Number of values (%d) exceeds size of array (%d)",
+                   _num_values, _size);
+    }
 
-    const boost::uint32_t size = data.size()*sizeof(T);
-    Encoder::encode_base64(&size, 1, stream);
-    Encoder::encode_base64(data, stream);
+    #ifdef HAS_ZLIB
+    if (_zlib)
+    {
+      _zlib->finish();
+      _base64.finish();
+
+      // Write compressed size to header and return to end of stream
+      const std::streampos end_position = _stream.tellp();
+      _stream.seekp(_header_position);
+      write_compressed_header(_zlib->compressed_sizes());
+      _stream.seekp(end_position);
+      return;
+    }
+    #endif
 
-    return stream.str();
+    _base64.finish();
   }
   //--------------------------------------------------------------------------
-  #ifdef HAS_ZLIB
   template<typename T>
-  std::string VTKWriter::encode_inline_compressed_base64(const std::vector<T>&
-                                                         data)
+  void VTKWriter::EncodedArrayWriter<T>::write_chunk()
   {
-    std::stringstream stream;
-
-    boost::uint32_t header[4];
-    header[0] = 1;
-    header[1] = data.size()*sizeof(T);
-    header[2] = 0;
-
-    // Compress data
-    std::pair<boost::shared_array<unsigned char>, std::size_t>
-      compressed_data = Encoder::compress_data(data);
-
-    // Length of compressed data
-    header[3] = compressed_data.second;
-
-    // Encode header
-    Encoder::encode_base64(&header[0], 4, stream);
-
-    // Encode data
-    Encoder::encode_base64(compressed_data.first.get(),
-                           compressed_data.second, stream);
+    const unsigned char* data = (const unsigned char*) _chunk.data();
+    const std::size_t num_bytes = _chunk.size()*sizeof(T);
+    #ifdef HAS_ZLIB
+    if (_zlib)
+      _zlib->write(data, num_bytes);
+    else
+      _base64.write(data, num_bytes);
+    #else
+    _base64.write(data, num_bytes);
+    #endif
 
-    return stream.str();
+    _num_values += _chunk.size();
+    _chunk.clear();
+  }
+  //--------------------------------------------------------------------------
+  #ifdef HAS_ZLIB
+  template<typename T>
+  void VTKWriter::EncodedArrayWriter<T>::write_compressed_header(
+    const std::vector<std::size_t>& compressed_sizes)
+  {
+    std::vector<boost::uint32_t> header(3 + compressed_sizes.size());
+    header[0] = compressed_sizes.size();
+    header[1] = block_size;
+    header[2] = (_size*sizeof(T)) % block_size;
+    std::copy(compressed_sizes.begin(), compressed_sizes.end(),
+              header.begin() + 3);
+
+    Encoder::Base64Stream stream(_stream);
+    stream.write((const unsigned char*) header.data(),
+                 header.size()*sizeof(boost::uint32_t));
+    stream.finish();
   }
   #endif
   //--------------------------------------------------------------------------
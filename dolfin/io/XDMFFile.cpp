@@ -70,6 +70,11 @@ XDMFFile::XDMFFile(MPI_Comm comm, const std::string filename)
   // HDF5 file restart interval. Use 0 to collect all output in one file.
   parameters.add("multi_file", 0);
 
+  // Write the mesh of a time series once, append values to a single
+  // dataset and extend the XDMF file at each time step. The mesh and
+  // Function space must remain constant.
+  parameters.add("incremental_time_series", false);
+
 }
 //----------------------------------------------------------------------------
 XDMFFile::~XDMFFile()
@@ -211,6 +216,13 @@ void XDMFFile::operator<< (const Function& u)
 void XDMFFile::operator<< (const std::pair<const Function*, double> ut)
 {
   const int mf_interval = parameters["multi_file"];
+  const bool incremental = parameters["incremental_time_series"];
+  if (incremental && mf_interval != 0)
+  {
+    dolfin_error("XDMFFile.cpp",
+                 "write Function to XDMF file",
+                 "Parameters \"incremental_time_series\" and \"multi_file\" cannot be combined");
+  }
 
   // Conditions for starting a new HDF5 file
   if ( (mf_interval != 0 and counter%mf_interval == 0) or hdf5_filemode != "w" )
@@ -239,6 +251,20 @@ void XDMFFile::operator<< (const std::pair<const Function*, double> ut)
   dolfin_assert(ut.first);
   const Function& u = *(ut.first);
 
+  // An incremental time series holds a single Function
+  if (incremental)
+  {
+    if (counter == 0)
+      incremental_function_name = u.name();
+    else if (u.name() != incremental_function_name)
+    {
+      dolfin_error("XDMFFile.cpp",
+                   "write Function to XDMF file",
+                   "Incremental time series holds Function \"%s\", cannot write Function \"%s\"",
+                   incremental_function_name.c_str(), u.name().c_str());
+    }
+  }
+
   dolfin_assert(u.function_space()->mesh());
   const Mesh& mesh = *u.function_space()->mesh();
   const std::size_t degree = mesh.geometry().degree();
@@ -356,7 +382,7 @@ void XDMFFile::operator<< (const std::pair<const Function*, double> ut)
   // FIXME: Below is messy. Should query HDF5 file writer for existing
   //        mesh name
   // Write mesh to HDF5 file
-  if (parameters["rewrite_function_mesh"] || counter == 0)
+  if ((parameters["rewrite_function_mesh"] && !incremental) || counter == 0)
   {
     const std::string h5_mesh_name = "/Mesh/" + std::to_string(counter);
     boost::filesystem::path p(hdf5_filename);
@@ -391,11 +417,20 @@ void XDMFFile::operator<< (const std::pair<const Function*, double> ut)
 
   // Save data values to HDF5 file.  Vertex/cell values are saved in
   // the hdf5 group /VisualisationVector as distinct from /Vector
-  // which is used for solution vectors.
-  const std::string dataset_name = "/VisualisationVector/"
-    + std::to_string(counter);
-
-  hdf5_file->write_data(dataset_name, data_values, global_size, mpi_io);
+  // which is used for solution vectors. Incremental time series are
+  // saved as steps of a single dataset named after the Function.
+  const std::string step_dataset_name = "/VisualisationVector/" + u.name();
+  if (incremental)
+  {
+    hdf5_file->write_data_step(step_dataset_name, data_values, global_size,
+                               counter, mpi_io);
+  }
+  else
+  {
+    const std::string dataset_name = "/VisualisationVector/"
+      + std::to_string(counter);
+    hdf5_file->write_data(dataset_name, data_values, global_size, mpi_io);
+  }
 
   // Flush file. Improves chances of recovering data if
   // interrupted. Also makes file somewhat readable between writes.
@@ -405,7 +440,25 @@ void XDMFFile::operator<< (const std::pair<const Function*, double> ut)
   // Write the XML meta description (see http://www.xdmf.org) on
   // process zero
 
-  if (MPI::rank(mesh.mpi_comm()) == 0)
+  if (MPI::rank(mesh.mpi_comm()) == 0 && incremental)
+  {
+    // Append time step to XDMF file
+    if (!timestep_xml)
+      timestep_xml.reset(new XDMFxml(_filename));
+    timestep_xml->init_timestep(time_step);
+    timestep_xml->mesh_topology(mesh.type().cell_type(), degree,
+                                num_global_cells, current_mesh_name);
+    timestep_xml->mesh_geometry(num_global_points, gdim, current_mesh_name);
+
+    boost::filesystem::path p(hdf5_filename);
+    timestep_xml->data_attribute_step(u.name(), value_rank, vertex_data,
+                                      num_global_points, num_global_cells,
+                                      padded_value_size, counter,
+                                      p.filename().string()
+                                      + ":" + step_dataset_name);
+    timestep_xml->append_timestep();
+  }
+  else if (MPI::rank(mesh.mpi_comm()) == 0)
   {
     XDMFxml xml(_filename);
     xml.init_timeseries(u.name(), time_step, counter);
@@ -417,7 +470,8 @@ void XDMFFile::operator<< (const std::pair<const Function*, double> ut)
     xml.data_attribute(u.name(), value_rank, vertex_data,
                        num_global_points, num_global_cells,
                        padded_value_size,
-                       p.filename().string() + ":" + dataset_name);
+                       p.filename().string() + ":/VisualisationVector/"
+                       + std::to_string(counter));
     xml.write();
   }
 
@@ -40,6 +40,7 @@ namespace dolfin
   class Mesh;
   template<typename T> class MeshFunction;
   class Point;
+  class XDMFxml;
 
   /// This class supports the output of meshes and functions in XDMF
   /// (http://www.xdmf.org) format. It creates an XML file that describes
@@ -48,6 +49,18 @@ namespace dolfin
   ///
   /// XDMF is not suitable for checkpointing as it may decimate
   /// some data.
+  ///
+  /// If the parameter "incremental_time_series" is set, a time
+  /// series of a Function on a constant mesh is written with the
+  /// mesh stored once, the values of all time steps appended to a
+  /// single extensible HDF5 dataset and the XDMF file extended at
+  /// each time step rather than regenerated. The cost of writing a
+  /// time step then depends on the size of the Function only.
+  /// The dataset is named /VisualisationVector/<name> after the
+  /// Function, and writing a Function with a different name to the
+  /// same series is an error. Each time step refers to the steps
+  /// written so far, so readers must select values through the
+  /// HyperSlab rather than the extent of the HDF5 dataset.
 
   class XDMFFile : public GenericFile, public Variable
   {
@@ -133,6 +146,12 @@ namespace dolfin
 
     // Most recent mesh name
     std::string current_mesh_name;
+
+    // XML of incrementally written time series (process zero)
+    std::unique_ptr<XDMFxml> timestep_xml;
+
+    // Name of the Function in an incremental time series
+    std::string incremental_function_name;
   };
 }
 #endif
@@ -17,6 +17,8 @@
 
 #ifdef HAS_HDF5
 
+#include <fstream>
+#include <sstream>
 #include <string>
 #include <vector>
 #include <boost/algorithm/string.hpp>
@@ -28,7 +30,7 @@
 using namespace dolfin;
 
 //----------------------------------------------------------------------------
-XDMFxml::XDMFxml(std::string filename): _filename(filename)
+XDMFxml::XDMFxml(std::string filename): _filename(filename), _timestep_end(-1)
 {
   // Do nothing
 }
@@ -154,6 +156,65 @@ void XDMFxml::data_attribute(std::string name,
                              std::size_t num_global_cells,
                              std::size_t padded_value_size,
                              std::string dataset_name)
+{
+  pugi::xml_node xdmf_values = attribute(name, value_rank, vertex_data,
+                                         padded_value_size);
+
+  pugi::xml_node xdmf_data = xdmf_values.append_child("DataItem");
+  xdmf_data.append_attribute("Format") = "HDF";
+
+  const std::size_t num_total_entities
+    = (vertex_data ? num_total_vertices : num_global_cells);
+  const std::string s = std::to_string(num_total_entities) + " "
+    + std::to_string(padded_value_size);
+  xdmf_data.append_attribute("Dimensions") = s.c_str();
+
+  xdmf_data.append_child(pugi::node_pcdata).set_value(dataset_name.c_str());
+}
+//-----------------------------------------------------------------------------
+void XDMFxml::data_attribute_step(std::string name,
+                                  std::size_t value_rank,
+                                  bool vertex_data,
+                                  std::size_t num_total_vertices,
+                                  std::size_t num_global_cells,
+                                  std::size_t padded_value_size,
+                                  std::size_t step,
+                                  std::string dataset_name)
+{
+  pugi::xml_node xdmf_values = attribute(name, value_rank, vertex_data,
+                                         padded_value_size);
+
+  const std::size_t num_total_entities
+    = (vertex_data ? num_total_vertices : num_global_cells);
+  const std::string entity_dims = std::to_string(num_total_entities) + " "
+    + std::to_string(padded_value_size);
+
+  // Select step from dataset with a hyperslab
+  pugi::xml_node xdmf_slab = xdmf_values.append_child("DataItem");
+  xdmf_slab.append_attribute("ItemType") = "HyperSlab";
+  xdmf_slab.append_attribute("Dimensions") = entity_dims.c_str();
+
+  // Start, stride and count of hyperslab
+  pugi::xml_node xdmf_select = xdmf_slab.append_child("DataItem");
+  xdmf_select.append_attribute("Format") = "XML";
+  xdmf_select.append_attribute("Dimensions") = "3 3";
+  const std::string selection = std::to_string(step) + " 0 0 1 1 1 1 "
+    + entity_dims;
+  xdmf_select.append_child(pugi::node_pcdata).set_value(selection.c_str());
+
+  // The dataset is extended at each step, so refer to the steps
+  // written so far. Earlier time steps are not rewritten and keep a
+  // smaller extent, so readers must honour the hyperslab only.
+  pugi::xml_node xdmf_data = xdmf_slab.append_child("DataItem");
+  xdmf_data.append_attribute("Format") = "HDF";
+  const std::string s = std::to_string(step + 1) + " " + entity_dims;
+  xdmf_data.append_attribute("Dimensions") = s.c_str();
+  xdmf_data.append_child(pugi::node_pcdata).set_value(dataset_name.c_str());
+}
+//-----------------------------------------------------------------------------
+pugi::xml_node XDMFxml::attribute(std::string name, std::size_t value_rank,
+                                  bool vertex_data,
+                                  std::size_t padded_value_size)
 {
   // Grid/Attribute (Function value data)
   pugi::xml_node xdmf_values = xdmf_grid.append_child("Attribute");
@@ -169,16 +230,7 @@ void XDMFxml::data_attribute(std::string name,
 
   xdmf_values.append_attribute("Center") = (vertex_data ? "Node" : "Cell");
 
-  pugi::xml_node xdmf_data = xdmf_values.append_child("DataItem");
-  xdmf_data.append_attribute("Format") = "HDF";
-
-  const std::size_t num_total_entities
-    = (vertex_data ? num_total_vertices : num_global_cells);
-  const std::string s = std::to_string(num_total_entities) + " "
-    + std::to_string(padded_value_size);
-  xdmf_data.append_attribute("Dimensions") = s.c_str();
-
-  xdmf_data.append_child(pugi::node_pcdata).set_value(dataset_name.c_str());
+  return xdmf_values;
 }
 //-----------------------------------------------------------------------------
 pugi::xml_node XDMFxml::init_mesh(std::string name)
@@ -291,6 +343,74 @@ pugi::xml_node XDMFxml::init_timeseries(std::string name, double time_step,
    return xdmf_grid;
  }
 //-----------------------------------------------------------------------------
+pugi::xml_node XDMFxml::init_timestep(double time_step)
+{
+  // The document holds the grid of this time step only
+  xml_doc.reset();
+
+  //   /Xdmf/Domain/Grid/Grid - the actual data for this timestep
+  xdmf_grid = xml_doc.append_child("Grid");
+  xdmf_grid.append_attribute("Name") = "grid";
+  xdmf_grid.append_attribute("GridType") = "Uniform";
+
+  // Grid/Time
+  const std::string timestep_str
+    = boost::str((boost::format("%g") % time_step));
+  xdmf_grid.append_child("Time").append_attribute("Value")
+    = timestep_str.c_str();
+
+  // Grid/Topology and Grid/Geometry
+  xdmf_grid.append_child("Topology");
+  xdmf_grid.append_child("Geometry");
+
+  return xdmf_grid;
+}
+//-----------------------------------------------------------------------------
+void XDMFxml::append_timestep()
+{
+  dolfin_assert(xdmf_grid);
+
+  // Closing tags of TimeSeries grid, Domain and Xdmf
+  const std::string footer = "    </Grid>\n  </Domain>\n</Xdmf>\n";
+
+  if (_timestep_end < 0)
+  {
+    // Create file with header and empty TimeSeries
+    std::ofstream file(_filename.c_str(), std::ios::out | std::ios::trunc);
+    file << "<?xml version=\"1.0\"?>\n"
+         << "<!DOCTYPE Xdmf SYSTEM \"Xdmf.dtd\" []>\n"
+         << "<Xdmf Version=\"2.0\" xmlns:xi=\"http://www.w3.org/2001/XInclude\">\n"
+         << "  <Domain>\n"
+         << "    <Grid Name=\"TimeSeries\" GridType=\"Collection\" CollectionType=\"Temporal\">\n";
+    _timestep_end = file.tellp();
+    file << footer;
+    if (!file)
+    {
+      dolfin_error("XDMFxml.cpp",
+                   "write data to XDMF file",
+                   "Unable to create file \"%s\"", _filename.c_str());
+    }
+  }
+
+  // Grid of time step, indented to its depth in the document
+  std::ostringstream grid;
+  xdmf_grid.print(grid, "  ", pugi::format_default, pugi::encoding_auto, 3);
+  const std::string grid_str = grid.str();
+
+  // Overwrite closing tags with grid and closing tags
+  std::fstream file(_filename.c_str(), std::ios::in | std::ios::out);
+  file.seekp(_timestep_end);
+  file << grid_str << footer;
+  if (!file)
+  {
+    dolfin_error("XDMFxml.cpp",
+                 "write data to XDMF file",
+                 "Unable to append time step to file \"%s\"",
+                 _filename.c_str());
+  }
+  _timestep_end += grid_str.size();
+}
+//-----------------------------------------------------------------------------
 void XDMFxml::mesh_topology(const CellType::Type cell_type,
                             const std::size_t cell_order,
                             const std::size_t num_global_cells,
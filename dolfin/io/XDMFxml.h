@@ -21,6 +21,7 @@
 
 #ifdef HAS_HDF5
 
+#include <ios>
 #include <string>
 #include <vector>
 #include <dolfin/mesh/CellType.h>
@@ -66,6 +67,18 @@ namespace dolfin
                         std::size_t padded_value_size,
                         std::string dataset_name);
 
+    /// Add a data item to the current grid, referring to a step of
+    /// an extensible dataset with steps as first dimension. The
+    /// extent given for the dataset is that at the time of writing
+    void data_attribute_step(std::string name,
+                             std::size_t value_rank,
+                             bool vertex_data,
+                             std::size_t num_total_vertices,
+                             std::size_t num_global_cells,
+                             std::size_t padded_value_size,
+                             std::size_t step,
+                             std::string dataset_name);
+
     /// Initalise XML for a Mesh-like single output
     /// returning the xdmf_grid node
     pugi::xml_node init_mesh(std::string name);
@@ -75,6 +88,16 @@ namespace dolfin
     pugi::xml_node init_timeseries(std::string name, double time_step,
                                    std::size_t counter);
 
+    /// Initialise XML for a single time step of a TimeSeries that is
+    /// written incrementally with append_timestep(), returning the
+    /// xdmf_grid node
+    pugi::xml_node init_timestep(double time_step);
+
+    /// Append grid of current time step to file. The file is created
+    /// by the first call, and later time steps are inserted before
+    /// the closing tags without reading or rewriting previous steps.
+    void append_timestep();
+
     /// Attach topology to the current grid node
     void mesh_topology(const CellType::Type cell_type,
                        const std::size_t cell_order,
@@ -91,6 +114,10 @@ namespace dolfin
     // Generate the XML header generic to all files
     void header();
 
+    // Add Attribute node (without data item) to the current grid
+    pugi::xml_node attribute(std::string name, std::size_t value_rank,
+                             bool vertex_data, std::size_t padded_value_size);
+
     // The XML document
     pugi::xml_document xml_doc;
 
@@ -99,6 +126,10 @@ namespace dolfin
 
     // Filename
     std::string _filename;
+
+    // Position of closing tags in file written by append_timestep()
+    // (negative if the file has not been created)
+    std::streamoff _timestep_end;
   };
 }
 #endif
@@ -43,6 +43,7 @@
 #include <dolfin/mesh/Mesh.h>
 #include <dolfin/mesh/MeshPartitioning.h>
 #include <dolfin/parameter/GlobalParameters.h>
+#include "HDF5File.h"
 #include "XMLFunctionData.h"
 #include "XMLMesh.h"
 #include "XMLMeshFunction.h"
@@ -75,7 +76,8 @@ XMLFile::~XMLFile()
 //-----------------------------------------------------------------------------
 void XMLFile::operator>> (Mesh& input_mesh)
 {
-  if (MPI::rank(input_mesh.mpi_comm()) == 0)
+  const MPI_Comm mpi_comm = input_mesh.mpi_comm();
+  if (MPI::size(mpi_comm) == 1)
   {
     // Create XML doc and get DOLFIN node
     pugi::xml_document xml_doc;
@@ -84,28 +86,72 @@ void XMLFile::operator>> (Mesh& input_mesh)
 
     // Read mesh
     XMLMesh::read(input_mesh, dolfin_node);
+    return;
   }
 
-  if (MPI::size(input_mesh.mpi_comm()) > 1)
+  // Read mesh in parallel from cache, if valid
+  #ifdef HAS_HDF5
+  const bool use_cache = dolfin::parameters["xml_mesh_cache"];
+  const std::string cache_filename = _filename + ".h5";
+  if (use_cache)
   {
-    // Distribute local data
-    input_mesh.domains().clear();
-    LocalMeshData local_mesh_data(input_mesh);
+    // Check cache on process 0 only, such that all processes agree
+    std::vector<std::size_t> cache_valid(1, 0);
+    if (MPI::rank(mpi_comm) == 0)
+    {
+      // Require the cache to be strictly newer than the XML file,
+      // since an XML file rewritten within the resolution of the
+      // modification time (1 s) must not be read from an old cache
+      boost::system::error_code xml_ec, cache_ec;
+      const std::time_t xml_time
+        = boost::filesystem::last_write_time(_filename, xml_ec);
+      const std::time_t cache_time
+        = boost::filesystem::last_write_time(cache_filename, cache_ec);
+      cache_valid[0] = (!xml_ec && !cache_ec && cache_time > xml_time) ? 1 : 0;
+    }
+    MPI::broadcast(mpi_comm, cache_valid);
 
-    // FIXME: To be removed when advanced parallel XML IO is removed
-    // Add mesh domain data
-    if (MPI::rank(input_mesh.mpi_comm()) == 0)
+    if (cache_valid[0])
     {
-      // Create XML doc and get DOLFIN node
-      pugi::xml_document xml_doc;
-      load_xml_doc(xml_doc);
-      pugi::xml_node dolfin_node = get_dolfin_xml_node(xml_doc);
-      XMLMesh::read_domain_data(local_mesh_data, dolfin_node);
+      HDF5File cache(mpi_comm, cache_filename, "r");
+      if (cache.has_dataset("/mesh"))
+      {
+        cache.read(input_mesh, "/mesh", false);
+        return;
+      }
     }
+  }
+  #endif
 
-    // Partition and build mesh
-    MeshPartitioning::build_distributed_mesh(input_mesh, local_mesh_data);
+  // Read vertices and cells on process 0 (without building a Mesh)
+  // and distribute blocks to all processes
+  LocalMeshData local_mesh_data(mpi_comm);
+  if (MPI::rank(mpi_comm) == 0)
+  {
+    // Create XML doc and get DOLFIN node
+    pugi::xml_document xml_doc;
+    load_xml_doc(xml_doc);
+    pugi::xml_node dolfin_node = get_dolfin_xml_node(xml_doc);
+    XMLMesh::read_local_mesh_data(local_mesh_data, dolfin_node);
+
+    // Domain data is kept on process 0 and distributed by
+    // MeshPartitioning
+    local_mesh_data.broadcast_mesh_data(mpi_comm);
+  }
+  else
+    local_mesh_data.receive_mesh_data(mpi_comm);
+
+  // Partition and build mesh
+  MeshPartitioning::build_distributed_mesh(input_mesh, local_mesh_data);
+
+  // Write cache for later reads
+  #ifdef HAS_HDF5
+  if (use_cache)
+  {
+    HDF5File cache(mpi_comm, cache_filename, "w");
+    cache.write(input_mesh, "/mesh");
   }
+  #endif
 }
 //-----------------------------------------------------------------------------
 void XMLFile::operator<< (const Mesh& output_mesh)
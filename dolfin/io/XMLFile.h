@@ -62,7 +62,13 @@ namespace dolfin
 
     ~XMLFile();
 
-    // Mesh
+    // Mesh. In parallel, the XML file is parsed on process 0, which
+    // holds the vertices and cells of the whole mesh before they are
+    // distributed, so reading large meshes from XML does not scale.
+    // If the parameter "xml_mesh_cache" is set, the mesh is also
+    // written to a HDF5 cache which later reads use in parallel
+    // (while it is newer than the XML file), but the first read
+    // still parses the whole file on process 0.
     void operator>> (Mesh& input);
     void operator<< (const Mesh& output);
 
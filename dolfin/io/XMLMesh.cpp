@@ -26,6 +26,7 @@
 #include <iostream>
 #include <string>
 #include <vector>
+#include <boost/container/flat_map.hpp>
 #include <boost/format.hpp>
 
 #include "pugixml.hpp"
@@ -290,33 +291,122 @@ void XMLMesh::read_domains(MeshDomains& domains, const Mesh& mesh,
     XMLMeshValueCollection::read(mvc, type, *it);
 
     // Get mesh value collection data
-    const std::map<std::pair<std::size_t, std::size_t>, std::size_t>&
-      values = mvc.values();
+    const boost::container::flat_map<std::pair<std::size_t, std::size_t>,
+                                     std::size_t>& values = mvc.values();
 
     // Get mesh domain data and fill
-    std::map<std::size_t, std::size_t>& markers
-      = domains.markers(dim);
-    std::map<std::pair<std::size_t, std::size_t>,
-             std::size_t>::const_iterator entry;
+    std::vector<std::size_t> entities, markers;
+    entities.reserve(values.size());
+    markers.reserve(values.size());
+    boost::container::flat_map<std::pair<std::size_t, std::size_t>,
+                               std::size_t>::const_iterator entry;
     if (dim != mesh.topology().dim())
     {
       for (entry = values.begin(); entry != values.end(); ++entry)
       {
         const Cell cell(mesh, entry->first.first);
-        const std::size_t entity_index
-          = cell.entities(dim)[entry->first.second];
-        markers[entity_index] = entry->second;
+        entities.push_back(cell.entities(dim)[entry->first.second]);
+        markers.push_back(entry->second);
       }
     }
     else
     {
       // Special case for cells
       for (entry = values.begin(); entry != values.end(); ++entry)
-        markers[entry->first.first] = entry->second;
+      {
+        entities.push_back(entry->first.first);
+        markers.push_back(entry->second);
+      }
     }
+    domains.set_markers(entities, markers, dim);
   }
 }
 //-----------------------------------------------------------------------------
+void XMLMesh::read_local_mesh_data(LocalMeshData& mesh_data,
+                                   const pugi::xml_node xml_dolfin)
+{
+  // Get mesh node
+  const pugi::xml_node mesh_node = xml_dolfin.child("mesh");
+  if (!mesh_node)
+  {
+    dolfin_error("XMLMesh.cpp",
+                 "read mesh from XML file",
+                 "Not a DOLFIN XML Mesh file");
+  }
+
+  // Clear old data
+  mesh_data.clear();
+
+  // Get cell type and geometric dimension
+  const std::string cell_type_str = mesh_node.attribute("celltype").value();
+  std::unique_ptr<CellType> cell_type(CellType::create(cell_type_str));
+  mesh_data.gdim = mesh_node.attribute("dim").as_uint();
+  mesh_data.tdim = cell_type->dim();
+  mesh_data.cell_type = cell_type->cell_type();
+  mesh_data.num_vertices_per_cell = cell_type->num_vertices(mesh_data.tdim);
+
+  // Get vertices xml node
+  pugi::xml_node xml_vertices = mesh_node.child("vertices");
+  dolfin_assert(xml_vertices);
+
+  // Read vertex coordinates, stored by vertex index
+  const std::size_t num_vertices = xml_vertices.attribute("size").as_uint();
+  mesh_data.num_global_vertices = num_vertices;
+  mesh_data.vertex_coordinates.resize(boost::extents[num_vertices][mesh_data.gdim]);
+  static const char* coordinate_names[3] = {"x", "y", "z"};
+  for (pugi::xml_node_iterator it = xml_vertices.begin();
+       it != xml_vertices.end(); ++it)
+  {
+    const std::size_t index = it->attribute("index").as_uint();
+    dolfin_assert(index < num_vertices);
+    for (std::size_t i = 0; i < mesh_data.gdim; ++i)
+    {
+      mesh_data.vertex_coordinates[index][i]
+        = it->attribute(coordinate_names[i]).as_double();
+    }
+  }
+
+  // Global vertex indices
+  mesh_data.vertex_indices.resize(num_vertices);
+  for (std::size_t i = 0; i < num_vertices; ++i)
+    mesh_data.vertex_indices[i] = i;
+
+  // Get cells node
+  pugi::xml_node xml_cells = mesh_node.child("cells");
+  dolfin_assert(xml_cells);
+
+  // Read cell vertices, stored by cell index
+  const std::size_t num_cells = xml_cells.attribute("size").as_uint();
+  const std::size_t num_vertices_per_cell = mesh_data.num_vertices_per_cell;
+  mesh_data.num_global_cells = num_cells;
+  mesh_data.cell_vertices.resize(boost::extents[num_cells][num_vertices_per_cell]);
+
+  // Create list of vertex index attribute names
+  std::vector<std::string> v_str(num_vertices_per_cell);
+  for (std::size_t i = 0; i < num_vertices_per_cell; ++i)
+    v_str[i] = "v" + std::to_string(i);
+
+  for (pugi::xml_node_iterator it = xml_cells.begin(); it != xml_cells.end();
+       ++it)
+  {
+    const std::size_t index = it->attribute("index").as_uint();
+    dolfin_assert(index < num_cells);
+    for (std::size_t i = 0; i < num_vertices_per_cell; ++i)
+    {
+      mesh_data.cell_vertices[index][i]
+        = it->attribute(v_str[i].c_str()).as_uint();
+    }
+  }
+
+  // Global cell indices
+  mesh_data.global_cell_indices.resize(num_cells);
+  for (std::size_t i = 0; i < num_cells; ++i)
+    mesh_data.global_cell_indices[i] = i;
+
+  // Read domain data (if any)
+  read_domain_data(mesh_data, xml_dolfin);
+}
+//-----------------------------------------------------------------------------
 void XMLMesh::read_domain_data(LocalMeshData& mesh_data,
                                const pugi::xml_node xml_dolfin)
 {
@@ -564,12 +654,20 @@ void XMLMesh::write_domains(const Mesh& mesh, const MeshDomains& domains,
   {
     if (!domains.markers(d).empty())
     {
-      const std::map<std::size_t, std::size_t>& domain = domains.markers(d);
+      const boost::container::flat_map<std::size_t, std::size_t>& domain
+        = domains.markers(d);
 
-      MeshValueCollection<std::size_t> collection(mesh, d);
-      std::map<std::size_t, std::size_t>::const_iterator it;
+      std::vector<std::size_t> entities, values;
+      entities.reserve(domain.size());
+      values.reserve(domain.size());
+      boost::container::flat_map<std::size_t, std::size_t>::const_iterator it;
       for (it = domain.begin(); it != domain.end(); ++it)
-        collection.set_value(it->first, it->second);
+      {
+        entities.push_back(it->first);
+        values.push_back(it->second);
+      }
+      MeshValueCollection<std::size_t> collection(mesh, d);
+      collection.set_values(entities, values);
       XMLMeshValueCollection::write(collection, "uint", domains_node);
     }
   }
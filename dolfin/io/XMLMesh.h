@@ -68,6 +68,12 @@ namespace dolfin
 
   public:
 
+    /// Read vertices, cells and domain data of mesh from XML into
+    /// LocalMeshData (on one process, for distribution), without
+    /// building a Mesh
+    static void read_local_mesh_data(LocalMeshData& mesh_data,
+                                     const pugi::xml_node xml_dolfin);
+
     // FIXME: This is hack for domain data support via XML in
     // parallel.
     // Read domain data in LocalMeshData.
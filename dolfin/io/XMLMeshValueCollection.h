@@ -22,6 +22,8 @@
 #define __XML_MESH_VALUE_COLLECTION_H
 
 #include <string>
+#include <vector>
+#include <boost/container/flat_map.hpp>
 #include <dolfin/mesh/MeshValueCollection.h>
 #include "pugixml.hpp"
 #include "xmlutils.h"
@@ -83,6 +85,10 @@ namespace dolfin
     // Clear old values
     mesh_value_collection.clear();
 
+    // Values are collected and inserted in bulk
+    std::vector<std::size_t> cell_indices, local_entities;
+    std::vector<T> values;
+
     // Choose data type
     if (type == "uint")
     {
@@ -93,7 +99,9 @@ namespace dolfin
         const std::size_t local_entity
           = it->attribute("local_entity").as_uint();
         const std::size_t value = it->attribute("value").as_uint();
-        mesh_value_collection.set_value(cell_index, local_entity, value);
+        cell_indices.push_back(cell_index);
+        local_entities.push_back(local_entity);
+        values.push_back(value);
       }
     }
     else if (type == "int")
@@ -105,7 +113,9 @@ namespace dolfin
         const std::size_t local_entity
           = it->attribute("local_entity").as_uint();
         const int value = it->attribute("value").as_int();
-        mesh_value_collection.set_value(cell_index, local_entity, value);
+        cell_indices.push_back(cell_index);
+        local_entities.push_back(local_entity);
+        values.push_back(value);
       }
     }
     else if (type == "double")
@@ -117,7 +127,9 @@ namespace dolfin
         const std::size_t local_entity
           = it->attribute("local_entity").as_uint();
         const double value = it->attribute("value").as_double();
-        mesh_value_collection.set_value(cell_index, local_entity, value);
+        cell_indices.push_back(cell_index);
+        local_entities.push_back(local_entity);
+        values.push_back(value);
       }
     }
     else if (type == "bool")
@@ -129,7 +141,9 @@ namespace dolfin
         const std::size_t local_entity
           = it->attribute("local_entity").as_uint();
         const bool value = it->attribute("value").as_bool();
-        mesh_value_collection.set_value(cell_index, local_entity, value);
+        cell_indices.push_back(cell_index);
+        local_entities.push_back(local_entity);
+        values.push_back(value);
       }
     }
     else
@@ -138,6 +152,8 @@ namespace dolfin
                    "read mesh value collection from XML file",
                    "Unhandled value type \"%s\"", type.c_str());
     }
+
+    mesh_value_collection.set_values(cell_indices, local_entities, values);
   }
   //---------------------------------------------------------------------------
   template<typename T>
@@ -158,9 +174,9 @@ namespace dolfin
       = (unsigned int) mesh_value_collection.size();
 
     // Add data
-    const std::map<std::pair<std::size_t, std::size_t>, T>&
+    const boost::container::flat_map<std::pair<std::size_t, std::size_t>, T>&
       values = mesh_value_collection.values();
-    typename std::map<std::pair<std::size_t,
+    typename boost::container::flat_map<std::pair<std::size_t,
       std::size_t>, T>::const_iterator it;
     for (it = values.begin(); it != values.end(); ++it)
     {
@@ -23,6 +23,9 @@
 
    René Nyffenegger rene.nyffenegger@adp-gmbh.ch
 
+   Modified for DOLFIN 2016: encoding into a given buffer using a table
+   of pairs of characters (base64_encode with output buffer).
+
 */
 
 #include "base64.h"
@@ -38,47 +41,64 @@ static inline bool is_base64(unsigned char c) {
   return (isalnum(c) || (c == '+') || (c == '/'));
 }
 
-std::string base64_encode(unsigned char const* bytes_to_encode, unsigned int in_len) {
-  std::string ret;
-  int i = 0;
-  int j = 0;
-  unsigned char char_array_3[3];
-  unsigned char char_array_4[4];
-
-  while (in_len--) {
-    char_array_3[i++] = *(bytes_to_encode++);
-    if (i == 3) {
-      char_array_4[0] = (char_array_3[0] & 0xfc) >> 2;
-      char_array_4[1] = ((char_array_3[0] & 0x03) << 4) + ((char_array_3[1] & 0xf0) >> 4);
-      char_array_4[2] = ((char_array_3[1] & 0x0f) << 2) + ((char_array_3[2] & 0xc0) >> 6);
-      char_array_4[3] = char_array_3[2] & 0x3f;
-
-      for(i = 0; (i <4) ; i++)
-        ret += base64_chars[char_array_4[i]];
-      i = 0;
+namespace
+{
+  // Table of the two characters encoding each 12-bit value
+  struct Base64PairTable
+  {
+    Base64PairTable()
+    {
+      for (std::size_t i = 0; i < 4096; ++i)
+      {
+        pairs[2*i] = base64_chars[i >> 6];
+        pairs[2*i + 1] = base64_chars[i & 0x3f];
+      }
     }
-  }
+    char pairs[8192];
+  };
 
-  if (i)
+  const char* base64_pairs()
   {
-    for(j = i; j < 3; j++)
-      char_array_3[j] = '\0';
-
-    char_array_4[0] = (char_array_3[0] & 0xfc) >> 2;
-    char_array_4[1] = ((char_array_3[0] & 0x03) << 4) + ((char_array_3[1] & 0xf0) >> 4);
-    char_array_4[2] = ((char_array_3[1] & 0x0f) << 2) + ((char_array_3[2] & 0xc0) >> 6);
-    char_array_4[3] = char_array_3[2] & 0x3f;
-
-    for (j = 0; (j < i + 1); j++)
-      ret += base64_chars[char_array_4[j]];
+    static const Base64PairTable table;
+    return table.pairs;
+  }
+}
 
-    while((i++ < 3))
-      ret += '=';
+void base64_encode(unsigned char const* bytes_to_encode, std::size_t in_len,
+                   char* out) {
+  const char* pairs = base64_pairs();
+
+  // Encode groups of three bytes as two 12-bit values
+  const std::size_t num_groups = in_len/3;
+  for (std::size_t g = 0; g < num_groups; ++g) {
+    const unsigned char* in = bytes_to_encode + 3*g;
+    const unsigned int word = (in[0] << 16) | (in[1] << 8) | in[2];
+    const char* p0 = pairs + 2*(word >> 12);
+    const char* p1 = pairs + 2*(word & 0xfff);
+    out[0] = p0[0];
+    out[1] = p0[1];
+    out[2] = p1[0];
+    out[3] = p1[1];
+    out += 4;
+  }
 
+  // Encode remaining bytes with padding
+  const std::size_t rest = in_len - 3*num_groups;
+  if (rest > 0) {
+    const unsigned char* in = bytes_to_encode + 3*num_groups;
+    const unsigned int word = (in[0] << 16) | (rest == 2 ? in[1] << 8 : 0);
+    out[0] = base64_chars[word >> 18];
+    out[1] = base64_chars[(word >> 12) & 0x3f];
+    out[2] = rest == 2 ? base64_chars[(word >> 6) & 0x3f] : '=';
+    out[3] = '=';
   }
+}
 
+std::string base64_encode(unsigned char const* bytes_to_encode, unsigned int in_len) {
+  std::string ret(4*((in_len + 2)/3), '=');
+  if (!ret.empty())
+    base64_encode(bytes_to_encode, (std::size_t) in_len, &ret[0]);
   return ret;
-
 }
 
 std::string base64_decode(std::string const& encoded_string) {
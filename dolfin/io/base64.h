@@ -1,5 +1,7 @@
+#include <cstddef>
 #include <string>
 
 std::string base64_encode(unsigned char const* , unsigned int len);
+void base64_encode(unsigned char const* , std::size_t len, char* out);
 std::string base64_decode(std::string const& s);
 
@@ -15,6 +15,7 @@
 // You should have received a copy of the GNU Lesser General Public License
 // along with DOLFIN. If not, see <http://www.gnu.org/licenses/>.
 
+#include <algorithm>
 #include "EigenMatrix.h"
 #include "EigenFactory.h"
 
@@ -162,6 +163,52 @@ void EigenMatrix::add(const double* block, std::size_t m,
   }
 }
 //---------------------------------------------------------------------------
+void EigenMatrix::add_local_batch(
+  const double* blocks, std::size_t block_stride, std::size_t num_blocks,
+  const std::vector<std::vector<ArrayView<const dolfin::la_index> > >& rows)
+{
+  dolfin_assert(num_blocks <= rows.size());
+  for (std::size_t b = 0; b < num_blocks; ++b)
+  {
+    dolfin_assert(rows[b].size() == 2);
+    const ArrayView<const dolfin::la_index>& block_rows = rows[b][0];
+    const ArrayView<const dolfin::la_index>& block_cols = rows[b][1];
+    const std::size_t n = block_cols.size();
+    const double* block = blocks + b*block_stride;
+
+    for (std::size_t i = 0; i < block_rows.size(); ++i)
+    {
+      // Get sorted columns of row (storage may change when an entry
+      // is inserted below)
+      const dolfin::la_index row = block_rows[i];
+      const int* inner = _matA.innerIndexPtr();
+      const int* row_begin = inner + _matA.outerIndexPtr()[row];
+      const int* row_end = _matA.isCompressed()
+        ? inner + _matA.outerIndexPtr()[row + 1]
+        : row_begin + _matA.innerNonZeroPtr()[row];
+      double* values = _matA.valuePtr();
+
+      for (std::size_t j = 0; j < n; ++j)
+      {
+        const int* pos = std::lower_bound(row_begin, row_end, block_cols[j]);
+        if (pos != row_end && *pos == block_cols[j])
+          values[pos - inner] += block[i*n + j];
+        else
+        {
+          // Insert entry not in sparsity pattern and get storage again
+          _matA.coeffRef(row, block_cols[j]) += block[i*n + j];
+          inner = _matA.innerIndexPtr();
+          row_begin = inner + _matA.outerIndexPtr()[row];
+          row_end = _matA.isCompressed()
+            ? inner + _matA.outerIndexPtr()[row + 1]
+            : row_begin + _matA.innerNonZeroPtr()[row];
+          values = _matA.valuePtr();
+        }
+      }
+    }
+  }
+}
+//---------------------------------------------------------------------------
 void EigenMatrix::get(double* block, std::size_t m,
                       const dolfin::la_index* rows,
                       std::size_t n, const dolfin::la_index* cols) const
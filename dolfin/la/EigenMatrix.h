@@ -137,6 +137,14 @@ namespace dolfin
                            const dolfin::la_index* cols)
     { add(block, m, rows, n, cols); }
 
+    /// Add a batch of blocks of values using local indices. Entries
+    /// in the sparsity pattern are added directly to the values of
+    /// the compressed rows.
+    virtual void add_local_batch(
+      const double* blocks, std::size_t block_stride,
+      std::size_t num_blocks,
+      const std::vector<std::vector<ArrayView<const dolfin::la_index> > >& rows);
+
     /// Add multiple of given matrix (AXPY operation)
     virtual void axpy(double a, const GenericMatrix& A,
                       bool same_nonzero_pattern);
@@ -153,6 +153,22 @@ void EigenVector::add(const double* block, std::size_t m,
     (*_x)(rows[i]) += block[i];
 }
 //-----------------------------------------------------------------------------
+void EigenVector::add_local_batch(
+  const double* blocks, std::size_t block_stride, std::size_t num_blocks,
+  const std::vector<std::vector<ArrayView<const dolfin::la_index> > >& rows)
+{
+  dolfin_assert(num_blocks <= rows.size());
+  double* x = _x->data();
+  for (std::size_t b = 0; b < num_blocks; ++b)
+  {
+    dolfin_assert(rows[b].size() == 1);
+    const ArrayView<const dolfin::la_index>& block_rows = rows[b][0];
+    const double* block = blocks + b*block_stride;
+    for (std::size_t i = 0; i < block_rows.size(); ++i)
+      x[block_rows[i]] += block[i];
+  }
+}
+//-----------------------------------------------------------------------------
 void EigenVector::apply(std::string mode)
 {
   // Do nothing
@@ -183,6 +183,12 @@ namespace dolfin
                            const dolfin::la_index* rows)
     { add(block, m, rows); }
 
+    /// Add a batch of blocks of values using local indices
+    virtual void add_local_batch(
+      const double* blocks, std::size_t block_stride,
+      std::size_t num_blocks,
+      const std::vector<std::vector<ArrayView<const dolfin::la_index> > >& rows);
+
     /// Get all values on local process
     virtual void get_local(std::vector<double>& values) const;
 
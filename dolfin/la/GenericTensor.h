@@ -100,6 +100,21 @@ namespace dolfin
                            const dolfin::la_index* num_rows,
                            const dolfin::la_index * const * rows) = 0;
 
+    /// Add a batch of blocks of values using local indices. Block i
+    /// starts at blocks + i*block_stride and holds the values for
+    /// the indices in rows[i]. The default implementation adds the
+    /// blocks one at a time; backends may override it to insert the
+    /// whole batch at once.
+    virtual void add_local_batch(
+      const double* blocks, std::size_t block_stride,
+      std::size_t num_blocks,
+      const std::vector<std::vector<ArrayView<const dolfin::la_index> > >& rows)
+    {
+      dolfin_assert(num_blocks <= rows.size());
+      for (std::size_t i = 0; i < num_blocks; ++i)
+        add_local(blocks + i*block_stride, rows[i]);
+    }
+
     /// Set all entries to zero and keep any sparse structure
     virtual void zero() = 0;
 
@@ -108,10 +108,6 @@ void PETScMatrix::init(const TensorLayout& tensor_layout)
   // Initialize matrix
   if (dolfin::MPI::size(sparsity_pattern.mpi_comm()) == 1)
   {
-    // Get number of nonzeros for each row from sparsity pattern
-    std::vector<std::size_t> num_nonzeros(M);
-    sparsity_pattern.num_nonzeros_diagonal(num_nonzeros);
-
     // Create matrix
     ierr = MatCreate(PETSC_COMM_SELF, &_matA);
     if (ierr != 0) petsc_error(ierr, __FILE__, "MatCreate");
@@ -135,15 +131,37 @@ void PETScMatrix::init(const TensorLayout& tensor_layout)
      if (ierr != 0) petsc_error(ierr, __FILE__, "MatSetBlockSize");
     }
 
-    // FIXME: Change to MatSeqAIJSetPreallicationCSR for improved performance?
-
-    // Allocate space (using data from sparsity pattern)
-
-    // Copy number of non-zeros to PetscInt type
-    const std::vector<PetscInt> _num_nonzeros(num_nonzeros.begin(),
-                                              num_nonzeros.end());
-    ierr = MatSeqAIJSetPreallocation(_matA, 0, _num_nonzeros.data());
-    if (ierr != 0) petsc_error(ierr, __FILE__, "MatSeqAIJSetPreallocation");
+    // Allocate space (using data from sparsity pattern). If the
+    // compressed rows of the pattern are available, the nonzero
+    // structure is set in full, such that the matrix is assembled
+    // with explicit zeros and the positions of entries in the value
+    // array are known before assembly.
+    const SparsityPattern* pattern
+      = dynamic_cast<const SparsityPattern*>(&sparsity_pattern);
+    if (pattern && pattern->primary_dim() == 0
+        && pattern->diagonal_offsets().size() == M + 1)
+    {
+      const std::vector<std::size_t>& offsets = pattern->diagonal_offsets();
+      const std::vector<std::uint32_t>& columns = pattern->diagonal_columns();
+      const std::vector<PetscInt> _offsets(offsets.begin(), offsets.end());
+      const std::vector<PetscInt> _columns(columns.begin(), columns.end());
+      ierr = MatSeqAIJSetPreallocationCSR(_matA, _offsets.data(),
+                                          _columns.data(), NULL);
+      if (ierr != 0)
+        petsc_error(ierr, __FILE__, "MatSeqAIJSetPreallocationCSR");
+    }
+    else
+    {
+      // Get number of nonzeros for each row from sparsity pattern
+      std::vector<std::size_t> num_nonzeros(M);
+      sparsity_pattern.num_nonzeros_diagonal(num_nonzeros);
+
+      // Copy number of non-zeros to PetscInt type
+      const std::vector<PetscInt> _num_nonzeros(num_nonzeros.begin(),
+                                                num_nonzeros.end());
+      ierr = MatSeqAIJSetPreallocation(_matA, 0, _num_nonzeros.data());
+      if (ierr != 0) petsc_error(ierr, __FILE__, "MatSeqAIJSetPreallocation");
+    }
 
     ISLocalToGlobalMapping petsc_local_to_global0, petsc_local_to_global1;
     dolfin_assert(tensor_layout.local_to_global_map.size() == 2);
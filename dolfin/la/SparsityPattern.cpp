@@ -20,18 +20,107 @@
 // Modified by Ola Skavhaug, 2009.
 //
 // First added:  2007-03-13
-// Last changed: 2014-11-26
+// Last changed: 2016-10-18
 
 #include <algorithm>
+#include <limits>
 
 #include <dolfin/common/MPI.h>
 #include <dolfin/log/log.h>
 #include <dolfin/log/LogStream.h>
 #include <dolfin/la/IndexMap.h>
+#include <dolfin/parameter/GlobalParameters.h>
 #include "SparsityPattern.h"
 
 using namespace dolfin;
 
+// Minimum number of buffered entries before the buffer is merged
+// into the compressed rows
+static const std::size_t min_buffer_size = 1 << 20;
+
+//-----------------------------------------------------------------------------
+// Sort rows of compressed row storage, remove duplicate entries and
+// compact storage
+template<typename T>
+static void sort_unique_rows(std::vector<std::size_t>& offsets,
+                             std::vector<T>& columns)
+{
+  const int num_rows = offsets.size() - 1;
+  const int num_threads = std::max((int) parameters["num_threads"], 1);
+
+  // Sort rows and remove duplicates within each row
+  std::vector<std::size_t> row_sizes(num_rows);
+  #pragma omp parallel for schedule(dynamic, 256) num_threads(num_threads)
+  for (int i = 0; i < num_rows; ++i)
+  {
+    typename std::vector<T>::iterator row_begin = columns.begin() + offsets[i];
+    typename std::vector<T>::iterator row_end = columns.begin() + offsets[i + 1];
+    std::sort(row_begin, row_end);
+    row_sizes[i] = std::unique(row_begin, row_end) - row_begin;
+  }
+
+  // Compact storage (entries only move towards the front)
+  std::size_t pos = 0;
+  for (int i = 0; i < num_rows; ++i)
+  {
+    const std::size_t first = offsets[i];
+    offsets[i] = pos;
+    std::copy(columns.begin() + first, columns.begin() + first + row_sizes[i],
+              columns.begin() + pos);
+    pos += row_sizes[i];
+  }
+  offsets[num_rows] = pos;
+  columns.resize(pos);
+  columns.shrink_to_fit();
+}
+//-----------------------------------------------------------------------------
+// Merge compressed rows (offsets1, columns1) into compressed rows
+// (offsets0, columns0). The rows (offsets1, columns1) are used as
+// work arrays.
+template<typename T>
+static void merge_rows(std::vector<std::size_t>& offsets0,
+                       std::vector<T>& columns0,
+                       std::vector<std::size_t>& offsets1,
+                       std::vector<T>& columns1)
+{
+  dolfin_assert(offsets0.size() == offsets1.size());
+  const std::size_t num_rows = offsets0.size() - 1;
+
+  // Nothing to merge into, adopt rows
+  if (columns0.empty())
+  {
+    offsets0.swap(offsets1);
+    columns0.swap(columns1);
+    sort_unique_rows(offsets0, columns0);
+    return;
+  }
+
+  // Count entries per merged row
+  std::vector<std::size_t> offsets(num_rows + 1, 0);
+  for (std::size_t i = 0; i < num_rows; ++i)
+  {
+    offsets[i + 1] = offsets[i] + (offsets0[i + 1] - offsets0[i])
+      + (offsets1[i + 1] - offsets1[i]);
+  }
+
+  // Fill merged rows
+  std::vector<T> columns(offsets.back());
+  for (std::size_t i = 0; i < num_rows; ++i)
+  {
+    typename std::vector<T>::iterator pos
+      = std::copy(columns0.begin() + offsets0[i],
+                  columns0.begin() + offsets0[i + 1],
+                  columns.begin() + offsets[i]);
+    std::copy(columns1.begin() + offsets1[i], columns1.begin() + offsets1[i + 1],
+              pos);
+  }
+
+  // Release old storage before sorting
+  std::vector<T>().swap(columns0);
+  sort_unique_rows(offsets, columns);
+  offsets0.swap(offsets);
+  columns0.swap(columns);
+}
 //-----------------------------------------------------------------------------
 SparsityPattern::SparsityPattern(std::size_t primary_dim)
   : GenericSparsityPattern(primary_dim), _mpi_comm(MPI_COMM_NULL)
@@ -64,8 +153,9 @@ void SparsityPattern::init(
   const std::size_t _primary_dim = primary_dim();
 
   // Clear sparsity pattern data
-  diagonal.clear();
-  off_diagonal.clear();
+  _diagonal_columns.clear();
+  _off_diagonal_columns.clear();
+  _buffer.clear();
   non_local.clear();
 
   // Check that primary dimension is valid
@@ -76,14 +166,23 @@ void SparsityPattern::init(
                  "Primary dimension must be less than 2 (0=row major, 1=column major");
   }
 
+  // Check that local column offsets fit in diagonal block storage
+  if (index_maps[1 - _primary_dim]->size()
+      > std::numeric_limits<std::uint32_t>::max())
+  {
+    dolfin_error("SparsityPattern.cpp",
+                 "initialize sparsity pattern",
+                 "Local size exceeds range of 32-bit column indices");
+  }
+
   const std::size_t local_size = index_maps[_primary_dim]->size();
 
-  // Resize diagonal block
-  diagonal.resize(local_size);
+  // Create empty diagonal block
+  _diagonal_offsets.assign(local_size + 1, 0);
 
-  // Resize off-diagonal block (only needed when local range != global
-  // range)
-  off_diagonal.resize(local_size);
+  // Create empty off-diagonal block (only filled when local range
+  // != global range)
+  _off_diagonal_offsets.assign(local_size + 1, 0);
 }
 //-----------------------------------------------------------------------------
 void SparsityPattern::insert_global(dolfin::la_index i, dolfin::la_index j)
@@ -100,41 +199,18 @@ void SparsityPattern::insert_global(dolfin::la_index i, dolfin::la_index j)
   }
 
   // Check local range
-  if (MPI::size(_mpi_comm) == 1)
+  const std::pair<dolfin::la_index, dolfin::la_index>
+    local_range0 = _index_maps[_primary_dim]->local_range();
+  if (local_range0.first <= i_index && i_index < local_range0.second)
   {
-    // Sequential mode, do simple insertion
-    diagonal[i_index].insert(j_index);
+    // Subtract offset and store local entry
+    insert_entry(i_index - local_range0.first, j_index);
   }
   else
   {
-    const std::pair<dolfin::la_index, dolfin::la_index>
-      local_range0 = _index_maps[_primary_dim]->local_range();
-    const std::pair<dolfin::la_index, dolfin::la_index>
-      local_range1 = _index_maps[1 - _primary_dim]->local_range();
-
-    if (local_range0.first <= i_index && i_index < local_range0.second)
-      {
-        // Subtract offset
-        const std::size_t I = i_index - local_range0.first;
-
-        // Store local entry in diagonal or off-diagonal block
-        if (local_range1.first <= j_index && j_index < local_range1.second)
-        {
-          dolfin_assert(I < diagonal.size());
-          diagonal[I].insert(j_index);
-        }
-        else
-        {
-          dolfin_assert(I < off_diagonal.size());
-          off_diagonal[I].insert(j_index);
-        }
-      }
-    else
-    {
-      dolfin_error("SparsityPattern.cpp",
-                   "insert using global indices",
-                   "Index must be in the process range");
-    }
+    dolfin_error("SparsityPattern.cpp",
+                 "insert using global indices",
+                 "Index must be in the process range");
   }
 }
 //-----------------------------------------------------------------------------
@@ -147,69 +223,36 @@ void SparsityPattern::insert_global(
 
   ArrayView<const dolfin::la_index> map_i;
   ArrayView<const dolfin::la_index> map_j;
-  std::size_t primary_codim;
   dolfin_assert(_primary_dim < 2);
   if (_primary_dim == 0)
   {
-    primary_codim = 1;
     map_i = entries[0];
     map_j = entries[1];
   }
   else
   {
-    primary_codim = 0;
     map_i = entries[1];
     map_j = entries[0];
   }
 
   dolfin_assert(_primary_dim < _index_maps.size());
-  dolfin_assert(primary_codim < _index_maps.size());
   const std::pair<dolfin::la_index, dolfin::la_index>
     local_range0 = _index_maps[_primary_dim]->local_range();
-  const std::pair<dolfin::la_index, dolfin::la_index>
-    local_range1 = _index_maps[primary_codim]->local_range();
 
-  // Check local range
-  if (MPI::size(_mpi_comm) == 1)
+  for (const auto &i_index : map_i)
   {
-    // Sequential mode, do simple insertion
-    for (const auto &i_index : map_i)
+    if (local_range0.first <= i_index && i_index < local_range0.second)
     {
-      dolfin_assert((int) i_index < (int) diagonal.size());
-      diagonal[i_index].insert(map_j.begin(), map_j.end());
+      // Subtract offset and store local entries
+      const std::size_t I = i_index - local_range0.first;
+      for (const auto &j_index : map_j)
+        insert_entry(I, j_index);
     }
-  }
-  else
-  {
-    // Parallel mode, use either diagonal, off_diagonal or non_local
-    for (const auto &i_index : map_i)
+    else
     {
-      if (local_range0.first <= i_index && i_index < local_range0.second)
-      {
-        // Subtract offset
-        const std::size_t I = i_index - local_range0.first;
-
-        // Store local entry in diagonal or off-diagonal block
-        for (const auto &j_index : map_j)
-        {
-          if (local_range1.first <= j_index && j_index < local_range1.second)
-          {
-            dolfin_assert(I < diagonal.size());
-            diagonal[I].insert(j_index);
-          }
-          else
-          {
-            dolfin_assert(I < off_diagonal.size());
-            off_diagonal[I].insert(j_index);
-          }
-        }
-      }
-      else
-      {
-        dolfin_error("SparsityPattern.cpp",
-                     "insert using global indices",
-                     "Index must be in the process range");
-      }
+      dolfin_error("SparsityPattern.cpp",
+                   "insert using global indices",
+                   "Index must be in the process range");
     }
   }
 }
@@ -240,52 +283,97 @@ void SparsityPattern::insert_local(
   std::shared_ptr<const IndexMap> index_map0 = _index_maps[ _primary_dim];
   std::shared_ptr<const IndexMap> index_map1 = _index_maps[primary_codim];
   const la_index local_size0 = index_map0->size();
-  const la_index local_size1 = index_map1->size();
 
-  // Check local range
-  if (MPI::size(_mpi_comm) == 1)
+  for (const auto &i_index : map_i)
   {
-    // Sequential mode, do simple insertion
-    for (const auto &i_index : map_i)
-      diagonal[i_index].insert(map_j.begin(), map_j.end());
+    if (i_index < local_size0)
+    {
+      // Store local entry
+      for (const auto &j_index : map_j)
+        insert_entry(i_index, index_map1->local_to_global(j_index));
+    }
+    else
+    {
+      // Store non-local entry (communicated later during apply())
+      for (const auto &j_index : map_j)
+      {
+        const std::size_t J = index_map1->local_to_global(j_index);
+        // Store indices
+        non_local.push_back(i_index);
+        non_local.push_back(J);
+      }
+    }
   }
-  else
+}
+//-----------------------------------------------------------------------------
+void SparsityPattern::insert_local_rows(
+  const std::vector<std::size_t>& offsets,
+  const std::vector<dolfin::la_index>& columns)
+{
+  dolfin_assert(!offsets.empty());
+  const std::size_t _primary_dim = primary_dim();
+  dolfin_assert(_primary_dim < 2);
+  std::shared_ptr<const IndexMap> index_map0 = _index_maps[_primary_dim];
+  std::shared_ptr<const IndexMap> index_map1 = _index_maps[1 - _primary_dim];
+  const std::size_t local_size0 = index_map0->size();
+  const dolfin::la_index local_size1 = index_map1->size();
+  const std::size_t num_rows = std::min(offsets.size() - 1, local_size0);
+
+  // Count entries in diagonal and off-diagonal block for each owned
+  // row
+  std::vector<std::size_t> diagonal_offsets(local_size0 + 1, 0);
+  std::vector<std::size_t> off_diagonal_offsets(local_size0 + 1, 0);
+  for (std::size_t i = 0; i < num_rows; ++i)
+  {
+    std::size_t num_diagonal = 0;
+    for (std::size_t k = offsets[i]; k < offsets[i + 1]; ++k)
+    {
+      if (columns[k] < local_size1)
+        ++num_diagonal;
+    }
+    diagonal_offsets[i + 1] = diagonal_offsets[i] + num_diagonal;
+    off_diagonal_offsets[i + 1] = off_diagonal_offsets[i]
+      + (offsets[i + 1] - offsets[i]) - num_diagonal;
+  }
+  for (std::size_t i = num_rows; i < local_size0; ++i)
   {
-    // Parallel mode, use either diagonal, off_diagonal or non_local
+    diagonal_offsets[i + 1] = diagonal_offsets[i];
+    off_diagonal_offsets[i + 1] = off_diagonal_offsets[i];
+  }
 
-    for (const auto &i_index : map_i)
+  // Fill diagonal and off-diagonal block. Local column indices in the
+  // diagonal block are offsets from the start of the local range.
+  std::vector<std::uint32_t> diagonal_columns(diagonal_offsets.back());
+  std::vector<std::size_t> off_diagonal_columns(off_diagonal_offsets.back());
+  for (std::size_t i = 0; i < num_rows; ++i)
+  {
+    std::size_t diagonal_pos = diagonal_offsets[i];
+    std::size_t off_diagonal_pos = off_diagonal_offsets[i];
+    for (std::size_t k = offsets[i]; k < offsets[i + 1]; ++k)
     {
-      if (i_index < local_size0)
-      {
-        // Store local entry in diagonal or off-diagonal block
-        for (const auto &j_index : map_j)
-        {
-          const std::size_t J = index_map1->local_to_global(j_index);
-          if (j_index < local_size1)
-          {
-            dolfin_assert(i_index < (int)diagonal.size());
-            diagonal[i_index].insert(J);
-          }
-          else
-          {
-            dolfin_assert(i_index < (int)off_diagonal.size());
-            off_diagonal[i_index].insert(J);
-          }
-        }
-      }
+      const dolfin::la_index j_index = columns[k];
+      if (j_index < local_size1)
+        diagonal_columns[diagonal_pos++] = j_index;
       else
       {
-        // Store non-local entry (communicated later during apply())
-        for (const auto &j_index : map_j)
-        {
-          const std::size_t J = index_map1->local_to_global(j_index);
-          // Store indices
-          non_local.push_back(i_index);
-          non_local.push_back(J);
-        }
+        off_diagonal_columns[off_diagonal_pos++]
+          = index_map1->local_to_global(j_index);
       }
     }
   }
+
+  // Store non-local entries (communicated later during apply())
+  for (std::size_t i = local_size0; i + 1 < offsets.size(); ++i)
+  {
+    for (std::size_t k = offsets[i]; k < offsets[i + 1]; ++k)
+    {
+      non_local.push_back(i);
+      non_local.push_back(index_map1->local_to_global(columns[k]));
+    }
+  }
+
+  add_rows(diagonal_offsets, diagonal_columns,
+           off_diagonal_offsets, off_diagonal_columns);
 }
 //-----------------------------------------------------------------------------
 std::size_t SparsityPattern::rank() const
@@ -302,63 +390,53 @@ std::pair<std::size_t, std::size_t>
 //-----------------------------------------------------------------------------
 std::size_t SparsityPattern::num_nonzeros() const
 {
-  std::size_t nz = 0;
-  for (auto slice = diagonal.begin(); slice != diagonal.end(); ++slice)
-    nz += slice->size();
-  for (auto slice = off_diagonal.begin(); slice != off_diagonal.end(); ++slice)
-    nz += slice->size();
-
-  return nz;
+  compress();
+  return _diagonal_columns.size() + _off_diagonal_columns.size();
 }
 //-----------------------------------------------------------------------------
 void SparsityPattern::num_nonzeros_diagonal(std::vector<std::size_t>& num_nonzeros) const
 {
+  compress();
+
   // Resize vector
-  num_nonzeros.resize(diagonal.size());
+  const std::size_t num_rows = _diagonal_offsets.size() - 1;
+  num_nonzeros.resize(num_rows);
 
   // Get number of nonzeros per generalised row
-  for (auto slice = diagonal.begin(); slice != diagonal.end(); ++slice)
-    num_nonzeros[slice - diagonal.begin()] = slice->size();
+  for (std::size_t i = 0; i < num_rows; ++i)
+    num_nonzeros[i] = _diagonal_offsets[i + 1] - _diagonal_offsets[i];
 }
 //-----------------------------------------------------------------------------
 void SparsityPattern::num_nonzeros_off_diagonal(std::vector<std::size_t>& num_nonzeros) const
 {
+  compress();
+
   // Resize vector
-  num_nonzeros.resize(off_diagonal.size());
+  const std::size_t num_rows = _off_diagonal_offsets.size() - 1;
+  num_nonzeros.resize(num_rows);
 
   // Compute number of nonzeros per generalised row
-  for (auto slice = off_diagonal.begin(); slice != off_diagonal.end(); ++slice)
-    num_nonzeros[slice - off_diagonal.begin()] = slice->size();
+  for (std::size_t i = 0; i < num_rows; ++i)
+    num_nonzeros[i] = _off_diagonal_offsets[i + 1] - _off_diagonal_offsets[i];
 }
 //-----------------------------------------------------------------------------
 void SparsityPattern::num_local_nonzeros(std::vector<std::size_t>& num_nonzeros) const
 {
   num_nonzeros_diagonal(num_nonzeros);
-  if (!off_diagonal.empty())
-  {
-    std::vector<std::size_t> tmp;
-    num_nonzeros_off_diagonal(tmp);
-    dolfin_assert(num_nonzeros.size() == tmp.size());
-    std::transform(num_nonzeros.begin(), num_nonzeros.end(), tmp.begin(),
-                   num_nonzeros.begin(), std::plus<std::size_t>());
-  }
+  std::vector<std::size_t> tmp;
+  num_nonzeros_off_diagonal(tmp);
+  dolfin_assert(num_nonzeros.size() == tmp.size());
+  std::transform(num_nonzeros.begin(), num_nonzeros.end(), tmp.begin(),
+                 num_nonzeros.begin(), std::plus<std::size_t>());
 }
 //-----------------------------------------------------------------------------
 void SparsityPattern::apply()
 {
   const std::size_t _primary_dim = primary_dim();
-
-  std::size_t primary_codim;
   dolfin_assert(_primary_dim < 2);
-  if (_primary_dim == 0)
-    primary_codim = 1;
-  else
-    primary_codim = 0;
 
   const std::pair<dolfin::la_index, dolfin::la_index>
     local_range0 = _index_maps[_primary_dim]->local_range();
-  const std::pair<dolfin::la_index, dolfin::la_index>
-    local_range1 = _index_maps[primary_codim]->local_range();
   const std::size_t local_size0 = _index_maps[_primary_dim]->size();
   const std::size_t offset0 = local_range0.first;
 
@@ -446,42 +524,36 @@ void SparsityPattern::apply()
                        local_range0.second);
         }
 
-        // Get local I index
+        // Get local I index and store entry
         const std::size_t i_index = I - offset0;
-
-        // Insert in diagonal or off-diagonal block
-        if (local_range1.first <= J &&
-            J < local_range1.second)
-        {
-          dolfin_assert(i_index < diagonal.size());
-          diagonal[i_index].insert(J);
-        }
-        else
-        {
-          dolfin_assert(i_index < off_diagonal.size());
-          off_diagonal[i_index].insert(J);
-        }
+        insert_entry(i_index, J);
       }
     }
   }
 
   // Clear non-local entries
   non_local.clear();
+
+  // Merge buffered entries into compressed rows
+  compress();
 }
 //-----------------------------------------------------------------------------
 std::string SparsityPattern::str(bool verbose) const
 {
+  compress();
+
   // Print each row
+  const std::size_t offset1 = _index_maps[1 - primary_dim()]->local_range().first;
   std::stringstream s;
-  for (std::size_t i = 0; i < diagonal.size(); i++)
+  for (std::size_t i = 0; i < _diagonal_offsets.size() - 1; i++)
   {
     if (primary_dim() == 0)
       s << "Row " << i << ":";
     else
       s << "Col " << i << ":";
 
-    for (auto entry = diagonal[i].begin(); entry != diagonal[i].end(); ++entry)
-      s << " " << *entry;
+    for (std::size_t k = _diagonal_offsets[i]; k < _diagonal_offsets[i + 1]; ++k)
+      s << " " << offset1 + _diagonal_columns[k];
     s << std::endl;
   }
 
@@ -491,14 +563,16 @@ std::string SparsityPattern::str(bool verbose) const
 std::vector<std::vector<std::size_t>>
 SparsityPattern::diagonal_pattern(Type type) const
 {
-  std::vector<std::vector<std::size_t>> v(diagonal.size());
-  for (std::size_t i = 0; i < diagonal.size(); ++i)
-    v[i].insert(v[i].begin(), diagonal[i].begin(), diagonal[i].end());
+  compress();
 
-  if (type == sorted)
+  // Rows are stored sorted, so both options give the same result
+  const std::size_t offset1 = _index_maps[1 - primary_dim()]->local_range().first;
+  std::vector<std::vector<std::size_t>> v(_diagonal_offsets.size() - 1);
+  for (std::size_t i = 0; i < v.size(); ++i)
   {
-    for (std::size_t i = 0; i < v.size(); ++i)
-      std::sort(v[i].begin(), v[i].end());
+    v[i].reserve(_diagonal_offsets[i + 1] - _diagonal_offsets[i]);
+    for (std::size_t k = _diagonal_offsets[i]; k < _diagonal_offsets[i + 1]; ++k)
+      v[i].push_back(offset1 + _diagonal_columns[k]);
   }
 
   return v;
@@ -507,30 +581,118 @@ SparsityPattern::diagonal_pattern(Type type) const
 std::vector<std::vector<std::size_t>>
   SparsityPattern::off_diagonal_pattern(Type type) const
 {
-  std::vector<std::vector<std::size_t>> v(off_diagonal.size());
-  for (std::size_t i = 0; i < off_diagonal.size(); ++i)
-    v[i].insert(v[i].begin(), off_diagonal[i].begin(), off_diagonal[i].end());
+  compress();
 
-  if (type == sorted)
+  // Rows are stored sorted, so both options give the same result
+  std::vector<std::vector<std::size_t>> v(_off_diagonal_offsets.size() - 1);
+  for (std::size_t i = 0; i < v.size(); ++i)
   {
-    for (std::size_t i = 0; i < v.size(); ++i)
-      std::sort(v[i].begin(), v[i].end());
+    v[i].assign(_off_diagonal_columns.begin() + _off_diagonal_offsets[i],
+                _off_diagonal_columns.begin() + _off_diagonal_offsets[i + 1]);
   }
 
   return v;
 }
 //-----------------------------------------------------------------------------
+const std::vector<std::size_t>& SparsityPattern::diagonal_offsets() const
+{
+  compress();
+  return _diagonal_offsets;
+}
+//-----------------------------------------------------------------------------
+const std::vector<std::uint32_t>& SparsityPattern::diagonal_columns() const
+{
+  compress();
+  return _diagonal_columns;
+}
+//-----------------------------------------------------------------------------
+void SparsityPattern::insert_entry(std::size_t i, std::size_t J)
+{
+  _buffer.push_back(i);
+  _buffer.push_back(J);
+
+  // Merge buffer into compressed rows when it grows large compared
+  // to the compressed rows, such that the cost is amortised
+  const std::size_t num_compressed
+    = _diagonal_columns.size() + _off_diagonal_columns.size();
+  if (_buffer.size() > 2*std::max(min_buffer_size, 2*num_compressed))
+    compress();
+}
+//-----------------------------------------------------------------------------
+void SparsityPattern::compress() const
+{
+  if (_buffer.empty())
+    return;
+
+  const std::size_t num_rows = _diagonal_offsets.size() - 1;
+  const std::pair<std::size_t, std::size_t>
+    local_range1 = _index_maps[1 - primary_dim()]->local_range();
+
+  // Count buffered entries in diagonal and off-diagonal block for
+  // each row
+  std::vector<std::size_t> diagonal_offsets(num_rows + 1, 0);
+  std::vector<std::size_t> off_diagonal_offsets(num_rows + 1, 0);
+  for (std::size_t k = 0; k < _buffer.size(); k += 2)
+  {
+    const std::size_t i = _buffer[k];
+    const std::size_t J = _buffer[k + 1];
+    dolfin_assert(i < num_rows);
+    if (local_range1.first <= J && J < local_range1.second)
+      ++diagonal_offsets[i + 1];
+    else
+      ++off_diagonal_offsets[i + 1];
+  }
+  for (std::size_t i = 0; i < num_rows; ++i)
+  {
+    diagonal_offsets[i + 1] += diagonal_offsets[i];
+    off_diagonal_offsets[i + 1] += off_diagonal_offsets[i];
+  }
+
+  // Fill rows with buffered entries
+  std::vector<std::uint32_t> diagonal_columns(diagonal_offsets.back());
+  std::vector<std::size_t> off_diagonal_columns(off_diagonal_offsets.back());
+  std::vector<std::size_t> diagonal_pos(diagonal_offsets.begin(),
+                                        diagonal_offsets.end() - 1);
+  std::vector<std::size_t> off_diagonal_pos(off_diagonal_offsets.begin(),
+                                            off_diagonal_offsets.end() - 1);
+  for (std::size_t k = 0; k < _buffer.size(); k += 2)
+  {
+    const std::size_t i = _buffer[k];
+    const std::size_t J = _buffer[k + 1];
+    if (local_range1.first <= J && J < local_range1.second)
+      diagonal_columns[diagonal_pos[i]++] = J - local_range1.first;
+    else
+      off_diagonal_columns[off_diagonal_pos[i]++] = J;
+  }
+
+  // Release buffer
+  std::vector<std::size_t>().swap(_buffer);
+
+  add_rows(diagonal_offsets, diagonal_columns,
+           off_diagonal_offsets, off_diagonal_columns);
+}
+//-----------------------------------------------------------------------------
+void SparsityPattern::add_rows(
+  std::vector<std::size_t>& diagonal_offsets,
+  std::vector<std::uint32_t>& diagonal_columns,
+  std::vector<std::size_t>& off_diagonal_offsets,
+  std::vector<std::size_t>& off_diagonal_columns) const
+{
+  merge_rows(_diagonal_offsets, _diagonal_columns,
+             diagonal_offsets, diagonal_columns);
+  merge_rows(_off_diagonal_offsets, _off_diagonal_columns,
+             off_diagonal_offsets, off_diagonal_columns);
+}
+//-----------------------------------------------------------------------------
 void SparsityPattern::info_statistics() const
 {
+  compress();
+
   // Count nonzeros in diagonal block
-  std::size_t num_nonzeros_diagonal = 0;
-  for (std::size_t i = 0; i < diagonal.size(); ++i)
-    num_nonzeros_diagonal += diagonal[i].size();
+  const std::size_t num_nonzeros_diagonal = _diagonal_columns.size();
 
   // Count nonzeros in off-diagonal block
-  std::size_t num_nonzeros_off_diagonal = 0;
-  for (std::size_t i = 0; i < off_diagonal.size(); ++i)
-    num_nonzeros_off_diagonal += off_diagonal[i].size();
+  const std::size_t num_nonzeros_off_diagonal = _off_diagonal_columns.size();
 
   // Count nonzeros in non-local block
   const std::size_t num_nonzeros_non_local = non_local.size()/2;
@@ -18,11 +18,12 @@
 // Modified by Anders Logg, 2007-2009.
 //
 // First added:  2007-03-13
-// Last changed: 2011-01-02
+// Last changed: 2016-10-18
 
 #ifndef __SPARSITY_PATTERN_H
 #define __SPARSITY_PATTERN_H
 
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <unordered_map>
@@ -30,7 +31,6 @@
 #include <vector>
 
 #include <dolfin/common/ArrayView.h>
-#include <dolfin/common/Set.h>
 #include <dolfin/common/types.h>
 #include "GenericSparsityPattern.h"
 
@@ -41,15 +41,18 @@ namespace dolfin
 
   /// This class implements the GenericSparsityPattern interface.  It
   /// is used by most linear algebra backends.
+  ///
+  /// The diagonal and off-diagonal blocks are stored in compressed
+  /// row form, with sorted rows and without duplicate entries.
+  /// Columns of the diagonal block are stored as 32-bit offsets
+  /// from the start of the local column range. Entries inserted one
+  /// entity at a time are buffered and merged into the compressed
+  /// rows in bulk, when the buffer grows large, when the pattern is
+  /// accessed or by apply(). Whole rows can be inserted at once with
+  /// insert_local_rows().
 
   class SparsityPattern : public GenericSparsityPattern
   {
-
-    // NOTE: Do not change this typedef without performing careful
-    //       performance profiling
-    // Set type used for the rows of the sparsity pattern
-    typedef dolfin::Set<std::size_t> set_type;
-
   public:
 
     /// Create empty sparsity pattern
@@ -79,6 +82,14 @@ namespace dolfin
     void insert_local(const std::vector<
                       ArrayView<const dolfin::la_index> >& entries);
 
+    /// Insert rows of non-zero entries in compressed row form using
+    /// local (process-wise) indices. Row i (along the primary
+    /// dimension) holds the entries columns[offsets[i]], ...,
+    /// columns[offsets[i + 1] - 1]. Rows may include unowned
+    /// (ghost) rows, which are communicated during apply().
+    void insert_local_rows(const std::vector<std::size_t>& offsets,
+                           const std::vector<dolfin::la_index>& columns);
+
     /// Return rank
     std::size_t rank() const;
 
@@ -122,8 +133,30 @@ namespace dolfin
     std::vector<std::vector<std::size_t> >
       off_diagonal_pattern(Type type) const;
 
+    /// Return row offsets of the diagonal block in compressed row
+    /// form. Row i holds the columns diagonal_columns()[k] for
+    /// diagonal_offsets()[i] <= k < diagonal_offsets()[i + 1].
+    const std::vector<std::size_t>& diagonal_offsets() const;
+
+    /// Return sorted columns of the diagonal block in compressed row
+    /// form, relative to the start of local_range(1)
+    const std::vector<std::uint32_t>& diagonal_columns() const;
+
   private:
 
+    // Merge buffered entries into compressed rows
+    void compress() const;
+
+    // Merge rows into compressed rows. The arguments are used as
+    // work arrays and are left in an unspecified state.
+    void add_rows(std::vector<std::size_t>& diagonal_offsets,
+                  std::vector<std::uint32_t>& diagonal_columns,
+                  std::vector<std::size_t>& off_diagonal_offsets,
+                  std::vector<std::size_t>& off_diagonal_columns) const;
+
+    // Buffer entry with local row index i and global column index J
+    void insert_entry(std::size_t i, std::size_t J);
+
     // Print some useful information
     void info_statistics() const;
 
@@ -136,9 +169,19 @@ namespace dolfin
     // IndexMaps for each dimension
     std::vector<std::shared_ptr<const IndexMap>> _index_maps;
 
-    // Sparsity patterns for diagonal and off-diagonal blocks
-    std::vector<set_type> diagonal;
-    std::vector<set_type> off_diagonal;
+    // Sparsity patterns for diagonal and off-diagonal blocks in
+    // compressed row form. Diagonal columns are offsets from the
+    // start of the local column range, off-diagonal columns are
+    // global indices.
+    mutable std::vector<std::size_t> _diagonal_offsets;
+    mutable std::vector<std::uint32_t> _diagonal_columns;
+    mutable std::vector<std::size_t> _off_diagonal_offsets;
+    mutable std::vector<std::size_t> _off_diagonal_columns;
+
+    // Buffered local entries, not yet merged into the compressed
+    // rows, stored as [i0, J0, i1, J1, ...] with local row index i
+    // and global column index J
+    mutable std::vector<std::size_t> _buffer;
 
     // Sparsity pattern for non-local entries stored as [i0, j0, i1, j1, ...]
     std::vector<std::size_t> non_local;
@@ -91,6 +91,13 @@ namespace dolfin
     virtual std::string str(bool verbose) const
     { return "<Vector wrapper of " + vector->str(verbose) + ">"; }
 
+    /// Add a batch of blocks of values using local indices
+    virtual void add_local_batch(
+      const double* blocks, std::size_t block_stride,
+      std::size_t num_blocks,
+      const std::vector<std::vector<ArrayView<const dolfin::la_index> > >& rows)
+    { vector->add_local_batch(blocks, block_stride, num_blocks, rows); }
+
     //--- Implementation of the GenericVector interface ---
 
     /// Initialize vector to size N
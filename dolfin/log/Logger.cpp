@@ -262,7 +262,8 @@ void Logger::set_log_level(int log_level)
 }
 //-----------------------------------------------------------------------------
 void Logger::register_timing(std::string task,
-                             std::tuple<double, double, double> elapsed)
+                             std::tuple<double, double, double> elapsed,
+                             std::size_t num_reps)
 {
   dolfin_assert(elapsed >=
     std::make_tuple(double(0.0), double(0.0), double(0.0)));
@@ -277,7 +278,8 @@ void Logger::register_timing(std::string task,
   log(line.str(), TRACE);
 
   // Store values for summary
-  const auto timing = std::tuple_cat(std::make_tuple(std::size_t(1)), elapsed);
+  dolfin_assert(num_reps > 0);
+  const auto timing = std::tuple_cat(std::make_tuple(num_reps), elapsed);
   auto it = _timings.find(task);
   if (it == _timings.end())
   {
@@ -101,9 +101,11 @@ namespace dolfin
     /// Get log level
     inline int get_log_level() const { return _log_level; }
 
-    /// Register timing (for later summary)
+    /// Register timing (for later summary) of num_reps repetitions
+    /// of task
     void register_timing(std::string task,
-                         std::tuple<double, double, double> elapsed);
+                         std::tuple<double, double, double> elapsed,
+                         std::size_t num_reps=1);
 
     /// Return a summary of timings and tasks in a Table, optionally clearing
     /// stored timings
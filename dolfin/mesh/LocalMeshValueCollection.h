@@ -27,9 +27,9 @@
 #ifndef __LOCAL_MESH_VALUE_COLLECTION_H
 #define __LOCAL_MESH_VALUE_COLLECTION_H
 
-#include <map>
 #include <utility>
 #include <vector>
+#include <boost/container/flat_map.hpp>
 #include <dolfin/common/MPI.h>
 #include <dolfin/log/log.h>
 
@@ -95,13 +95,13 @@ namespace dolfin
       send_indices.resize(num_processes);
       send_v.resize(num_processes);
 
-      const std::map<std::pair<std::size_t, std::size_t>, T>& vals
-        = values.values();
+      const boost::container::flat_map<std::pair<std::size_t,
+        std::size_t>, T>& vals = values.values();
       for (std::size_t p = 0; p < num_processes; p++)
       {
         const std::pair<std::size_t, std::size_t> local_range
           = MPI::local_range(_mpi_comm, p, vals.size());
-        typename std::map<std::pair<std::size_t,
+        typename boost::container::flat_map<std::pair<std::size_t,
           std::size_t>, T>::const_iterator it = vals.begin();
         std::advance(it, local_range.first);
         for (std::size_t i = local_range.first; i < local_range.second; ++i)
@@ -194,7 +194,18 @@ void Mesh::init(std::size_t d0, std::size_t d1) const
 
   // Skip if already computed
   if (!_topology(d0, d1).empty())
+  {
+    // Compressed connectivity must be restored explicitly before use
+    if (_topology(d0, d1).compressed())
+    {
+      dolfin_error("Mesh.cpp",
+                   "initialize mesh connectivity",
+                   "Connectivity %d --> %d is compressed. Call MeshConnectivity::decompress() before accessing it",
+                   d0, d1);
+    }
+    _topology.touch(d0, d1);
     return;
+  }
 
   // Check that mesh is ordered
   if (!ordered())
@@ -211,6 +222,16 @@ void Mesh::init(std::size_t d0, std::size_t d1) const
   // Order mesh if necessary
   if (!ordered())
     mesh->order();
+
+  // Record access for the memory budget (connectivity is only
+  // cleared by trim_connectivity, never here, since iterators and
+  // arrays of other connectivity may still be in use)
+  mesh->_topology.computed(d0, d1);
+}
+//-----------------------------------------------------------------------------
+std::size_t Mesh::trim_connectivity()
+{
+  return _topology.evict();
 }
 //-----------------------------------------------------------------------------
 void Mesh::init() const
@@ -380,6 +380,19 @@ namespace dolfin
     /// Compute all entities and connectivity.
     void init() const;
 
+    /// Clear recomputable connectivity, least recently used first,
+    /// until the memory used by connectivity is within the budget
+    /// set by MeshTopology::set_connectivity_budget. Cleared
+    /// connectivity is recomputed by the next call to init(d0, d1).
+    /// This must not be called while iterating over mesh entities,
+    /// since iterators and arrays returned by MeshEntity::entities
+    /// may refer to cleared connectivity.
+    ///
+    /// *Returns*
+    ///     std::size_t
+    ///         Number of bytes freed.
+    std::size_t trim_connectivity();
+
     /// Clear all mesh data.
     void clear();
 
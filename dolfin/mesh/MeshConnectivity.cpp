@@ -18,8 +18,10 @@
 // Modified by Mikael Mortensen 2014
 //
 // First added:  2006-05-09
-// Last changed: 2014-01-09
+// Last changed: 2016-10-18
 
+#include <algorithm>
+#include <cstdint>
 #include <sstream>
 #include <boost/functional/hash.hpp>
 #include <dolfin/log/log.h>
@@ -27,15 +29,42 @@
 
 using namespace dolfin;
 
+// Append unsigned integer to data, 7 bits per byte with the high bit
+// marking continuation
+static void encode(std::uint64_t value, std::vector<unsigned char>& data)
+{
+  while (value >= 0x80)
+  {
+    data.push_back((value & 0x7f) | 0x80);
+    value >>= 7;
+  }
+  data.push_back(value);
+}
+
+// Read unsigned integer encoded by encode() and advance data
+static std::uint64_t decode(const unsigned char*& data)
+{
+  std::uint64_t value = 0;
+  for (unsigned int shift = 0; ; shift += 7)
+  {
+    const unsigned char byte = *data++;
+    value |= (std::uint64_t) (byte & 0x7f) << shift;
+    if (byte < 0x80)
+      return value;
+  }
+}
+
 //-----------------------------------------------------------------------------
 MeshConnectivity::MeshConnectivity(std::size_t d0, std::size_t d1)
-  : _d0(d0), _d1(d1)
+  : _d0(d0), _d1(d1), _num_entities(0), _stride(0),
+    _num_compressed_connections(0)
 {
   // Do nothing
 }
 //-----------------------------------------------------------------------------
 MeshConnectivity::MeshConnectivity(const MeshConnectivity& connectivity)
-  : _d0(0), _d1(0)
+  : _d0(0), _d1(0), _num_entities(0), _stride(0),
+    _num_compressed_connections(0)
 {
   *this = connectivity;
 }
@@ -51,9 +80,13 @@ MeshConnectivity::operator= (const MeshConnectivity& connectivity)
   // Copy data
   _d0 = connectivity._d0;
   _d1 = connectivity._d1;
+  _num_entities = connectivity._num_entities;
+  _stride = connectivity._stride;
   _connections = connectivity._connections;
   _num_global_connections = connectivity._num_global_connections;
   index_to_position = connectivity.index_to_position;
+  _compressed = connectivity._compressed;
+  _num_compressed_connections = connectivity._num_compressed_connections;
 
   return *this;
 }
@@ -62,6 +95,10 @@ void MeshConnectivity::clear()
 {
   std::vector<unsigned int>().swap(_connections);
   std::vector<unsigned int>().swap(index_to_position);
+  std::vector<unsigned char>().swap(_compressed);
+  _num_entities = 0;
+  _stride = 0;
+  _num_compressed_connections = 0;
 }
 //-----------------------------------------------------------------------------
 void MeshConnectivity::init(std::size_t num_entities,
@@ -70,17 +107,12 @@ void MeshConnectivity::init(std::size_t num_entities,
   // Clear old data if any
   clear();
 
-  // Compute the total size
-  const std::size_t size = num_entities*num_connections;
+  // Initialize offsets
+  init_offsets(std::vector<std::size_t>(num_entities, num_connections));
 
   // Allocate
-  _connections.resize(size);
+  _connections.resize(num_entities*num_connections);
   std::fill(_connections.begin(), _connections.end(), 0);
-  index_to_position.resize(num_entities + 1);
-
-  // Initialize data
-  for (std::size_t e = 0; e < index_to_position.size(); e++)
-    index_to_position[e] = e*num_connections;
 }
 //-----------------------------------------------------------------------------
 void MeshConnectivity::init(std::vector<std::size_t>& num_connections)
@@ -89,15 +121,9 @@ void MeshConnectivity::init(std::vector<std::size_t>& num_connections)
   clear();
 
   // Initialize offsets and compute total size
-  const std::size_t num_entities = num_connections.size();
-  index_to_position.resize(num_entities + 1);
-  std::size_t size = 0;
-  for (std::size_t e = 0; e < num_entities; e++)
-  {
-    index_to_position[e] = size;
-    size += num_connections[e];
-  }
-  index_to_position[num_entities] = size;
+  init_offsets(num_connections);
+  const std::size_t size = num_connections.empty()
+    ? 0 : position(num_connections.size() - 1) + num_connections.back();
 
   // Initialize connections
   _connections.resize(size);
@@ -107,22 +133,82 @@ void MeshConnectivity::init(std::vector<std::size_t>& num_connections)
 void MeshConnectivity::set(std::size_t entity, std::size_t connection,
                            std::size_t pos)
 {
-  dolfin_assert((entity + 1) < index_to_position.size());
-  dolfin_assert(pos < index_to_position[entity + 1]
-                - index_to_position[entity]);
-  _connections[index_to_position[entity] + pos] = connection;
+  dolfin_assert(entity < _num_entities);
+  dolfin_assert(pos < size(entity));
+  _connections[position(entity) + pos] = connection;
 }
 //-----------------------------------------------------------------------------
 void MeshConnectivity::set(std::size_t entity, std::size_t* connections)
 {
-  dolfin_assert((entity + 1) < index_to_position.size());
+  dolfin_assert(entity < _num_entities);
   dolfin_assert(connections);
 
   // Copy data
-  const std::size_t num_connections
-    = index_to_position[entity + 1] - index_to_position[entity];
-  std::copy(connections, connections + num_connections,
-            _connections.begin() + index_to_position[entity]);
+  std::copy(connections, connections + size(entity),
+            _connections.begin() + position(entity));
+}
+//-----------------------------------------------------------------------------
+void MeshConnectivity::compress()
+{
+  if (compressed() || _connections.empty())
+    return;
+
+  // Encode connections of each entity (preceded by the number of
+  // connections unless stride is fixed) as zigzag encoded
+  // differences to the previous connection, 7 bits per byte
+  std::vector<unsigned char> data;
+  data.reserve(_connections.size());
+  std::int64_t previous = 0;
+  for (std::size_t e = 0; e < _num_entities; ++e)
+  {
+    const std::size_t num_connections = size(e);
+    if (_stride == 0)
+      encode(num_connections, data);
+    const unsigned int* connections = (*this)(e);
+    for (std::size_t i = 0; i < num_connections; ++i)
+    {
+      const std::int64_t delta = (std::int64_t) connections[i] - previous;
+      encode(((std::uint64_t) delta << 1) ^ (std::uint64_t) (delta >> 63),
+             data);
+      previous = connections[i];
+    }
+  }
+
+  _num_compressed_connections = _connections.size();
+  std::vector<unsigned int>().swap(_connections);
+  std::vector<unsigned int>().swap(index_to_position);
+  _compressed.assign(data.begin(), data.end());
+}
+//-----------------------------------------------------------------------------
+void MeshConnectivity::decompress()
+{
+  if (!compressed())
+    return;
+
+  // Decode number of connections of each entity
+  const unsigned char* data = _compressed.data();
+  std::vector<std::size_t> num_connections(_num_entities, _stride);
+  std::vector<unsigned int> connections(_num_compressed_connections);
+  std::int64_t previous = 0;
+  std::size_t k = 0;
+  for (std::size_t e = 0; e < _num_entities; ++e)
+  {
+    if (_stride == 0)
+      num_connections[e] = decode(data);
+    for (std::size_t i = 0; i < num_connections[e]; ++i)
+    {
+      const std::uint64_t z = decode(data);
+      previous += (std::int64_t) (z >> 1) ^ -((std::int64_t) (z & 1));
+      connections[k++] = previous;
+    }
+  }
+  dolfin_assert(k == _num_compressed_connections);
+
+  // Restore offsets and connections
+  std::vector<unsigned char>().swap(_compressed);
+  _num_compressed_connections = 0;
+  init_offsets(num_connections);
+  _connections.swap(connections);
 }
 //-----------------------------------------------------------------------------
 std::size_t MeshConnectivity::hash() const
@@ -132,6 +218,49 @@ std::size_t MeshConnectivity::hash() const
   return uhash(_connections);
 }
 //-----------------------------------------------------------------------------
+std::size_t MeshConnectivity::memory_usage() const
+{
+  return sizeof(unsigned int)*(_connections.capacity()
+                               + _num_global_connections.capacity()
+                               + index_to_position.capacity())
+    + _compressed.capacity();
+}
+//-----------------------------------------------------------------------------
+std::size_t MeshConnectivity::memory_usage_uncompressed() const
+{
+  if (empty())
+    return 0;
+  return sizeof(unsigned int)*(size() + _num_global_connections.size()
+                               + _num_entities + 1);
+}
+//-----------------------------------------------------------------------------
+void
+MeshConnectivity::init_offsets(const std::vector<std::size_t>& num_connections)
+{
+  _num_entities = num_connections.size();
+
+  // Use fixed stride if all entities have the same number of
+  // connections
+  _stride = 0;
+  if (!num_connections.empty() && num_connections[0] > 0
+      && std::count(num_connections.begin(), num_connections.end(),
+                    num_connections[0]) == (long) _num_entities)
+  {
+    _stride = num_connections[0];
+    std::vector<unsigned int>().swap(index_to_position);
+    return;
+  }
+
+  index_to_position.resize(_num_entities + 1);
+  std::size_t size = 0;
+  for (std::size_t e = 0; e < _num_entities; e++)
+  {
+    index_to_position[e] = size;
+    size += num_connections[e];
+  }
+  index_to_position[_num_entities] = size;
+}
+//-----------------------------------------------------------------------------
 std::string MeshConnectivity::str(bool verbose) const
 {
   std::stringstream s;
@@ -139,21 +268,23 @@ std::string MeshConnectivity::str(bool verbose) const
   if (verbose)
   {
     s << str(false) << std::endl << std::endl;
-    for (std::size_t e = 0; e < index_to_position.size() - 1; e++)
+    if (compressed())
+      return s.str();
+    for (std::size_t e = 0; e < _num_entities; e++)
     {
       s << "  " << e << ":";
-      for (std::size_t i = index_to_position[e]; i < index_to_position[e + 1];
-           i++)
-      {
+      for (std::size_t i = position(e); i < position(e) + size(e); i++)
         s << " " << _connections[i];
-      }
       s << std::endl;
     }
   }
   else
   {
     s << "<MeshConnectivity " << _d0 << " -- " << _d1 << " of size "
-      << _connections.size() << ">";
+      << size();
+    if (compressed())
+      s << " (compressed)";
+    s << ">";
   }
 
   return s.str();
@@ -16,7 +16,7 @@
 // along with DOLFIN. If not, see <http://www.gnu.org/licenses/>.
 //
 // First added:  2006-05-09
-// Last changed: 2010-11-28
+// Last changed: 2016-10-18
 
 #ifndef __MESH_CONNECTIVITY_H
 #define __MESH_CONNECTIVITY_H
@@ -35,6 +35,15 @@ namespace dolfin
   /// number of entities and the number of connections for each entity,
   /// which may either be equal for all entities or different, or by
   /// giving the entire (sparse) connectivity pattern.
+  ///
+  /// If all entities have the same number of connections (e.g. cell
+  /// - vertex connectivity), connections are stored with a fixed
+  /// stride and no offsets. The connections can also be stored in
+  /// compressed form (delta and variable-length encoded) by an
+  /// explicit call to compress(), for connectivity that is kept but
+  /// not used for a while. Compressed connectivity can not be
+  /// accessed until decompress() is called: operator() then returns
+  /// a null pointer and Mesh::init(d0, d1) raises an error.
 
   class MeshConnectivity
   {
@@ -54,15 +63,24 @@ namespace dolfin
 
     /// Return true if the total number of connections is equal to zero
     bool empty() const
-    { return _connections.empty(); }
+    { return _connections.empty() && _compressed.empty(); }
+
+    /// Return true if connections are stored in compressed form
+    bool compressed() const
+    { return !_compressed.empty(); }
 
     /// Return total number of connections
     std::size_t size() const
-    { return _connections.size(); }
+    {
+      return _compressed.empty()
+        ? _connections.size() : _num_compressed_connections;
+    }
 
     /// Return number of connections for given entity
     std::size_t size(std::size_t entity) const
     {
+      if (_stride > 0)
+        return entity*_stride < _connections.size() ? _stride : 0;
       return ( (entity + 1) < index_to_position.size()
           ? index_to_position[entity + 1] - index_to_position[entity] : 0);
     }
@@ -82,6 +100,12 @@ namespace dolfin
     /// Return array of connections for given entity
     const unsigned int* operator() (std::size_t entity) const
     {
+      dolfin_assert(_compressed.empty());
+      if (_stride > 0)
+      {
+        return entity*_stride < _connections.size()
+          ? &_connections[entity*_stride] : 0;
+      }
       return ((entity + 1) < index_to_position.size()
         ? &_connections[index_to_position[entity]] : 0);
     }
@@ -109,13 +133,12 @@ namespace dolfin
     template<typename T>
     void set(std::size_t entity, const T& connections)
     {
-      dolfin_assert((entity + 1) < index_to_position.size());
-      dolfin_assert(connections.size()
-                    == index_to_position[entity + 1]-index_to_position[entity]);
+      dolfin_assert(entity < _num_entities);
+      dolfin_assert(connections.size() == size(entity));
 
       // Copy data
       std::copy(connections.begin(), connections.end(),
-                _connections.begin() + index_to_position[entity]);
+                _connections.begin() + position(entity));
     }
 
     /// Set all connections for given entity
@@ -129,15 +152,14 @@ namespace dolfin
       // Clear old data if any
       clear();
 
-      // Initialize offsets and compute total size
-      index_to_position.resize(connections.size() + 1);
-      unsigned int size = 0;
+      // Initialize offsets (unless all entities have the same number
+      // of connections) and compute total size
+      std::vector<std::size_t> num_connections(connections.size());
       for (std::size_t e = 0; e < connections.size(); e++)
-      {
-        index_to_position[e] = size;
-        size += connections[e].size();
-      }
-      index_to_position[connections.size()] = size;
+        num_connections[e] = connections[e].size();
+      init_offsets(num_connections);
+      const std::size_t size = num_connections.empty()
+        ? 0 : position(num_connections.size() - 1) + num_connections.back();
 
       // Initialize connections
       _connections.reserve(size);
@@ -150,22 +172,56 @@ namespace dolfin
     void
       set_global_size(const std::vector<unsigned int>& num_global_connections)
     {
-      dolfin_assert(num_global_connections.size()
-                    == index_to_position.size() - 1);
+      dolfin_assert(num_global_connections.size() == _num_entities);
       _num_global_connections = num_global_connections;
     }
 
     /// Hash of connections
     std::size_t hash() const;
 
+    /// Store connections in compressed form. Connections of each
+    /// entity are stored as differences to the previous connection,
+    /// encoded with a variable number of bytes. The connections can
+    /// not be accessed until decompress() is called, and the
+    /// connectivity must not be compressed while arrays returned by
+    /// operator() are in use.
+    void compress();
+
+    /// Restore connections stored in compressed form (does nothing if
+    /// not compressed)
+    void decompress();
+
+    /// Return number of bytes allocated for the connectivity
+    std::size_t memory_usage() const;
+
+    /// Return number of bytes the connectivity would use if stored
+    /// uncompressed with an offset for each entity (used to report
+    /// memory saved by fixed stride and compressed storage)
+    std::size_t memory_usage_uncompressed() const;
+
     /// Return informal string representation (pretty-print)
     std::string str(bool verbose) const;
 
   private:
 
+    // Initialize offsets for given number of connections of each
+    // entity, or fixed stride if equal for all entities
+    void init_offsets(const std::vector<std::size_t>& num_connections);
+
+    // Return position of first connection for given entity
+    std::size_t position(std::size_t entity) const
+    { return _stride > 0 ? entity*_stride : index_to_position[entity]; }
+
     // Dimensions (only used for pretty-printing)
     std::size_t _d0, _d1;
 
+    // Number of entities
+    std::size_t _num_entities;
+
+    // Number of connections for each entity if equal for all
+    // entities (zero otherwise, in which case offsets are stored)
+    std::size_t _stride;
+
     // Connections for all entities stored as a contiguous array
     std::vector<unsigned int> _connections;
 
@@ -173,9 +229,16 @@ namespace dolfin
     // computed)
     std::vector<unsigned int> _num_global_connections;
 
-    // Position of first connection for each entity (using local index)
+    // Position of first connection for each entity (using local
+    // index), empty for fixed stride
     std::vector<unsigned int> index_to_position;
 
+    // Compressed connections (empty unless compressed)
+    std::vector<unsigned char> _compressed;
+
+    // Total number of connections when compressed
+    std::size_t _num_compressed_connections;
+
   };
 
 }
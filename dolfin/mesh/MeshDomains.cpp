@@ -18,14 +18,22 @@
 // Modified by Garth N. Wells, 2012
 //
 // First added:  2011-08-29
-// Last changed: 2011-04-03
+// Last changed: 2016-10-18
 
+#include <algorithm>
 #include <limits>
 #include <dolfin/log/log.h>
 #include "MeshDomains.h"
 
 using namespace dolfin;
 
+// Compare markers by entity index
+static bool compare_entity_index(const std::pair<std::size_t, std::size_t>& a,
+                                 const std::pair<std::size_t, std::size_t>& b)
+{
+  return a.first < b.first;
+}
+
 //-----------------------------------------------------------------------------
 MeshDomains::MeshDomains()
 {
@@ -59,13 +67,14 @@ bool MeshDomains::is_empty() const
   return size == 0;
 }
 //-----------------------------------------------------------------------------
-std::map<std::size_t, std::size_t>& MeshDomains::markers(std::size_t dim)
+boost::container::flat_map<std::size_t, std::size_t>&
+MeshDomains::markers(std::size_t dim)
 {
   dolfin_assert(dim < _markers.size());
   return _markers[dim];
 }
 //-----------------------------------------------------------------------------
-const std::map<std::size_t, std::size_t>&
+const boost::container::flat_map<std::size_t, std::size_t>&
 MeshDomains::markers(std::size_t dim) const
 {
   dolfin_assert(dim < _markers.size());
@@ -89,11 +98,73 @@ bool MeshDomains::set_marker(std::pair<std::size_t, std::size_t> marker,
   return new_entity_index;
 }
 //-----------------------------------------------------------------------------
+void MeshDomains::set_markers(const std::vector<std::size_t>& entity_indices,
+                              const std::vector<std::size_t>& values,
+                              std::size_t dim)
+{
+  dolfin_assert(dim < _markers.size());
+  dolfin_assert(entity_indices.size() == values.size());
+
+  // Sort new markers by entity index, keeping the last value for
+  // each entity
+  std::vector<std::pair<std::size_t, std::size_t>> new_markers(values.size());
+  for (std::size_t i = 0; i < values.size(); ++i)
+    new_markers[i] = std::make_pair(entity_indices[i], values[i]);
+  std::stable_sort(new_markers.begin(), new_markers.end(),
+                   compare_entity_index);
+  std::size_t num_new_markers = 0;
+  for (std::size_t i = 0; i < new_markers.size(); ++i)
+  {
+    if (num_new_markers > 0
+        && new_markers[num_new_markers - 1].first == new_markers[i].first)
+    {
+      new_markers[num_new_markers - 1].second = new_markers[i].second;
+    }
+    else
+      new_markers[num_new_markers++] = new_markers[i];
+  }
+  new_markers.resize(num_new_markers);
+
+  // Merge with existing markers, new markers taking precedence
+  const boost::container::flat_map<std::size_t, std::size_t>& old_markers
+    = _markers[dim];
+  std::vector<std::pair<std::size_t, std::size_t>> markers;
+  markers.reserve(old_markers.size() + new_markers.size());
+  boost::container::flat_map<std::size_t, std::size_t>::const_iterator
+    old_marker = old_markers.begin();
+  std::vector<std::pair<std::size_t, std::size_t>>::const_iterator
+    new_marker = new_markers.begin();
+  while (old_marker != old_markers.end() || new_marker != new_markers.end())
+  {
+    if (new_marker == new_markers.end()
+        || (old_marker != old_markers.end()
+            && old_marker->first < new_marker->first))
+    {
+      markers.push_back(std::make_pair(old_marker->first, old_marker->second));
+      ++old_marker;
+    }
+    else
+    {
+      if (old_marker != old_markers.end()
+          && old_marker->first == new_marker->first)
+      {
+        ++old_marker;
+      }
+      markers.push_back(*new_marker);
+      ++new_marker;
+    }
+  }
+
+  _markers[dim]
+    = boost::container::flat_map<std::size_t, std::size_t>(
+      boost::container::ordered_unique_range, markers.begin(), markers.end());
+}
+//-----------------------------------------------------------------------------
 std::size_t MeshDomains::get_marker(std::size_t entity_index,
                                     std::size_t dim) const
 {
   dolfin_assert(dim < _markers.size());
-  std::map<std::size_t, std::size_t>::const_iterator it
+  boost::container::flat_map<std::size_t, std::size_t>::const_iterator it
     = _markers[dim].find(entity_index);
   if (it == _markers[dim].end())
   {
@@ -18,13 +18,14 @@
 // Modified by Garth N. Wells, 2012
 //
 // First added:  2011-08-29
-// Last changed: 2012-04-03
+// Last changed: 2016-10-18
 
 #ifndef __MESH_DOMAINS_H
 #define __MESH_DOMAINS_H
 
-#include <map>
+#include <utility>
 #include <vector>
+#include <boost/container/flat_map.hpp>
 
 namespace dolfin
 {
@@ -36,7 +37,8 @@ namespace dolfin
   /// indicating for each entity in the subset the number of the
   /// subdomain. It should be noted that the subset does not need to
   /// contain all entities of any given dimension; entities not
-  /// contained in the subset are "unmarked".
+  /// contained in the subset are "unmarked". Markers are stored in
+  /// flat arrays sorted by entity index.
 
   class MeshDomains
   {
@@ -59,17 +61,26 @@ namespace dolfin
 
     /// Get subdomain markers for given dimension (shared pointer
     /// version)
-    std::map<std::size_t, std::size_t>& markers(std::size_t dim);
+    boost::container::flat_map<std::size_t, std::size_t>&
+      markers(std::size_t dim);
 
     /// Get subdomain markers for given dimension (const shared
     /// pointer version)
-    const std::map<std::size_t, std::size_t>& markers(std::size_t dim) const;
+    const boost::container::flat_map<std::size_t, std::size_t>&
+      markers(std::size_t dim) const;
 
     /// Set marker (entity index, marker value) of a given dimension
     /// d. Returns true if a new key is inserted, false otherwise.
     bool set_marker(std::pair<std::size_t, std::size_t> marker,
                     std::size_t dim);
 
+    /// Set markers for given entity indices of a given dimension
+    /// d. Existing markers of the entities are overwritten, and if an
+    /// entity appears more than once the last value is used.
+    void set_markers(const std::vector<std::size_t>& entity_indices,
+                     const std::vector<std::size_t>& values,
+                     std::size_t dim);
+
     /// Get marker (entity index, marker value) of a given dimension
     /// d. Throws an error if marker does not exist.
     std::size_t get_marker(std::size_t entity_index, std::size_t dim) const;
@@ -86,7 +97,8 @@ namespace dolfin
   private:
 
     // Subdomain markers for each geometric dimension
-    std::vector<std::map<std::size_t, std::size_t> > _markers;
+    std::vector<boost::container::flat_map<std::size_t, std::size_t> >
+      _markers;
 
   };
 
@@ -533,10 +533,11 @@ namespace dolfin
     dolfin_assert(dim <= D);
 
     // Get domain data
-    const std::map<std::size_t, std::size_t>& data = domains.markers(dim);
+    const boost::container::flat_map<std::size_t, std::size_t>& data
+      = domains.markers(dim);
 
     // Iterate over all values and copy into MeshFunctions
-    std::map<std::size_t, std::size_t>::const_iterator it;
+    boost::container::flat_map<std::size_t, std::size_t>::const_iterator it;
     for (it = data.begin(); it != data.end(); ++it)
     {
       // Get value collection entry data
@@ -592,10 +593,12 @@ namespace dolfin
     set_all(std::numeric_limits<T>::max());
 
     // Iterate over all values
-    boost::unordered_set<std::size_t> entities_values_set;
-    typename std::map<std::pair<std::size_t, std::size_t>, T>::const_iterator it;
-    const std::map<std::pair<std::size_t, std::size_t>, T>& values
-      = mesh_value_collection.values();
+    std::vector<bool> entity_value_set(_size, false);
+    std::size_t num_entity_values_set = 0;
+    typename boost::container::flat_map<std::pair<std::size_t, std::size_t>,
+                                        T>::const_iterator it;
+    const boost::container::flat_map<std::pair<std::size_t, std::size_t>, T>&
+      values = mesh_value_collection.values();
     for (it = values.begin(); it != values.end(); ++it)
     {
       // Get value collection entry data
@@ -620,12 +623,16 @@ namespace dolfin
       dolfin_assert(entity_index < _size);
       _values[entity_index] = value;
 
-      // Add entity index to set (used to check that all values are set)
-      entities_values_set.insert(entity_index);
+      // Mark entity (used to check that all values are set)
+      if (!entity_value_set[entity_index])
+      {
+        entity_value_set[entity_index] = true;
+        ++num_entity_values_set;
+      }
     }
 
     // Check that all values have been set, if not issue a debug message
-    if (entities_values_set.size() != _size)
+    if (num_entity_values_set != _size)
       dolfin_debug("Mesh value collection does not contain all values for all entities");
 
     return *this;
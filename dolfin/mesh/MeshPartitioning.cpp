@@ -1115,28 +1115,33 @@ void MeshPartitioning::build_mesh_domains(Mesh& mesh,
     }
 
     // Get data from mesh value collection
-    const std::map<std::pair<std::size_t, std::size_t>, std::size_t>& values
-      = mvc.values();
-
-    // Get map from mesh domains
-    std::map<std::size_t, std::size_t>& markers = mesh.domains().markers(d);
-
-    std::map<std::pair<std::size_t, std::size_t>,
-             std::size_t>::const_iterator it;
+    const boost::container::flat_map<std::pair<std::size_t, std::size_t>,
+                                     std::size_t>& values = mvc.values();
+
+    // Collect entity indices and markers
+    std::vector<std::size_t> entities;
+    std::vector<std::size_t> markers;
+    entities.reserve(values.size());
+    markers.reserve(values.size());
+    boost::container::flat_map<std::pair<std::size_t, std::size_t>,
+                               std::size_t>::const_iterator it;
     for (it = values.begin(); it != values.end(); ++it)
     {
       const std::size_t cell_index = it->first.first;
       const std::size_t local_entity_index = it->first.second;
 
       if (d == D)
-        markers[0] = it->second;
+        entities.push_back(cell_index);
       else
       {
         const Cell cell(mesh, cell_index);
-        const MeshEntity e(mesh, d, cell.entities(d)[local_entity_index]);
-        markers[e.index()] = it->second;
+        entities.push_back(cell.entities(d)[local_entity_index]);
       }
+      markers.push_back(it->second);
     }
+
+    // Set mesh domain markers
+    mesh.domains().set_markers(entities, markers, d);
   }
 }
 //-----------------------------------------------------------------------------
@@ -225,6 +225,10 @@ namespace dolfin
     const std::vector<std::size_t> global_entity_indices
       = mesh.topology().global_indices(D);
 
+    // Values are collected and inserted into the collection in bulk
+    std::vector<std::size_t> cell_indices, local_entities;
+    std::vector<T> values;
+
     // Add local (to this process) data to domain marker
     std::vector<std::size_t> off_process_global_cell_entities;
 
@@ -242,8 +246,9 @@ namespace dolfin
       {
         const std::size_t local_cell_index = data->second;
         const std::size_t entity_local_index = ldata[i].first.second;
-        const T value = ldata[i].second;
-        markers.set_value(local_cell_index, entity_local_index, value);
+        cell_indices.push_back(local_cell_index);
+        local_entities.push_back(entity_local_index);
+        values.push_back(ldata[i].second);
       }
       else
         off_process_global_cell_entities.push_back(global_cell_index);
@@ -318,11 +323,13 @@ namespace dolfin
       {
         const std::size_t local_cell_entity = received_data0[p][2*i];
         const std::size_t local_entity_index = received_data0[p][2*i + 1];
-        const T value = received_data1[p][i];
         dolfin_assert(local_cell_entity < mesh.num_cells());
-        markers.set_value(local_cell_entity, local_entity_index, value);
+        cell_indices.push_back(local_cell_entity);
+        local_entities.push_back(local_entity_index);
+        values.push_back(received_data1[p][i]);
       }
     }
+    markers.set_values(cell_indices, local_entities, values);
   }
   //---------------------------------------------------------------------------
 
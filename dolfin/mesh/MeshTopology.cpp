@@ -16,8 +16,9 @@
 // along with DOLFIN. If not, see <http://www.gnu.org/licenses/>.
 //
 // First added:  2006-05-08
-// Last changed: 2014-07-02
+// Last changed: 2016-10-18
 
+#include <limits>
 #include <numeric>
 #include <sstream>
 #include <dolfin/log/log.h>
@@ -29,6 +30,8 @@ using namespace dolfin;
 
 //-----------------------------------------------------------------------------
 MeshTopology::MeshTopology()
+  : _connectivity_budget(0), _access_count(0), _num_evictions(0),
+    _num_recomputations(0)
 {
   // Do nothing
 }
@@ -39,7 +42,13 @@ MeshTopology::MeshTopology(const MeshTopology& topology)
     global_num_entities(topology.global_num_entities),
     _global_indices(topology._global_indices),
     _shared_entities(topology._shared_entities),
-    connectivity(topology.connectivity)
+    connectivity(topology.connectivity),
+    _connectivity_budget(topology._connectivity_budget),
+    _last_access(topology._last_access),
+    _access_count(topology._access_count),
+    _evicted(topology._evicted),
+    _num_evictions(topology._num_evictions),
+    _num_recomputations(topology._num_recomputations)
 {
   // Do nothing
 }
@@ -61,6 +70,12 @@ MeshTopology& MeshTopology::operator= (const MeshTopology& topology)
   _global_indices = topology._global_indices;
   _shared_entities = topology._shared_entities;
   connectivity = topology.connectivity;
+  _connectivity_budget = topology._connectivity_budget;
+  _last_access = topology._last_access;
+  _access_count = topology._access_count;
+  _evicted = topology._evicted;
+  _num_evictions = topology._num_evictions;
+  _num_recomputations = topology._num_recomputations;
 
   return *this;
 }
@@ -107,6 +122,8 @@ void MeshTopology::clear()
   _global_indices.clear();
   _shared_entities.clear();
   connectivity.clear();
+  _last_access.clear();
+  _evicted.clear();
 }
 //-----------------------------------------------------------------------------
 void MeshTopology::clear(std::size_t d0, std::size_t d1)
@@ -134,6 +151,10 @@ void MeshTopology::init(std::size_t dim)
   for (std::size_t d0 = 0; d0 <= dim; d0++)
     for (std::size_t d1 = 0; d1 <= dim; d1++)
       connectivity[d0].push_back(MeshConnectivity(d0, d1));
+
+  // Initialize connectivity access data
+  _last_access.assign((dim + 1)*(dim + 1), 0);
+  _evicted.assign((dim + 1)*(dim + 1), false);
 }
 //-----------------------------------------------------------------------------
 void MeshTopology::init(std::size_t dim, std::size_t local_size,
@@ -202,6 +223,90 @@ const std::map<unsigned int, std::set<unsigned int>>&
   return e->second;
 }
 //-----------------------------------------------------------------------------
+void MeshTopology::touch(std::size_t d0, std::size_t d1) const
+{
+  // Access statistics are only needed to meet a memory budget
+  if (_connectivity_budget == 0)
+    return;
+
+  // Mesh::init is called by entity iterators inside threaded loops,
+  // so the counter and time stamps are updated atomically
+  const std::size_t k = d0*connectivity.size() + d1;
+  dolfin_assert(k < _last_access.size());
+  std::size_t access;
+  #pragma omp atomic capture
+  access = ++_access_count;
+  #pragma omp atomic write
+  _last_access[k] = access;
+}
+//-----------------------------------------------------------------------------
+void MeshTopology::computed(std::size_t d0, std::size_t d1)
+{
+  // Count recomputation of connectivity cleared to meet the budget
+  const std::size_t k = d0*connectivity.size() + d1;
+  dolfin_assert(k < _evicted.size());
+  if (_evicted[k])
+  {
+    _evicted[k] = false;
+    ++_num_recomputations;
+  }
+  touch(d0, d1);
+}
+//-----------------------------------------------------------------------------
+std::size_t MeshTopology::evict()
+{
+  if (_connectivity_budget == 0)
+    return 0;
+
+  std::size_t memory_usage = connectivity_memory_usage();
+  const std::size_t initial_memory_usage = memory_usage;
+
+  while (memory_usage > _connectivity_budget)
+  {
+    // Find least recently used recomputable connectivity
+    std::size_t e0 = 0, e1 = 0;
+    std::size_t oldest_access = std::numeric_limits<std::size_t>::max();
+    for (std::size_t i = 0; i < connectivity.size(); ++i)
+    {
+      for (std::size_t j = 0; j < connectivity[i].size(); ++j)
+      {
+        const std::size_t k = i*connectivity.size() + j;
+        if (!is_recomputable(i, j) || connectivity[i][j].empty()
+            || _last_access[k] >= oldest_access)
+        {
+          continue;
+        }
+        e0 = i;
+        e1 = j;
+        oldest_access = _last_access[k];
+      }
+    }
+
+    // Stop if nothing more can be cleared
+    if (oldest_access == std::numeric_limits<std::size_t>::max())
+      break;
+
+    log(TRACE, "Clearing connectivity %d - %d to meet memory budget.",
+        e0, e1);
+    MeshConnectivity& c = connectivity[e0][e1];
+    memory_usage -= c.memory_usage();
+    c.clear();
+    _evicted[e0*connectivity.size() + e1] = true;
+    ++_num_evictions;
+  }
+
+  return initial_memory_usage - memory_usage;
+}
+//-----------------------------------------------------------------------------
+std::size_t MeshTopology::connectivity_memory_usage() const
+{
+  std::size_t memory_usage = 0;
+  for (std::size_t d0 = 0; d0 < connectivity.size(); ++d0)
+    for (std::size_t d1 = 0; d1 < connectivity[d0].size(); ++d1)
+      memory_usage += connectivity[d0][d1].memory_usage();
+  return memory_usage;
+}
+//-----------------------------------------------------------------------------
 size_t MeshTopology::hash() const
 {
   return (*this)(dim(), 0).hash();
@@ -239,6 +344,31 @@ std::string MeshTopology::str(bool verbose) const
     }
     s << std::endl;
 
+    s << "  Memory used by connectivity: " << connectivity_memory_usage()
+      << " bytes";
+    if (_connectivity_budget > 0)
+      s << " (budget " << _connectivity_budget << " bytes)";
+    s << std::endl;
+    s << "  Connectivity cleared/recomputed: " << _num_evictions << "/"
+      << _num_recomputations << std::endl << std::endl;
+
+    s << "  Memory used (saved) by connectivity:" << std::endl << std::endl;
+    for (std::size_t d0 = 0; d0 <= _dim; d0++)
+    {
+      for (std::size_t d1 = 0; d1 <= _dim; d1++)
+      {
+        const MeshConnectivity& c = connectivity[d0][d1];
+        if (c.empty())
+          continue;
+        const std::size_t used = c.memory_usage();
+        const std::size_t uncompressed = c.memory_usage_uncompressed();
+        s << "    " << d0 << " - " << d1 << ": " << used << " ("
+          << (uncompressed > used ? uncompressed - used : 0) << ") bytes"
+          << (c.compressed() ? ", compressed" : "") << std::endl;
+      }
+    }
+    s << std::endl;
+
     for (std::size_t d0 = 0; d0 <= _dim; d0++)
     {
       for (std::size_t d1 = 0; d1 <= _dim; d1++)
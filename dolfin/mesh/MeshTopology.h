@@ -16,7 +16,7 @@
 // along with DOLFIN. If not, see <http://www.gnu.org/licenses/>.
 //
 // First added:  2006-05-08
-// Last changed: 2014-07-02
+// Last changed: 2016-10-18
 
 #ifndef __MESH_TOPOLOGY_H
 #define __MESH_TOPOLOGY_H
@@ -149,6 +149,58 @@ namespace dolfin
     const dolfin::MeshConnectivity& operator() (std::size_t d0,
                                                 std::size_t d1) const;
 
+    /// Set memory budget (in bytes) for connectivity that can be
+    /// recomputed, i.e. connectivity d0 - d1 with d0 <= d1 except
+    /// vertex-vertex (transposes and diagonal connectivity). When
+    /// Mesh::trim_connectivity is called and the memory used by all
+    /// connectivity exceeds the budget, such connectivity is
+    /// cleared, least recently used first, and recomputed on the
+    /// next call to Mesh::init(d0, d1). Connectivity is never cleared
+    /// by Mesh::init, so arrays returned by MeshConnectivity and
+    /// MeshEntity::entities stay valid until the next call to
+    /// Mesh::trim_connectivity. A budget of zero (default) means no
+    /// limit, in which case no access statistics are recorded.
+    void set_connectivity_budget(std::size_t num_bytes)
+    { _connectivity_budget = num_bytes; }
+
+    /// Return memory budget (in bytes) for connectivity
+    std::size_t connectivity_budget() const
+    { return _connectivity_budget; }
+
+    /// Return true if connectivity d0 - d1 may be cleared to meet
+    /// the memory budget
+    bool is_recomputable(std::size_t d0, std::size_t d1) const
+    { return d0 < d1 || (d0 == d1 && d0 > 0); }
+
+    /// Mark connectivity d0 - d1 as most recently used (called by
+    /// Mesh::init). Does nothing if no memory budget is set, and is
+    /// safe to call from several threads otherwise.
+    void touch(std::size_t d0, std::size_t d1) const;
+
+    /// Record that connectivity d0 - d1 has been computed, counting
+    /// recomputation of connectivity cleared to meet the memory
+    /// budget (called by Mesh::init)
+    void computed(std::size_t d0, std::size_t d1);
+
+    /// Clear recomputable connectivity, least recently used first,
+    /// until the memory
+    /// used by connectivity is within the budget (called by
+    /// Mesh::trim_connectivity). Returns number of bytes freed.
+    std::size_t evict();
+
+    /// Return number of bytes used by connectivity
+    std::size_t connectivity_memory_usage() const;
+
+    /// Return number of connectivities cleared to meet the memory
+    /// budget
+    std::size_t num_evictions() const
+    { return _num_evictions; }
+
+    /// Return number of connectivities recomputed after being
+    /// cleared to meet the memory budget
+    std::size_t num_recomputations() const
+    { return _num_recomputations; }
+
     /// Return hash based on the hash of cell-vertex connectivity
     size_t hash() const;
 
@@ -196,6 +248,21 @@ namespace dolfin
     // Connectivity for pairs of topological dimensions
     std::vector<std::vector<MeshConnectivity> > connectivity;
 
+    // Memory budget for recomputable connectivity (zero if unlimited)
+    std::size_t _connectivity_budget;
+
+    // Time of last access to each connectivity (d0*(dim + 1) + d1),
+    // counted in calls to touch()
+    mutable std::vector<std::size_t> _last_access;
+    mutable std::size_t _access_count;
+
+    // Flags for connectivity cleared to meet the memory budget
+    std::vector<bool> _evicted;
+
+    // Residency statistics
+    std::size_t _num_evictions;
+    std::size_t _num_recomputations;
+
   };
 
 }
@@ -18,14 +18,16 @@
 // Modified by Chris Richardson, 2013.
 //
 // First added:  2006-08-30
-// Last changed: 2013-05-22
+// Last changed: 2016-10-18
 
 #ifndef __MESH_VALUE_COLLECTION_H
 #define __MESH_VALUE_COLLECTION_H
 
-#include <map>
+#include <algorithm>
 #include <utility>
 #include <memory>
+#include <vector>
+#include <boost/container/flat_map.hpp>
 #include <dolfin/common/NoDeleter.h>
 #include <dolfin/common/Variable.h>
 #include <dolfin/log/log.h>
@@ -45,6 +47,11 @@ namespace dolfin
   /// entities through the corresponding cell index and local entity
   /// number (relative to the cell), not by global entity index, which
   /// means that data may be stored robustly to file.
+  ///
+  /// Values are stored in a flat array sorted by cell index and local
+  /// entity number. Inserting values one by one is fast if they are
+  /// inserted in increasing order; otherwise set_values() should be
+  /// used to insert many values at once.
 
   template <typename T>
   class MeshValueCollection : public Variable
@@ -211,6 +218,34 @@ namespace dolfin
     ///         an existing value.
     bool set_value(std::size_t entity_index, const T& value);
 
+    /// Set values for given entities defined by cell indices and
+    /// local entity indices. Existing values of the entities are
+    /// overwritten, and if an entity appears more than once the last
+    /// value is used.
+    ///
+    /// *Arguments*
+    ///     cell_indices (std::vector<std::size_t>)
+    ///         The indices of the cells.
+    ///     local_entities (std::vector<std::size_t>)
+    ///         The local indices of the entities relative to the cells.
+    ///     values (std::vector<T>)
+    ///         The values.
+    void set_values(const std::vector<std::size_t>& cell_indices,
+                    const std::vector<std::size_t>& local_entities,
+                    const std::vector<T>& values);
+
+    /// Set values for given entity indices. Existing values of the
+    /// entities are overwritten, and if an entity appears more than
+    /// once the last value is used.
+    ///
+    /// *Arguments*
+    ///     entity_indices (std::vector<std::size_t>)
+    ///         The indices of the entities.
+    ///     values (std::vector<T>)
+    ///         The values.
+    void set_values(const std::vector<std::size_t>& entity_indices,
+                    const std::vector<T>& values);
+
     /// Get marker value for given entity defined by a cell index and
     /// a local entity index
     ///
@@ -228,16 +263,18 @@ namespace dolfin
     /// Get all values
     ///
     /// *Returns*
-    ///     std::map<std::pair<std::size_t, std::size_t>, T>
+    ///     boost::container::flat_map<std::pair<std::size_t, std::size_t>, T>
     ///         A map from positions to values.
-    std::map<std::pair<std::size_t, std::size_t>, T>& values();
+    boost::container::flat_map<std::pair<std::size_t, std::size_t>, T>&
+      values();
 
     /// Get all values (const version)
     ///
     /// *Returns*
-    ///     std::map<std::pair<std::size_t, std::size_t>, T>
+    ///     boost::container::flat_map<std::pair<std::size_t, std::size_t>, T>
     ///         A map from positions to values.
-    const std::map<std::pair<std::size_t, std::size_t>, T>& values() const;
+    const boost::container::flat_map<std::pair<std::size_t, std::size_t>, T>&
+      values() const;
 
     /// Clear all values
     void clear();
@@ -255,14 +292,20 @@ namespace dolfin
 
   private:
 
+    // Insert values, sorting them and keeping the last value for each
+    // position
+    void insert_values(std::vector<std::pair<std::pair<std::size_t,
+                       std::size_t>, T>>& values);
+
     // Associated mesh
     std::shared_ptr<const Mesh> _mesh;
 
     // Topological dimension
     int _dim;
 
-    // The values
-    std::map<std::pair<std::size_t, std::size_t>, T> _values;
+    // The values, sorted by position
+    boost::container::flat_map<std::pair<std::size_t, std::size_t>, T>
+      _values;
 
   };
 
@@ -303,48 +346,9 @@ namespace dolfin
   template <typename T>
   MeshValueCollection<T>::MeshValueCollection(const MeshFunction<T>&
                                               mesh_function)
-    : Variable("m", "unnamed MeshValueCollection"), _mesh(mesh_function.mesh()),
-      _dim(mesh_function.dim())
+    : Variable("m", "unnamed MeshValueCollection"), _dim(-1)
   {
-    dolfin_assert(_mesh);
-    const std::size_t D = _mesh->topology().dim();
-
-    // Handle cells as a special case
-    if ((int) D == _dim)
-    {
-      for (std::size_t cell_index = 0; cell_index < mesh_function.size();
-           ++cell_index)
-      {
-        const std::pair<std::size_t, std::size_t> key(cell_index, 0);
-        _values.insert(std::make_pair(key, mesh_function[cell_index]));
-      }
-    }
-    else
-    {
-      _mesh->init(_dim, D);
-      const MeshConnectivity& connectivity = _mesh->topology()(_dim, D);
-      dolfin_assert(!connectivity.empty());
-      for (std::size_t entity_index = 0; entity_index < mesh_function.size();
-           ++entity_index)
-      {
-        // Find the cell
-        dolfin_assert(connectivity.size(entity_index) > 0);
-        const MeshEntity entity(*_mesh, _dim, entity_index);
-        for (std::size_t i = 0; i < entity.num_entities(D) ; ++i)
-        {
-          // Create cell
-          const Cell cell(*_mesh, connectivity(entity_index)[i]);
-
-          // Find the local entity index
-          const std::size_t local_entity = cell.index(entity);
-
-          // Insert into map
-          const std::pair<std::size_t, std::size_t> key(cell.index(),
-                                                        local_entity);
-          _values.insert(std::make_pair(key, mesh_function[entity_index]));
-        }
-      }
-    }
+    *this = mesh_function;
   }
   //---------------------------------------------------------------------------
   template <typename T>
@@ -368,45 +372,42 @@ namespace dolfin
     dolfin_assert(_mesh);
     const std::size_t D = _mesh->topology().dim();
 
-    // FIXME: Use iterators
-
-    // Handle cells as a special case
+    // Collect values for each entity of each cell, which gives the
+    // positions in increasing order
+    std::vector<std::pair<std::pair<std::size_t, std::size_t>, T>> values;
     if ((int) D == _dim)
     {
+      // Handle cells as a special case
+      values.reserve(mesh_function.size());
       for (std::size_t cell_index = 0; cell_index < mesh_function.size();
            ++cell_index)
       {
-        const std::pair<std::size_t, std::size_t> key(cell_index, 0);
-        _values.insert(std::make_pair(key, mesh_function[cell_index]));
+        values.push_back(std::make_pair(std::make_pair(cell_index, 0),
+                                        mesh_function[cell_index]));
       }
     }
     else
     {
-      _mesh->init(_dim, D);
-      const MeshConnectivity& connectivity = _mesh->topology()(_dim, D);
+      _mesh->init(_dim);
+      const MeshConnectivity& connectivity = _mesh->topology()(D, _dim);
       dolfin_assert(!connectivity.empty());
-      for (std::size_t entity_index = 0; entity_index < mesh_function.size();
-           ++entity_index)
+      const std::size_t num_cells = _mesh->num_cells();
+      values.reserve(connectivity.size());
+      for (std::size_t cell_index = 0; cell_index < num_cells; ++cell_index)
       {
-        // Find the cell
-        dolfin_assert(connectivity.size(entity_index) > 0);
-        const MeshEntity entity(*_mesh, _dim, entity_index);
-        for (std::size_t i = 0; i < entity.num_entities(D) ; ++i)
+        const unsigned int* entities = connectivity(cell_index);
+        for (std::size_t i = 0; i < connectivity.size(cell_index); ++i)
         {
-          // Create cell
-          const Cell cell(*_mesh, connectivity(entity_index)[i]);
-
-          // Find the local entity index
-          const std::size_t local_entity = cell.index(entity);
-
-          // Insert into map
-          const std::pair<std::size_t, std::size_t> key(cell.index(),
-                                                        local_entity);
-          _values.insert(std::make_pair(key, mesh_function[entity_index]));
+          values.push_back(std::make_pair(std::make_pair(cell_index, i),
+                                          mesh_function[entities[i]]));
         }
       }
     }
 
+    _values = boost::container::flat_map<std::pair<std::size_t, std::size_t>,
+                                         T>(boost::container::ordered_unique_range,
+                                            values.begin(), values.end());
+
     return *this;
   }
   //---------------------------------------------------------------------------
@@ -489,7 +490,8 @@ namespace dolfin
     }
 
     const std::pair<std::size_t, std::size_t> pos(cell_index, local_entity);
-    std::pair<typename std::map<std::pair<std::size_t, std::size_t>, T>::iterator, bool>
+    std::pair<typename boost::container::flat_map<std::pair<std::size_t,
+      std::size_t>, T>::iterator, bool>
       it = _values.insert(std::make_pair(pos, value));
 
     // If an item with same key already exists the value has not been
@@ -519,7 +521,7 @@ namespace dolfin
     {
       // Set local entity index to zero when we mark a cell
       const std::pair<std::size_t, std::size_t> pos(entity_index, 0);
-      std::pair<typename std::map<std::pair<std::size_t,
+      std::pair<typename boost::container::flat_map<std::pair<std::size_t,
         std::size_t>, T>::iterator, bool> it;
       it = _values.insert(std::make_pair(pos, value));
 
@@ -546,7 +548,7 @@ namespace dolfin
 
     // Add value
     const std::pair<std::size_t, std::size_t> pos(cell.index(), local_entity);
-    std::pair<typename std::map<std::pair<std::size_t,
+    std::pair<typename boost::container::flat_map<std::pair<std::size_t,
       std::size_t>, T>::iterator, bool> it;
     it = _values.insert(std::make_pair(pos, value));
 
@@ -559,13 +561,86 @@ namespace dolfin
   }
   //---------------------------------------------------------------------------
   template <typename T>
+  void MeshValueCollection<T>::set_values(
+    const std::vector<std::size_t>& cell_indices,
+    const std::vector<std::size_t>& local_entities,
+    const std::vector<T>& values)
+  {
+    dolfin_assert(_dim >= 0);
+    if (!_mesh)
+    {
+      dolfin_error("MeshValueCollection.h",
+                   "set values",
+                   "A mesh has not been associated with this MeshValueCollection");
+    }
+    dolfin_assert(cell_indices.size() == values.size());
+    dolfin_assert(local_entities.size() == values.size());
+
+    std::vector<std::pair<std::pair<std::size_t, std::size_t>, T>>
+      new_values(values.size());
+    for (std::size_t i = 0; i < values.size(); ++i)
+    {
+      new_values[i].first = std::make_pair(cell_indices[i], local_entities[i]);
+      new_values[i].second = values[i];
+    }
+    insert_values(new_values);
+  }
+  //---------------------------------------------------------------------------
+  template <typename T>
+  void MeshValueCollection<T>::set_values(
+    const std::vector<std::size_t>& entity_indices,
+    const std::vector<T>& values)
+  {
+    if (!_mesh)
+    {
+      dolfin_error("MeshValueCollection.h",
+                   "set values",
+                   "A mesh has not been associated with this MeshValueCollection");
+    }
+    dolfin_assert(_dim >= 0);
+    dolfin_assert(entity_indices.size() == values.size());
+
+    std::vector<std::pair<std::pair<std::size_t, std::size_t>, T>>
+      new_values(values.size());
+
+    // Special case when d = D
+    const std::size_t D = _mesh->topology().dim();
+    if (_dim == (int) D)
+    {
+      for (std::size_t i = 0; i < values.size(); ++i)
+      {
+        new_values[i].first = std::make_pair(entity_indices[i], 0);
+        new_values[i].second = values[i];
+      }
+    }
+    else
+    {
+      // Get mesh connectivity d --> D
+      _mesh->init(_dim, D);
+      const MeshConnectivity& connectivity = _mesh->topology()(_dim, D);
+      dolfin_assert(!connectivity.empty());
+
+      for (std::size_t i = 0; i < values.size(); ++i)
+      {
+        // Find the first cell and the local entity index
+        dolfin_assert(connectivity.size(entity_indices[i]) > 0);
+        const MeshEntity entity(*_mesh, _dim, entity_indices[i]);
+        const Cell cell(*_mesh, connectivity(entity_indices[i])[0]);
+        new_values[i].first = std::make_pair(cell.index(), cell.index(entity));
+        new_values[i].second = values[i];
+      }
+    }
+    insert_values(new_values);
+  }
+  //---------------------------------------------------------------------------
+  template <typename T>
   T MeshValueCollection<T>::get_value(std::size_t cell_index,
 				      std::size_t local_entity)
   {
     dolfin_assert(_dim >= 0);
 
     const std::pair<std::size_t, std::size_t> pos(cell_index, local_entity);
-    const typename std::map<std::pair<std::size_t,
+    const typename boost::container::flat_map<std::pair<std::size_t,
       std::size_t>, T>::const_iterator
       it = _values.find(pos);
 
@@ -581,14 +656,14 @@ namespace dolfin
   }
   //---------------------------------------------------------------------------
   template <typename T>
-  std::map<std::pair<std::size_t, std::size_t>, T>&
+  boost::container::flat_map<std::pair<std::size_t, std::size_t>, T>&
     MeshValueCollection<T>::values()
   {
     return _values;
   }
   //---------------------------------------------------------------------------
   template <typename T>
-  const std::map<std::pair<std::size_t, std::size_t>, T>&
+  const boost::container::flat_map<std::pair<std::size_t, std::size_t>, T>&
   MeshValueCollection<T>::values() const
   {
     return _values;
@@ -618,6 +693,62 @@ namespace dolfin
     return s.str();
   }
   //---------------------------------------------------------------------------
+  template <typename T>
+  void MeshValueCollection<T>::insert_values(
+    std::vector<std::pair<std::pair<std::size_t, std::size_t>, T>>& values)
+  {
+    typedef std::pair<std::pair<std::size_t, std::size_t>, T> value_type;
+
+    // Sort new values by position, keeping the last value for each
+    // position
+    std::stable_sort(values.begin(), values.end(),
+                     [](const value_type& a, const value_type& b)
+                     { return a.first < b.first; });
+    std::size_t num_values = 0;
+    for (std::size_t i = 0; i < values.size(); ++i)
+    {
+      if (num_values > 0 && values[num_values - 1].first == values[i].first)
+        values[num_values - 1].second = values[i].second;
+      else
+        values[num_values++] = values[i];
+    }
+    values.resize(num_values);
+
+    // Merge with existing values, new values taking precedence
+    if (!_values.empty())
+    {
+      std::vector<value_type> merged;
+      merged.reserve(_values.size() + values.size());
+      auto old_value = _values.begin();
+      auto new_value = values.begin();
+      while (old_value != _values.end() || new_value != values.end())
+      {
+        if (new_value == values.end()
+            || (old_value != _values.end()
+                && old_value->first < new_value->first))
+        {
+          merged.push_back(value_type(old_value->first, old_value->second));
+          ++old_value;
+        }
+        else
+        {
+          if (old_value != _values.end()
+              && old_value->first == new_value->first)
+          {
+            ++old_value;
+          }
+          merged.push_back(*new_value);
+          ++new_value;
+        }
+      }
+      values.swap(merged);
+    }
+
+    _values = boost::container::flat_map<std::pair<std::size_t, std::size_t>,
+                                         T>(boost::container::ordered_unique_range,
+                                            values.begin(), values.end());
+  }
+  //---------------------------------------------------------------------------
 
 }
 
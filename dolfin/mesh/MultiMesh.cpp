@@ -18,13 +18,16 @@
 // Modified by August Johansson 2014
 //
 // First added:  2013-08-05
-// Last changed: 2014-05-28
+// Last changed: 2016-10-18
 
+#include <algorithm>
+#include <limits>
 #include <dolfin/log/log.h>
 #include <dolfin/plot/plot.h>
 #include <dolfin/common/NoDeleter.h>
 #include <dolfin/geometry/BoundingBoxTree.h>
 #include <dolfin/geometry/SimplexQuadrature.h>
+#include <dolfin/parameter/GlobalParameters.h>
 #include "Cell.h"
 #include "Facet.h"
 #include "BoundaryMesh.h"
@@ -34,7 +37,7 @@
 using namespace dolfin;
 
 //-----------------------------------------------------------------------------
-MultiMesh::MultiMesh()
+MultiMesh::MultiMesh() : _quadrature_order(0)
 {
   // Set parameters
   parameters = default_parameters();
@@ -85,38 +88,81 @@ MultiMesh::collision_map_cut_cells(std::size_t part) const
   return _collision_maps_cut_cells[part];
 }
 //-----------------------------------------------------------------------------
-const std::map<unsigned int, quadrature_rule> &
+const std::map<unsigned int, quadrature_rule>&
 MultiMesh::quadrature_rule_cut_cells(std::size_t part) const
-
 {
   dolfin_assert(part < num_parts());
-  return _quadrature_rules_cut_cells[part];
+  _build_quadrature_rule_maps();
+  return _quadrature_rule_map_cut_cells[part];
 }
 //-----------------------------------------------------------------------------
 quadrature_rule
 MultiMesh::quadrature_rule_cut_cell(std::size_t part,
                                     unsigned int cell_index) const
 {
-  auto q = quadrature_rule_cut_cells(part);
-  return q[cell_index];
+  dolfin_assert(part < num_parts());
+
+  // Find cut cell number (return empty rule if not a cut cell)
+  const std::vector<unsigned int>& cells = _cut_cells[part];
+  const auto it = std::lower_bound(cells.begin(), cells.end(), cell_index);
+  if (it == cells.end() || *it != cell_index)
+    return quadrature_rule();
+
+  return _quadrature_rules_cut_cells[part].rule(it - cells.begin());
 }
 //-----------------------------------------------------------------------------
 const std::map<unsigned int, std::vector<quadrature_rule>>&
   MultiMesh::quadrature_rule_overlap(std::size_t part) const
 {
   dolfin_assert(part < num_parts());
-  return _quadrature_rules_overlap[part];
+  _build_quadrature_rule_maps();
+  return _quadrature_rule_map_overlap[part];
 }
 //-----------------------------------------------------------------------------
 const std::map<unsigned int, std::vector<quadrature_rule>>&
   MultiMesh::quadrature_rule_interface(std::size_t part) const
 {
   dolfin_assert(part < num_parts());
-  return _quadrature_rules_interface[part];
+  _build_quadrature_rule_maps();
+  return _quadrature_rule_map_interface[part];
 }
 //-----------------------------------------------------------------------------
 const std::map<unsigned int, std::vector<std::vector<double>>>&
   MultiMesh::facet_normals(std::size_t part) const
+{
+  dolfin_assert(part < num_parts());
+  _build_quadrature_rule_maps();
+  return _facet_normal_map[part];
+}
+//-----------------------------------------------------------------------------
+const std::vector<std::size_t>&
+MultiMesh::collision_offsets(std::size_t part) const
+{
+  dolfin_assert(part < num_parts());
+  return _collision_offsets[part];
+}
+//-----------------------------------------------------------------------------
+const QuadratureRules& MultiMesh::cut_cell_quadrature(std::size_t part) const
+{
+  dolfin_assert(part < num_parts());
+  return _quadrature_rules_cut_cells[part];
+}
+//-----------------------------------------------------------------------------
+const QuadratureRules& MultiMesh::overlap_quadrature(std::size_t part) const
+{
+  dolfin_assert(part < num_parts());
+  return _quadrature_rules_overlap[part];
+}
+//-----------------------------------------------------------------------------
+const QuadratureRules&
+MultiMesh::interface_quadrature(std::size_t part) const
+{
+  dolfin_assert(part < num_parts());
+  return _quadrature_rules_interface[part];
+}
+//-----------------------------------------------------------------------------
+const std::vector<double>&
+MultiMesh::interface_normals(std::size_t part) const
 {
   dolfin_assert(part < num_parts());
   return _facet_normals[part];
@@ -165,12 +211,14 @@ void MultiMesh::build()
   // of quadrature rules: the cut cell qr, qr of the overlap part and
   // qr of the interface.
 
-  // Build quadrature rules of the cut cells' overlap. Do this before
-  // we build the quadrature rules of the cut cells
-  _build_quadrature_rules_overlap();
-
-  // Build quadrature rules of the cut cells
-  _build_quadrature_rules_cut_cells();
+  // Build quadrature rules of the cut cells, overlap and interface
+  // (no rules to reuse)
+  const std::vector<bool> moved(num_parts(), true);
+  const std::vector<std::vector<unsigned int>> old_cut_cells;
+  const std::vector<std::map<unsigned int,
+                             std::vector<std::pair<std::size_t, unsigned int>>>>
+    old_collision_maps;
+  _build_quadrature_rules(moved, old_cut_cells, old_collision_maps);
 
   end();
 }
@@ -185,9 +233,81 @@ void MultiMesh::clear()
   _covered_cells.clear();
   _collision_maps_cut_cells.clear();
   _collision_maps_cut_cells_boundary.clear();
+  _collision_offsets.clear();
   _quadrature_rules_cut_cells.clear();
   _quadrature_rules_overlap.clear();
   _quadrature_rules_interface.clear();
+  _facet_normals.clear();
+  _quadrature_rule_map_cut_cells.clear();
+  _quadrature_rule_map_overlap.clear();
+  _quadrature_rule_map_interface.clear();
+  _facet_normal_map.clear();
+}
+//-----------------------------------------------------------------------------
+void MultiMesh::update(const std::vector<std::size_t>& parts)
+{
+  // Check that multimesh has been built
+  if (_trees.size() != num_parts()
+      || _quadrature_rules_cut_cells.size() != num_parts())
+  {
+    dolfin_error("MultiMesh.cpp",
+                 "update multimesh",
+                 "Multimesh has not been built for the current parts; call build() first");
+  }
+
+  begin(PROGRESS, "Updating multimesh for %d moved part(s).", parts.size());
+
+  // Mark moved parts
+  std::vector<bool> moved(num_parts(), false);
+  for (std::size_t k = 0; k < parts.size(); k++)
+  {
+    if (parts[k] >= num_parts())
+    {
+      dolfin_error("MultiMesh.cpp",
+                   "update multimesh",
+                   "Part number %d is out of range (multimesh has %d parts)",
+                   parts[k], num_parts());
+    }
+    moved[parts[k]] = true;
+  }
+
+  // Update boundary meshes and bounding box trees of moved parts
+  for (std::size_t i = 0; i < num_parts(); i++)
+  {
+    if (!moved[i])
+      continue;
+
+    // Copy vertex coordinates to boundary mesh
+    BoundaryMesh& boundary_mesh = *_boundary_meshes[i];
+    if (boundary_mesh.num_vertices() > 0)
+    {
+      const MeshFunction<std::size_t>& vertex_map
+        = boundary_mesh.entity_map(0);
+      for (std::size_t v = 0; v < boundary_mesh.num_vertices(); v++)
+        boundary_mesh.geometry().set(v, _meshes[i]->geometry().x(vertex_map[v]));
+    }
+
+    // Refit trees for the new coordinates
+    _trees[i]->refit();
+    if (boundary_mesh.num_vertices() > 0)
+      _boundary_trees[i]->refit();
+  }
+
+  // Keep collision maps of previous build to compare against
+  std::vector<std::vector<unsigned int>> old_cut_cells;
+  std::vector<std::map<unsigned int,
+                       std::vector<std::pair<std::size_t, unsigned int>>>>
+    old_collision_maps;
+  std::swap(old_cut_cells, _cut_cells);
+  std::swap(old_collision_maps, _collision_maps_cut_cells);
+
+  // Rebuild collision maps
+  _build_collision_maps();
+
+  // Rebuild quadrature rules of cut cells affected by the move
+  _build_quadrature_rules(moved, old_cut_cells, old_collision_maps);
+
+  end();
 }
 //-----------------------------------------------------------------------------
 void MultiMesh::_build_boundary_meshes()
@@ -370,24 +490,25 @@ void MultiMesh::_build_collision_maps()
   end();
 }
 //-----------------------------------------------------------------------------
-void MultiMesh::_build_quadrature_rules_overlap()
+void MultiMesh::_build_quadrature_rules(const std::vector<bool>& moved,
+  const std::vector<std::vector<unsigned int>>& old_cut_cells,
+  const std::vector<std::map<unsigned int,
+  std::vector<std::pair<std::size_t, unsigned int>>>>& old_collision_maps)
 {
-  begin(PROGRESS, "Building quadrature rules of cut cells' overlap.");
+  begin(PROGRESS, "Building quadrature rules of cut cells, overlap and interface.");
 
   // Get quadrature order
   const std::size_t quadrature_order = parameters["quadrature_order"];
 
-  // Clear quadrature rules
-  _quadrature_rules_overlap.clear();
-  _quadrature_rules_interface.clear();
+  // Get number of threads
+  const std::size_t num_threads_param = dolfin::parameters["num_threads"];
+  const int num_threads = std::max((int) num_threads_param, 1);
 
-  // Resize quadrature rules
-  _quadrature_rules_overlap.resize(num_parts());
-  _quadrature_rules_interface.resize(num_parts());
-
-  // Clear and resize facet normals
-  _facet_normals.clear();
-  _facet_normals.resize(num_parts());
+  // Check whether we have rules from a previous build to reuse
+  const bool have_old_rules = quadrature_order == _quadrature_order
+    && old_cut_cells.size() == num_parts()
+    && old_collision_maps.size() == num_parts()
+    && _quadrature_rules_cut_cells.size() == num_parts();
 
   // FIXME: test prebuild map from boundary facets to full mesh cells
   // for all meshes: Loop over all boundary mesh facets to find the
@@ -398,9 +519,14 @@ void MultiMesh::_build_quadrature_rules_overlap()
   // the corresponding cell in the full mesh. This cell is to match
   // the cutting_cell_no.
 
-  // Build map from boundary facets to full mesh
-  std::vector<std::vector<std::vector<std::pair<std::size_t, std::size_t>>>>
+  // Build map from full mesh cells to boundary facets, and compute
+  // the inward normal of each boundary facet with respect to its
+  // full mesh cell. The normals are computed here and not when
+  // computing the rules in parallel since Cell::normal may compute
+  // mesh connectivity (Mesh::init), which is not thread-safe.
+  std::vector<std::vector<std::vector<std::size_t>>>
     full_to_bdry(num_parts());
+  std::vector<std::vector<Point>> boundary_normals(num_parts());
   for (std::size_t part = 0; part < num_parts(); ++part)
   {
     full_to_bdry[part].resize(_meshes[part]->num_cells());
@@ -417,6 +543,10 @@ void MultiMesh::_build_quadrature_rules_overlap()
     const MeshConnectivity& full_facet_cell_map
       = _meshes[part]->topology()(tdim_boundary, tdim);
 
+    // Generate cell to facet connectivity, needed for the facet normals
+    _meshes[part]->init(tdim, tdim_boundary);
+
+    boundary_normals[part].resize(boundary_cell_map.size());
     for (std::size_t boundary_facet = 0;
          boundary_facet < boundary_cell_map.size(); ++boundary_facet)
     {
@@ -427,301 +557,451 @@ void MultiMesh::_build_quadrature_rules_overlap()
       // can have 2 facets, but here we should only have 1)
       dolfin_assert(full_facet_cell_map.size(full_mesh_facet) == 1);
       const auto& full_cells = full_facet_cell_map(full_mesh_facet);
-      full_to_bdry[part][full_cells[0]].push_back(std::make_pair(boundary_facet,
-                                                                 full_mesh_facet));
+      full_to_bdry[part][full_cells[0]].push_back(boundary_facet);
+
+      // Compute inward normal of the facet
+      const Cell cell(*_meshes[part], full_cells[0]);
+      const Facet facet(*_meshes[part], full_mesh_facet);
+      boundary_normals[part][boundary_facet] = -cell.normal(cell.index(facet));
     }
   }
 
+  // Data structures for new quadrature rules
+  std::vector<std::vector<std::size_t>> collision_offsets(num_parts());
+  std::vector<QuadratureRules> quadrature_rules_cut_cells(num_parts());
+  std::vector<QuadratureRules> quadrature_rules_overlap(num_parts());
+  std::vector<QuadratureRules> quadrature_rules_interface(num_parts());
+  std::vector<std::vector<double>> facet_normals(num_parts());
+  std::size_t num_computed = 0;
+  std::size_t num_reused = 0;
+
   // Iterate over all parts
+  const std::size_t not_reused = std::numeric_limits<std::size_t>::max();
   for (std::size_t cut_part = 0; cut_part < num_parts(); cut_part++)
   {
-    // Iterate over cut cells for current part
-    const auto& cmap = collision_map_cut_cells(cut_part);
-    for (auto it = cmap.begin(); it != cmap.end(); ++it)
+    const std::size_t gdim = _meshes[cut_part]->geometry().dim();
+    const std::vector<unsigned int>& cut_cells = _cut_cells[cut_part];
+    const auto& cmap = _collision_maps_cut_cells[cut_part];
+    dolfin_assert(cmap.size() == cut_cells.size());
+
+    // Find the cut cells for which the rules of the previous build
+    // can be reused: the cut cell and all cutting cells are in parts
+    // that have not moved, and the cutting cells are the same. For
+    // these, store the number of the cut cell in the previous build.
+    std::vector<const std::vector<std::pair<std::size_t, unsigned int>>*>
+      cutting_cells(cut_cells.size());
+    std::vector<std::size_t> old_numbers(cut_cells.size(), not_reused);
+    std::vector<std::size_t> computed_cells;
+    std::size_t j = 0;
+    for (auto it = cmap.begin(); it != cmap.end(); ++it, ++j)
     {
-      // Get cut cell
-      const unsigned int cut_cell_index = it->first;
-      const Cell cut_cell(*(_meshes[cut_part]), cut_cell_index);
-
-      // Get dimensions
-      const std::size_t tdim = cut_cell.mesh().topology().dim();
-      const std::size_t gdim = cut_cell.mesh().geometry().dim();
+      dolfin_assert(it->first == cut_cells[j]);
+      cutting_cells[j] = &it->second;
 
-      // Data structure for the volume triangulation of the cut_cell
-      std::vector<double> volume_triangulation;
-
-      // Data structure for the overlap quadrature rule
-      std::vector<quadrature_rule> overlap_qr;
+      bool reuse = have_old_rules && !moved[cut_part];
+      for (auto jt = it->second.begin(); reuse && jt != it->second.end(); ++jt)
+        reuse = !moved[jt->first];
+      if (reuse)
+      {
+        const std::vector<unsigned int>& old_cells = old_cut_cells[cut_part];
+        const auto pos = std::lower_bound(old_cells.begin(), old_cells.end(),
+                                          it->first);
+        if (pos != old_cells.end() && *pos == it->first
+            && old_collision_maps[cut_part].find(it->first)->second == it->second)
+        {
+          old_numbers[j] = pos - old_cells.begin();
+        }
+      }
 
-      // Data structure for the interface quadrature rule
-      std::vector<quadrature_rule> interface_qr;
+      if (old_numbers[j] == not_reused)
+        computed_cells.push_back(j);
+    }
 
-      // Data structure for the facet normals of the interface. The
-      // numbering matches the numbering of interface_qr. This means
-      // we have one normal for each quadrature point, since this is
-      // how the data are grouped during assembly: for each pair of
-      // colliding cells, we build a list of quadrature points and a
-      // corresponding list of facet normals.
-      std::vector<std::vector<double>> interface_n;
+    // Compute quadrature rules for the remaining cut cells in
+    // parallel (the work per cut cell varies with the number of
+    // cutting cells, hence dynamic scheduling)
+    std::vector<CutCellQuadrature> quadrature(computed_cells.size());
+    const int num_computed_cells = computed_cells.size();
+    #pragma omp parallel for schedule(dynamic) num_threads(num_threads)
+    for (int k = 0; k < num_computed_cells; k++)
+    {
+      const std::size_t cut_cell_number = computed_cells[k];
+      _compute_quadrature_rules(quadrature[k], cut_part,
+                                cut_cells[cut_cell_number],
+                                *cutting_cells[cut_cell_number],
+                                full_to_bdry, boundary_normals,
+                                quadrature_order);
+    }
+    num_computed += computed_cells.size();
+    num_reused += cut_cells.size() - computed_cells.size();
+
+    // Store computed and reused rules in compressed row storage
+    std::vector<std::size_t>& offsets = collision_offsets[cut_part];
+    offsets.reserve(cut_cells.size() + 1);
+    offsets.push_back(0);
+    QuadratureRules& qr_cut_cells = quadrature_rules_cut_cells[cut_part];
+    QuadratureRules& qr_overlap = quadrature_rules_overlap[cut_part];
+    QuadratureRules& qr_interface = quadrature_rules_interface[cut_part];
+    std::vector<double>& normals = facet_normals[cut_part];
+    qr_cut_cells.clear(gdim);
+    qr_overlap.clear(gdim);
+    qr_interface.clear(gdim);
+    std::size_t k = 0;
+    for (j = 0; j < cut_cells.size(); j++)
+    {
+      const std::size_t num_collisions = cutting_cells[j]->size();
+      offsets.push_back(offsets.back() + num_collisions);
 
-      // Data structure for the interface triangulation
-      std::vector<double> interface_triangulation;
+      if (old_numbers[j] == not_reused)
+      {
+        // Copy computed rules
+        const CutCellQuadrature& q = quadrature[k++];
+        dolfin_assert(q.overlap_rules.size() == num_collisions);
+        dolfin_assert(q.interface_rules.size() == num_collisions);
+        dolfin_assert(q.normals.size() == num_collisions);
+        qr_cut_cells.push_back(q.cut_cell);
+        for (std::size_t c = 0; c < num_collisions; c++)
+        {
+          qr_overlap.push_back(q.overlap_rules[c]);
+          qr_interface.push_back(q.interface_rules[c]);
+          normals.insert(normals.end(), q.normals[c].begin(),
+                         q.normals[c].end());
+        }
+      }
+      else
+      {
+        // Copy rules of previous build
+        const std::size_t old_number = old_numbers[j];
+        const std::size_t c0 = _collision_offsets[cut_part][old_number];
+        const QuadratureRules& old_interface
+          = _quadrature_rules_interface[cut_part];
+        dolfin_assert(_collision_offsets[cut_part][old_number + 1] - c0
+                      == num_collisions);
+        qr_cut_cells.push_back(_quadrature_rules_cut_cells[cut_part],
+                               old_number);
+        for (std::size_t c = c0; c < c0 + num_collisions; c++)
+        {
+          qr_overlap.push_back(_quadrature_rules_overlap[cut_part], c);
+          qr_interface.push_back(old_interface, c);
+        }
+        const std::vector<double>& old_normals = _facet_normals[cut_part];
+        normals.insert(normals.end(),
+                       old_normals.begin() + gdim*old_interface.offset(c0),
+                       old_normals.begin()
+                       + gdim*old_interface.offset(c0 + num_collisions));
+      }
+    }
+    dolfin_assert(normals.size() == gdim*qr_interface.num_points());
+  }
 
-      // Data structure for normals to the interface. The numbering
-      // should match the numbering of interface_triangulation.
-      std::vector<Point> triangulation_normals;
+  log(PROGRESS, "Computed quadrature rules for %d cut cells, reused %d.",
+      num_computed, num_reused);
 
-      // Iterate over cutting cells
-      const auto& cutting_cells = it->second;
-      for (auto jt = cutting_cells.begin(); jt != cutting_cells.end(); jt++)
-      {
-        // Get cutting part and cutting cell
-        const std::size_t cutting_part = jt->first;
-        const std::size_t cutting_cell_index = jt->second;
-        const Cell cutting_cell(*(_meshes[cutting_part]), cutting_cell_index);
+  // Store new quadrature rules
+  std::swap(_collision_offsets, collision_offsets);
+  std::swap(_quadrature_rules_cut_cells, quadrature_rules_cut_cells);
+  std::swap(_quadrature_rules_overlap, quadrature_rules_overlap);
+  std::swap(_quadrature_rules_interface, quadrature_rules_interface);
+  std::swap(_facet_normals, facet_normals);
+  _quadrature_order = quadrature_order;
 
-        // Topology of this cut part
-        const std::size_t tdim_boundary = _boundary_meshes[cutting_part]->topology().dim();
+  // Clear maps created from previous quadrature rules
+  _quadrature_rule_map_cut_cells.clear();
+  _quadrature_rule_map_overlap.clear();
+  _quadrature_rule_map_interface.clear();
+  _facet_normal_map.clear();
 
-        // Must have the same topology at the moment (FIXME)
-        dolfin_assert(cutting_cell.mesh().topology().dim() == tdim);
+  end();
+}
+//-----------------------------------------------------------------------------
+void MultiMesh::_compute_quadrature_rules(CutCellQuadrature& quadrature,
+  std::size_t cut_part,
+  unsigned int cut_cell_index,
+  const std::vector<std::pair<std::size_t, unsigned int>>& cutting_cells,
+  const std::vector<std::vector<std::vector<std::size_t>>>& full_to_bdry,
+  const std::vector<std::vector<Point>>& boundary_normals,
+  std::size_t quadrature_order) const
+{
+  // Get cut cell
+  const Cell cut_cell(*(_meshes[cut_part]), cut_cell_index);
+
+  // Get dimensions
+  const std::size_t tdim = cut_cell.mesh().topology().dim();
+  const std::size_t gdim = cut_cell.mesh().geometry().dim();
+
+  // Data structure for the volume triangulation of the cut_cell
+  std::vector<double> volume_triangulation;
+
+  // Data structure for the overlap quadrature rule
+  std::vector<quadrature_rule>& overlap_qr = quadrature.overlap_rules;
+  overlap_qr.clear();
+
+  // Data structure for the interface quadrature rule
+  std::vector<quadrature_rule>& interface_qr = quadrature.interface_rules;
+  interface_qr.clear();
+
+  // Data structure for the facet normals of the interface. The
+  // numbering matches the numbering of interface_qr. This means
+  // we have one normal for each quadrature point, since this is
+  // how the data are grouped during assembly: for each pair of
+  // colliding cells, we build a list of quadrature points and a
+  // corresponding list of facet normals.
+  std::vector<std::vector<double>>& interface_n = quadrature.normals;
+  interface_n.clear();
+
+  // Data structure for the interface triangulation
+  std::vector<double> interface_triangulation;
+
+  // Data structure for normals to the interface. The numbering
+  // should match the numbering of interface_triangulation.
+  std::vector<Point> triangulation_normals;
+
+  // Iterate over cutting cells
+  for (auto jt = cutting_cells.begin(); jt != cutting_cells.end(); jt++)
+  {
+    // Get cutting part and cutting cell
+    const std::size_t cutting_part = jt->first;
+    const std::size_t cutting_cell_index = jt->second;
+    const Cell cutting_cell(*(_meshes[cutting_part]), cutting_cell_index);
 
-        // Data structure for local interface triangulation
-        std::vector<double> local_interface_triangulation;
+    // Topology of this cut part
+    const std::size_t tdim_boundary = _boundary_meshes[cutting_part]->topology().dim();
 
-        // Data structure for the local interface normals. The
-        // numbering should match the numbering of
-        // local_interface_triangulation.
-        std::vector<Point> local_triangulation_normals;
+    // Must have the same topology at the moment (FIXME)
+    dolfin_assert(cutting_cell.mesh().topology().dim() == tdim);
 
-        // Data structure for the overlap part quadrature rule
-        quadrature_rule overlap_part_qr;
+    // Data structure for local interface triangulation
+    std::vector<double> local_interface_triangulation;
 
-        // Data structure for the interface part quadrature rule
-        quadrature_rule interface_part_qr;
+    // Data structure for the local interface normals. The
+    // numbering should match the numbering of
+    // local_interface_triangulation.
+    std::vector<Point> local_triangulation_normals;
 
-        // Data structure for the interface part facet normals. The
-        // numbering matches the numbering of interface_part_qr.
-        std::vector<double> interface_part_n;
+    // Data structure for the overlap part quadrature rule
+    quadrature_rule overlap_part_qr;
 
-        // Iterate over boundary cells
-        for (auto boundary_cell_index : full_to_bdry[cutting_part][cutting_cell_index])
-        {
-          // Get the boundary facet as a cell in the boundary mesh
-          const Cell boundary_cell(*_boundary_meshes[cutting_part],
-                                   boundary_cell_index.first);
+    // Data structure for the interface part quadrature rule
+    quadrature_rule interface_part_qr;
 
-          // Get the boundary facet as a facet in the full mesh
-          const Facet boundary_facet(*_meshes[cutting_part],
-                                     boundary_cell_index.second);
+    // Data structure for the interface part facet normals. The
+    // numbering matches the numbering of interface_part_qr.
+    std::vector<double> interface_part_n;
 
-          // Triangulate intersection of cut cell and boundary cell
-          const auto triangulation_cut_boundary
-            = cut_cell.triangulate_intersection(boundary_cell);
+    // Iterate over boundary cells
+    for (auto boundary_cell_index : full_to_bdry[cutting_part][cutting_cell_index])
+    {
+      // Get the boundary facet as a cell in the boundary mesh
+      const Cell boundary_cell(*_boundary_meshes[cutting_part],
+                               boundary_cell_index);
 
-          // The normals to triangulation_cut_boundary
-          std::vector<Point> normals_cut_boundary;
+      // Get the inward normal of the boundary facet
+      const Point& n = boundary_normals[cutting_part][boundary_cell_index];
 
-          // Add quadrature rule and normals for triangulation
-          if (triangulation_cut_boundary.size())
-          {
-            dolfin_assert(interface_part_n.size() == interface_part_qr.first.size());
-
-            const auto num_qr_points
-              = _add_quadrature_rule(interface_part_qr,
-                                     triangulation_cut_boundary,
-                                     tdim_boundary, gdim,
-                                     quadrature_order, 1);
-
-            const std::size_t local_facet_index = cutting_cell.index(boundary_facet);
-            const Point n = -cutting_cell.normal(local_facet_index);
-            for (std::size_t i = 0; i < num_qr_points.size(); ++i)
-            {
-              _add_normal(interface_part_n,
-                          n,
-                          num_qr_points[i],
-                          gdim);
-              normals_cut_boundary.push_back(n);
-            }
-
-            dolfin_assert(interface_part_n.size() == interface_part_qr.first.size());
-          }
+      // Triangulate intersection of cut cell and boundary cell
+      const auto triangulation_cut_boundary
+        = cut_cell.triangulate_intersection(boundary_cell);
 
-          // Triangulate intersection of boundary cell and previous volume triangulation
-          const auto triangulation_boundary_prev_volume
-            = IntersectionTriangulation::triangulate_intersection(boundary_cell,
-                                                                  volume_triangulation,
-                                                                  tdim);
+      // The normals to triangulation_cut_boundary
+      std::vector<Point> normals_cut_boundary;
 
-          // Add quadrature rule and normals for triangulation
-          if (triangulation_boundary_prev_volume.size())
-          {
-            dolfin_assert(interface_part_n.size() == interface_part_qr.first.size());
-
-            const auto num_qr_points
-              = _add_quadrature_rule(interface_part_qr,
-                                     triangulation_boundary_prev_volume,
-                                     tdim_boundary, gdim,
-                                     quadrature_order, -1);
-
-            const std::size_t local_facet_index = cutting_cell.index(boundary_facet);
-            const Point n = -cutting_cell.normal(local_facet_index);
-            for (std::size_t i = 0; i < num_qr_points.size(); ++i)
-              _add_normal(interface_part_n,
-                          n,
-                          num_qr_points[i],
-                          gdim);
-
-            dolfin_assert(interface_part_n.size() == interface_part_qr.first.size());
-          }
+      // Add quadrature rule and normals for triangulation
+      if (triangulation_cut_boundary.size())
+      {
+        dolfin_assert(interface_part_n.size() == interface_part_qr.first.size());
 
-          // Update triangulation
-          local_interface_triangulation.insert(local_interface_triangulation.end(),
-                                               triangulation_cut_boundary.begin(),
-                                               triangulation_cut_boundary.end());
+        const auto num_qr_points
+          = _add_quadrature_rule(interface_part_qr,
+                                 triangulation_cut_boundary,
+                                 tdim_boundary, gdim,
+                                 quadrature_order, 1);
 
-          // Update interface facet normals
-          local_triangulation_normals.insert(local_triangulation_normals.end(),
-                                             normals_cut_boundary.begin(),
-                                             normals_cut_boundary.end());
+        for (std::size_t i = 0; i < num_qr_points.size(); ++i)
+        {
+          _add_normal(interface_part_n,
+                      n,
+                      num_qr_points[i],
+                      gdim);
+          normals_cut_boundary.push_back(n);
         }
 
-        // Triangulate the intersection of the previous interface
-        // triangulation and the cutting cell (to remove)
-        std::vector<double> triangulation_prev_cutting;
-        std::vector<Point> normals_prev_cutting;
-        IntersectionTriangulation::triangulate_intersection(cutting_cell,
-                                                            interface_triangulation,
-                                                            triangulation_normals,
-                                                            triangulation_prev_cutting,
-                                                            normals_prev_cutting,
-                                                            tdim_boundary);
-
-        // Add quadrature rule for triangulation
-        if (triangulation_prev_cutting.size())
-        {
-          dolfin_assert(interface_part_n.size() == interface_part_qr.first.size());
+        dolfin_assert(interface_part_n.size() == interface_part_qr.first.size());
+      }
 
-          const auto num_qr_points
-            = _add_quadrature_rule(interface_part_qr,
-                                   triangulation_prev_cutting,
-                                   tdim_boundary, gdim,
-                                   quadrature_order, -1);
+      // Triangulate intersection of boundary cell and previous volume triangulation
+      const auto triangulation_boundary_prev_volume
+        = IntersectionTriangulation::triangulate_intersection(boundary_cell,
+                                                              volume_triangulation,
+                                                              tdim);
 
-          for (std::size_t i = 0; i < num_qr_points.size(); ++i)
-            _add_normal(interface_part_n,
-                        normals_prev_cutting[i],
-                        num_qr_points[i],
-                        gdim);
+      // Add quadrature rule and normals for triangulation
+      if (triangulation_boundary_prev_volume.size())
+      {
+        dolfin_assert(interface_part_n.size() == interface_part_qr.first.size());
 
-          dolfin_assert(interface_part_n.size() == interface_part_qr.first.size());
-        }
+        const auto num_qr_points
+          = _add_quadrature_rule(interface_part_qr,
+                                 triangulation_boundary_prev_volume,
+                                 tdim_boundary, gdim,
+                                 quadrature_order, -1);
 
-        // Update triangulation
-        interface_triangulation.insert(interface_triangulation.end(),
-                                       local_interface_triangulation.begin(),
-                                       local_interface_triangulation.end());
-
-        // Update normals
-        triangulation_normals.insert(triangulation_normals.end(),
-                                     local_triangulation_normals.begin(),
-                                     local_triangulation_normals.end());
-
-        // Do the volume segmentation
-
-        // Compute volume triangulation of intersection of cut and cutting cells
-        const auto triangulation_cut_cutting
-          = cut_cell.triangulate_intersection(cutting_cell);
-
-        // Compute triangulation of intersection of cutting cell and
-        // the (previous) volume triangulation
-        const auto triangulation_cutting_prev
-          = IntersectionTriangulation::triangulate_intersection(cutting_cell,
-                                                                volume_triangulation,
-                                                                tdim);
-
-        // Add these new triangulations
-        volume_triangulation.insert(volume_triangulation.end(),
-                                    triangulation_cut_cutting.begin(),
-                                    triangulation_cut_cutting.end());
-
-        // Add quadrature rule with weights corresponding to the two
-        // triangulations
-        _add_quadrature_rule(overlap_part_qr,
-                             triangulation_cut_cutting,
-                             tdim, gdim, quadrature_order, 1);
-        _add_quadrature_rule(overlap_part_qr,
-                             triangulation_cutting_prev,
-                             tdim, gdim, quadrature_order, -1);
-
-        // Add quadrature rule for overlap part
-        overlap_qr.push_back(overlap_part_qr);
-
-        // Add quadrature rule for interface part
-        interface_qr.push_back(interface_part_qr);
-
-        // Add facet normal for interface part
-        interface_n.push_back(interface_part_n);
+        for (std::size_t i = 0; i < num_qr_points.size(); ++i)
+          _add_normal(interface_part_n,
+                      n,
+                      num_qr_points[i],
+                      gdim);
+
+        dolfin_assert(interface_part_n.size() == interface_part_qr.first.size());
       }
 
-      // Store quadrature rules for cut cell
-      _quadrature_rules_overlap[cut_part][cut_cell_index] = overlap_qr;
-      _quadrature_rules_interface[cut_part][cut_cell_index] = interface_qr;
+      // Update triangulation
+      local_interface_triangulation.insert(local_interface_triangulation.end(),
+                                           triangulation_cut_boundary.begin(),
+                                           triangulation_cut_boundary.end());
+
+      // Update interface facet normals
+      local_triangulation_normals.insert(local_triangulation_normals.end(),
+                                         normals_cut_boundary.begin(),
+                                         normals_cut_boundary.end());
+    }
+
+    // Triangulate the intersection of the previous interface
+    // triangulation and the cutting cell (to remove)
+    std::vector<double> triangulation_prev_cutting;
+    std::vector<Point> normals_prev_cutting;
+    IntersectionTriangulation::triangulate_intersection(cutting_cell,
+                                                        interface_triangulation,
+                                                        triangulation_normals,
+                                                        triangulation_prev_cutting,
+                                                        normals_prev_cutting,
+                                                        tdim_boundary);
+
+    // Add quadrature rule for triangulation
+    if (triangulation_prev_cutting.size())
+    {
+      dolfin_assert(interface_part_n.size() == interface_part_qr.first.size());
+
+      const auto num_qr_points
+        = _add_quadrature_rule(interface_part_qr,
+                               triangulation_prev_cutting,
+                               tdim_boundary, gdim,
+                               quadrature_order, -1);
 
-      // Store facet normals for cut cell
-      _facet_normals[cut_part][cut_cell_index] = interface_n;
+      for (std::size_t i = 0; i < num_qr_points.size(); ++i)
+        _add_normal(interface_part_n,
+                    normals_prev_cutting[i],
+                    num_qr_points[i],
+                    gdim);
+
+      dolfin_assert(interface_part_n.size() == interface_part_qr.first.size());
     }
+
+    // Update triangulation
+    interface_triangulation.insert(interface_triangulation.end(),
+                                   local_interface_triangulation.begin(),
+                                   local_interface_triangulation.end());
+
+    // Update normals
+    triangulation_normals.insert(triangulation_normals.end(),
+                                 local_triangulation_normals.begin(),
+                                 local_triangulation_normals.end());
+
+    // Do the volume segmentation
+
+    // Compute volume triangulation of intersection of cut and cutting cells
+    const auto triangulation_cut_cutting
+      = cut_cell.triangulate_intersection(cutting_cell);
+
+    // Compute triangulation of intersection of cutting cell and
+    // the (previous) volume triangulation
+    const auto triangulation_cutting_prev
+      = IntersectionTriangulation::triangulate_intersection(cutting_cell,
+                                                            volume_triangulation,
+                                                            tdim);
+
+    // Add these new triangulations
+    volume_triangulation.insert(volume_triangulation.end(),
+                                triangulation_cut_cutting.begin(),
+                                triangulation_cut_cutting.end());
+
+    // Add quadrature rule with weights corresponding to the two
+    // triangulations
+    _add_quadrature_rule(overlap_part_qr,
+                         triangulation_cut_cutting,
+                         tdim, gdim, quadrature_order, 1);
+    _add_quadrature_rule(overlap_part_qr,
+                         triangulation_cutting_prev,
+                         tdim, gdim, quadrature_order, -1);
+
+    // Add quadrature rule for overlap part
+    overlap_qr.push_back(overlap_part_qr);
+
+    // Add quadrature rule for interface part
+    interface_qr.push_back(interface_part_qr);
+
+    // Add facet normal for interface part
+    interface_n.push_back(interface_part_n);
   }
 
-  end();
+  // Compute quadrature rule for the cut cell itself
+  quadrature_rule& qr = quadrature.cut_cell;
+  qr = SimplexQuadrature::compute_quadrature_rule(cut_cell, quadrature_order);
+
+  // Add the quadrature rule for the overlapping part to the
+  // quadrature rule of the cut cell with flipped sign
+  for (std::size_t k = 0; k < overlap_qr.size(); k++)
+    _add_quadrature_rule(qr, overlap_qr[k], gdim, -1);
 }
 //-----------------------------------------------------------------------------
-void MultiMesh::_build_quadrature_rules_cut_cells()
+void MultiMesh::_build_quadrature_rule_maps() const
 {
-  begin(PROGRESS, "Building quadrature rules of cut cells.");
-
-  // FIXME: Do we want to check to make sure we
-  // have the same order in the overlapping part?
-
-  // Get quadrature order
-  const std::size_t quadrature_order = parameters["quadrature_order"];
-
-  // Clear quadrature rules
-  _quadrature_rules_cut_cells.clear();
-  _quadrature_rules_cut_cells.resize(num_parts());
+  // Skip if already created
+  const std::size_t num_built = _quadrature_rules_cut_cells.size();
+  if (_quadrature_rule_map_cut_cells.size() == num_built)
+    return;
+
+  _quadrature_rule_map_cut_cells.assign(num_built,
+                                        std::map<unsigned int, quadrature_rule>());
+  _quadrature_rule_map_overlap.assign(num_built,
+    std::map<unsigned int, std::vector<quadrature_rule>>());
+  _quadrature_rule_map_interface.assign(num_built,
+    std::map<unsigned int, std::vector<quadrature_rule>>());
+  _facet_normal_map.assign(num_built,
+    std::map<unsigned int, std::vector<std::vector<double>>>());
 
   // Iterate over all parts
-  for (std::size_t cut_part = 0; cut_part < num_parts(); cut_part++)
+  for (std::size_t part = 0; part < num_built; part++)
   {
-    // Iterate over cut cells for current part
-    const auto& cmap = collision_map_cut_cells(cut_part);
-    for (auto it = cmap.begin(); it != cmap.end(); ++it)
+    const std::vector<unsigned int>& cut_cells = _cut_cells[part];
+    const std::vector<std::size_t>& offsets = _collision_offsets[part];
+    const QuadratureRules& qr_interface = _quadrature_rules_interface[part];
+    const std::vector<double>& normals = _facet_normals[part];
+    const std::size_t gdim = qr_interface.gdim();
+
+    // Iterate over cut cells
+    for (std::size_t j = 0; j < cut_cells.size(); j++)
     {
-      // Get cut cell
-      const unsigned int cut_cell_index = it->first;
-      const Cell cut_cell(*(_meshes[cut_part]), cut_cell_index);
-
-      // Get dimension
-      const std::size_t gdim = cut_cell.mesh().geometry().dim();
+      const unsigned int cut_cell_index = cut_cells[j];
+      _quadrature_rule_map_cut_cells[part][cut_cell_index]
+        = _quadrature_rules_cut_cells[part].rule(j);
 
-      // Compute quadrature rule for the cell itself.
-      auto qr = SimplexQuadrature::compute_quadrature_rule(cut_cell,
-                                                           quadrature_order);
-
-      // Get the quadrature rule for the overlapping part
-      const auto& qr_overlap = _quadrature_rules_overlap[cut_part][cut_cell_index];
-
-      // Add the quadrature rule for the overlapping part to the
-      // quadrature rule of the cut cell with flipped sign
-      for (std::size_t k = 0; k < qr_overlap.size(); k++)
-        _add_quadrature_rule(qr, qr_overlap[k], gdim, -1);
-
-      // Store quadrature rule for cut cell
-      _quadrature_rules_cut_cells[cut_part][cut_cell_index] = qr;
+      // Iterate over cutting cells
+      std::vector<quadrature_rule>& overlap_qr
+        = _quadrature_rule_map_overlap[part][cut_cell_index];
+      std::vector<quadrature_rule>& interface_qr
+        = _quadrature_rule_map_interface[part][cut_cell_index];
+      std::vector<std::vector<double>>& interface_n
+        = _facet_normal_map[part][cut_cell_index];
+      for (std::size_t c = offsets[j]; c < offsets[j + 1]; c++)
+      {
+        overlap_qr.push_back(_quadrature_rules_overlap[part].rule(c));
+        interface_qr.push_back(qr_interface.rule(c));
+        interface_n.push_back(std::vector<double>(
+          normals.begin() + gdim*qr_interface.offset(c),
+          normals.begin() + gdim*qr_interface.offset(c + 1)));
+      }
     }
   }
-
-  end();
 }
 //-----------------------------------------------------------------------------
 std::vector<std::size_t>
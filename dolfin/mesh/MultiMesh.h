@@ -16,7 +16,7 @@
 // along with DOLFIN. If not, see <http://www.gnu.org/licenses/>.
 //
 // First added:  2014-03-03
-// Last changed: 2014-06-17
+// Last changed: 2016-10-18
 
 #ifndef __MULTI_MESH_H
 #define __MULTI_MESH_H
@@ -28,6 +28,7 @@
 #include <dolfin/plot/plot.h>
 #include <dolfin/common/Variable.h>
 #include <dolfin/geometry/Point.h>
+#include "QuadratureRules.h"
 
 namespace dolfin
 {
@@ -45,7 +46,9 @@ namespace dolfin
   /// overlaps. A multimesh may be created from a set of standard
   /// meshes spaces by repeatedly calling add(), followed by a call to
   /// build(). Note that a multimesh is not useful until build() has
-  /// been called.
+  /// been called. When some parts have been moved, update() may be
+  /// called instead of build() to recompute only the data that is
+  /// affected by the moved parts.
 
   class MultiMesh : public Variable
   {
@@ -228,6 +231,75 @@ namespace dolfin
     const std::map<unsigned int, std::vector<std::vector<double> > >&
     facet_normals(std::size_t part) const;
 
+    /// Return offsets into the flattened collision lists of the cut
+    /// cells of the given part. The cutting cells of cut cell number
+    /// j (in the list of cut cells) are given collision numbers
+    /// offsets[j] to offsets[j + 1] - 1, in the same order as in the
+    /// collision map. The collision numbers index the quadrature
+    /// rules of overlap_quadrature() and interface_quadrature().
+    ///
+    /// *Arguments*
+    ///     part (std::size_t)
+    ///         The part number
+    ///
+    /// *Returns*
+    ///     std::vector<std::size_t>
+    ///         Offsets into the collision lists (number of cut cells
+    ///         + 1 values).
+    const std::vector<std::size_t>& collision_offsets(std::size_t part) const;
+
+    /// Return quadrature rules for the cut cells of the given part,
+    /// with rule j for cut cell number j (in the list of cut cells)
+    ///
+    /// *Arguments*
+    ///     part (std::size_t)
+    ///         The part number
+    ///
+    /// *Returns*
+    ///     _QuadratureRules_
+    ///         The quadrature rules in compressed row storage
+    const QuadratureRules& cut_cell_quadrature(std::size_t part) const;
+
+    /// Return quadrature rules for the overlap on the given part,
+    /// with one rule for each collision number (see
+    /// collision_offsets())
+    ///
+    /// *Arguments*
+    ///     part (std::size_t)
+    ///         The part number
+    ///
+    /// *Returns*
+    ///     _QuadratureRules_
+    ///         The quadrature rules in compressed row storage
+    const QuadratureRules& overlap_quadrature(std::size_t part) const;
+
+    /// Return quadrature rules for the interface on the given part,
+    /// with one rule for each collision number (see
+    /// collision_offsets())
+    ///
+    /// *Arguments*
+    ///     part (std::size_t)
+    ///         The part number
+    ///
+    /// *Returns*
+    ///     _QuadratureRules_
+    ///         The quadrature rules in compressed row storage
+    const QuadratureRules& interface_quadrature(std::size_t part) const;
+
+    /// Return facet normals for the interface on the given part, one
+    /// for each quadrature point of interface_quadrature(). The
+    /// normal of quadrature point p is stored at positions gdim*p to
+    /// gdim*(p + 1) - 1.
+    ///
+    /// *Arguments*
+    ///     part (std::size_t)
+    ///         The part number
+    ///
+    /// *Returns*
+    ///     std::vector<double>
+    ///         The facet normals (flattened num_points x gdim array)
+    const std::vector<double>& interface_normals(std::size_t part) const;
+
     /// Return the bounding box tree for the mesh of the given part
     ///
     /// *Arguments*
@@ -270,6 +342,20 @@ namespace dolfin
     /// Build multimesh
     void build();
 
+    /// Update multimesh after the given parts have been moved (the
+    /// vertex coordinates have changed but not the topology). The
+    /// boundary meshes and bounding box trees of the moved parts are
+    /// updated and the collision maps are recomputed. Quadrature
+    /// rules are recomputed only for cut cells whose list of cutting
+    /// cells has changed or which belong to or are cut by a moved
+    /// part; the rules of all other cut cells are kept. Note that
+    /// build() must have been called before update().
+    ///
+    /// *Arguments*
+    ///     parts (std::vector<std::size_t>)
+    ///         The part numbers of the moved parts
+    void update(const std::vector<std::size_t>& parts);
+
     /// Clear multimesh
     void clear();
 
@@ -333,11 +419,12 @@ namespace dolfin
     //     j = the cell number (in the list of covered cells)
     std::vector<std::vector<unsigned int> > _covered_cells;
 
-    // Developer note 1: The data structures _collision_map_cut_cells
-    // and _quadrature_rules_cut_cells may be changed from maps to
-    // vectors and indexed by the number of the cut cell (in the list
-    // of cut cells), instead of indexed by the local cell index as
-    // here, if we find that this is important for performance.
+    // Developer note 1: The quadrature rules are stored in compressed
+    // row storage and indexed by the number of the cut cell (in the
+    // list of cut cells) or by the collision number, instead of in
+    // maps indexed by the local cell index. The maps returned by
+    // quadrature_rule_cut_cells() etc are created from these on
+    // first access.
     //
     // Developer note 2: Quadrature points are naturally a part of a
     // form (or a term in a form) and not a part of a mesh. However,
@@ -365,60 +452,79 @@ namespace dolfin
                          std::vector<std::pair<std::size_t, unsigned int> > > >
     _collision_maps_cut_cells_boundary;
 
-    // Quadrature rules for cut cells. Access data by
+    // Offsets into the flattened collision lists of the cut cells.
+    // The collision numbers of cut cell j of part i are
     //
-    //     q = _quadrature_rules_cut_cells[i][j]
+    //     _collision_offsets[i][j] to _collision_offsets[i][j + 1] - 1
     //
-    // where
-    //
-    //     q.first  = quadrature weights, array of length num_points
-    //     q.second = quadrature points, flattened num_points x gdim array
-    //            i = the part (mesh) number
-    //            j = the cell number (local cell index)
-    std::vector<std::map<unsigned int, quadrature_rule> >
-    _quadrature_rules_cut_cells;
+    // where j is the cell number (in the list of cut cells)
+    std::vector<std::vector<std::size_t> > _collision_offsets;
 
-    // Quadrature rules for overlap. Access data by
+    // Quadrature rules for cut cells. Access data by
+    //
+    //     q = _quadrature_rules_cut_cells[i]
     //
-    //     q = _quadrature_rules_overlap[i][j][k]
+    //     q.points(j)  = quadrature points, flattened num_points x gdim array
+    //     q.weights(j) = quadrature weights, array of length num_points
     //
     // where
     //
-    //     q.first  = quadrature weights, array of length num_points
-    //     q.second = quadrature points, flattened num_points x gdim array
-    //            i = the part (mesh) number
-    //            j = the cell number (local cell index)
-    //            k = the collision number (in the list of cutting cells)
-    std::vector<std::map<unsigned int, std::vector<quadrature_rule> > >
-    _quadrature_rules_overlap;
+    //     i = the part (mesh) number
+    //     j = the cell number (in the list of cut cells)
+    std::vector<QuadratureRules> _quadrature_rules_cut_cells;
 
-    // Quadrature rules for interface. Access data by
+    // Quadrature rules for overlap. Access data by
     //
-    //     q = _quadrature_rules_interface[i][j][k]
+    //     q = _quadrature_rules_overlap[i]
+    //
+    //     q.points(c)  = quadrature points, flattened num_points x gdim array
+    //     q.weights(c) = quadrature weights, array of length num_points
     //
     // where
     //
-    //     q.first  = quadrature weights, array of length num_points
-    //     q.second = quadrature points, flattened num_points x gdim array
-    //            i = the part (mesh) number
-    //            j = the cell number (local cell index)
-    //            k = the collision number (in the list of cutting cells)
-    std::vector<std::map<unsigned int, std::vector<quadrature_rule> > >
-    _quadrature_rules_interface;
+    //     i = the part (mesh) number
+    //     c = the collision number (see _collision_offsets)
+    std::vector<QuadratureRules> _quadrature_rules_overlap;
+
+    // Quadrature rules for interface. Access data as for
+    // _quadrature_rules_overlap
+    std::vector<QuadratureRules> _quadrature_rules_interface;
 
     // Facet normals for interface. Access data by
     //
-    //     n = _facet_normals_interface[i][j][k][
+    //     n = &_facet_normals[i][gdim*p]
     //
     // where
     //
-    //     n = a flattened array vector of facet normals, one point for
-    //         each quadrature point
+    //     n = the facet normal at quadrature point p
     //     i = the part (mesh) number
-    //     j = the cell number (local cell index)
-    //     k = the collision number (in the list of cutting cells)
-    std::vector<std::map<unsigned int, std::vector<std::vector<double> > > >
-    _facet_normals;
+    //     p = the point number in _quadrature_rules_interface[i]
+    std::vector<std::vector<double> > _facet_normals;
+
+    // Quadrature order used for the stored quadrature rules
+    std::size_t _quadrature_order;
+
+    // Maps from cell indices of cut cells to quadrature rules and
+    // facet normals, created from the compressed row storage on
+    // first access (see Developer note 1)
+    mutable std::vector<std::map<unsigned int, quadrature_rule> >
+    _quadrature_rule_map_cut_cells;
+    mutable std::vector<std::map<unsigned int, std::vector<quadrature_rule> > >
+    _quadrature_rule_map_overlap;
+    mutable std::vector<std::map<unsigned int, std::vector<quadrature_rule> > >
+    _quadrature_rule_map_interface;
+    mutable std::vector<std::map<unsigned int, std::vector<std::vector<double> > > >
+    _facet_normal_map;
+
+    // Quadrature rules and facet normals computed for a single cut
+    // cell (one overlap and interface rule for each cutting cell)
+    struct CutCellQuadrature
+    {
+      quadrature_rule cut_cell;
+      std::vector<quadrature_rule> overlap_rules;
+      std::vector<quadrature_rule> interface_rules;
+      std::vector<std::vector<double> > normals;
+    };
 
     // Build boundary meshes
     void _build_boundary_meshes();
@@ -431,11 +537,28 @@ namespace dolfin
     //void _build_collision_maps_same_topology();
     //void _build_collision_maps_different_topology();
 
-    // Build quadrature rules for the cut cells
-    void _build_quadrature_rules_cut_cells();
-
-    // Build quadrature rules for the overlap
-    void _build_quadrature_rules_overlap();
+    // Build quadrature rules for the cut cells, overlap and
+    // interface. Rules are reused for cut cells that are not in a
+    // moved part, have the same cutting cells as in the given old
+    // collision maps, and are not cut by a moved part.
+    void _build_quadrature_rules(const std::vector<bool>& moved,
+      const std::vector<std::vector<unsigned int> >& old_cut_cells,
+      const std::vector<std::map<unsigned int,
+      std::vector<std::pair<std::size_t, unsigned int> > > >& old_collision_maps);
+
+    // Compute quadrature rules for cut cell (overlap and interface
+    // for each cutting cell, and the cut cell itself)
+    void _compute_quadrature_rules(CutCellQuadrature& quadrature,
+      std::size_t cut_part,
+      unsigned int cut_cell_index,
+      const std::vector<std::pair<std::size_t, unsigned int> >& cutting_cells,
+      const std::vector<std::vector<std::vector<std::size_t> > >& full_to_bdry,
+      const std::vector<std::vector<Point> >& boundary_normals,
+      std::size_t quadrature_order) const;
+
+    // Create maps from cell indices of cut cells to quadrature rules
+    // and facet normals (if not already created)
+    void _build_quadrature_rule_maps() const;
 
     // Add quadrature rule for simplices in the triangulation
     // array. Returns the number of points generated for each simplex.
@@ -0,0 +1,85 @@
+// Copyright (C) 2016 The FEniCS Project
+//
+// This file is part of DOLFIN.
+//
+// DOLFIN is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// DOLFIN is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with DOLFIN. If not, see <http://www.gnu.org/licenses/>.
+//
+// First added:  2016-10-18
+// Last changed: 2016-10-18
+
+#include "QuadratureRules.h"
+
+using namespace dolfin;
+
+//-----------------------------------------------------------------------------
+QuadratureRules::QuadratureRules(std::size_t gdim)
+  : _gdim(gdim), _offsets(1, 0)
+{
+  // Do nothing
+}
+//-----------------------------------------------------------------------------
+QuadratureRules::~QuadratureRules()
+{
+  // Do nothing
+}
+//-----------------------------------------------------------------------------
+std::pair<std::vector<double>, std::vector<double> >
+QuadratureRules::rule(std::size_t i) const
+{
+  dolfin_assert(i + 1 < _offsets.size());
+  std::pair<std::vector<double>, std::vector<double> > qr;
+  qr.first.assign(_points.begin() + _gdim*_offsets[i],
+                  _points.begin() + _gdim*_offsets[i + 1]);
+  qr.second.assign(_weights.begin() + _offsets[i],
+                   _weights.begin() + _offsets[i + 1]);
+  return qr;
+}
+//-----------------------------------------------------------------------------
+void QuadratureRules::push_back(const std::pair<std::vector<double>,
+                                                std::vector<double> >& rule)
+{
+  dolfin_assert(rule.first.size() == _gdim*rule.second.size());
+  _points.insert(_points.end(), rule.first.begin(), rule.first.end());
+  _weights.insert(_weights.end(), rule.second.begin(), rule.second.end());
+  _offsets.push_back(_weights.size());
+}
+//-----------------------------------------------------------------------------
+void QuadratureRules::push_back(const QuadratureRules& rules, std::size_t i)
+{
+  dolfin_assert(rules._gdim == _gdim);
+  dolfin_assert(i + 1 < rules._offsets.size());
+  const std::size_t begin = rules._offsets[i];
+  const std::size_t end = rules._offsets[i + 1];
+  _points.insert(_points.end(), rules._points.begin() + _gdim*begin,
+                 rules._points.begin() + _gdim*end);
+  _weights.insert(_weights.end(), rules._weights.begin() + begin,
+                  rules._weights.begin() + end);
+  _offsets.push_back(_weights.size());
+}
+//-----------------------------------------------------------------------------
+void QuadratureRules::clear(std::size_t gdim)
+{
+  _gdim = gdim;
+  _offsets.assign(1, 0);
+  _points.clear();
+  _weights.clear();
+}
+//-----------------------------------------------------------------------------
+void QuadratureRules::reserve(std::size_t num_rules, std::size_t num_points)
+{
+  _offsets.reserve(num_rules + 1);
+  _points.reserve(_gdim*num_points);
+  _weights.reserve(num_points);
+}
+//-----------------------------------------------------------------------------
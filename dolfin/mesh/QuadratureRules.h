@@ -0,0 +1,132 @@
+// Copyright (C) 2016 The FEniCS Project
+//
+// This file is part of DOLFIN.
+//
+// DOLFIN is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// DOLFIN is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with DOLFIN. If not, see <http://www.gnu.org/licenses/>.
+//
+// First added:  2016-10-18
+// Last changed: 2016-10-18
+
+#ifndef __QUADRATURE_RULES_H
+#define __QUADRATURE_RULES_H
+
+#include <utility>
+#include <vector>
+#include <dolfin/log/log.h>
+
+namespace dolfin
+{
+
+  /// This class stores a list of quadrature rules in compressed row
+  /// storage. The points (a flattened num_points x gdim array) and
+  /// the weights of all rules are stored in two contiguous arrays,
+  /// and rule i consists of the points numbered offset(i) to
+  /// offset(i + 1) - 1. Data attached to the quadrature points (such
+  /// as facet normals) may be stored in arrays indexed by the same
+  /// point numbers.
+
+  class QuadratureRules
+  {
+  public:
+
+    /// Create empty list of quadrature rules
+    ///
+    /// *Arguments*
+    ///     gdim (std::size_t)
+    ///         The geometric dimension of the quadrature points.
+    explicit QuadratureRules(std::size_t gdim=0);
+
+    /// Destructor
+    ~QuadratureRules();
+
+    /// Return the number of quadrature rules
+    std::size_t size() const
+    { return _offsets.size() - 1; }
+
+    /// Return the geometric dimension of the quadrature points
+    std::size_t gdim() const
+    { return _gdim; }
+
+    /// Return the total number of quadrature points of all rules
+    std::size_t num_points() const
+    { return _weights.size(); }
+
+    /// Return the number of quadrature points of rule i
+    std::size_t num_points(std::size_t i) const
+    {
+      dolfin_assert(i + 1 < _offsets.size());
+      return _offsets[i + 1] - _offsets[i];
+    }
+
+    /// Return the number of the first quadrature point of rule i
+    std::size_t offset(std::size_t i) const
+    {
+      dolfin_assert(i < _offsets.size());
+      return _offsets[i];
+    }
+
+    /// Return the quadrature points of rule i (flattened
+    /// num_points(i) x gdim array)
+    const double* points(std::size_t i) const
+    {
+      dolfin_assert(i + 1 < _offsets.size());
+      return _points.data() + _gdim*_offsets[i];
+    }
+
+    /// Return the quadrature weights of rule i
+    const double* weights(std::size_t i) const
+    {
+      dolfin_assert(i + 1 < _offsets.size());
+      return _weights.data() + _offsets[i];
+    }
+
+    /// Return a copy of rule i as a pair of a flattened array of
+    /// quadrature points and an array of quadrature weights
+    std::pair<std::vector<double>, std::vector<double> >
+    rule(std::size_t i) const;
+
+    /// Append quadrature rule given as a pair of a flattened array of
+    /// quadrature points and an array of quadrature weights
+    void push_back(const std::pair<std::vector<double>,
+                                   std::vector<double> >& rule);
+
+    /// Append rule i of another list of quadrature rules
+    void push_back(const QuadratureRules& rules, std::size_t i);
+
+    /// Remove all rules and set the geometric dimension
+    void clear(std::size_t gdim);
+
+    /// Reserve space for the given number of rules and points
+    void reserve(std::size_t num_rules, std::size_t num_points);
+
+  private:
+
+    // Geometric dimension
+    std::size_t _gdim;
+
+    // Offsets into the arrays of points and weights for each rule
+    // (size equal to the number of rules + 1)
+    std::vector<std::size_t> _offsets;
+
+    // Quadrature points (flattened num_points x gdim array)
+    std::vector<double> _points;
+
+    // Quadrature weights
+    std::vector<double> _weights;
+
+  };
+
+}
+
+#endif
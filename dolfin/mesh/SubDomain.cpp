@@ -26,6 +26,7 @@
 #include <dolfin/log/Progress.h>
 #include "Mesh.h"
 #include "MeshData.h"
+#include "MeshDomains.h"
 #include "MeshEntity.h"
 #include "MeshEntityIterator.h"
 #include "Vertex.h"
@@ -35,6 +36,26 @@
 
 using namespace dolfin;
 
+// Set value of entities of mesh function
+template<typename T>
+static void set_markers(MeshFunction<T>& sub_domains,
+                        const std::vector<std::size_t>& entities,
+                        T sub_domain)
+{
+  for (std::size_t i = 0; i < entities.size(); ++i)
+    sub_domains[entities[i]] = sub_domain;
+}
+
+// Set value of entities of mesh value collection
+template<typename T>
+static void set_markers(MeshValueCollection<T>& sub_domains,
+                        const std::vector<std::size_t>& entities,
+                        T sub_domain)
+{
+  sub_domains.set_values(entities,
+                         std::vector<T>(entities.size(), sub_domain));
+}
+
 //-----------------------------------------------------------------------------
 SubDomain::SubDomain(const double map_tol) : map_tolerance(map_tol),
                                              _geometric_dimension(0)
@@ -83,8 +104,7 @@ void SubDomain::mark(Mesh& mesh,
 {
   //dolfin_assert(mesh.domains().markers(dim));
   //dolfin_error("Not yet updated (SubDomain::mark) ");
-  apply_markers(mesh.domains().markers(dim), dim, sub_domain, mesh,
-                check_midpoint);
+  apply_markers(mesh.domains(), dim, sub_domain, mesh, check_midpoint);
 }
 //-----------------------------------------------------------------------------
 void SubDomain::mark(MeshFunction<std::size_t>& sub_domains,
@@ -193,6 +213,7 @@ void SubDomain::apply_markers(S& sub_domains,
   bool on_boundary = false;
 
   // Compute sub domain markers
+  std::vector<std::size_t> marked_entities;
   Progress p("Computing sub domain markers", mesh.num_entities(dim));
   for (MeshEntityIterator entity(mesh, dim); !entity.end(); ++entity)
   {
@@ -237,21 +258,24 @@ void SubDomain::apply_markers(S& sub_domains,
 
     // Mark entity with all vertices inside
     if (all_points_inside)
-      sub_domains.set_value(entity->index(), sub_domain);
+      marked_entities.push_back(entity->index());
 
     p++;
   }
+
+  // Set markers of marked entities
+  set_markers(sub_domains, marked_entities, sub_domain);
 }
 //-----------------------------------------------------------------------------
 template<typename T>
-void SubDomain::apply_markers(std::map<std::size_t, std::size_t>& sub_domains,
+void SubDomain::apply_markers(MeshDomains& sub_domains,
                               std::size_t dim,
                               T sub_domain,
                               const Mesh& mesh,
                               bool check_midpoint) const
 {
   // FIXME: This function can probably be folded into the above
-  //        function operator[] in std::map and MeshFunction.
+  //        function.
 
   log(TRACE, "Computing sub domain markers for sub domain %d.", sub_domain);
 
@@ -277,6 +301,7 @@ void SubDomain::apply_markers(std::map<std::size_t, std::size_t>& sub_domains,
   bool on_boundary = false;
 
   // Compute sub domain markers
+  std::vector<std::size_t> marked_entities;
   Progress p("Computing sub domain markers", mesh.num_entities(dim));
   for (MeshEntityIterator entity(mesh, dim); !entity.end(); ++entity)
   {
@@ -321,9 +346,14 @@ void SubDomain::apply_markers(std::map<std::size_t, std::size_t>& sub_domains,
 
     // Mark entity with all vertices inside
     if (all_points_inside)
-      sub_domains[entity->index()] =  sub_domain;
+      marked_entities.push_back(entity->index());
 
     p++;
   }
+
+  // Set markers of marked entities
+  sub_domains.set_markers(marked_entities,
+                          std::vector<std::size_t>(marked_entities.size(),
+                                                   sub_domain), dim);
 }
 //-----------------------------------------------------------------------------
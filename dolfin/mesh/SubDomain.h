@@ -22,7 +22,6 @@
 #define __SUB_DOMAIN_H
 
 #include <cstddef>
-#include <map>
 #include <dolfin/common/constants.h>
 
 namespace dolfin
@@ -30,6 +29,7 @@ namespace dolfin
 
   // Forward declarations
   class Mesh;
+  class MeshDomains;
   template <typename T> class MeshFunction;
   template <typename T> class MeshValueCollection;
   template <typename T> class Array;
@@ -267,7 +267,7 @@ namespace dolfin
                        bool check_midpoint) const;
 
     template<typename T>
-      void apply_markers(std::map<std::size_t, std::size_t>& sub_domains,
+      void apply_markers(MeshDomains& sub_domains,
                          std::size_t dim,
                          T sub_domain,
                          const Mesh& mesh,
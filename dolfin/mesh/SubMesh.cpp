@@ -78,13 +78,13 @@ SubMesh::SubMesh(const Mesh& mesh, std::size_t sub_domain)
   }
 
   // Get cell markers
-  const std::map<std::size_t, std::size_t>& cell_markers
+  const boost::container::flat_map<std::size_t, std::size_t>& cell_markers
     = mesh.domains().markers(D);
 
   // Build vector for all cells to hold markers
   std::vector<std::size_t> sub_domains(mesh.num_cells(),
                                 std::numeric_limits<std::size_t>::max());
-  std::map<std::size_t, std::size_t>::const_iterator it;
+  boost::container::flat_map<std::size_t, std::size_t>::const_iterator it;
   for (it = cell_markers.begin(); it != cell_markers.end(); ++it)
     sub_domains[it->first] = it->second;
 
@@ -254,16 +254,16 @@ void SubMesh::init(const Mesh& mesh,
       entity_map.insert(std::make_pair(vertex_list, e->index()));
     }
 
-    // Get submesh marker map
-    std::map<std::size_t, std::size_t>& submesh_markers
-      = this->domains().markers(dim_t);
+    // Submesh entities and markers
+    std::vector<std::size_t> submesh_entities;
+    std::vector<std::size_t> submesh_markers;
 
     // Get values map from parent MeshValueCollection
-    const std::map<std::size_t, std::size_t>& parent_markers
+    const boost::container::flat_map<std::size_t, std::size_t>& parent_markers
       = parent_domains.markers(dim_t);
 
     // Iterate over all parents marker values
-    std::map<std::size_t, std::size_t>::const_iterator itt;
+    boost::container::flat_map<std::size_t, std::size_t>::const_iterator itt;
     for (itt = parent_markers.begin(); itt != parent_markers.end(); itt++)
     {
       // Create parent entity
@@ -297,7 +297,8 @@ void SubMesh::init(const Mesh& mesh,
           // Get submesh cell index
           const std::size_t submesh_cell_index
             = parent_to_submesh_cell_indices[parent_cell_index];
-	  submesh_markers[submesh_cell_index] = itt->second;
+	  submesh_entities.push_back(submesh_cell_index);
+	  submesh_markers.push_back(itt->second);
         }
 	else
 	{
@@ -311,10 +312,14 @@ void SubMesh::init(const Mesh& mesh,
             submesh_it = entity_map.find(parent_vertex_list);
           dolfin_assert(submesh_it != entity_map.end());
 
-          submesh_markers[submesh_it->second] = itt->second;
+          submesh_entities.push_back(submesh_it->second);
+          submesh_markers.push_back(itt->second);
 	}
       }
     }
+
+    // Set submesh markers
+    this->domains().set_markers(submesh_entities, submesh_markers, dim_t);
   }
 
 }
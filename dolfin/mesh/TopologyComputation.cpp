@@ -21,6 +21,8 @@
 // Last changed: 2014-07-02
 
 #include <algorithm>
+#include <limits>
+#include <string>
 #include <vector>
 #include <boost/multi_array.hpp>
 #include <boost/unordered_map.hpp>
@@ -29,6 +31,7 @@
 #include <dolfin/common/Timer.h>
 #include <dolfin/common/utils.h>
 #include <dolfin/log/log.h>
+#include <dolfin/parameter/GlobalParameters.h>
 #include "Cell.h"
 #include "CellType.h"
 #include "Mesh.h"
@@ -39,6 +42,97 @@
 
 using namespace dolfin;
 
+// Number of bits of vertex indices sorted per radix sort pass
+static const unsigned int radix_bits = 16;
+
+// Compute permutation which sorts tuples of n vertex indices (stored
+// contiguously in keys, all indices less than or equal to
+// max_vertex) lexicographically. Uses a stable least significant
+// digit radix sort, so equal tuples appear in order of position.
+static void sort_tuples(const std::vector<unsigned int>& keys,
+                        std::size_t n, unsigned int max_vertex,
+                        int num_threads, std::vector<unsigned int>& order)
+{
+  const std::size_t num_tuples = keys.size()/n;
+  const std::size_t num_buckets = 1 << radix_bits;
+  const unsigned int mask = num_buckets - 1;
+
+  order.resize(num_tuples);
+  for (std::size_t i = 0; i < num_tuples; ++i)
+    order[i] = i;
+  std::vector<unsigned int> sorted(num_tuples);
+
+  // Each thread counts and scatters a contiguous chunk of the
+  // current order
+  const std::size_t chunk_size = (num_tuples + num_threads - 1)/num_threads;
+  std::vector<std::size_t> offsets(num_threads*num_buckets);
+
+  // Sort by each vertex, last vertex first, one digit at a time
+  for (std::size_t j = n; j-- > 0;)
+  {
+    for (unsigned int shift = 0; shift < 32 && (max_vertex >> shift) > 0;
+         shift += radix_bits)
+    {
+      // Count digits in each chunk
+      std::fill(offsets.begin(), offsets.end(), 0);
+      #pragma omp parallel for schedule(static, 1) num_threads(num_threads)
+      for (int t = 0; t < num_threads; ++t)
+      {
+        std::size_t* count = offsets.data() + t*num_buckets;
+        const std::size_t first = std::min(t*chunk_size, num_tuples);
+        const std::size_t last = std::min(first + chunk_size, num_tuples);
+        for (std::size_t i = first; i < last; ++i)
+          ++count[(keys[order[i]*n + j] >> shift) & mask];
+      }
+
+      // Compute positions of digits in each chunk
+      std::size_t position = 0;
+      for (std::size_t b = 0; b < num_buckets; ++b)
+      {
+        for (int t = 0; t < num_threads; ++t)
+        {
+          const std::size_t count = offsets[t*num_buckets + b];
+          offsets[t*num_buckets + b] = position;
+          position += count;
+        }
+      }
+
+      // Scatter
+      #pragma omp parallel for schedule(static, 1) num_threads(num_threads)
+      for (int t = 0; t < num_threads; ++t)
+      {
+        std::size_t* offset = offsets.data() + t*num_buckets;
+        const std::size_t first = std::min(t*chunk_size, num_tuples);
+        const std::size_t last = std::min(first + chunk_size, num_tuples);
+        for (std::size_t i = first; i < last; ++i)
+          sorted[offset[(keys[order[i]*n + j] >> shift) & mask]++] = order[i];
+      }
+      order.swap(sorted);
+    }
+  }
+}
+
+// Number unique tuples in sorted order. On return, entity[i] is the
+// number of tuple i and first[e] is the first position of tuple
+// number e. Returns the number of unique tuples.
+static std::size_t number_tuples(const std::vector<unsigned int>& keys,
+                                 std::size_t n,
+                                 const std::vector<unsigned int>& order,
+                                 std::vector<unsigned int>& entity,
+                                 std::vector<unsigned int>& first)
+{
+  const std::size_t num_tuples = order.size();
+  entity.resize(num_tuples);
+  first.clear();
+  for (std::size_t k = 0; k < num_tuples; ++k)
+  {
+    const unsigned int* key = keys.data() + order[k]*n;
+    if (k == 0 || !std::equal(key, key + n, keys.data() + order[k - 1]*n))
+      first.push_back(order[k]);
+    entity[order[k]] = first.size() - 1;
+  }
+  return first.size();
+}
 //-----------------------------------------------------------------------------
 std::size_t TopologyComputation::compute_entities(Mesh& mesh, std::size_t dim)
 {
@@ -68,6 +162,22 @@ std::size_t TopologyComputation::compute_entities(Mesh& mesh, std::size_t dim)
                  "Connectivity for topological dimension %d exists but entities are missing", dim);
   }
 
+  // Number entities by sorting or by lookup in a map
+  const std::string algorithm = parameters["entity_numbering"];
+  if (algorithm == "sort")
+    return compute_entities_by_sort(mesh, dim);
+  else
+    return compute_entities_by_map(mesh, dim);
+}
+//-----------------------------------------------------------------------------
+std::size_t TopologyComputation::compute_entities_by_map(Mesh& mesh,
+                                                         std::size_t dim)
+{
+  // Get mesh topology and connectivity
+  MeshTopology& topology = mesh.topology();
+  MeshConnectivity& ce = topology(topology.dim(), dim);
+  MeshConnectivity& ev = topology(dim, 0);
+
   // Optimisation for common case where facets lie between two cells
   bool erase_visited_facets = false;
   if (mesh.geometry().dim() == topology.dim() and dim == topology.dim() - 1)
@@ -175,6 +285,125 @@ std::size_t TopologyComputation::compute_entities(Mesh& mesh, std::size_t dim)
   return current_entity;
 }
 //-----------------------------------------------------------------------------
+std::size_t TopologyComputation::compute_entities_by_sort(Mesh& mesh,
+                                                          std::size_t dim)
+{
+  // Get mesh topology and connectivity
+  MeshTopology& topology = mesh.topology();
+  const std::size_t tdim = topology.dim();
+  const MeshConnectivity& cv = topology(tdim, 0);
+  MeshConnectivity& ce = topology(tdim, dim);
+  MeshConnectivity& ev = topology(dim, 0);
+
+  // Start timer
+  Timer timer("Compute entities dim = " + to_string(dim));
+
+  // Get cell type
+  const CellType& cell_type = mesh.type();
+
+  // Number of entities and vertices per entity of each cell
+  const std::size_t m = cell_type.num_entities(dim);
+  const std::size_t n = cell_type.num_vertices(dim);
+  const std::size_t num_cells = mesh.num_cells();
+  if (num_cells*m >= std::numeric_limits<unsigned int>::max())
+  {
+    dolfin_error("TopologyComputation.cpp",
+                 "compute topological entities",
+                 "Too many cell entities to number by sorting. Consider setting the parameter \"entity_numbering\" to \"map\"");
+  }
+
+  // Number of threads
+  const std::size_t num_threads_param = parameters["num_threads"];
+  const int num_threads = std::max((int) num_threads_param, 1);
+
+  // Create sorted vertex tuple for each entity of each cell
+  std::vector<unsigned int> keys(num_cells*m*n);
+  #pragma omp parallel num_threads(num_threads)
+  {
+    boost::multi_array<unsigned int, 2> e_vertices(boost::extents[m][n]);
+    #pragma omp for
+    for (int c = 0; c < (int) num_cells; ++c)
+    {
+      cell_type.create_entities(e_vertices, dim, cv(c));
+      for (std::size_t j = 0; j < m; ++j)
+      {
+        unsigned int* key = keys.data() + (c*m + j)*n;
+        std::copy(e_vertices[j].begin(), e_vertices[j].end(), key);
+        std::sort(key, key + n);
+      }
+    }
+  }
+
+  // Sort tuples and number unique tuples
+  std::vector<unsigned int> entity, first;
+  std::size_t num_entities = 0;
+  {
+    std::vector<unsigned int> order;
+    const unsigned int max_vertex
+      = mesh.num_vertices() > 0 ? mesh.num_vertices() - 1 : 0;
+    sort_tuples(keys, n, max_vertex, num_threads, order);
+    num_entities = number_tuples(keys, n, order, entity, first);
+  }
+  std::vector<unsigned int>().swap(keys);
+
+  // Renumber entities in order of first occurrence, which is the
+  // order in which they are found when iterating over cells. Entities
+  // first found in ghost cells are numbered last.
+  const std::size_t num_regular_positions = topology.ghost_offset(tdim)*m;
+  std::vector<unsigned int> index(num_entities);
+  std::size_t current_entity = 0;
+  std::size_t num_regular_entities = 0;
+  for (std::size_t q = 0; q < entity.size(); ++q)
+  {
+    if (first[entity[q]] != q)
+      continue;
+    index[entity[q]] = current_entity++;
+    if (q < num_regular_positions)
+      num_regular_entities = current_entity;
+  }
+
+  // Initialise connectivity data structure
+  topology.init(dim, num_entities, num_entities);
+
+  // Initialise ghost entity offset
+  topology.init_ghost(dim, num_regular_entities);
+
+  // Set cell-entity and entity-vertex connectivity. The vertices of
+  // an entity are taken from the cell where it is first found.
+  ce.init(num_cells, m);
+  ev.init(num_entities, n);
+  #pragma omp parallel num_threads(num_threads)
+  {
+    boost::multi_array<unsigned int, 2> e_vertices(boost::extents[m][n]);
+    std::vector<std::size_t> connections(std::max(m, n));
+    #pragma omp for
+    for (int c = 0; c < (int) num_cells; ++c)
+    {
+      bool created = false;
+      for (std::size_t j = 0; j < m; ++j)
+      {
+        const std::size_t q = c*m + j;
+        const unsigned int e = entity[q];
+        connections[j] = index[e];
+        if (first[e] != q)
+          continue;
+
+        if (!created)
+        {
+          cell_type.create_entities(e_vertices, dim, cv(c));
+          created = true;
+        }
+        std::vector<std::size_t> vertices(e_vertices[j].begin(),
+                                          e_vertices[j].end());
+        ev.set(index[e], vertices.data());
+      }
+      ce.set(c, connections.data());
+    }
+  }
+
+  return num_entities;
+}
+//-----------------------------------------------------------------------------
 void TopologyComputation::compute_connectivity(Mesh& mesh,
                                                std::size_t d0,
                                                std::size_t d1)
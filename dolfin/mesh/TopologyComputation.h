@@ -46,6 +46,12 @@ namespace dolfin
 
   private:
 
+    // Number entities by inserting their vertices into a map
+    static std::size_t compute_entities_by_map(Mesh& mesh, std::size_t dim);
+
+    // Number entities by sorting their vertices
+    static std::size_t compute_entities_by_sort(Mesh& mesh, std::size_t dim);
+
     // Compute connectivity from transpose
     static void compute_from_transpose(Mesh& mesh, std::size_t d0,
                                        std::size_t d1);
@@ -35,6 +35,7 @@
 #include <dolfin/mesh/BoundaryMesh.h>
 #include <dolfin/mesh/PeriodicBoundaryComputation.h>
 #include <dolfin/mesh/MeshQuality.h>
+#include <dolfin/mesh/QuadratureRules.h>
 #include <dolfin/mesh/MultiMesh.h>
 #include <dolfin/mesh/MeshHierarchy.h>
 #include <dolfin/mesh/MeshPartitioning.h>
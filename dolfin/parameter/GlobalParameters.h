@@ -63,6 +63,11 @@ namespace dolfin
       // Warn if reading large XML files in parallel (MB)
       p.add("warn_on_xml_file_size", 100);
 
+      // Cache meshes read from XML in parallel in a HDF5 file
+      // (<filename>.h5), which is read in parallel instead of the XML
+      // file by later reads if it is newer (requires HDF5)
+      p.add("xml_mesh_cache", false);
+
       //-- Output
 
       // Print standard output on all processes
@@ -79,6 +84,28 @@ namespace dolfin
       // Print the level of thread support provided by the MPI library
       p.add("print_mpi_thread_support_level", false);
 
+      //-- Assembly
+
+      // Number of cells (or facets) per block in multithreaded
+      // assembly, 0 = choose block size from size of cell tensor
+      p.add("threaded_assembly_block_size", 0);
+
+      // Colour blocks in multithreaded assembly and process colours
+      // in a fixed order, such that the assembled tensor does not
+      // depend on the number of threads
+      p.add("threaded_assembly_reproducible", false);
+
+      // Number of cells gathered and tabulated per block during cell
+      // assembly, 0 or 1 = assemble cell by cell
+      p.add("assembly_cell_block_size", 0);
+
+      // Reuse tensors of congruent cells with equal coefficient
+      // values during cell assembly on affine simplex meshes, for
+      // integrals without spatial coordinate and with coefficients
+      // constant on each cell (used by Assembler, cell by cell and
+      // blocked, and ignored with a warning by OpenMpAssembler)
+      p.add("assembly_cache_cell_tensors", false);
+
       //-- dof ordering
 
       // DOF reordering when running in serial
@@ -128,6 +155,10 @@ namespace dolfin
       p.add("Zoltan_PHG_REPART_MULTIPLIER", 1.0);
       #endif
 
+      // Algorithm for numbering mesh entities (edges and facets):
+      // sorting of vertex tuples or lookup of vertices in a map
+      p.add("entity_numbering", "sort", {"sort", "map"});
+
       // Mesh refinement
       p.add("refinement_algorithm",
             "plaza",
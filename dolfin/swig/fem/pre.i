@@ -47,6 +47,19 @@
 PROBLEM_RENAMES(LinearVariational)
 PROBLEM_RENAMES(NonlinearVariational)
 
+//-----------------------------------------------------------------------------
+// Ignore low level interface of AssemblyPlan
+//-----------------------------------------------------------------------------
+%ignore dolfin::AssemblyPlan::AssemblyPlan(const Form&);
+%ignore dolfin::AssemblyPlan::ufc;
+%ignore dolfin::AssemblyPlan::cell_integral;
+%ignore dolfin::AssemblyPlan::cell_dofs;
+%ignore dolfin::AssemblyPlan::values;
+%ignore dolfin::AssemblyPlan::positions;
+%ignore dolfin::AssemblyPlan::init_cell_tensors;
+%ignore dolfin::AssemblyPlan::cell_tensor;
+%ignore dolfin::AssemblyPlan::cell_data;
+
 //-----------------------------------------------------------------------------
 // To simplify handling of shared_ptr types in PyDOLFIN we ignore the reference
 // version of constructors to these types
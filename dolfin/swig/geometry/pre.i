@@ -38,10 +38,16 @@
 %ignore dolfin::BoundingBoxTree::BoundingBoxTree(const Mesh&);
 %ignore dolfin::BoundingBoxTree::BoundingBoxTree(const Mesh&, unsigned int);
 
+//-----------------------------------------------------------------------------
+// Ignore PointLocator function with output to raw pointer
+//-----------------------------------------------------------------------------
+%ignore dolfin::PointLocator::compute_reference_coordinates;
+
 //-----------------------------------------------------------------------------
 // Ignore nested classes. They are not supported by SWIG
 //-----------------------------------------------------------------------------
 %warnfilter(325) dolfin::GenericBoundingBoxTree::BBox;
+%warnfilter(325) dolfin::GenericBoundingBoxTree::Subtree;
 %warnfilter(325) dolfin::GenericBoundingBoxTree::less_x_point;
 %warnfilter(325) dolfin::GenericBoundingBoxTree::less_y_point;
 %warnfilter(325) dolfin::GenericBoundingBoxTree::less_z_point;
@@ -110,6 +110,7 @@
 %ignore dolfin::GenericTensor::get(double*, const  dolfin::la_index*, const dolfin::la_index * const *) const;
 %ignore dolfin::GenericTensor::set(const double* , const dolfin::la_index* , const dolfin::la_index * const *);
 %ignore dolfin::GenericTensor::add(const double* , const dolfin::la_index* , const dolfin::la_index * const *);
+%ignore dolfin::GenericTensor::add_local_batch;
 %ignore dolfin::PETScLinearOperator::wrapper;
 
 //-----------------------------------------------------------------------------
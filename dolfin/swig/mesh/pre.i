@@ -320,3 +320,9 @@ FORWARD_DECLARE_MESHFUNCTIONS(std::size_t, Sizet)
 //-----------------------------------------------------------------------------
 %ignore dolfin::plot(const MultiMesh& multimesh);
 %ignore dolfin::plot(std::shared_ptr<const MultiMesh> multimesh);
+
+//-----------------------------------------------------------------------------
+// Ignore raw pointer access to QuadratureRules (use rule(i) from Python)
+//-----------------------------------------------------------------------------
+%ignore dolfin::QuadratureRules::points;
+%ignore dolfin::QuadratureRules::weights;
@@ -75,6 +75,8 @@
 %shared_ptr(dolfin::DofMap)
 %shared_ptr(dolfin::MultiMeshDofMap)
 %shared_ptr(dolfin::Form)
+%shared_ptr(dolfin::AssemblyPlan)
+%shared_ptr(dolfin::MatrixFreeOperator)
 %shared_ptr(dolfin::FiniteElement)
 %shared_ptr(dolfin::BasisFunction)
 %shared_ptr(dolfin::MultiStageScheme)
@@ -217,6 +219,7 @@
 %shared_ptr(dolfin::File)
 %shared_ptr(dolfin::XDMFFile)
 %shared_ptr(dolfin::HDF5File)
+%shared_ptr(dolfin::CheckpointWriter)
 
 // math
 %shared_ptr(dolfin::Lagrange)
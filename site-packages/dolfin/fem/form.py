@@ -30,6 +30,7 @@ import dolfin.cpp as cpp
 
 # Import ufl and ufc
 import ufl, ufc
+from ufl.algorithms import extract_type
 
 # Import JIT compiler
 from dolfin.compilemodules.jit import jit
@@ -116,6 +117,13 @@ class Form(cpp.Form):
         # Attach mesh (because function spaces and coefficients may be empty lists)
         self.set_mesh(mesh)
 
+        # Describe dependence of integrand on the position of cells
+        # (decides whether tensors of congruent cells may be reused)
+        uses_x = bool(extract_type(form, ufl.SpatialCoordinate))
+        cellwise_constant = [i for i, c in enumerate(self.coefficients)
+                             if c.ufl_element().degree() == 0]
+        self.set_position_dependence(uses_x, cellwise_constant)
+
 
         # Type checking subdomain data
         # Delete None entries
@@ -44,10 +44,10 @@ public:
     CPPUNIT_ASSERT(dolfin::MPI::sum(mesh.mpi_comm(), markers.size()) == 6);
 
     // Check sum of values
-    const std::map<std::pair<std::size_t, std::size_t>, std::size_t>&
-      values = markers.values();
-    std::map<std::pair<std::size_t, std::size_t>,
-             std::size_t>::const_iterator it;
+    const boost::container::flat_map<std::pair<std::size_t, std::size_t>,
+                                     std::size_t>& values = markers.values();
+    boost::container::flat_map<std::pair<std::size_t, std::size_t>,
+                               std::size_t>::const_iterator it;
     std::size_t sum = 0;
     for (it = values.begin(); it != values.end(); ++it)
       sum += it->second;
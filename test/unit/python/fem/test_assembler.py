@@ -125,6 +125,241 @@ def test_cell_assembly_multithreaded():
     parameters["num_threads"] = 0
 
 
+def test_cell_assembly_blocked():
+    mesh = UnitCubeMesh(4, 4, 4)
+    V = VectorFunctionSpace(mesh, "DG", 1)
+
+    v = TestFunction(V)
+    u = TrialFunction(V)
+    f = Constant((10, 20, 30))
+
+    def epsilon(v):
+        return 0.5*(grad(v) + grad(v).T)
+
+    a = inner(epsilon(v), epsilon(u))*dx
+    L = inner(v, f)*dx
+
+    A_frobenius_norm =  4.3969686527582512
+    b_l2_norm = 0.95470326978246278
+
+    # Assemble A and b in blocks of cells (block size does not divide
+    # the number of cells)
+    parameters["assembly_cell_block_size"] = 7
+    assert round(assemble(a).norm("frobenius") - A_frobenius_norm, 10) == 0
+    assert round(assemble(L).norm("l2") - b_l2_norm, 10) == 0
+
+    # Negative block sizes are rejected
+    parameters["assembly_cell_block_size"] = -1
+    with pytest.raises(RuntimeError):
+        assemble(a)
+    parameters["assembly_cell_block_size"] = 0
+
+
+def test_cell_assembly_cached():
+    mesh = UnitCubeMesh(4, 4, 4)
+    V = VectorFunctionSpace(mesh, "DG", 1)
+
+    v = TestFunction(V)
+    u = TrialFunction(V)
+    f = Constant((10, 20, 30))
+    x = SpatialCoordinate(mesh)
+
+    def epsilon(v):
+        return 0.5*(grad(v) + grad(v).T)
+
+    # The last form depends on the position of the cell and must not
+    # be cached
+    forms = [inner(epsilon(v), epsilon(u))*dx, inner(v, f)*dx,
+             x[0]*inner(v, u)*dx]
+    norms = [assemble(form).norm("frobenius" if i != 1 else "l2")
+             for i, form in enumerate(forms)]
+
+    # Assemble with cached cell tensors and compare
+    parameters["assembly_cache_cell_tensors"] = True
+    for i, form in enumerate(forms):
+        norm = assemble(form).norm("frobenius" if i != 1 else "l2")
+        assert round(norm - norms[i], 10) == 0
+    parameters["assembly_cache_cell_tensors"] = False
+
+    # Structured mesh has few distinct cell shapes
+    assert timing("Cell tensor cache hit", TimingClear_clear)[0] > 0
+
+
+def test_cell_assembly_cached_position_dependent():
+    mesh = UnitSquareMesh(8, 8)
+    V = FunctionSpace(mesh, "DG", 1)
+    Q = FunctionSpace(mesh, "CG", 1)
+
+    v = TestFunction(V)
+    u = TrialFunction(V)
+    x = SpatialCoordinate(mesh)
+    g = interpolate(Expression("x[0] < 0.75 ? 1.0 : 2.0", degree=1), Q)
+
+    # The integrands are equal on the first cells (which are congruent)
+    # and differ on cells with x > 0.75, so checking the tensors of the
+    # first cache hits would not detect the position dependence
+    forms = [conditional(lt(x[0], 0.75), 1.0, 2.0)*v*u*dx, g*v*u*dx]
+    for form in forms:
+        A_ref = assemble(form)
+        parameters["assembly_cache_cell_tensors"] = True
+        for block_size in [0, 16]:
+            parameters["assembly_cell_block_size"] = block_size
+            A = assemble(form)
+            A.axpy(-1.0, A_ref, True)
+            assert A.norm("frobenius") < 1.0e-12
+        parameters["assembly_cell_block_size"] = 0
+        parameters["assembly_cache_cell_tensors"] = False
+
+
+def test_assembly_plan():
+    mesh = UnitSquareMesh(8, 8)
+    V = FunctionSpace(mesh, "CG", 1)
+
+    v = TestFunction(V)
+    u = TrialFunction(V)
+    f = Function(V)
+    f.vector()[:] = 1.0
+
+    a = Form(f*inner(grad(v), grad(u))*dx)
+    plan = AssemblyPlan(a)
+    assembler = cpp.Assembler()
+
+    # Assemble with plan and compare to standard assembly, also after
+    # a coefficient has been updated
+    A = Matrix()
+    for value in [1.0, 2.0]:
+        f.vector()[:] = value
+        assembler.assemble(A, plan)
+        A_frobenius_norm = assemble(a).norm("frobenius")
+        assert round(A.norm("frobenius") - A_frobenius_norm, 10) == 0
+
+
+@skip_in_parallel
+def test_assembly_plan_direct_insertion():
+    mesh = UnitSquareMesh(8, 8)
+    V = FunctionSpace(mesh, "CG", 2)
+
+    v = TestFunction(V)
+    u = TrialFunction(V)
+    f = Function(V)
+    f.vector()[:] = 1.0
+
+    # Cell tensors are added directly into the matrix storage, facet
+    # tensors through the matrix interface
+    a = Form(f*inner(grad(v), grad(u))*dx + v*u*ds)
+    assembler = cpp.Assembler()
+
+    backends = [b for b in ["PETSc", "Eigen"] if has_linear_algebra_backend(b)]
+    prev_backend = parameters["linear_algebra_backend"]
+    for backend in backends:
+        parameters["linear_algebra_backend"] = backend
+        plan = AssemblyPlan(a)
+        A = Matrix()
+        for value in [1.0, 2.0]:
+            f.vector()[:] = value
+            assembler.assemble(A, plan)
+            A_frobenius_norm = assemble(a).norm("frobenius")
+            assert round(A.norm("frobenius") - A_frobenius_norm, 10) == 0
+    parameters["linear_algebra_backend"] = prev_backend
+
+
+@skip_in_parallel
+@pytest.mark.skipif(not has_linear_algebra_backend("Eigen"),
+                    reason="Eigen backend required")
+def test_eigen_batch_insertion():
+    mesh = UnitSquareMesh(8, 8)
+    V = FunctionSpace(mesh, "CG", 2)
+
+    v = TestFunction(V)
+    u = TrialFunction(V)
+
+    # Cell tensors are added to Eigen tensors in batches
+    prev_backend = parameters["linear_algebra_backend"]
+    parameters["linear_algebra_backend"] = "Eigen"
+    A = assemble(inner(grad(v), grad(u))*dx + v*u*ds)
+    b = assemble(v*dx)
+    parameters["linear_algebra_backend"] = prev_backend
+
+    # Sum of all entries is the boundary length and the area
+    x = b.copy()
+    x[:] = 1.0
+    assert round((A*x).sum() - 4.0, 10) == 0
+    assert round(b.sum() - 1.0, 10) == 0
+
+
+def test_assembly_plan_reassembly():
+    mesh = UnitSquareMesh(8, 8)
+    V = FunctionSpace(mesh, "CG", 1)
+    Q = FunctionSpace(mesh, "DG", 0)
+
+    v = TestFunction(V)
+    u = TrialFunction(V)
+    kappa = Function(Q)
+    kappa.vector()[:] = 1.0
+
+    class Left(SubDomain):
+        def inside(self, x, on_boundary):
+            return x[0] < 0.5 + DOLFIN_EPS
+
+    markers = CellFunction("size_t", mesh, 0)
+    Left().mark(markers, 1)
+
+    a = Form(kappa*inner(grad(v), grad(u))*dx)
+    plan = AssemblyPlan(a)
+    plan.keep_cell_tensors(True)
+    assembler = cpp.Assembler()
+    A = Matrix()
+    assembler.assemble(A, plan)
+
+    # Change coefficient on marked cells and reassemble these cells
+    dofmap = Q.dofmap()
+    for cell in cells(mesh):
+        if markers[cell] == 1:
+            kappa.vector()[dofmap.cell_dofs(cell.index())[0]] = 3.0
+    assembler.reassemble(A, plan, markers, 1)
+    A_frobenius_norm = assemble(a).norm("frobenius")
+    assert round(A.norm("frobenius") - A_frobenius_norm, 10) == 0
+
+    # Change coefficient on remaining cells and let the assembler
+    # detect the changed cells
+    for cell in cells(mesh):
+        if markers[cell] == 0:
+            kappa.vector()[dofmap.cell_dofs(cell.index())[0]] = 2.0
+    assembler.reassemble(A, plan)
+    A_frobenius_norm = assemble(a).norm("frobenius")
+    assert round(A.norm("frobenius") - A_frobenius_norm, 10) == 0
+
+
+def test_assembly_plan_reassembly_bcs():
+    mesh = UnitSquareMesh(8, 8)
+    V = FunctionSpace(mesh, "CG", 1)
+    Q = FunctionSpace(mesh, "DG", 0)
+
+    v = TestFunction(V)
+    u = TrialFunction(V)
+    kappa = Function(Q)
+    kappa.vector()[:] = 1.0
+    bc = DirichletBC(V, 0.0, "on_boundary")
+
+    a = Form(kappa*inner(grad(v), grad(u))*dx)
+    plan = AssemblyPlan(a)
+    plan.keep_cell_tensors(True)
+    assembler = cpp.Assembler()
+    A = Matrix()
+    assembler.assemble(A, plan)
+    bc.apply(A)
+
+    # Reassembly adds to the rows set by the boundary condition,
+    # which are restored by applying it again
+    kappa.vector()[:] = 2.0
+    assembler.reassemble(A, plan)
+    bc.apply(A)
+    A_ref = assemble(a)
+    bc.apply(A_ref)
+    A.axpy(-1.0, A_ref, True)
+    assert A.norm("frobenius") < 1.0e-12
+
+
 def test_facet_assembly():
     parameters["ghost_mode"] = "shared_facet"
     mesh = UnitSquareMesh(24, 24)
@@ -200,6 +435,67 @@ def test_facet_assembly_multithreaded():
     parameters["num_threads"] = 0
 
 
+@skip_in_parallel
+def test_facet_assembly_multithreaded_reproducible():
+    mesh = UnitSquareMesh(24, 24)
+    V = FunctionSpace(mesh, "DG", 1)
+
+    v = TestFunction(V)
+    u = TrialFunction(V)
+    n = FacetNormal(mesh)
+    h = CellSize(mesh)
+    h_avg = (h('+') + h('-'))/2
+
+    a = dot(grad(v), grad(u))*dx \
+        - dot(avg(grad(v)), jump(u, n))*dS \
+        - dot(jump(v, n), avg(grad(u)))*dS \
+        + 4.0/h_avg*dot(jump(v, n), jump(u, n))*dS \
+        + 8.0/h*v*u*ds
+    M = avg(h)*dS + h*ds
+
+    # Reference values from serial assembly
+    A_ref = assemble(a).array()
+    M_ref = assemble(M)
+
+    # Results must not depend on the number of threads
+    parameters["threaded_assembly_reproducible"] = True
+    parameters["threaded_assembly_block_size"] = 16
+    results = []
+    for num_threads in (2, 3, 4):
+        parameters["num_threads"] = num_threads
+        A = assemble(a).array()
+        assert numpy.allclose(A, A_ref, rtol=1e-12, atol=1e-12)
+        results.append((A, assemble(M)))
+    parameters["num_threads"] = 0
+    parameters["threaded_assembly_block_size"] = 0
+    parameters["threaded_assembly_reproducible"] = False
+
+    for A, m in results[1:]:
+        assert (A == results[0][0]).all()
+        assert m == results[0][1]
+    assert round(results[0][1] - M_ref, 12) == 0
+
+
+@skip_in_parallel
+def test_facet_sparsity_pattern_multithreaded():
+    mesh = UnitSquareMesh(4, 4)
+    V = FunctionSpace(mesh, "DG", 0)
+    v = TestFunction(V)
+    u = TrialFunction(V)
+    a = u*v*dx + jump(u)*jump(v)*dS
+
+    # Each cell couples to itself and to its neighbours across
+    # interior facets
+    mesh.init(1, 2)
+    num_interior_facets = sum(1 for f in facets(mesh) if not f.exterior())
+    nnz = mesh.num_cells() + 2*num_interior_facets
+
+    for num_threads in (0, 4):
+        parameters["num_threads"] = num_threads
+        assert assemble(a).nnz() == nnz
+    parameters["num_threads"] = 0
+
+
 def test_functional_assembly():
     mesh = UnitSquareMesh(24, 24)
 
@@ -0,0 +1,95 @@
+#!/usr/bin/env py.test
+
+"""Unit tests for class MatrixFreeOperator"""
+
+# Copyright (C) 2016 The FEniCS Project
+#
+# This file is part of DOLFIN.
+#
+# DOLFIN is free software: you can redistribute it and/or modify
+# it under the terms of the GNU Lesser General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# DOLFIN is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+# GNU Lesser General Public License for more details.
+#
+# You should have received a copy of the GNU Lesser General Public License
+# along with DOLFIN. If not, see <http://www.gnu.org/licenses/>.
+#
+# First added:  2016-10-18
+# Last changed: 2016-10-18
+
+import pytest
+from dolfin import *
+from dolfin_utils.test import *
+
+
+def _problem():
+    mesh = UnitSquareMesh(8, 8)
+    V = FunctionSpace(mesh, "Lagrange", 2)
+    u = TrialFunction(V)
+    v = TestFunction(V)
+    k = Expression("1.0 + x[0]*x[1]", degree=2)
+    a = k*inner(grad(u), grad(v))*dx + u*v*dx
+    L = v*dx
+    bc = DirichletBC(V, Constant(0.0), "x[0] < DOLFIN_EPS")
+    return V, a, L, bc
+
+
+@skip_if_not_PETSc
+@pytest.mark.parametrize('cache', [False, True])
+@pytest.mark.parametrize('num_threads', [0, 4])
+def test_matrix_free_action(cache, num_threads):
+    prev_backend = parameters["linear_algebra_backend"]
+    parameters["linear_algebra_backend"] = "PETSc"
+
+    V, a, L, bc = _problem()
+
+    # Reference action of assembled matrix with boundary conditions
+    A = assemble(a)
+    bc.apply(A)
+    x = interpolate(Expression("sin(3.0*x[0])*x[1]", degree=2), V).vector()
+    y_ref = x.copy()
+    A.mult(x, y_ref)
+
+    # Matrix-free action
+    O = MatrixFreeOperator(Form(a), [bc])
+    O.parameters["cache_cell_tensors"] = cache
+    assert O.size(0) == V.dim()
+    parameters["num_threads"] = num_threads
+    for i in range(2):
+        y = x.copy()
+        O.mult(x, y)
+        y.axpy(-1.0, y_ref)
+        assert y.norm("linf") < 1.0e-12
+    parameters["num_threads"] = 0
+
+    parameters["linear_algebra_backend"] = prev_backend
+
+
+@skip_if_not_PETSc
+def test_matrix_free_solve():
+    prev_backend = parameters["linear_algebra_backend"]
+    parameters["linear_algebra_backend"] = "PETSc"
+
+    V, a, L, bc = _problem()
+
+    # Reference solution
+    A, b = assemble_system(a, L, bc)
+    x_ref = Function(V).vector()
+    solve(A, x_ref, b, "cg", "none")
+
+    # Matrix-free solution, with boundary conditions applied to the
+    # right-hand side as for an assembled matrix
+    b = assemble(L)
+    bc.apply(b)
+    O = MatrixFreeOperator(Form(a), [bc])
+    x = Function(V).vector()
+    solve(O, x, b, "gmres", "none")
+    x.axpy(-1.0, x_ref)
+    assert x.norm("l2") < 1.0e-6*x_ref.norm("l2")
+
+    parameters["linear_algebra_backend"] = prev_backend
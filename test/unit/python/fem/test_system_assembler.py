@@ -120,6 +120,58 @@ def test_cell_assembly_bc():
     assert round(b.norm("l2") - b_l2_norm, 10) == 0
 
 
+@skip_in_parallel
+def test_cell_assembly_bc_multithreaded():
+
+    mesh = UnitCubeMesh(4, 4, 4)
+    V = FunctionSpace(mesh, "Lagrange", 1)
+    bc = DirichletBC(V, 1.0, "on_boundary")
+
+    u, v = TrialFunction(V), TestFunction(V)
+    f = Constant(10)
+
+    a = inner(grad(u), grad(v))*dx
+    L = inner(f, v)*dx + f*v*ds
+
+    # Reference from serial assembly
+    A_ref, b_ref = assemble_system(a, L, bc)
+
+    # Assemble system with threads
+    parameters["num_threads"] = 4
+    A, b = assemble_system(a, L, bc)
+    parameters["num_threads"] = 0
+
+    assert numpy.allclose(A.array(), A_ref.array(), rtol=1e-12, atol=1e-12)
+    assert numpy.allclose(b.array(), b_ref.array(), rtol=1e-12, atol=1e-12)
+
+
+def test_cell_assembly_bc_assembly_plan():
+
+    mesh = UnitCubeMesh(4, 4, 4)
+    V = FunctionSpace(mesh, "Lagrange", 1)
+    bc = DirichletBC(V, 1.0, "on_boundary")
+
+    u, v = TrialFunction(V), TestFunction(V)
+    f = Constant(10)
+
+    a = Form(inner(grad(u), grad(v))*dx)
+    L = Form(inner(f, v)*dx)
+
+    A_frobenius_norm = 96.847818767384
+    b_l2_norm =  96.564760289080
+
+    # Create assembler using assembly plans
+    assembler = SystemAssembler(a, L, bc)
+    assembler.set_assembly_plans(AssemblyPlan(a), AssemblyPlan(L))
+
+    # Assemble system twice, reusing the plans
+    A, b = Matrix(), Vector()
+    for i in range(2):
+        assembler.assemble(A, b)
+        assert round(A.norm("frobenius") - A_frobenius_norm, 10) == 0
+        assert round(b.norm("l2") - b_l2_norm, 10) == 0
+
+
 def test_facet_assembly():
 
     def test(mesh):
@@ -183,6 +235,40 @@ def test_facet_assembly():
     parameters["ghost_mode"] = "none"
 
 
+@skip_in_parallel
+def test_facet_assembly_multithreaded():
+    mesh = UnitSquareMesh(24, 24)
+    V = FunctionSpace(mesh, "DG", 1)
+    bc = DirichletBC(V, 1.0, "on_boundary", "pointwise")
+
+    v = TestFunction(V)
+    u = TrialFunction(V)
+    n = FacetNormal(mesh)
+    h = CellSize(mesh)
+    h_avg = (h('+') + h('-'))/2
+    f = Expression("500.0*exp(-(pow(x[0] - 0.5, 2) + pow(x[1] - 0.5, 2)) / 0.02)", degree=1)
+
+    a = dot(grad(v), grad(u))*dx \
+        - dot(avg(grad(v)), jump(u, n))*dS \
+        - dot(jump(v, n), avg(grad(u)))*dS \
+        + 4.0/h_avg*dot(jump(v, n), jump(u, n))*dS \
+        + 8.0/h*v*u*ds
+    L = v*f*dx + avg(v)*dS
+
+    # Reference from serial assembly
+    A_ref, b_ref = assemble_system(a, L, bc)
+
+    # Assemble with threads, with and without block colouring
+    for reproducible in (False, True):
+        parameters["threaded_assembly_reproducible"] = reproducible
+        parameters["num_threads"] = 4
+        A, b = assemble_system(a, L, bc)
+        parameters["num_threads"] = 0
+        assert numpy.allclose(A.array(), A_ref.array(), rtol=1e-12, atol=1e-12)
+        assert numpy.allclose(b.array(), b_ref.array(), rtol=1e-12, atol=1e-12)
+    parameters["threaded_assembly_reproducible"] = False
+
+
 def test_vertex_assembly():
 
     # Create mesh and define function space
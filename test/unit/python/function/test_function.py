@@ -259,6 +259,44 @@ def test_call(R, V, W, mesh):
     with pytest.raises(TypeError):
         u0([0,0])
 
+def test_eval_points(W):
+    import numpy
+    u = Function(W)
+    u.interpolate(Expression(("x[0]+x[1]+x[2]", "x[0]-x[1]-x[2]", "x[2]")))
+
+    # Linear function is reproduced exactly; points off this process
+    # are evaluated on other processes
+    numpy.random.seed(1)
+    x = numpy.random.rand(1000, 3)
+    exact = numpy.column_stack((x[:, 0] + x[:, 1] + x[:, 2],
+                                x[:, 0] - x[:, 1] - x[:, 2], x[:, 2]))
+    for num_threads in [0, 4]:
+        parameters["num_threads"] = num_threads
+        values = u.eval_points(x.flatten())
+        assert numpy.allclose(values, exact.flatten())
+    parameters["num_threads"] = 0
+
+    with pytest.raises(RuntimeError):
+        u.eval_points(numpy.array([2.0, 2.0, 2.0]))
+
+def test_eval_points_extrapolation(mesh):
+    import numpy
+    Q = FunctionSpace(mesh, "DG", 0)
+    u = interpolate(Expression("x[0] + 2.0*x[1] + 4.0*x[2]", degree=1), Q)
+    u.set_allow_extrapolation(True)
+
+    # Points outside the mesh take the value of the closest cell, the
+    # same on all processes
+    x = numpy.array([[1.5, 0.25, 0.5], [-0.5, 0.5, 0.75],
+                     [0.3, 1.2, -0.4], [2.0, 2.0, 2.0]])
+    values = u.eval_points(x.flatten())
+    for i, point in enumerate(x):
+        value = values[i]
+        assert MPI.max(mesh.mpi_comm(), value) == MPI.min(mesh.mpi_comm(), value)
+        if MPI.size(mesh.mpi_comm()) == 1:
+            cell = mesh.bounding_box_tree().compute_closest_entity(Point(*point))[0]
+            assert value == u.vector()[Q.dofmap().cell_dofs(cell)[0]]
+
 def test_constant_float_conversion():
     c = Constant(3.45)
     assert float(c) == 3.45
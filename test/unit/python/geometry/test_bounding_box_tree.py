@@ -25,8 +25,9 @@ import numpy
 
 from dolfin import BoundingBoxTree
 from dolfin import UnitIntervalMesh, UnitSquareMesh, UnitCubeMesh
-from dolfin import Point
+from dolfin import Point, Cell
 from dolfin import MPI, mpi_comm_world
+from dolfin import parameters
 from dolfin_utils.test import skip_in_parallel
 
 
@@ -296,6 +297,88 @@ def test_compute_entity_collisions_tree_3d():
         assert set(entities_A) == references[i][0]
         assert set(entities_B) == references[i][1]
 
+@skip_in_parallel
+def test_compute_entity_collisions_tree_batched():
+    "Batched collision tests agree with pairwise tests of the candidates"
+
+    for mesh_A, mesh_B, point in \
+        [(UnitSquareMesh(12, 12), UnitSquareMesh(9, 11), Point(0.3, 0.21)),
+         (UnitSquareMesh(8, 8), UnitSquareMesh(8, 8), Point(0.0, 0.0)),
+         (UnitCubeMesh(5, 5, 5), UnitCubeMesh(4, 6, 3), Point(0.3, 0.21, 0.1)),
+         (UnitCubeMesh(3, 3, 3), UnitCubeMesh(3, 3, 3), Point(0.0, 0.0, 0.0))]:
+
+        mesh_B.translate(point)
+
+        tree_A = BoundingBoxTree()
+        tree_A.build(mesh_A)
+        tree_B = BoundingBoxTree()
+        tree_B.build(mesh_B)
+
+        candidates_A, candidates_B = tree_A.compute_collisions(tree_B)
+        reference = [(a, b) for a, b in zip(candidates_A, candidates_B)
+                     if Cell(mesh_A, a).collides(Cell(mesh_B, b))]
+
+        entities_A, entities_B = tree_A.compute_entity_collisions(tree_B)
+        assert list(zip(entities_A, entities_B)) == reference
+
+#--- refit and parallel build ---
+
+@skip_in_parallel
+def test_refit():
+    "Refitted tree gives the same collisions as a new tree"
+
+    for mesh, points in \
+        [(UnitSquareMesh(16, 16), [Point(0.3, 0.2), Point(1.2, 0.9)]),
+         (UnitCubeMesh(6, 6, 6), [Point(0.3, 0.2, 0.1),
+                                  Point(1.2, 0.9, 0.05)])]:
+
+        tree = BoundingBoxTree()
+        tree.build(mesh)
+
+        # Move mesh (non-uniformly)
+        x = mesh.coordinates()
+        x[:, 0] += 0.5*x[:, 0]*x[:, 1]
+        x[:, 1] *= 1.0 - 0.2*x[:, 0]
+        tree.refit()
+
+        reference = BoundingBoxTree()
+        reference.build(mesh)
+
+        for p in points:
+            assert set(tree.compute_entity_collisions(p)) == \
+                set(reference.compute_entity_collisions(p))
+            assert set(tree.compute_collisions(p)) == \
+                set(reference.compute_collisions(p))
+
+        other = UnitSquareMesh(5, 5) if mesh.geometry().dim() == 2 \
+                else UnitCubeMesh(3, 3, 3)
+        other_tree = BoundingBoxTree()
+        other_tree.build(other)
+        entities = tree.compute_entity_collisions(other_tree)
+        reference_entities = reference.compute_entity_collisions(other_tree)
+        assert set(zip(*entities)) == set(zip(*reference_entities))
+
+@skip_in_parallel
+def test_build_threaded():
+    "Tree built with several threads equals tree built with one thread"
+
+    mesh = UnitCubeMesh(8, 8, 8)
+    num_threads = parameters["num_threads"]
+    try:
+        parameters["num_threads"] = 0
+        serial = BoundingBoxTree()
+        serial.build(mesh)
+        parameters["num_threads"] = 4
+        threaded = BoundingBoxTree()
+        threaded.build(mesh)
+    finally:
+        parameters["num_threads"] = num_threads
+
+    for p in [Point(0.3, 0.2, 0.1), Point(0.5, 0.5, 0.5)]:
+        assert threaded.compute_collisions(p) == serial.compute_collisions(p)
+        assert threaded.compute_closest_entity(p) == \
+            serial.compute_closest_entity(p)
+
 #--- compute_first_collision ---
 
 @skip_in_parallel
@@ -402,6 +485,22 @@ def test_compute_first_entity_collision_3d():
     first = tree.compute_first_entity_collision(p)
     assert first in reference
 
+@skip_in_parallel
+def test_compute_first_entity_collisions():
+    "Batched point location agrees with locating one point at a time"
+
+    for mesh in [UnitIntervalMesh(16), UnitSquareMesh(16, 16),
+                 UnitCubeMesh(6, 6, 6)]:
+        gdim = mesh.geometry().dim()
+        x = numpy.random.RandomState(1).uniform(-0.2, 1.2, (50, gdim))
+        points = [Point(*xi) for xi in x]
+
+        tree = BoundingBoxTree()
+        tree.build(mesh)
+        entities = tree.compute_first_entity_collisions(points)
+        reference = [tree.compute_first_entity_collision(p) for p in points]
+        assert list(entities) == reference
+
 #--- compute_closest_entity ---
 
 @skip_in_parallel
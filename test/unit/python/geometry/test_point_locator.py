@@ -0,0 +1,65 @@
+#!/usr/bin/env py.test
+
+"""Unit tests for PointLocator"""
+
+# Copyright (C) 2016 The FEniCS Project
+#
+# This file is part of DOLFIN.
+#
+# DOLFIN is free software: you can redistribute it and/or modify
+# it under the terms of the GNU Lesser General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# DOLFIN is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+# GNU Lesser General Public License for more details.
+#
+# You should have received a copy of the GNU Lesser General Public License
+# along with DOLFIN. If not, see <http://www.gnu.org/licenses/>.
+#
+# First added:  2016-10-18
+# Last changed: 2016-10-18
+
+import pytest
+import numpy
+from dolfin import *
+
+
+@pytest.fixture(params=range(3))
+def mesh(request):
+    return [UnitIntervalMesh(mpi_comm_world(), 20),
+            UnitSquareMesh(mpi_comm_world(), 8, 8),
+            UnitCubeMesh(mpi_comm_world(), 4, 4, 4)][request.param]
+
+
+def test_locate(mesh):
+    "Points are located on one process with their reference coordinates"
+
+    gdim = mesh.geometry().dim()
+    tdim = mesh.topology().dim()
+    rank = MPI.rank(mesh.mpi_comm())
+
+    # Same points on all processes, with the last one outside
+    x = numpy.random.RandomState(2).uniform(0.0, 1.0, (40, gdim))
+    x[-1, :] = 1.5
+    processes, cells, X = PointLocator.locate(mesh, x.flatten())
+
+    assert all(p >= 0 for p in processes[:-1])
+    assert processes[-1] == -1
+    X = X.reshape((-1, tdim))
+
+    # Check points located on this process
+    for i in range(len(x) - 1):
+        if processes[i] != rank:
+            continue
+        cell = Cell(mesh, int(cells[i]))
+        assert cell.collides(Point(*x[i]))
+        assert cells[i] < mesh.topology().ghost_offset(tdim)
+
+        # Map reference coordinates to point
+        v = mesh.coordinates()[cell.entities(0)]
+        y = v[0] + numpy.dot((v[1:] - v[0]).T, X[i])
+        assert numpy.allclose(y, x[i])
+        assert min(X[i]) > -1e-12 and sum(X[i]) < 1.0 + 1e-12
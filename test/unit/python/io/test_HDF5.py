@@ -24,7 +24,7 @@
 import pytest
 import os
 from dolfin import *
-from dolfin_utils.test import skip_if_not_HDF5, fixture, tempdir
+from dolfin_utils.test import skip_if_not_HDF5, skip_in_parallel, fixture, tempdir
 
 
 @skip_if_not_HDF5
@@ -52,6 +52,50 @@ def test_save_and_read_vector(tempdir):
         assert y.size() == x.size()
         assert (x - y).norm("l1") == 0.0
 
+@skip_if_not_HDF5
+@skip_in_parallel
+def test_save_and_read_vector_compressed(tempdir):
+    filename = os.path.join(tempdir, "vector_compressed.h5")
+
+    # Write to file with chunking and filters
+    x = Vector(mpi_comm_world(), 10000)
+    x[:] = 1.2
+    p = HDF5File.default_parameters()
+    p["chunk_size"] = 1000
+    p["compression_level"] = 4
+    p["shuffle"] = True
+    with HDF5File(x.mpi_comm(), filename, "w", p) as vector_file:
+        vector_file.write(x, "/my_vector")
+
+    # Read from file
+    y = Vector()
+    with HDF5File(x.mpi_comm(), filename, "r") as vector_file:
+        vector_file.read(y, "/my_vector", False)
+        assert y.size() == x.size()
+        assert (x - y).norm("l1") == 0.0
+
+    # Compressed file is smaller than the raw data
+    assert os.path.getsize(filename) < 8*x.size()
+
+@skip_if_not_HDF5
+def test_save_and_read_mesh_mpi_io_parameters(tempdir):
+    filename = os.path.join(tempdir, "mesh_mpi_io.h5")
+    mesh = UnitSquareMesh(20, 20)
+
+    # Write and read with independent transfer and MPI-IO hints
+    p = HDF5File.default_parameters()
+    p["mpi_io_transfer"] = "independent"
+    p["mpi_io_hints"] = "cb_nodes=1,romio_cb_write=enable"
+    p["chunking"] = True
+    p["alignment"] = 4096
+    with HDF5File(mesh.mpi_comm(), filename, "w", p) as mesh_file:
+        mesh_file.write(mesh, "/mesh")
+    mesh2 = Mesh()
+    with HDF5File(mesh.mpi_comm(), filename, "r", p) as mesh_file:
+        mesh_file.read(mesh2, "/mesh", False)
+    assert mesh.size_global(0) == mesh2.size_global(0)
+    assert mesh.size_global(2) == mesh2.size_global(2)
+
 @skip_if_not_HDF5
 def test_save_and_read_meshfunction_2D(tempdir):
     filename = os.path.join(tempdir, "meshfn-2d.h5")
@@ -57,3 +57,39 @@ def test_save_and_read_function_timeseries(tempdir):
         assert len(result.array().nonzero()[0]) == 0
     hdf5_file.close()
 
+
+@skip_if_not_HDF5
+@pytest.mark.parametrize("asynchronous", [True, False])
+def test_checkpoint_writer_function_timeseries(tempdir, asynchronous):
+    filename = os.path.join(tempdir, "checkpoint.h5")
+
+    mesh = UnitSquareMesh(10, 10)
+    Q = FunctionSpace(mesh, "CG", 2)
+    F0 = Function(Q)
+    F1 = Function(Q)
+    E = Expression("t*x[0]", t = 0.0)
+
+    # Write asynchronously, modifying the Function while writes are
+    # pending
+    writer = CheckpointWriter(mesh.mpi_comm(), filename)
+    writer.parameters["asynchronous"] = asynchronous
+    for t in range(5):
+        E.t = t
+        F0.interpolate(E)
+        writer.write(F0, "/function", t)
+    writer.flush()
+    assert writer.num_pending() == 0
+    del writer
+
+    # Read back from file
+    hdf5_file = HDF5File(mesh.mpi_comm(), filename, "r")
+    assert hdf5_file.attributes("/function")["count"] == 5
+    for t in range(5):
+        E.t = t
+        F1.interpolate(E)
+        vec_name = "/function/vector_%d"%t
+        hdf5_file.read(F0, vec_name)
+        assert hdf5_file.attributes(vec_name)["timestamp"] == t
+        result = F0.vector() - F1.vector()
+        assert len(result.array().nonzero()[0]) == 0
+    hdf5_file.close()
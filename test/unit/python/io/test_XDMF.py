@@ -19,6 +19,7 @@
 
 import pytest
 import os
+import xml.etree.ElementTree as ET
 from dolfin import *
 from dolfin_utils.test import skip_if_not_HDF5, skip_in_parallel, fixture, tempdir
 
@@ -183,6 +184,49 @@ def test_save_3d_vector_series(tempdir):
 
     del file
 
+@skip_if_not_HDF5
+def test_save_2d_scalar_incremental_series(tempdir):
+    filename = os.path.join(tempdir, "u_series.xdmf")
+    mesh = UnitSquareMesh(16, 16)
+    u = Function(FunctionSpace(mesh, "Lagrange", 1))
+
+    file = XDMFFile(mesh.mpi_comm(), filename)
+    file.parameters["incremental_time_series"] = True
+    times = [0.1, 0.2, 0.3, 0.4]
+    for i, t in enumerate(times):
+        u.vector()[:] = float(i)
+        file << (u, t)
+    del file
+
+    # Each time step is a grid referring to one step of a single
+    # dataset
+    if MPI.rank(mesh.mpi_comm()) == 0:
+        series = ET.parse(filename).getroot().find("Domain").find("Grid")
+        grids = series.findall("Grid")
+        assert len(grids) == len(times)
+        for i, grid in enumerate(grids):
+            assert float(grid.find("Time").get("Value")) == times[i]
+            slab = grid.find("Attribute").find("DataItem")
+            assert slab.get("ItemType") == "HyperSlab"
+            start = slab.findall("DataItem")[0].text.split()
+            assert int(start[0]) == i
+            assert slab.findall("DataItem")[1].text.endswith("/VisualisationVector/" + u.name())
+
+@skip_if_not_HDF5
+def test_save_incremental_series_other_function(tempdir):
+    filename = os.path.join(tempdir, "uv_series.xdmf")
+    mesh = UnitSquareMesh(4, 4)
+    V = FunctionSpace(mesh, "Lagrange", 1)
+    u = Function(V, name="u")
+    v = Function(V, name="v")
+
+    file = XDMFFile(mesh.mpi_comm(), filename)
+    file.parameters["incremental_time_series"] = True
+    file << (u, 0.0)
+    file << (u, 1.0)
+    with pytest.raises(RuntimeError):
+        file << (v, 1.0)
+
 @skip_if_not_HDF5
 def test_save_2d_tensor(tempdir):
     filename = os.path.join(tempdir, "tensor.xdmf")
@@ -23,8 +23,9 @@
 
 import pytest
 from dolfin import *
+import math
 import os
-from dolfin_utils.test import skip_in_parallel, fixture, cd_tempdir
+from dolfin_utils.test import skip_in_parallel, skip_in_serial, skip_if_not_HDF5, fixture, cd_tempdir
 
 
 @skip_in_parallel
@@ -113,3 +114,70 @@ def test_mesh_domains_io(cd_tempdir):
             len(output_mesh.domains().markers(2))
     assert len(input_mesh.domains().markers(3)) == \
             len(output_mesh.domains().markers(3))
+
+def mesh_signature(mesh):
+    "Return global numbers of vertices and cells and a hash of cell midpoints"
+    comm = mesh.mpi_comm()
+    tdim = mesh.topology().dim()
+    h = MPI.sum(comm, sum(math.sin(1.0 + c.midpoint().dot(Point(1.0, 2.0, 3.0)))
+                          for c in cells(mesh)))
+    return mesh.size_global(0), mesh.size_global(tdim), h
+
+def same_signature(s0, s1):
+    return s0[:2] == s1[:2] and abs(s0[2] - s1[2]) < 1.0e-10
+
+@skip_if_not_HDF5
+@skip_in_serial
+def test_read_mesh_cache(cd_tempdir):
+    "Test parallel input of mesh through HDF5 cache"
+    comm = mpi_comm_world()
+    filename = "XMLMesh_test_cache.xml"
+    cache_filename = filename + ".h5"
+
+    def write_mesh(n):
+        "Write mesh on one process"
+        if MPI.rank(comm) == 0:
+            if os.path.isfile(filename):
+                os.remove(filename)
+            output_mesh = UnitCubeMesh(mpi_comm_self(), n, n, n)
+            File(mpi_comm_self(), filename) << output_mesh
+        MPI.barrier(comm)
+
+    def set_xml_time(offset):
+        "Set modification time of XML file relative to the cache"
+        if MPI.rank(comm) == 0:
+            t = os.path.getmtime(cache_filename) + offset
+            os.utime(filename, (t, t))
+        MPI.barrier(comm)
+
+    if MPI.rank(comm) == 0 and os.path.isfile(cache_filename):
+        os.remove(cache_filename)
+    MPI.barrier(comm)
+
+    parameters["xml_mesh_cache"] = True
+    try:
+        # First read parses the XML file and writes the cache
+        write_mesh(4)
+        mesh0 = Mesh(comm, filename)
+        assert os.path.isfile(cache_filename)
+        signature = mesh_signature(mesh0)
+        assert signature[:2] == (125, 384)
+
+        # Read from cache, which is newer than the XML file
+        set_xml_time(-10)
+        mesh1 = Mesh(comm, filename)
+        assert same_signature(mesh_signature(mesh1), signature)
+
+        # Replace the XML file by another mesh, but older than the
+        # cache: the cached mesh is read
+        write_mesh(2)
+        set_xml_time(-10)
+        mesh2 = Mesh(comm, filename)
+        assert same_signature(mesh_signature(mesh2), signature)
+
+        # Touch the XML file: the stale cache is ignored
+        set_xml_time(10)
+        mesh3 = Mesh(comm, filename)
+        assert mesh_signature(mesh3)[:2] == (27, 48)
+    finally:
+        parameters["xml_mesh_cache"] = False
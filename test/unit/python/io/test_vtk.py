@@ -20,6 +20,11 @@
 import pytest
 from dolfin import *
 import os
+import base64
+import struct
+import zlib
+import numpy
+import xml.etree.ElementTree as ET
 from dolfin_utils.test import skip_in_parallel, fixture, tempdir
 
 # VTK file options
@@ -110,6 +115,39 @@ def test_save_3d_mesh(tempfile, file_options):
     for file_option in file_options:
         File(tempfile + "mesh.pvd", file_option) << mesh
 
+@skip_in_parallel
+def test_save_encoded_mesh_data(tempfile):
+    """Decode binary VTK data arrays, which are written in chunks
+    (compressed in parallel blocks), and compare with the mesh"""
+    mesh = UnitCubeMesh(24, 24, 24)
+    for file_option in ["base64", "compressed"]:
+        File(tempfile + file_option + ".pvd", file_option) << mesh
+        vtu = ET.parse(tempfile + file_option + "000000.vtu")
+        points = vtu.find(".//Points/DataArray").text.strip()
+        if file_option == "compressed" and has_zlib():
+            # Multi-block header: number of blocks, block size, size of
+            # last block (if partial) and compressed size of each block
+            num_blocks, block_size, last_size \
+                = struct.unpack("3I", base64.b64decode(points[:16]))
+            header_length = 4*((4*(3 + num_blocks) + 2)//3)
+            header = struct.unpack("%dI" % (3 + num_blocks),
+                                   base64.b64decode(points[:header_length]))
+            data = base64.b64decode(points[header_length:])
+            assert sum(header[3:]) == len(data)
+            blocks = []
+            for size in header[3:]:
+                blocks.append(zlib.decompress(data[:size]))
+                data = data[size:]
+            assert all(len(b) == block_size for b in blocks[:-1])
+            assert len(blocks[-1]) == (last_size if last_size else block_size)
+            data = b"".join(blocks)
+        else:
+            size = struct.unpack("I", base64.b64decode(points[:8]))[0]
+            data = base64.b64decode(points[8:])
+            assert size == len(data)
+        x = numpy.frombuffer(data, dtype=numpy.float64).reshape(-1, 3)
+        assert numpy.array_equal(x, mesh.coordinates())
+
 def test_save_1d_scalar(tempfile, file_options):
     mesh = UnitIntervalMesh(32)
     u = Function(FunctionSpace(mesh, "Lagrange", 2))
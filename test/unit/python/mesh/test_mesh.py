@@ -439,3 +439,90 @@ def test_shared_entities():
                     sharing = e.sharing_processes()
                     assert isinstance(sharing, numpy.ndarray)
                     assert (sharing.size > 0) == e.is_shared()
+
+
+@pytest.mark.parametrize("MeshClass, args", [(UnitSquareMesh, (5, 4)),
+                                             (UnitCubeMesh, (3, 4, 2))])
+def test_entity_numbering(MeshClass, args):
+    "Test that entities are numbered identically by sorting and by map"
+    old_numbering = parameters["entity_numbering"]
+    connectivity = {}
+    for numbering in ("sort", "map"):
+        parameters["entity_numbering"] = numbering
+        mesh = MeshClass(*args)
+        tdim = mesh.topology().dim()
+        data = []
+        for dim in range(1, tdim):
+            mesh.init(dim)
+            data.append(numpy.array(mesh.topology()(tdim, dim)()))
+            data.append(numpy.array(mesh.topology()(dim, 0)()))
+            data.append(mesh.topology().ghost_offset(dim))
+        connectivity[numbering] = data
+    parameters["entity_numbering"] = old_numbering
+
+    for a, b in zip(connectivity["sort"], connectivity["map"]):
+        assert numpy.all(numpy.equal(a, b))
+
+
+def test_connectivity_budget():
+    "Test that connectivity is cleared to meet memory budget and recomputed"
+    mesh = UnitCubeMesh(4, 4, 4)
+    topology = mesh.topology()
+    mesh.init(0, 3)
+    cells_of_vertex = numpy.array(topology(0, 3)())
+    base_usage = topology.connectivity_memory_usage()
+
+    # Limit memory such that only one transpose fits
+    topology.set_connectivity_budget(base_usage)
+    assert topology.connectivity_budget() == base_usage
+    mesh.init(0, 1)
+
+    # Connectivity is only cleared when trimmed
+    assert topology(0, 3).size() > 0
+    assert topology.num_evictions() == 0
+    assert mesh.trim_connectivity() > 0
+    assert topology(0, 3).size() == 0
+    assert topology(0, 1).size() > 0
+    assert topology.num_evictions() == 1
+
+    # Connectivity is recomputed on access
+    mesh.init(0, 3)
+    assert numpy.all(topology(0, 3)() == cells_of_vertex)
+    assert topology.num_recomputations() == 1
+    mesh.trim_connectivity()
+    assert topology(0, 1).size() == 0
+    assert topology.num_evictions() == 2
+
+    # Entities are never cleared
+    mesh.init(2)
+    mesh.trim_connectivity()
+    assert topology(3, 2).size() > 0
+    assert topology(2, 0).size() > 0
+
+
+def test_connectivity_compression():
+    "Test fixed stride and compressed storage of connectivity"
+    mesh = UnitCubeMesh(4, 4, 4)
+    topology = mesh.topology()
+
+    # Cell-vertex connectivity is stored without offsets
+    cell_vertex = topology(3, 0)
+    assert cell_vertex.memory_usage() < cell_vertex.memory_usage_uncompressed()
+
+    mesh.init(0, 3)
+    cells_of_vertex = numpy.array(topology(0, 3)())
+    memory_03 = topology(0, 3).memory_usage()
+
+    # Compression is an explicit call
+    topology(0, 3).compress()
+    assert topology(0, 3).compressed()
+    assert topology(0, 3).size() == len(cells_of_vertex)
+    assert topology(0, 3).memory_usage() < memory_03//2
+
+    # Compressed connectivity can not be accessed until restored
+    with pytest.raises(RuntimeError):
+        mesh.init(0, 3)
+    topology(0, 3).decompress()
+    assert not topology(0, 3).compressed()
+    mesh.init(0, 3)
+    assert numpy.all(topology(0, 3)() == cells_of_vertex)
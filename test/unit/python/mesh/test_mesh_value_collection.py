@@ -22,6 +22,7 @@
 # First added:  2011-03-10
 # Last changed: 2011-03-10
 
+import numpy
 import numpy.random
 from dolfin import *
 
@@ -167,3 +168,32 @@ def test_mesh_function_assign_2D_vertices():
         for i, vert in enumerate(vertices(cell)):
             assert 25 == g.get_value(cell.index(), i)
             assert f2[vert] == g.get_value(cell.index(), i)
+
+def test_set_values():
+    mesh = UnitSquareMesh(3, 3)
+    mesh.init(2, 1)
+    ncells = mesh.num_cells()
+
+    # Unordered values, with a repeated entry where the last one wins
+    cell_indices = [ncells - 1 - c for c in range(ncells)] + [0]
+    local_entities = [1]*ncells + [1]
+    values = [c for c in range(ncells)] + [-1]
+    f = MeshValueCollection("int", mesh, 1)
+    f.set_value(1, 0, 7)
+    f.set_values(cell_indices, local_entities, values)
+    assert ncells + 1 == f.size()
+    assert 7 == f.get_value(1, 0)
+    assert -1 == f.get_value(0, 1)
+    for c in range(1, ncells):
+        assert ncells - 1 - c == f.get_value(c, 1)
+
+    # Values are ordered by cell and local entity
+    keys = sorted(f.values().keys())
+    assert keys[0] == (0, 1)
+    assert keys[1] == (1, 0)
+
+    # Round trip through a MeshFunction
+    g = MeshValueCollection("int", mesh, 2)
+    g.set_values(list(range(ncells)), list(range(ncells)))
+    h = MeshFunction("int", mesh, g)
+    assert all(h.array() == numpy.arange(ncells))
@@ -131,3 +131,95 @@ def test_integrate():
 
     # errorstring = "translation=" + str(dx[0]) + str(" ") + str(dx[1])
     # assert round(volume - exactvolume, 7, errorstring)
+
+
+@skip_in_parallel
+def test_update():
+    "Updating after moving a part gives the same rules as a new build"
+
+    # Background mesh with two disjoint overlapping meshes
+    mesh_0 = UnitSquareMesh(10, 10)
+    mesh_1 = RectangleMesh(Point(0.12, 0.13), Point(0.41, 0.38), 6, 5)
+    mesh_2 = RectangleMesh(Point(0.53, 0.51), Point(0.88, 0.83), 7, 6)
+
+    multimesh = MultiMesh()
+    multimesh.add(mesh_0)
+    multimesh.add(mesh_1)
+    multimesh.add(mesh_2)
+    multimesh.build()
+
+    # Move last part and update (rules of cells cut by part 1 are kept)
+    mesh_2.translate(Point(0.031, -0.027))
+    multimesh.update([2])
+
+    reference = MultiMesh()
+    reference.add(mesh_0)
+    reference.add(mesh_1)
+    reference.add(mesh_2)
+    reference.build()
+
+    for part in range(multimesh.num_parts()):
+        cut_cells = multimesh.cut_cells(part)
+        assert numpy.array_equal(cut_cells, reference.cut_cells(part))
+        assert numpy.array_equal(multimesh.covered_cells(part),
+                                 reference.covered_cells(part))
+        for c in cut_cells:
+            points, weights = multimesh.quadrature_rule_cut_cell(part, c)
+            ref_points, ref_weights = reference.quadrature_rule_cut_cell(part, c)
+            assert numpy.allclose(points, ref_points)
+            assert numpy.allclose(weights, ref_weights)
+
+        # Overlap rules in compressed row storage
+        overlap = multimesh.overlap_quadrature(part)
+        ref_overlap = reference.overlap_quadrature(part)
+        assert overlap.size() == ref_overlap.size()
+        for i in range(overlap.size()):
+            assert numpy.allclose(overlap.rule(i)[1], ref_overlap.rule(i)[1])
+
+
+@skip_in_parallel
+def test_build_threads():
+    "Building and updating with several threads gives the serial rules"
+
+    def create_multimesh(num_threads):
+        # Create new meshes so that no connectivity has been computed
+        mesh_0 = UnitSquareMesh(10, 10)
+        mesh_1 = RectangleMesh(Point(0.12, 0.13), Point(0.41, 0.38), 6, 5)
+        mesh_2 = RectangleMesh(Point(0.53, 0.51), Point(0.88, 0.83), 7, 6)
+
+        multimesh = MultiMesh()
+        multimesh.add(mesh_0)
+        multimesh.add(mesh_1)
+        multimesh.add(mesh_2)
+
+        # Build, move last part and update
+        old_num_threads = parameters["num_threads"]
+        parameters["num_threads"] = num_threads
+        try:
+            multimesh.build()
+            mesh_2.translate(Point(0.031, -0.027))
+            multimesh.update([2])
+        finally:
+            parameters["num_threads"] = old_num_threads
+        return multimesh
+
+    multimesh = create_multimesh(4)
+    reference = create_multimesh(0)
+
+    for part in range(multimesh.num_parts()):
+        assert numpy.array_equal(multimesh.cut_cells(part),
+                                 reference.cut_cells(part))
+        for rules, ref_rules in [(multimesh.cut_cell_quadrature(part),
+                                  reference.cut_cell_quadrature(part)),
+                                 (multimesh.overlap_quadrature(part),
+                                  reference.overlap_quadrature(part)),
+                                 (multimesh.interface_quadrature(part),
+                                  reference.interface_quadrature(part))]:
+            assert rules.size() == ref_rules.size()
+            for i in range(rules.size()):
+                points, weights = rules.rule(i)
+                ref_points, ref_weights = ref_rules.rule(i)
+                assert numpy.allclose(points, ref_points)
+                assert numpy.allclose(weights, ref_weights)
+        assert numpy.allclose(multimesh.interface_normals(part),
+                              reference.interface_normals(part))